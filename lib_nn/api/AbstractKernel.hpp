@@ -55,6 +55,14 @@ class AbstractKernel {
      */
     int32_t output_channel_slice_offset;
 
+    /**
+     * The channel of the output image at which channel 0 of the filter's output
+     * is written. This is non-zero when the output image is a larger tensor of
+     * which the filter writes only some channels, e.g. the output of a channel
+     * concatenation, and is included in `output_channel_slice_offset`.
+     */
+    int32_t output_channel_view_offset;
+
     /**
      * This is the number of bytes required to move from the start of a pixel
      * (offset by output_channel_slice_offset) on the final column of a output
@@ -69,8 +77,20 @@ class AbstractKernel {
      */
     int32_t output_w_mem_stride;
 
+    /**
+     * Construct the parameters for computing `output_region` of the filter's
+     * output, written to `output_image`.
+     *
+     * With a non-zero `output_channel_view_offset`, `output_image` is a larger
+     * tensor than the filter's output and the filter's channels are written to
+     * it starting at that channel, so that several filters can write their
+     * outputs directly into a shared tensor, one channel range each. The
+     * channels of `output_region` are the filter's own, and the view offset
+     * must be a multiple of 4 channels.
+     */
     Params(const ImageGeometry &output_image, const ImageRegion &output_region,
-           const int channels_per_group)
+           const int channels_per_group,
+           const int32_t output_channel_view_offset = 0)
         : h_begin(output_region.start.row),
           h_end(output_region.EndVect().row),
           w_begin(output_region.start.col),
@@ -78,10 +98,32 @@ class AbstractKernel {
           output_channel_group_count(
               (output_region.shape.depth + channels_per_group - 1) /
               channels_per_group),
-          output_channel_slice_offset(output_region.start.channel),
+          output_channel_slice_offset(output_channel_view_offset +
+                                      output_region.start.channel),
+          output_channel_view_offset(output_channel_view_offset),
           output_h_mem_stride(
               output_image.GetStride(1, -output_region.shape.width, 0)),
           output_w_mem_stride(output_image.GetStride(0, 1, 0)) {}
+
+    /**
+     * Construct the parameters for the rows [`h_begin`, `h_end`) and the
+     * channel groups [`group_begin`, `group_end`) of the region described by
+     * `parent`. Group indices are relative to the first channel group of
+     * `parent`.
+     */
+    Params(const Params &parent, const int32_t h_begin, const int32_t h_end,
+           const int32_t group_begin, const int32_t group_end,
+           const int channels_per_group)
+        : h_begin(h_begin),
+          h_end(h_end),
+          w_begin(parent.w_begin),
+          w_end(parent.w_end),
+          output_channel_group_count(group_end - group_begin),
+          output_channel_slice_offset(parent.output_channel_slice_offset +
+                                      group_begin * channels_per_group),
+          output_channel_view_offset(parent.output_channel_view_offset),
+          output_h_mem_stride(parent.output_h_mem_stride),
+          output_w_mem_stride(parent.output_w_mem_stride) {}
   };
 
  protected:
@@ -104,6 +146,11 @@ class AbstractKernel {
    */
   AbstractKernel(Params *kparams) : kparams(kparams) {}
 
+  /**
+   * Get the parameters describing the output region processed by this kernel.
+   */
+  Params *get_params() { return kparams; }
+
   /**
    * Execute this kernel using the output image pointed to by `Y` and input
    * image pointed to by `X`.
@@ -119,10 +166,13 @@ class AbstractKernel {
    * confusing? Why is there an output channel offset built into kparams, but
    * not an output row or column offset?
    *
+   * Subclasses which visit the output in another order, e.g. `Filter2DT`,
+   * override this, so it may be called through a reference to this class.
+   *
    * @param [in] Y  Pointer to the output image.
    * @param [in] X  Pointer to the input image.
    */
-  void execute(int8_t *Y, int8_t *X) {
+  virtual void execute(int8_t *Y, int8_t *X) {
     int bytes_per_row =
         kparams->output_h_mem_stride +
         (kparams->w_end - kparams->w_begin) * kparams->output_w_mem_stride;
@@ -140,6 +190,27 @@ class AbstractKernel {
       Y += kparams->output_h_mem_stride;
     }
   }
+
+  /**
+   * Execute this kernel for each of `batch_count` images. The output and input
+   * images of image `i` are at `Y + i * Y_image_bytes` and
+   * `X + i * X_image_bytes`.
+   *
+   * This executes the images one after another with `execute()`, and shares
+   * nothing between them. Subclasses which can reuse work across the batch,
+   * e.g. `Filter2DT` with the channel groups as the outer loop, override it.
+   *
+   * @param [in] Y  Pointer to the first output image.
+   * @param [in] X  Pointer to the first input image.
+   * @param [in] batch_count  The number of images.
+   * @param [in] Y_image_bytes  The bytes from one output image to the next.
+   * @param [in] X_image_bytes  The bytes from one input image to the next.
+   */
+  virtual void execute(int8_t *Y, int8_t *X, int32_t batch_count,
+                       int32_t Y_image_bytes, int32_t X_image_bytes) {
+    for (int32_t image = 0; image < batch_count; image++)
+      execute(Y + image * Y_image_bytes, X + image * X_image_bytes);
+  }
 };
 
 }  // namespace nn
@@ -27,6 +27,34 @@ class AggregateFn {
    */
   virtual void aggregate_fn(VPURingBuffer *A, int8_t *T,
                             int32_t output_channel_group) = 0;
+
+  /**
+   * @brief Get the weights read when computing `output_channel_group`, so that
+   * they can be copied into faster memory and used with
+   * `aggregate_fn_sliced()`.
+   *
+   * @param output_channel_group Denotes which channel group's weights to get.
+   * @param bytes Set to the number of bytes to be copied, or zero if the
+   * aggregation has no weights.
+   * @return Pointer to the first byte to be copied.
+   */
+  virtual const int8_t *get_channel_group_weights(int32_t output_channel_group,
+                                                  int32_t *bytes) {
+    *bytes = 0;
+    return nullptr;
+  }
+
+  /**
+   * @brief As `aggregate_fn()`, but reading the weights from `weights`, a copy
+   * of those given by `get_channel_group_weights()` for the same channel
+   * group. As with `CONV2D_DEEP_FLAG_SLICED_K`, `weights` holds only the slice
+   * of the weights needed.
+   */
+  virtual void aggregate_fn_sliced(VPURingBuffer *A, int8_t *T,
+                                   int32_t output_channel_group,
+                                   const int8_t *weights) {
+    aggregate_fn(A, T, output_channel_group);
+  }
 };
 
 struct Conv2dReorderedWeights {
@@ -54,6 +82,14 @@ struct Conv2dReorderedWeights {
       : weights(), final_vpu_load_addresses(channels, 0) {}
 };
 
+/**
+ * Multiplies a patch by the weights of an output channel group, one pixel at a
+ * time.
+ *
+ * VLMACCR reads its weights from memory for every pixel, and the VPU has a
+ * single set of accumulators. Interleaving the patches of several pixels
+ * would not read the weights any less often, so it is not done.
+ */
 class MatMulInt8 : public AggregateFn {
  public:
   class Params {
@@ -80,11 +116,16 @@ class MatMulInt8 : public AggregateFn {
    * @brief This describes the region over which this class will perform its
    * operation(MatMul).
    */
-  Params *params;
+  const Params *params;
 
  public:
-  MatMulInt8(Params *params) : params(params){};
+  MatMulInt8(const Params *params) : params(params){};
   void aggregate_fn(VPURingBuffer *A, int8_t *T, int32_t output_channel_group);
+  const int8_t *get_channel_group_weights(int32_t output_channel_group,
+                                          int32_t *bytes);
+  void aggregate_fn_sliced(VPURingBuffer *A, int8_t *T,
+                           int32_t output_channel_group,
+                           const int8_t *weights);
 
   /**
    * @brief Used to reorder the weights from their normal form ([OutputChannel,
@@ -167,23 +208,403 @@ class MatMulDirectFn : public AggregateFn {
    * @brief This describes the region over which this class will perform its
    * operation(MatMul).
    */
-  Params *params;
+  const Params *params;
 
  public:
-  MatMulDirectFn(Params *params) : params(params){};
+  MatMulDirectFn(const Params *params) : params(params){};
 
   void aggregate_fn(VPURingBuffer *A, int8_t *T, int32_t output_channel_group);
+  const int8_t *get_channel_group_weights(int32_t output_channel_group,
+                                          int32_t *bytes);
+  void aggregate_fn_sliced(VPURingBuffer *A, int8_t *T,
+                           int32_t output_channel_group,
+                           const int8_t *weights);
 };
 
 class MatMulBinaryDirectFn : public MatMulDirectFn {
  public:
-  MatMulBinaryDirectFn(Params *params) : MatMulDirectFn(params) {}
+  MatMulBinaryDirectFn(const Params *params) : MatMulDirectFn(params) {}
 
  private:
   void mat_mul_direct_impl(VPURingBuffer *A, int8_t *T,
                            int32_t output_channel_group);
 };
 
+/**
+ * Aggregator for performing a depthwise convolution on 16 channels at a time.
+ *
+ * Each output channel is the dot product of one input channel over the window
+ * with that channel's kernel. The input is read either directly from the input
+ * image (with `DerefInputFn`), in which case the VPU may read up to
+ * `XS3_VPU_VREG_WIDTH_BYTES` bytes beyond the last channel of a pixel, or from
+ * a patch written by `ImToColPadded` with 16 channels per output group.
+ *
+ * The accumulator of output channel `k` of a group is left in element `k` of
+ * the ring buffer, as with the other aggregators.
+ */
+class MatMulDirectFn_DW : public AggregateFn {
+ public:
+  class Params {
+   public:
+    /**
+     * The weights, as reordered by `reorder_kernel_weights()`.
+     */
+    const int8_t *weights;
+
+    int32_t k_height;
+    int32_t k_width;
+
+    /**
+     * The number of weight bytes of each channel group.
+     */
+    int32_t bytes_per_kernel_channel_group;
+
+    /**
+     * Stride between the columns of the window.
+     */
+    int32_t inner_x_h_step;
+
+    /**
+     * Stride from the end of one row of the window to the start of the next.
+     */
+    int32_t inner_x_v_step;
+
+    /**
+     * @brief Construct a new Params object for reading the input image
+     * directly.
+     *
+     * @param X Class describing the properties of the input image.
+     * @param K Class describing the properties of the convolution window.
+     * @param weights A Pointer to the begining of the reordered weights.
+     */
+    Params(const ImageGeometry &X, const WindowGeometry &K,
+           const int8_t *weights);
+
+    /**
+     * @brief Construct a new Params object for reading a patch written by
+     * `ImToColPadded` with 16 channels per output group.
+     *
+     * @param K Class describing the properties of the convolution window.
+     * @param weights A Pointer to the begining of the reordered weights.
+     */
+    Params(const WindowGeometry &K, const int8_t *weights);
+  };
+
+ protected:
+  /**
+   * @brief This describes the region over which this class will perform its
+   * operation(MatMul).
+   */
+  Params *params;
+
+ public:
+  MatMulDirectFn_DW(Params *params) : params(params){};
+
+  void aggregate_fn(VPURingBuffer *A, int8_t *T, int32_t output_channel_group);
+
+  /**
+   * @brief Reorder the weights from their TensorFlow Lite form ([1, Height,
+   * Width, Channels]) into the order in which the VPU loads them.
+   *
+   * For each group of 16 channels, there is a 16 byte vector of the group's
+   * weights for each position of the window, in row major order. Partial
+   * channel groups are padded with zeros.
+   *
+   * @param raw_weights Pointer to the raw weights.
+   * @param shape [1, Height, Width, Channels]
+   * @return The reordered weights.
+   */
+  static std::vector<int8_t> reorder_kernel_weights(
+      const int8_t *raw_weights, const std::array<int, 4> &shape);
+
+  /**
+   * @brief Get the size in bytes of the reordered weights.
+   */
+  static int get_weights_bytes(int k_height, int k_width, int channels);
+};
+
+/**
+ * Weights reordered for `MatMulBlockSparseInt8`.
+ *
+ * The weights of each output channel group are divided into blocks, one per
+ * `XS3_VPU_VREG_WIDTH_BYTES` byte vector of the patch. A block holds a vector
+ * of weights for each of the 16 channels of the group, in reverse channel
+ * order as with `MatMulInt8`. Only the blocks with a non-zero weight are kept.
+ */
+struct Conv2dBlockSparseWeights {
+  /**
+   * The non-zero blocks, channel group by channel group. Partial blocks and
+   * channel groups are padded with zeros.
+   */
+  std::vector<int8_t> weights;
+
+  /**
+   * For each block in `weights`, the index of the patch vector it multiplies.
+   */
+  std::vector<int16_t> block_indices;
+
+  /**
+   * The blocks of channel group `g` are [`group_offsets[g]`,
+   * `group_offsets[g + 1]`).
+   */
+  std::vector<int32_t> group_offsets;
+
+  /**
+   * Get the total size in bytes of the weights, indices and offsets.
+   */
+  int get_bytes() const {
+    return weights.size() * sizeof(int8_t) +
+           block_indices.size() * sizeof(int16_t) +
+           group_offsets.size() * sizeof(int32_t);
+  }
+};
+
+/**
+ * Aggregator for a dense convolution with block-sparse weights, consuming the
+ * same patches as `MatMulInt8`.
+ *
+ * For each non-zero block of the channel group, the patch vector it
+ * multiplies is loaded and multiplied with the 16 vectors of the block. Blocks
+ * of zeros are skipped entirely, so the cost is proportional to the number of
+ * non-zero blocks. As blocks are whole vectors padded with zero weights, the
+ * bytes of the patch after the final kernel byte may hold any value, but must
+ * be readable.
+ */
+class MatMulBlockSparseInt8 : public AggregateFn {
+ public:
+  class Params {
+   public:
+    /**
+     * The non-zero blocks, as `Conv2dBlockSparseWeights::weights`.
+     */
+    const int8_t *weights;
+
+    /**
+     * As `Conv2dBlockSparseWeights::block_indices`.
+     */
+    const int16_t *block_indices;
+
+    /**
+     * As `Conv2dBlockSparseWeights::group_offsets`.
+     */
+    const int32_t *group_offsets;
+
+    /**
+     * @brief Construct a new Params object.
+     *
+     * @param weights The weights, as reordered by `reorder_kernel_weights()`.
+     * The pointers are kept, so `weights` must outlive this object.
+     */
+    Params(const Conv2dBlockSparseWeights &weights);
+  };
+
+  /**
+   * The number of bytes of a block.
+   */
+  static constexpr int BlockBytes = VPU_INT16_EPV * XS3_VPU_VREG_WIDTH_BYTES;
+
+ protected:
+  /**
+   * @brief This describes the region over which this class will perform its
+   * operation(MatMul).
+   */
+  Params *params;
+
+ public:
+  MatMulBlockSparseInt8(Params *params) : params(params){};
+  void aggregate_fn(VPURingBuffer *A, int8_t *T, int32_t output_channel_group);
+  const int8_t *get_channel_group_weights(int32_t output_channel_group,
+                                          int32_t *bytes);
+  void aggregate_fn_sliced(VPURingBuffer *A, int8_t *T,
+                           int32_t output_channel_group,
+                           const int8_t *weights);
+
+  /**
+   * @brief Reorder the weights from their normal form ([OutputChannel,
+   * Height, Width, InputChannel]) into blocks, dropping the blocks which are
+   * entirely zero.
+   *
+   * @param raw_weights Pointer to the raw int8 weights.
+   * @param shape [OutputChannels, Height, Width, InputChannels]
+   * @return The block-sparse weights.
+   */
+  static Conv2dBlockSparseWeights reorder_kernel_weights(
+      const int8_t *raw_weights, const std::array<int, 4> &shape);
+};
+
+/**
+ * Weights reordered and packed for `MatMulInt4`.
+ *
+ * Each weight is a signed 4-bit value, two per byte with the even element in
+ * the low nibble. As with `MatMulInt8`, the weights of each output channel
+ * group are vectors of `XS3_VPU_VREG_WIDTH_BYTES` elements in reverse channel
+ * order, but every vector is whole: partial vectors and channel groups are
+ * padded with zeros, so a packed vector is always half a VPU vector.
+ */
+struct Conv2dInt4Weights {
+  /**
+   * The packed weights, channel group by channel group.
+   */
+  std::vector<int8_t> weights;
+
+  /**
+   * For each output channel, the scale of its 4-bit weights, i.e. a raw
+   * weight is approximated by `scales[ch] * w`. The accumulators are in units
+   * of the 4-bit weights, so these must be folded into the multipliers of the
+   * output transform.
+   */
+  std::vector<float> scales;
+};
+
+/**
+ * Aggregator for a dense convolution with 4-bit weights, consuming the same
+ * patches as `MatMulInt8`.
+ *
+ * The weights for each patch vector are unpacked into a block of int8 vectors
+ * just before it is multiplied, halving the memory and bandwidth needed for
+ * the weights at the cost of the unpacking. As the weight vectors are padded
+ * with zeros, the bytes of the patch after the final kernel byte may hold any
+ * value, but must be readable.
+ */
+class MatMulInt4 : public AggregateFn {
+ public:
+  class Params {
+   public:
+    const int8_t *weights;
+    const int32_t bytes_per_kernel_channel;
+
+    /**
+     * @brief Construct a new Params object.
+     *
+     * @param bytes_per_kernel_channel The count of int8 inputs multiplied by
+     * each channel of the kernel.
+     * @param weights A pointer to the packed weights, as reordered by
+     * `reorder_kernel_weights()`.
+     */
+    Params(const int32_t bytes_per_kernel_channel, const int8_t *weights);
+  };
+
+  /**
+   * The number of bytes of packed weights multiplied with each patch vector.
+   */
+  static constexpr int BlockBytes =
+      VPU_INT16_EPV * XS3_VPU_VREG_WIDTH_BYTES / 2;
+
+ protected:
+  /**
+   * @brief This describes the region over which this class will perform its
+   * operation(MatMul).
+   */
+  Params *params;
+
+ public:
+  MatMulInt4(Params *params) : params(params){};
+  void aggregate_fn(VPURingBuffer *A, int8_t *T, int32_t output_channel_group);
+  const int8_t *get_channel_group_weights(int32_t output_channel_group,
+                                          int32_t *bytes);
+  void aggregate_fn_sliced(VPURingBuffer *A, int8_t *T,
+                           int32_t output_channel_group,
+                           const int8_t *weights);
+
+  /**
+   * @brief Quantize the weights from their normal form ([OutputChannel,
+   * Height, Width, InputChannel]) to 4 bits per output channel, and reorder
+   * and pack them.
+   *
+   * A channel whose weights are all within [-8, 7] is kept exactly, with a
+   * scale of 1. Otherwise its weights are divided by `max(abs(w)) / 7` and
+   * rounded.
+   *
+   * @param raw_weights Pointer to the raw int8 weights.
+   * @param shape [OutputChannels, Height, Width, InputChannels]
+   * @return The packed weights and the scale of each channel.
+   */
+  static Conv2dInt4Weights reorder_kernel_weights(
+      const int8_t *raw_weights, const std::array<int, 4> &shape);
+
+  /**
+   * @brief Get the size in bytes of the packed weights.
+   *
+   * @param input_bytes The count of int8 inputs multiplied by each channel.
+   * @param output_channel_count The number of output channels.
+   */
+  static int get_weights_bytes(int input_bytes, int output_channel_count);
+};
+
+/**
+ * Aggregator for a dense convolution of int16 activations with int8 weights,
+ * consuming the patches of `ImToColPaddedInt16`.
+ *
+ * The VPU runs in 16-bit mode, so each patch vector holds `VPU_INT16_EPV`
+ * activations and the 32-bit accumulators saturate as in the int8 path. The
+ * weights are stored as int8, ordered as for `MatMulInt4` but a byte per
+ * weight, and each block is widened to int16 just before it is multiplied. As
+ * the weight vectors are padded with zeros, the elements of the patch after
+ * the final kernel element may hold any value, but must be readable.
+ *
+ * @see OT_int16
+ */
+class MatMulInt16x8 : public AggregateFn {
+ public:
+  class Params {
+   public:
+    const int8_t *weights;
+    const int32_t elements_per_kernel_channel;
+
+    /**
+     * @brief Construct a new Params object.
+     *
+     * @param elements_per_kernel_channel The count of int16 inputs multiplied
+     * by each channel of the kernel.
+     * @param weights A pointer to the weights, as reordered by
+     * `reorder_kernel_weights()`.
+     */
+    Params(const int32_t elements_per_kernel_channel, const int8_t *weights);
+  };
+
+  /**
+   * The number of bytes of weights multiplied with each patch vector.
+   */
+  static constexpr int BlockBytes = VPU_INT16_EPV * VPU_INT16_EPV;
+
+ protected:
+  /**
+   * @brief This describes the region over which this class will perform its
+   * operation(MatMul).
+   */
+  Params *params;
+
+ public:
+  MatMulInt16x8(Params *params) : params(params){};
+  void aggregate_fn(VPURingBuffer *A, int8_t *T, int32_t output_channel_group);
+  const int8_t *get_channel_group_weights(int32_t output_channel_group,
+                                          int32_t *bytes);
+  void aggregate_fn_sliced(VPURingBuffer *A, int8_t *T,
+                           int32_t output_channel_group,
+                           const int8_t *weights);
+
+  /**
+   * @brief Reorder the weights from their normal form ([OutputChannel,
+   * Height, Width, InputChannel]) into whole blocks of `VPU_INT16_EPV`
+   * elements per vector.
+   *
+   * @param raw_weights Pointer to the raw int8 weights.
+   * @param shape [OutputChannels, Height, Width, InputChannels]
+   * @return The reordered weights.
+   */
+  static std::vector<int8_t> reorder_kernel_weights(
+      const int8_t *raw_weights, const std::array<int, 4> &shape);
+
+  /**
+   * @brief Get the size in bytes of the reordered weights.
+   *
+   * @param input_elements The count of int16 inputs multiplied by each
+   * channel.
+   * @param output_channel_count The number of output channels.
+   */
+  static int get_weights_bytes(int input_elements, int output_channel_count);
+};
+
 /**
  * Aggregator for performing maxpool on a contiguous sequence of 32-channel
  * pixels.
@@ -0,0 +1,161 @@
+#ifndef LIB_NN_CONV_DISPATCHER_HPP_
+#define LIB_NN_CONV_DISPATCHER_HPP_
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "geom/Filter2dGeometry.hpp"
+
+namespace nn {
+
+/**
+ * The implementations of a dense int8 2D convolution a `ConvDispatcher` can
+ * choose between.
+ */
+enum class ConvImpl {
+  /** conv2d_deep(), or conv2d_deep_ext_view() for an input view */
+  Conv2dDeep,
+  /** conv2d_shallowin() */
+  Conv2dShallowIn,
+  /** conv2d_1x1(), or conv2d_1x1_ext_view() for an input view */
+  Conv2d1x1,
+  /** conv2d_im2col() */
+  Conv2dIm2col,
+  /** `Filter2D` with `DerefInputFn` and `MatMulDirectFn` */
+  Filter2dDirect,
+  /** `Filter2D` with `ImToColValid` and `MatMulInt8` */
+  Filter2dIm2colValid,
+  /** `Filter2D` with `ImToColPadded` and `MatMulInt8` */
+  Filter2dIm2colPadded,
+  /** No implementation, chosen when none is legal */
+  None,
+};
+
+/**
+ * The number of implementations in `ConvImpl`, which excludes `None`.
+ */
+constexpr int ConvImplCount = 7;
+
+/**
+ * Linear cycle model of a convolution implementation.
+ *
+ * The cycles estimated for a convolution are
+ *
+ *    per_call
+ *    + P * (per_pixel + W * per_window_pixel + V * per_patch_vector)
+ *    + P * G * (per_channel_group + M * per_mac_vector)
+ *
+ * where `P` is the number of output pixels, `G` the number of output channel
+ * groups, `W` the number of window pixels copied into a patch per output
+ * pixel, `V` the number of 32 byte vectors of patch written per output pixel
+ * and `M` the number of 32 byte input vectors multiplied with each channel
+ * group (each being `VPU_INT8_ACC_PERIOD` VLMACCRs).
+ */
+struct ConvCostModel {
+  int32_t per_call;
+  int32_t per_pixel;
+  int32_t per_window_pixel;
+  int32_t per_patch_vector;
+  int32_t per_channel_group;
+  int32_t per_mac_vector;
+};
+
+/**
+ * An implementation chosen by a `ConvDispatcher`, with its estimated cost.
+ *
+ * `impl` is `ConvImpl::None` (and `cycles` is -1) when no implementation is
+ * legal, which `is_valid()` checks.
+ */
+struct ConvDispatch {
+  ConvImpl impl;
+  int64_t cycles;
+
+  bool is_valid() const { return impl != ConvImpl::None; }
+};
+
+/**
+ * Chooses the fastest legal implementation of a dense int8 2D convolution
+ * using a per-implementation cycle model.
+ *
+ * The legality rules are those documented for each operator and handler:
+ * channel counts which are multiples of 4, `conv2d_shallowin()` needing
+ * `X_c * K_w <= 32`, `conv2d_1x1()` needing a unit window and stride, the
+ * valid-only patch handlers needing no padding, and so on.
+ *
+ * An input which is a view of a larger tensor is legal for `conv2d_deep()` and
+ * `conv2d_1x1()`, executed with their `_ext_view()` variants, and for the
+ * `Filter2D` compositions. An output which is a channel slice of a larger
+ * tensor is legal for those operators too, with their `OUTPUT_VIEW` flags.
+ * `conv2d_shallowin()` and `conv2d_im2col()` need dense images.
+ */
+class ConvDispatcher {
+  std::array<ConvCostModel, ConvImplCount> costs;
+
+ public:
+  /**
+   * Construct a dispatcher using `default_costs()`.
+   */
+  ConvDispatcher();
+
+  /**
+   * Construct a dispatcher using the cost models in `costs`, indexed by
+   * `ConvImpl`.
+   */
+  explicit ConvDispatcher(
+      const std::array<ConvCostModel, ConvImplCount> &costs);
+
+  /**
+   * Get the default cost models, indexed by `ConvImpl`, on xcore.ai at one
+   * thread per core.
+   */
+  static const std::array<ConvCostModel, ConvImplCount> &default_costs();
+
+  /**
+   * Get the cost model of `impl`.
+   */
+  const ConvCostModel &get_cost_model(ConvImpl impl) const {
+    return costs[(int)impl];
+  }
+
+  /**
+   * Replace the cost model of `impl`, e.g. with one fitted to measurements.
+   */
+  void set_cost_model(ConvImpl impl, const ConvCostModel &model) {
+    costs[(int)impl] = model;
+  }
+
+  /**
+   * Whether `impl` can compute the convolution described by `filter`.
+   */
+  static bool is_legal(ConvImpl impl, const Filter2dGeometry &filter);
+
+  /**
+   * Estimate the cycles `impl` takes to compute the convolution described by
+   * `filter`. `impl` must be legal for `filter`.
+   */
+  int64_t estimate_cycles(ConvImpl impl, const Filter2dGeometry &filter) const;
+
+  /**
+   * Get every legal implementation for `filter` with its estimated cost, from
+   * the cheapest to the most expensive.
+   */
+  std::vector<ConvDispatch> rank(const Filter2dGeometry &filter) const;
+
+  /**
+   * Get the cheapest legal implementation for `filter`.
+   *
+   * If `filter` has no legal implementation, e.g. because it is depthwise, the
+   * dispatch returned is not valid and the caller must not execute it.
+   */
+  ConvDispatch choose(const Filter2dGeometry &filter) const;
+
+  /**
+   * Get the name of `impl`, for logging.
+   */
+  static const char *get_name(ConvImpl impl);
+};
+
+}  // namespace nn
+
+#endif  // LIB_NN_CONV_DISPATCHER_HPP_
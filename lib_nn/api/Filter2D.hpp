@@ -1,25 +1,87 @@
 #ifndef LIB_NN_FILTER2D_HPP_
 #define LIB_NN_FILTER2D_HPP_
 
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+
 #include "AbstractKernel.hpp"
 #include "AggregateFn.hpp"
 #include "MemCpyFn.hpp"
 #include "OutputTransformFn.hpp"
 #include "Utils.hpp"
+#include "WinogradFn.hpp"
 #include "geom/util.hpp"
 
 namespace nn {
 
 /**
- * Base class for non-depthwise 2D filter kernels.
+ * The order in which a `Filter2DT` visits the output pixels and output channel
+ * groups of its region.
+ */
+enum class Filter2DLoopOrder {
+  /**
+   * For each output pixel, compute each channel group. The patch is copied
+   * once per pixel, but every channel group's weights are read for every pixel.
+   */
+  PixelOuter,
+
+  /**
+   * For each channel group, compute each output pixel. The patch is copied for
+   * every channel group, but only one channel group's weights are in use at a
+   * time, so they can be prefetched into a small SRAM buffer.
+   *
+   * The output transform must not write beyond the channels it produces (as
+   * `OT_int8` does not), since the following pixel has already been written.
+   */
+  ChannelGroupOuter,
+};
+
+/**
+ * Relative costs per byte of the memory traffic of a `Filter2DT`, used to
+ * choose its loop order. Only the ratios matter, e.g. cycles per byte.
+ */
+struct Filter2DMemoryCosts {
+  /**
+   * Reading weights from where they are stored, e.g. flash or external RAM.
+   */
+  int32_t weights_read;
+
+  /**
+   * Reading weights from SRAM, i.e. from the prefetch buffer.
+   */
+  int32_t sram_read;
+
+  /**
+   * Writing the patch with the patch handler.
+   */
+  int32_t patch_write;
+
+  /**
+   * The costs assumed by `Filter2DT::set_weights_buffer()`: weights stored in
+   * flash or external RAM, read at 8 times the cost of SRAM.
+   */
+  static Filter2DMemoryCosts default_costs() { return {8, 1, 1}; }
+};
+
+/**
+ * Non-depthwise 2D filter kernel composed statically from its component
+ * handlers.
+ *
+ * This implements `calc_output_pixel_slice()` used by `AbstractKernel`, and its
+ * behavior is ultimately determined by 3 component objects supplied to it, the
+ * patch handler (a `MemCpyT`, derived from `MemCpyFn`), the aggregation handler
+ * (an `AggregateT`, derived from `AggregateFn`) and the output transformer (an
+ * `OutputT`, derived from `OutputTransformFn`).
  *
- * This class implements `calc_output_pixel_slice()` used by `AbstractKernel`,
- * and its behavior is ultimately determined by 3 component objects supplied to
- * it, the patch handler (instance of `MemCpyFn`), the aggregation handler
- * (instance of `AggregateFn`) and the output transformer (instance of
- * `OutputTransformFn`).
+ * When the handler types are concrete classes their methods are called
+ * directly rather than through the vtable, and `execute()` processes each
+ * pixel without a virtual call, letting the compiler inline the whole
+ * per-pixel path. When they are the abstract interfaces, as in `Filter2D`, the
+ * handlers are called virtually.
  */
-class Filter2D : public AbstractKernel {
+template <class MemCpyT, class AggregateT, class OutputT>
+class Filter2DT : public AbstractKernel {
  public:
   /**
    * @brief Denotes if the class uses a memcpy that copies a channel group at a
@@ -35,21 +97,21 @@ class Filter2D : public AbstractKernel {
    * region of the input image is copied into (and padded out, if necessary) a
    * scratch buffer used for im2col-like aggregation.
    */
-  MemCpyFn *memcpy_handler;
+  MemCpyT *memcpy_handler;
 
   /**
    * The aggregation handler used by this class. This determines how the input
    * image's values are processed to form the 32-bit accumulator values used by
    * the output tranformer.
    */
-  AggregateFn *aggregate_handler;
+  AggregateT *aggregate_handler;
 
   /**
    * The output tranform handler used by this class. This determines how the
    * 32-bit accumulators produced by the aggregation handler are compressed down
    * into the 8-bit values which populate the output image.
    */
-  OutputTransformFn *ot_handler;
+  OutputT *ot_handler;
 
   /**
    * A pointer to a scratch memory buffer. Required when im2col-like patch
@@ -59,23 +121,403 @@ class Filter2D : public AbstractKernel {
    */
   int8_t *scratch_mem;
 
+  /**
+   * The index of the first channel group of this filter as seen by the
+   * aggregation and output transform handlers. This is non-zero when the
+   * filter computes a channel slice of a filter sharing its handlers.
+   */
+  int32_t output_channel_group_offset;
+
+  Filter2DLoopOrder loop_order;
+
+  /**
+   * An optional SRAM buffer of `weights_mem_bytes` bytes into which the
+   * weights of each channel group are copied when the channel groups are the
+   * outer loop.
+   */
+  int8_t *weights_mem;
+  int32_t weights_mem_bytes;
+
+ private:
+  // Concrete handlers are called with a qualified name, which bypasses the
+  // vtable; abstract ones keep the virtual call.
+  template <class T>
+  static int8_t *memcopy(T *handler, int8_t *scratch, int8_t *X, int32_t h,
+                         int32_t w, std::false_type) {
+    return handler->T::memcopy_fn(scratch, X, h, w, 0);
+  }
+  template <class T>
+  static int8_t *memcopy(T *handler, int8_t *scratch, int8_t *X, int32_t h,
+                         int32_t w, std::true_type) {
+    return handler->memcopy_fn(scratch, X, h, w, 0);
+  }
+  template <class T>
+  static void aggregate(T *handler, VPURingBuffer *A, int8_t *input,
+                        int32_t chan_group, std::false_type) {
+    handler->T::aggregate_fn(A, input, chan_group);
+  }
+  template <class T>
+  static void aggregate(T *handler, VPURingBuffer *A, int8_t *input,
+                        int32_t chan_group, std::true_type) {
+    handler->aggregate_fn(A, input, chan_group);
+  }
+  template <class T>
+  static void aggregate_sliced(T *handler, VPURingBuffer *A, int8_t *input,
+                               int32_t chan_group, const int8_t *weights,
+                               std::false_type) {
+    handler->T::aggregate_fn_sliced(A, input, chan_group, weights);
+  }
+  template <class T>
+  static void aggregate_sliced(T *handler, VPURingBuffer *A, int8_t *input,
+                               int32_t chan_group, const int8_t *weights,
+                               std::true_type) {
+    handler->aggregate_fn_sliced(A, input, chan_group, weights);
+  }
+  template <class T>
+  static int8_t *output_transform(T *handler, int8_t *Y, VPURingBuffer *A,
+                                  int32_t chan_group, std::false_type) {
+    return handler->T::output_transform_fn(Y, A, chan_group);
+  }
+  template <class T>
+  static int8_t *output_transform(T *handler, int8_t *Y, VPURingBuffer *A,
+                                  int32_t chan_group, std::true_type) {
+    return handler->output_transform_fn(Y, A, chan_group);
+  }
+
  protected:
+  /*
+    This is going to compute the output for output_channel_group_count channel
+    groups of the output. The pointer is going to be set to the begining on the
+    next output by output_w_mem_stride. This allows it to address sub-channel
+    regions.
+  */
+  inline void calc_output_pixel_slice_inline(int8_t *Y, int8_t *X, int32_t h,
+                                             int32_t w) {
+    // copy all input channels, channel start is implicitly 0.
+    int8_t *input_img = memcopy(memcpy_handler, scratch_mem, X, h, w,
+                                std::is_abstract<MemCpyT>());
+
+    VPURingBuffer A;
+
+    for (int32_t chan_group = 0;
+         chan_group < kparams->output_channel_group_count; chan_group++) {
+      aggregate(aggregate_handler, &A, input_img,
+                output_channel_group_offset + chan_group,
+                std::is_abstract<AggregateT>());
+
+      Y = output_transform(ot_handler, Y, &A,
+                           output_channel_group_offset + chan_group,
+                           std::is_abstract<OutputT>());
+    }
+  }
+
   /**
    * Process a single output pixel (subject to the region constraints given by
    * `kparams`
+   *
+   * `AbstractKernel::execute()` has no hook at its start, so the scratch
+   * memory is reset at the start of each row instead.
    */
   virtual void calc_output_pixel_slice(int8_t *Y, int8_t *X, int32_t h,
-                                       int32_t w) override;
+                                       int32_t w) override {
+    if (w == kparams->w_begin) memcpy_handler->reset_scratch(scratch_mem);
+    calc_output_pixel_slice_inline(Y, X, h, w);
+  }
 
- public:
-  Filter2D(ImageGeometry &Y, ImageRegion &r, MemCpyFn *memcpy_handler,
-           AggregateFn *aggregate_handler, OutputTransformFn *ot_handler,
-           int8_t *scratch_mem = nullptr);
+  /*
+    Reset the scratch memory before the first memcopy() of an execution, @see
+    MemCpyFn::reset_scratch().
+  */
+  void reset_scratch() { memcpy_handler->reset_scratch(scratch_mem); }
+
+  /**
+   * Compute the whole region of each of `batch_count` images with the channel
+   * groups as the outer loop, so each channel group's weights are used for
+   * every image before moving on to the next.
+   */
+  void execute_channel_group_outer(int8_t *Y, int8_t *X, int32_t batch_count,
+                                   int32_t Y_image_bytes,
+                                   int32_t X_image_bytes) {
+    int bytes_per_row =
+        kparams->output_h_mem_stride +
+        (kparams->w_end - kparams->w_begin) * kparams->output_w_mem_stride;
+
+    Y += kparams->h_begin * bytes_per_row +
+         kparams->w_begin * kparams->output_w_mem_stride;
+
+    Y += kparams->output_channel_slice_offset;
+
+    reset_scratch();
+
+    VPURingBuffer A;
+
+    for (int32_t chan_group = 0;
+         chan_group < kparams->output_channel_group_count; chan_group++) {
+      const int32_t cog = output_channel_group_offset + chan_group;
+
+      const int8_t *weights = nullptr;
+      if (weights_mem != nullptr) {
+        int32_t bytes;
+        const int8_t *src =
+            aggregate_handler->get_channel_group_weights(cog, &bytes);
+        if (bytes > 0) {
+          assert(bytes <= weights_mem_bytes);
+          vpu_memcpy_ext(weights_mem, src, bytes);
+          weights = weights_mem;
+        }
+      }
+
+      for (int32_t image = 0; image < batch_count; image++) {
+        int8_t *X_image = X + image * X_image_bytes;
+        int8_t *Y_group =
+            Y + image * Y_image_bytes + chan_group * VPU_INT8_ACC_PERIOD;
 
+        for (int32_t h = kparams->h_begin; h < kparams->h_end; h++) {
+          for (int32_t w = kparams->w_begin; w < kparams->w_end; w++) {
+            int8_t *input_img = memcopy(memcpy_handler, scratch_mem, X_image,
+                                        h, w, std::is_abstract<MemCpyT>());
+            if (weights != nullptr)
+              aggregate_sliced(aggregate_handler, &A, input_img, cog, weights,
+                               std::is_abstract<AggregateT>());
+            else
+              aggregate(aggregate_handler, &A, input_img, cog,
+                        std::is_abstract<AggregateT>());
+
+            output_transform(ot_handler, Y_group, &A, cog,
+                             std::is_abstract<OutputT>());
+            Y_group += kparams->output_w_mem_stride;
+          }
+          Y_group += kparams->output_h_mem_stride;
+        }
+      }
+    }
+  }
+
+ public:
   /**
    * Construct a filter using the provided component handlers.
    */
-  Filter2D(AbstractKernel::Params *kparams, MemCpyFn *memcpy_handler,
+  Filter2DT(AbstractKernel::Params *kparams, MemCpyT *memcpy_handler,
+            AggregateT *aggregate_handler, OutputT *ot_handler,
+            int8_t *scratch_mem = nullptr)
+      : AbstractKernel(kparams),
+        memcpy_handler(memcpy_handler),
+        aggregate_handler(aggregate_handler),
+        ot_handler(ot_handler),
+        scratch_mem(scratch_mem),
+        output_channel_group_offset(0),
+        loop_order(Filter2DLoopOrder::PixelOuter),
+        weights_mem(nullptr),
+        weights_mem_bytes(0) {}
+
+  /**
+   * Construct a filter computing part of the output of `parent`, using the
+   * same component handlers but its own scratch memory.
+   *
+   * `kparams` must describe a sub-region of `parent`'s region which starts on
+   * one of its channel group boundaries.
+   *
+   * The loop order of `parent` is kept, but not its weights buffer, which
+   * cannot be shared.
+   */
+  Filter2DT(const Filter2DT &parent, AbstractKernel::Params *kparams,
+            int8_t *scratch_mem)
+      : AbstractKernel(kparams),
+        memcpy_handler(parent.memcpy_handler),
+        aggregate_handler(parent.aggregate_handler),
+        ot_handler(parent.ot_handler),
+        scratch_mem(scratch_mem),
+        output_channel_group_offset(
+            parent.output_channel_group_offset +
+            (kparams->output_channel_slice_offset -
+             parent.kparams->output_channel_slice_offset) /
+                VPU_INT8_ACC_PERIOD),
+        loop_order(parent.loop_order),
+        weights_mem(nullptr),
+        weights_mem_bytes(0) {}
+
+  /**
+   * Execute this kernel using the output image pointed to by `Y` and input
+   * image pointed to by `X`.
+   *
+   * This behaves as `AbstractKernel::execute()`, but calls the per-pixel code
+   * directly instead of through `calc_output_pixel_slice()`, and follows the
+   * loop order chosen by `set_weights_buffer()` or set with
+   * `set_loop_order()`. Until either is called the pixels are the outer loop.
+   */
+  void execute(int8_t *Y, int8_t *X) override {
+    if (loop_order == Filter2DLoopOrder::ChannelGroupOuter) {
+      execute_channel_group_outer(Y, X, 1, 0, 0);
+      return;
+    }
+
+    int bytes_per_row =
+        kparams->output_h_mem_stride +
+        (kparams->w_end - kparams->w_begin) * kparams->output_w_mem_stride;
+
+    Y += kparams->h_begin * bytes_per_row +
+         kparams->w_begin * kparams->output_w_mem_stride;
+
+    Y += kparams->output_channel_slice_offset;
+
+    reset_scratch();
+
+    for (int32_t h = kparams->h_begin; h < kparams->h_end; h++) {
+      for (int32_t w = kparams->w_begin; w < kparams->w_end; w++) {
+        calc_output_pixel_slice_inline(Y, X, h, w);
+        Y += kparams->output_w_mem_stride;
+      }
+      Y += kparams->output_h_mem_stride;
+    }
+  }
+
+  /**
+   * Execute this kernel for a batch of `batch_count` images, the output and
+   * input images of image `i` being at `Y + i * Y_image_bytes` and
+   * `X + i * X_image_bytes`.
+   *
+   * With the channel groups as the outer loop and a weights buffer set, each
+   * channel group's weights are copied into the buffer once for the whole
+   * batch, and every image reads them from there. Without a weights buffer
+   * only the loop order changes, and the weights are read in place for each
+   * image. With the pixels as the outer loop, this is the same as executing
+   * each image in turn.
+   */
+  void execute(int8_t *Y, int8_t *X, int32_t batch_count,
+               int32_t Y_image_bytes, int32_t X_image_bytes) override {
+    if (loop_order == Filter2DLoopOrder::ChannelGroupOuter) {
+      execute_channel_group_outer(Y, X, batch_count, Y_image_bytes,
+                                  X_image_bytes);
+      return;
+    }
+
+    for (int32_t image = 0; image < batch_count; image++)
+      execute(Y + image * Y_image_bytes, X + image * X_image_bytes);
+  }
+
+  /**
+   * Get the number of bytes of scratch memory this filter requires.
+   */
+  int get_scratch_bytes() { return memcpy_handler->get_scratch_bytes(); }
+
+  /**
+   * Get the number of output channels in each channel group.
+   */
+  int get_output_channels_per_group() { return VPU_INT8_ACC_PERIOD; }
+
+  Filter2DLoopOrder get_loop_order() const { return loop_order; }
+
+  /**
+   * Set the order in which `execute()` visits the output, overriding the one
+   * chosen by `set_weights_buffer()`.
+   */
+  void set_loop_order(Filter2DLoopOrder order) { loop_order = order; }
+
+  /**
+   * Provide a word-aligned buffer of `bytes` bytes, which must be at least
+   * `get_weights_buffer_bytes()`, into which each channel group's weights are
+   * copied before use when the channel groups are the outer loop. Pass
+   * nullptr to read the weights in place.
+   *
+   * The loop order is then chosen with `choose_loop_order()`, so the channel
+   * groups become the outer loop only when copying the weights pays off. A
+   * buffer should therefore only be given when the output transform meets the
+   * requirements of `Filter2DLoopOrder::ChannelGroupOuter`.
+   *
+   * @param costs The relative costs of the memory traffic.
+   * @param batch_count The number of images per execution.
+   */
+  void set_weights_buffer(
+      int8_t *mem, int32_t bytes,
+      const Filter2DMemoryCosts &costs = Filter2DMemoryCosts::default_costs(),
+      int32_t batch_count = 1) {
+    assert(mem == nullptr || bytes >= get_weights_buffer_bytes());
+    weights_mem = mem;
+    weights_mem_bytes = bytes;
+    choose_loop_order(costs, batch_count);
+  }
+
+  /**
+   * Get the number of bytes needed to hold the weights of any one of this
+   * filter's channel groups, or zero if the aggregation has no weights.
+   */
+  int32_t get_weights_buffer_bytes() {
+    int32_t max_bytes = 0;
+    for (int32_t chan_group = 0;
+         chan_group < kparams->output_channel_group_count; chan_group++) {
+      int32_t bytes;
+      aggregate_handler->get_channel_group_weights(
+          output_channel_group_offset + chan_group, &bytes);
+      max_bytes = std::max(max_bytes, bytes);
+    }
+    return max_bytes;
+  }
+
+  /**
+   * Choose the loop order with the least memory traffic under `costs`, given
+   * whether a weights buffer has been set, and use it.
+   *
+   * With the pixels outer, every pixel reads the weights of every channel group
+   * where they are stored. With the channel groups outer and a weights buffer,
+   * each channel group's weights are copied once and read from SRAM, but each
+   * patch is written once per channel group. Without a weights buffer the
+   * channel groups are never the better choice.
+   *
+   * @param costs The relative costs of the memory traffic.
+   * @param batch_count The number of images per execution, whose pixels all
+   * share the copy of a channel group's weights.
+   * @return The loop order chosen.
+   */
+  Filter2DLoopOrder choose_loop_order(const Filter2DMemoryCosts &costs,
+                                      int32_t batch_count = 1) {
+    const int64_t pixels = (int64_t)batch_count *
+                           (kparams->h_end - kparams->h_begin) *
+                           (kparams->w_end - kparams->w_begin);
+    const int64_t groups = kparams->output_channel_group_count;
+    const int64_t patch_bytes = memcpy_handler->get_scratch_bytes();
+
+    int64_t weights_bytes = 0;
+    for (int32_t chan_group = 0; chan_group < groups; chan_group++) {
+      int32_t bytes;
+      aggregate_handler->get_channel_group_weights(
+          output_channel_group_offset + chan_group, &bytes);
+      weights_bytes += bytes;
+    }
+
+    const int64_t pixel_outer =
+        pixels * (patch_bytes * costs.patch_write +
+                  weights_bytes * costs.weights_read);
+
+    int64_t group_outer = pixels * groups * patch_bytes * costs.patch_write;
+    if (weights_mem != nullptr)
+      group_outer += weights_bytes * (costs.weights_read + costs.sram_read) +
+                     pixels * weights_bytes * costs.sram_read;
+    else
+      group_outer += pixels * weights_bytes * costs.weights_read;
+
+    loop_order = (group_outer < pixel_outer)
+                     ? Filter2DLoopOrder::ChannelGroupOuter
+                     : Filter2DLoopOrder::PixelOuter;
+    return loop_order;
+  }
+};
+
+template <class MemCpyT, class AggregateT, class OutputT>
+constexpr bool Filter2DT<MemCpyT, AggregateT, OutputT>::UsesPerGroupMemCopy;
+
+/**
+ * Base class for non-depthwise 2D filter kernels.
+ *
+ * This is the runtime-polymorphic form of `Filter2DT`: any combination of
+ * `MemCpyFn`, `AggregateFn` and `OutputTransformFn` can be supplied, and each
+ * is called through its vtable.
+ */
+class Filter2D
+    : public Filter2DT<MemCpyFn, AggregateFn, OutputTransformFn> {
+ public:
+  using Filter2DT<MemCpyFn, AggregateFn, OutputTransformFn>::Filter2DT;
+
+  Filter2D(ImageGeometry &Y, ImageRegion &r, MemCpyFn *memcpy_handler,
            AggregateFn *aggregate_handler, OutputTransformFn *ot_handler,
            int8_t *scratch_mem = nullptr);
 };
@@ -118,6 +560,12 @@ class Filter2D_DW : public AbstractKernel {
    */
   int8_t *scratch_mem;
 
+  /**
+   * The index of the first channel group of this filter as seen by the
+   * aggregation and output transform handlers.
+   */
+  int32_t output_channel_group_offset;
+
  protected:
   /**
    * Process a single output pixel (subject to the region constraints given by
@@ -136,6 +584,312 @@ class Filter2D_DW : public AbstractKernel {
               AggregateFn *aggregate_handler, OutputTransformFn *ot_handler,
               int8_t *scratch_mem = nullptr,
               int output_channels_per_group = VPU_INT8_ACC_PERIOD);
+
+  /**
+   * Construct a filter computing part of the output of `parent`, using the
+   * same component handlers but its own scratch memory.
+   *
+   * `kparams` must describe a sub-region of `parent`'s region which starts on
+   * one of its channel group boundaries.
+   */
+  Filter2D_DW(const Filter2D_DW &parent, AbstractKernel::Params *kparams,
+              int8_t *scratch_mem);
+
+  /**
+   * Get the number of bytes of scratch memory this filter requires.
+   */
+  int get_scratch_bytes() { return memcpy_handler->get_scratch_bytes(); }
+
+  /**
+   * Get the number of output channels in each channel group.
+   */
+  int get_output_channels_per_group() { return output_channels_per_group; }
+};
+
+/**
+ * Non-depthwise 2D filter kernel fused with a 2x2, stride 2 max or average
+ * pool.
+ *
+ * `kparams` describes the region of the pooled output image. For each pooled
+ * output pixel the 2x2 block of filter outputs it covers is computed with the
+ * component handlers, which are set up exactly as for a `Filter2D` producing
+ * the unpooled image, and reduced before anything is written. The unpooled
+ * image is never materialized.
+ *
+ * The reduction is applied to the int8 outputs of the output transform and
+ * matches `maxpool2d()` and `avgpool2d_2x2()` respectively: for `Avg` each
+ * output is `(a + b + c + d + 2) >> 2`.
+ *
+ * Each of the 4 patches is copied into its own part of the scratch memory, so
+ * `get_scratch_bytes()` is 4 times that of the equivalent `Filter2D`.
+ */
+class Filter2D_Pool2x2 : public AbstractKernel {
+ public:
+  static constexpr bool UsesPerGroupMemCopy = false;
+
+  /**
+   * The pooling applied to each 2x2 block of filter outputs.
+   */
+  enum class PoolType { Max, Avg };
+
+ private:
+  MemCpyFn *memcpy_handler;
+  AggregateFn *aggregate_handler;
+  OutputTransformFn *ot_handler;
+  PoolType pool_type;
+
+  /**
+   * A pointer to a scratch memory buffer of `get_scratch_bytes()` bytes.
+   */
+  int8_t *scratch_mem;
+
+  /**
+   * The index of the first channel group of this filter as seen by the
+   * aggregation and output transform handlers.
+   */
+  int32_t output_channel_group_offset;
+
+  /**
+   * The word aligned size of each patch in the scratch memory.
+   */
+  int get_patch_bytes() {
+    return (memcpy_handler->get_scratch_bytes() + 3) & ~3;
+  }
+
+ protected:
+  /**
+   * Process a single pooled output pixel (subject to the region constraints
+   * given by `kparams`)
+   */
+  virtual void calc_output_pixel_slice(int8_t *Y, int8_t *X, int32_t h,
+                                       int32_t w) override;
+
+ public:
+  /**
+   * Construct a filter using the provided component handlers.
+   */
+  Filter2D_Pool2x2(AbstractKernel::Params *kparams, MemCpyFn *memcpy_handler,
+                   AggregateFn *aggregate_handler,
+                   OutputTransformFn *ot_handler, PoolType pool_type,
+                   int8_t *scratch_mem = nullptr);
+
+  /**
+   * Construct a filter computing part of the output of `parent`, using the
+   * same component handlers but its own scratch memory.
+   *
+   * `kparams` must describe a sub-region of `parent`'s region which starts on
+   * one of its channel group boundaries.
+   */
+  Filter2D_Pool2x2(const Filter2D_Pool2x2 &parent,
+                   AbstractKernel::Params *kparams, int8_t *scratch_mem);
+
+  /**
+   * Get the number of bytes of scratch memory this filter requires.
+   */
+  int get_scratch_bytes() { return 4 * get_patch_bytes(); }
+
+  /**
+   * Get the number of output channels in each channel group.
+   */
+  int get_output_channels_per_group() { return VPU_INT8_ACC_PERIOD; }
+};
+
+/**
+ * Depthwise 2D filter kernel fused with a following pointwise (1x1) filter, as
+ * in a depthwise-separable convolution.
+ *
+ * For each output pixel, every channel group of the depthwise filter is
+ * computed with the depthwise handlers, which are set up exactly as for a
+ * `Filter2D_DW` producing the intermediate image, into a vector in the scratch
+ * memory. The pointwise aggregation handler (e.g. a `MatMulInt8` with
+ * `depthwise_channels` bytes per kernel channel) then reads that vector as its
+ * patch, and the pointwise output transform writes the output image. The
+ * intermediate image is never materialized.
+ *
+ * `kparams` describes the region of the output image. The depthwise output
+ * of a pixel is recomputed for each channel slice of the pointwise output, so
+ * splitting a filter by channel group duplicates that work.
+ */
+class Filter2D_DWPW : public AbstractKernel {
+ public:
+  static constexpr bool UsesPerGroupMemCopy = false;
+
+ private:
+  MemCpyFn *dw_memcpy_handler;
+  AggregateFn *dw_aggregate_handler;
+  OutputTransformFn *dw_ot_handler;
+
+  AggregateFn *pw_aggregate_handler;
+  OutputTransformFn *pw_ot_handler;
+
+  /**
+   * The number of channels of the intermediate image.
+   */
+  int32_t depthwise_channels;
+
+  /**
+   * A pointer to a scratch memory buffer of `get_scratch_bytes()` bytes.
+   */
+  int8_t *scratch_mem;
+
+  /**
+   * The index of the first channel group of this filter as seen by the
+   * pointwise aggregation and output transform handlers.
+   */
+  int32_t output_channel_group_offset;
+
+  /**
+   * The word aligned size of the depthwise patch in the scratch memory.
+   */
+  int get_patch_bytes() {
+    return (dw_memcpy_handler->get_scratch_bytes() + 3) & ~3;
+  }
+
+ protected:
+  /**
+   * Process a single output pixel (subject to the region constraints given by
+   * `kparams`)
+   */
+  virtual void calc_output_pixel_slice(int8_t *Y, int8_t *X, int32_t h,
+                                       int32_t w) override;
+
+ public:
+  /**
+   * Construct a filter using the provided component handlers.
+   *
+   * @param kparams The region of the output image to compute.
+   * @param dw_memcpy_handler The depthwise patch handler.
+   * @param dw_aggregate_handler The depthwise aggregation handler.
+   * @param dw_ot_handler The depthwise output transform handler.
+   * @param depthwise_channels The number of channels of the intermediate image.
+   * @param pw_aggregate_handler The pointwise aggregation handler.
+   * @param pw_ot_handler The pointwise output transform handler.
+   * @param scratch_mem A word-aligned scratch buffer of `get_scratch_bytes()`
+   * bytes.
+   */
+  Filter2D_DWPW(AbstractKernel::Params *kparams, MemCpyFn *dw_memcpy_handler,
+                AggregateFn *dw_aggregate_handler,
+                OutputTransformFn *dw_ot_handler, int32_t depthwise_channels,
+                AggregateFn *pw_aggregate_handler,
+                OutputTransformFn *pw_ot_handler,
+                int8_t *scratch_mem = nullptr);
+
+  /**
+   * Construct a filter computing part of the output of `parent`, using the
+   * same component handlers but its own scratch memory.
+   *
+   * `kparams` must describe a sub-region of `parent`'s region which starts on
+   * one of its channel group boundaries.
+   */
+  Filter2D_DWPW(const Filter2D_DWPW &parent, AbstractKernel::Params *kparams,
+                int8_t *scratch_mem);
+
+  /**
+   * Get the number of bytes of scratch memory this filter requires: the
+   * depthwise patch, followed by the intermediate vector padded for the
+   * pointwise aggregation's final vector load.
+   */
+  int get_scratch_bytes() {
+    const int vector_bytes =
+        ((depthwise_channels + VPU_INT8_ACC_PERIOD - 1) &
+         ~(VPU_INT8_ACC_PERIOD - 1)) +
+        XS3_VPU_VREG_WIDTH_BYTES;
+    return get_patch_bytes() + vector_bytes;
+  }
+
+  /**
+   * Get the number of output channels in each channel group.
+   */
+  int get_output_channels_per_group() { return VPU_INT8_ACC_PERIOD; }
+};
+
+/**
+ * 3x3, stride 1 2D filter kernel computed with Winograd F(2x2, 3x3).
+ *
+ * Each call to `calc_output_pixel_slice()` computes a tile of 2x2 output
+ * pixels, so `kparams` describes a region of the _tile_ grid, with the output
+ * strides of whole tiles; use `get_tile_params()` to construct it from a
+ * region of the output image. Tiles extending past the bottom or right edge of
+ * the output image are clipped.
+ *
+ * The accumulators are identical to those of the direct convolution, so the
+ * output transform handler is set up exactly as for a `Filter2D` producing the
+ * same image.
+ *
+ * @see WinogradF2x3
+ */
+class Filter2D_Winograd : public AbstractKernel {
+ public:
+  static constexpr bool UsesPerGroupMemCopy = false;
+
+ private:
+  WinogradInputTransform *input_handler;
+  MatMulWinograd *aggregate_handler;
+  OutputTransformFn *ot_handler;
+
+  /**
+   * A pointer to a scratch memory buffer of `get_scratch_bytes()` bytes.
+   */
+  int8_t *scratch_mem;
+
+  /**
+   * The index of the first channel group of this filter as seen by the
+   * aggregation and output transform handlers.
+   */
+  int32_t output_channel_group_offset;
+
+  int32_t output_height;
+  int32_t output_width;
+  int32_t output_row_bytes;
+  int32_t output_pixel_bytes;
+
+ protected:
+  /**
+   * Process a single tile of output pixels (subject to the region constraints
+   * given by `kparams`)
+   */
+  virtual void calc_output_pixel_slice(int8_t *Y, int8_t *X, int32_t h,
+                                       int32_t w) override;
+
+ public:
+  /**
+   * Construct a filter writing to `output_image` using the provided component
+   * handlers.
+   */
+  Filter2D_Winograd(const ImageGeometry &output_image,
+                    AbstractKernel::Params *kparams,
+                    WinogradInputTransform *input_handler,
+                    MatMulWinograd *aggregate_handler,
+                    OutputTransformFn *ot_handler,
+                    int8_t *scratch_mem = nullptr);
+
+  /**
+   * Construct a filter computing part of the output of `parent`, using the
+   * same component handlers but its own scratch memory.
+   *
+   * `kparams` must describe a sub-region of `parent`'s region which starts on
+   * one of its channel group boundaries.
+   */
+  Filter2D_Winograd(const Filter2D_Winograd &parent,
+                    AbstractKernel::Params *kparams, int8_t *scratch_mem);
+
+  /**
+   * Get the kernel parameters for the tiles covering `output_region` of
+   * `output_image`. The region must start on an even row and column, and
+   * end on one or at the edge of the image.
+   */
+  static AbstractKernel::Params get_tile_params(
+      const ImageGeometry &output_image, const ImageRegion &output_region);
+
+  /**
+   * Get the number of bytes of scratch memory this filter requires.
+   */
+  int get_scratch_bytes() { return input_handler->get_scratch_bytes(); }
+
+  /**
+   * Get the number of output channels in each channel group.
+   */
+  int get_output_channels_per_group() { return VPU_INT8_ACC_PERIOD; }
 };
 
 }  // namespace nn
@@ -0,0 +1,155 @@
+#ifndef LIB_NN_INTERIOR_BORDER_PLANNER_HPP_
+#define LIB_NN_INTERIOR_BORDER_PLANNER_HPP_
+
+#include <memory>
+#include <vector>
+
+#include "Filter2D.hpp"
+
+namespace nn {
+
+/**
+ * The patch handler used for the interior of a padded filter's output.
+ */
+enum class InteriorCopy {
+  /** `DerefInputFn`, with an aggregation handler such as `MatMulDirectFn` */
+  Deref,
+  /** `ImToColValid`, with an aggregation handler such as `MatMulInt8` */
+  ImToColValid,
+};
+
+/**
+ * Plans the execution of a padded dense filter as an interior region, whose
+ * windows lie entirely within the input image, and border strips around it
+ * whose windows reach into the padding.
+ *
+ * Only the border strips are computed with `ImToColPadded`, so the interior
+ * pixels don't pay for its per-pixel bounds checks. The valid-only patch
+ * handlers ignore the window's start, so the interior is executed as its own
+ * image with the input and output pointers advanced to its first pixel.
+ *
+ * The planner owns the patch handlers and the kernels it creates. The
+ * aggregation and output transform handlers are given by the caller, and the
+ * border aggregation handler must consume `ImToColPadded` patches.
+ */
+class InteriorBorderPlanner {
+ public:
+  /**
+   * The interior region of a filter's output and the border strips around it.
+   */
+  struct Regions {
+    /**
+     * The output pixels whose windows lie entirely within the input image.
+     * Empty if there are none.
+     */
+    ImageRegion interior;
+
+    /**
+     * The remaining output pixels, as the strips above, to the left of, to the
+     * right of and below the interior, omitting empty strips. If there is no
+     * interior, this is the whole output image.
+     */
+    std::vector<ImageRegion> border;
+
+    Regions(const ImageRegion &interior) : interior(interior) {}
+  };
+
+  /**
+   * A ready-to-execute kernel computing one region of the output.
+   */
+  struct Kernel {
+    /**
+     * The region of the output image computed by `filter`.
+     */
+    ImageRegion region;
+
+    /**
+     * Whether `filter` copies its patches with `ImToColPadded`.
+     */
+    bool padded;
+
+    /**
+     * The bytes by which the output and input image pointers are advanced
+     * before being given to `filter`.
+     */
+    int32_t output_offset;
+    int32_t input_offset;
+
+    Filter2D *filter;
+
+    void execute(int8_t *Y, int8_t *X) {
+      filter->execute(Y + output_offset, X + input_offset);
+    }
+  };
+
+ private:
+  std::unique_ptr<DerefInputFn::Params> deref_params;
+  std::unique_ptr<ImToColValid::Params> valid_params;
+  std::unique_ptr<ImToColPadded::Params> padded_params;
+  // MemCpyFn has no virtual destructor, so the handlers are held by type
+  std::unique_ptr<DerefInputFn> deref_memcpy;
+  std::unique_ptr<ImToColValid> valid_memcpy;
+  std::unique_ptr<ImToColPadded> border_memcpy;
+
+  std::vector<std::unique_ptr<AbstractKernel::Params>> kparams;
+  std::vector<std::unique_ptr<Filter2D>> filters;
+  std::vector<Kernel> kernels;
+
+  void add_kernel(const ImageGeometry &Y, const ImageRegion &region,
+                  const ImageRegion &output_region, bool padded,
+                  int32_t output_offset, int32_t input_offset,
+                  MemCpyFn *memcpy_handler, AggregateFn *aggregate_handler,
+                  OutputTransformFn *ot_handler, int8_t *scratch_mem);
+
+ public:
+  /**
+   * Split the output of `filter` into its interior and border strips, using
+   * the padding of the window at each output row and column.
+   */
+  static Regions split(const Filter2dGeometry &filter);
+
+  /**
+   * @brief Construct the kernels computing the output of a dense filter.
+   *
+   * @param filter The geometry of the filter.
+   * @param padding_value The value of the input image's padding.
+   * @param interior_copy The patch handler to use for the interior. `Deref`
+   * requires a multiple of 32 input channels, and `MatMulDirectFn` a multiple
+   * of 16 output channels.
+   * @param interior_aggregate_handler The aggregation handler of the interior,
+   * consuming the patches of `interior_copy`.
+   * @param border_aggregate_handler The aggregation handler of the border
+   * strips, consuming `ImToColPadded` patches.
+   * @param ot_handler The output transform handler of every region.
+   * @param scratch_mem A word-aligned scratch buffer of `get_scratch_bytes()`
+   * bytes, shared by the kernels. May be null to only query that size.
+   */
+  InteriorBorderPlanner(const Filter2dGeometry &filter, int8_t padding_value,
+                        InteriorCopy interior_copy,
+                        AggregateFn *interior_aggregate_handler,
+                        AggregateFn *border_aggregate_handler,
+                        OutputTransformFn *ot_handler,
+                        int8_t *scratch_mem = nullptr);
+
+  InteriorBorderPlanner(const InteriorBorderPlanner &) = delete;
+  InteriorBorderPlanner &operator=(const InteriorBorderPlanner &) = delete;
+
+  /**
+   * Get the kernels, whose regions together cover the output image once.
+   */
+  std::vector<Kernel> &get_kernels() { return kernels; }
+
+  /**
+   * Get the bytes of scratch memory needed by the kernels.
+   */
+  int get_scratch_bytes();
+
+  /**
+   * Execute every kernel with the output image `Y` and the input image `X`.
+   */
+  void execute(int8_t *Y, int8_t *X);
+};
+
+}  // namespace nn
+
+#endif  // LIB_NN_INTERIOR_BORDER_PLANNER_HPP_
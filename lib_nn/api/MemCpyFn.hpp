@@ -1,6 +1,9 @@
 #ifndef LIB_NN_MEMCPY_FN_HPP_
 #define LIB_NN_MEMCPY_FN_HPP_
 
+#include <array>
+#include <vector>
+
 #include "geom/Filter2dGeometry.hpp"
 
 namespace nn {
@@ -60,6 +63,20 @@ class MemCpyFn {
    * @return int
    */
   virtual int get_overread_bytes() = 0;
+
+  /**
+   * @brief Prepare the scratch memory `T` for a sequence of `memcopy_fn()`
+   * calls. Filters call this before the first `memcopy_fn()` of each
+   * execution, or of each row of their region.
+   *
+   * Most handlers keep no state in the scratch memory and do nothing. A
+   * handler which does, e.g. `ImToColSliding`, must not assume anything about
+   * the contents of the scratch memory before it has been reset, as it may be
+   * uninitialised or have been used by another kernel sharing the same arena.
+   *
+   * @param [inout] T   pointer to patch buffer
+   */
+  virtual void reset_scratch(int8_t *T) {}
 };
 
 /**
@@ -108,11 +125,14 @@ class DerefInputFn : public MemCpyFn {
    * @brief This describes the region over which this class will perform its
    * operation(Memcopy).
    */
-  Params *params;
+  const Params *params;
 
  public:
-  DerefInputFn(Params *params) : params(params){};
-  int8_t *memcopy_fn(int8_t *T, int8_t *X, int32_t h, int32_t w, int32_t c);
+  DerefInputFn(const Params *params) : params(params){};
+  int8_t *memcopy_fn(int8_t *T, int8_t *X, int32_t h, int32_t w, int32_t c) {
+    return X + (int)(h * params->bytes_per_h_line +
+                     w * params->bytes_per_pixel + c);
+  }
   int get_scratch_bytes();
   int get_overread_bytes();
 };
@@ -192,10 +212,10 @@ class ImToColPadded : public MemCpyFn {
    * @brief This describes the region over which this class will perform its
    * operation(Memcopy).
    */
-  Params *params;
+  const Params *params;
 
  public:
-  ImToColPadded(Params *p) : params(p) {}
+  ImToColPadded(const Params *p) : params(p) {}
   int8_t *memcopy_fn(int8_t *T, int8_t *X, int32_t h, int32_t w, int32_t c);
   int get_scratch_bytes();
   int get_overread_bytes();
@@ -205,6 +225,50 @@ class ImToColPadded : public MemCpyFn {
                           int32_t c);
 };
 
+/**
+ * Patch handler for int16 input images, otherwise as `ImToColPadded`.
+ *
+ * The input image must have a `channel_depth` of 2, and the patch is made of
+ * int16 elements, with padding written as `padding_value` rather than a byte.
+ * A `VPU_INT16_EPV` element vector of zeros follows the patch.
+ *
+ * @see MatMulInt16x8
+ */
+class ImToColPaddedInt16 : public MemCpyFn {
+ public:
+  class Params : public ImToColPadded::Params {
+   public:
+    /**
+     * @brief Construct a new Params object
+     *
+     * @param X Class describing the properties of the int16 input tensor.
+     * @param K Class describing the properties of the convolution to be
+     * performed.
+     * @param padding Struct describing the padding to be applied during the
+     * copy.
+     * @param input_ch_per_output The count of input channels that contribute
+     * to an output channel.
+     * @param padding_value The value to insert for the padding.
+     */
+    Params(const ImageGeometry &X, const WindowGeometry &K,
+           const padding_t &padding, const int input_ch_per_output,
+           const int16_t padding_value);
+  };
+
+ private:
+  /**
+   * @brief This describes the region over which this class will perform its
+   * operation(Memcopy).
+   */
+  const Params *params;
+
+ public:
+  ImToColPaddedInt16(const Params *p) : params(p) {}
+  int8_t *memcopy_fn(int8_t *T, int8_t *X, int32_t h, int32_t w, int32_t c);
+  int get_scratch_bytes();
+  int get_overread_bytes();
+};
+
 class ImToColValid : public MemCpyFn {
  public:
   struct Params {
@@ -271,12 +335,12 @@ class ImToColValid : public MemCpyFn {
    * @brief This describes the region over which this class will perform its
    * operation(Memcopy).
    */
-  Params *params;
+  const Params *params;
 
  public:
   // input_ch_per_output lets the kernel know how many input channels to copy to
   // scratch
-  ImToColValid(Params *params) : params(params){};
+  ImToColValid(const Params *params) : params(params){};
 
   int get_scratch_bytes();
   int get_overread_bytes();
@@ -287,5 +351,140 @@ class ImToColValid : public MemCpyFn {
   int8_t *memcopy_fn_impl(int8_t *T, int8_t *X, int32_t h, int32_t w,
                           int32_t c);
 };
+
+/**
+ * Patch handler for dense filters which, when consecutive output pixels of a
+ * row are processed, only copies the column of the input image newly exposed
+ * by the window rather than the whole patch.
+ *
+ * The patch is laid out column major, i.e. as `[kernel_width][kernel_height]
+ * [input_channels]`, so that the columns of a window are contiguous in the
+ * scratch buffer. The weights must be in the same order, @see
+ * transpose_kernel_weights().
+ *
+ * The scratch buffer holds a small header followed by `window_count` windows
+ * worth of columns. Each window starts one column after the previous one, and
+ * when the buffer is exhausted the columns still in use are moved back to its
+ * start. The header records the last pixel copied, so the state belongs to
+ * the scratch buffer rather than this class and one handler may be shared by
+ * filters running on different threads, each with its own scratch buffer.
+ *
+ * The header must be initialised with `reset_scratch()` before the first call
+ * of `memcopy_fn()` on a scratch buffer, and again whenever the buffer may
+ * have been written by anything else. The filters do this at the start of
+ * each execution or row. Otherwise stale state could match the next pixel, and
+ * columns of a previous image be used in its patch.
+ *
+ * A column is only reused if `memcopy_fn()` is called for the pixel to the
+ * right of the previous call with the same image and channel, and the state is
+ * dropped after the final column of the output image. Filters must therefore
+ * process whole output rows from left to right, as `AbstractKernel::execute()`
+ * does, for the input image to be allowed to change between calls.
+ *
+ * Windows with a horizontal stride or dilation other than 1 do not overlap
+ * column-wise, in which case the whole patch is always copied.
+ */
+class ImToColSliding : public MemCpyFn {
+ public:
+  struct Params {
+    int32_t kernel_height;
+    int32_t kernel_width;
+
+    int32_t input_v_length;
+    int32_t input_h_length;
+
+    int32_t vertical_stride;
+    int32_t horizontal_stride;
+    int32_t vertical_dilation;
+    int32_t horizontal_dilation;
+
+    int32_t padding_top;
+    int32_t padding_left;
+    int32_t padding_val;
+
+    int32_t bytes_per_h_line;
+    int32_t bytes_per_pixel;
+
+    /**
+     * Bytes copied from each input pixel.
+     */
+    int32_t bytes_per_copy_per_channel;
+
+    /**
+     * Bytes of a column of the patch, i.e. `kernel_height` pixels.
+     */
+    int32_t bytes_per_column;
+
+    /**
+     * Columns the scratch buffer holds.
+     */
+    int32_t buffer_columns;
+
+    /**
+     * Width of the output image. The sliding state is dropped after its final
+     * column.
+     */
+    int32_t output_width;
+
+    /**
+     * Whether consecutive windows of a row share `kernel_width - 1` columns.
+     */
+    int32_t slides;
+
+    /**
+     * @brief Construct a new Params object
+     *
+     * @param filter_geometry Class representing the properties of the input
+     * tensor and convolution properties over which the convolution will be
+     * performed. The filter must be dense.
+     * @param padding_value The value to insert for the padding.
+     * @param window_count The number of windows the scratch buffer holds, at
+     * least 2. The columns of a window are moved to the start of the buffer
+     * once every `(window_count - 1) * kernel_width + 1` pixels.
+     */
+    Params(const Filter2dGeometry &filter_geometry, const int8_t padding_value,
+           const int window_count = 4);
+  };
+
+ private:
+  /**
+   * @brief This describes the region over which this class will perform its
+   * operation(Memcopy).
+   */
+  const Params *params;
+
+ public:
+  ImToColSliding(const Params *params) : params(params) {}
+  int8_t *memcopy_fn(int8_t *T, int8_t *X, int32_t h, int32_t w, int32_t c);
+  int get_scratch_bytes();
+  int get_overread_bytes();
+
+  /**
+   * Drop the sliding state of scratch buffer `T`, so that the next call of
+   * `memcopy_fn()` copies the whole patch.
+   */
+  void reset_scratch(int8_t *T);
+
+  /**
+   * @brief Transpose the kernel window of each output channel of a weights
+   * tensor from `[height][width][channels]` to `[width][height][channels]`,
+   * the order of the patches produced by this class.
+   *
+   * The result is in the layout of a tensor with shape `[output_channels,
+   * kernel_width, kernel_height, input_channels]`, and is reordered for the
+   * aggregation handler as such, e.g. by
+   * `MatMulInt8::reorder_kernel_weights()`.
+   *
+   * @param raw_weights The weights, with shape `shape`.
+   * @param shape The shape of `raw_weights`, i.e. `[output_channels,
+   * kernel_height, kernel_width, input_channels]`.
+   */
+  static std::vector<int8_t> transpose_kernel_weights(
+      const int8_t *raw_weights, const std::array<int, 4> &shape);
+
+ private:
+  void copy_column(int8_t *T, int8_t *X, int32_t h, int32_t input_h_coord,
+                   int32_t c);
+};
 }  // namespace nn
 #endif  // LIB_NN_MEMCPY_FN_HPP_
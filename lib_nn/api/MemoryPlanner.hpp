@@ -0,0 +1,162 @@
+#ifndef LIB_NN_MEMORY_PLANNER_HPP_
+#define LIB_NN_MEMORY_PLANNER_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include "MemCpyFn.hpp"
+#include "geom/ImageGeometry.hpp"
+#include "xs3_vpu.h"
+
+namespace nn {
+
+/**
+ * Static planner for the memory used by a graph of lib_nn operators.
+ *
+ * The graph is described by adding tensors (activations) and then operators,
+ * in the order in which the operators will be executed. Each operator reads
+ * some tensors, writes others and may need scratch memory for the duration of
+ * its execution (e.g. the patch buffer of a `Filter2D`, or the `data_scratch`
+ * of `bconv2d_bin`).
+ *
+ * `plan()` then places every tensor and scratch buffer in a single arena.
+ * Buffers whose lifetimes do not overlap may share memory, so the arena is
+ * usually much smaller than the sum of the buffers.
+ *
+ * A tensor is live from the operator which writes it (or from the first
+ * operator, if it is a graph input) until the last operator which reads it (or
+ * the last operator, if it was passed to `mark_output()`). A scratch buffer is
+ * live only during its operator. The inputs and outputs of an operator are
+ * never placed in the same memory; in-place operation is not planned for.
+ *
+ * Every buffer begins on an `Alignment` byte boundary, as required by the VPU's
+ * vector loads and stores.
+ */
+class MemoryPlanner {
+ public:
+  /**
+   * Identifies a tensor added to the planner.
+   */
+  typedef int TensorId;
+
+  /**
+   * Alignment, in bytes, of every buffer in the arena.
+   */
+  static constexpr int Alignment = XS3_VPU_VREG_WIDTH_BYTES;
+
+  /**
+   * The result of planning: the offset of every buffer from the base of the
+   * arena.
+   */
+  struct Plan {
+    /**
+     * The number of bytes required for the arena. The arena itself must be
+     * `Alignment` byte aligned.
+     */
+    int arena_bytes;
+
+    /**
+     * The offset of each tensor, indexed by `TensorId`.
+     */
+    std::vector<int> tensor_offsets;
+
+    /**
+     * The offset of the scratch buffer of each operator, indexed by the value
+     * returned from `add_op()`. This is -1 for operators without scratch.
+     */
+    std::vector<int> scratch_offsets;
+
+    /**
+     * Get the address of `tensor` within `arena`.
+     */
+    int8_t *tensor(int8_t *arena, TensorId tensor) const {
+      return arena + tensor_offsets[tensor];
+    }
+
+    /**
+     * Get the address of the scratch memory of operator `op` within `arena`,
+     * or `nullptr` if the operator has no scratch.
+     */
+    int8_t *scratch(int8_t *arena, int op) const {
+      return (scratch_offsets[op] < 0) ? nullptr : arena + scratch_offsets[op];
+    }
+  };
+
+ private:
+  struct Tensor {
+    int bytes;
+    // The largest overread by any operator reading this tensor
+    int overread_bytes;
+    int producer;
+    int last_consumer;
+    bool is_output;
+  };
+
+  struct Op {
+    int scratch_bytes;
+  };
+
+  std::vector<Tensor> tensors;
+  std::vector<Op> ops;
+
+ public:
+  /**
+   * Add a tensor of `bytes` bytes.
+   */
+  TensorId add_tensor(int bytes);
+
+  /**
+   * Add a tensor holding an image with the given geometry.
+   */
+  TensorId add_tensor(const ImageGeometry &geometry) {
+    return add_tensor(geometry.ImageBytes());
+  }
+
+  /**
+   * Keep `tensor` live until the end of the graph.
+   */
+  void mark_output(TensorId tensor);
+
+  /**
+   * Add an operator which reads `inputs` and writes `outputs`. Operators must
+   * be added in execution order, and each tensor may be written by only one
+   * operator.
+   *
+   * `overread_bytes` is the number of bytes the operator may read beyond the
+   * end of each of its inputs. These bytes must lie within the arena, but
+   * their contents are never used, so they may be shared with other live
+   * buffers.
+   *
+   * @return The index of the operator, used to find its scratch memory in the
+   * `Plan`.
+   */
+  int add_op(const std::vector<TensorId> &inputs,
+             const std::vector<TensorId> &outputs, int scratch_bytes = 0,
+             int overread_bytes = 0);
+
+  /**
+   * Add an operator built around the patch handler `memcpy_handler`, e.g. a
+   * `Filter2D`, taking its scratch and overread requirements from the handler.
+   */
+  int add_op(MemCpyFn *memcpy_handler, TensorId input, TensorId output) {
+    return add_op({input}, {output}, memcpy_handler->get_scratch_bytes(),
+                  memcpy_handler->get_overread_bytes());
+  }
+
+  /**
+   * The arena size which would be needed if no buffers shared memory.
+   */
+  int get_unshared_bytes() const;
+
+  /**
+   * Place every tensor and scratch buffer in the arena.
+   *
+   * Buffers are placed largest first, each at the lowest aligned offset which
+   * does not collide with an already placed buffer of overlapping lifetime.
+   */
+  Plan plan() const;
+};
+
+}  // namespace nn
+
+#endif  // LIB_NN_MEMORY_PLANNER_HPP_
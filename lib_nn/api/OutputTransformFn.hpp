@@ -6,6 +6,7 @@
 
 #include "Utils.hpp"
 #include "geom/ImageGeometry.hpp"
+#include "nn_operator.h"
 #include "vpu.hpp"
 
 namespace nn {
@@ -34,6 +35,15 @@ class OutputTransformFn {
    */
   virtual int8_t *output_transform_fn(int8_t *Y, VPURingBuffer *A,
                                       int32_t output_channel_group) = 0;
+
+  /**
+   * @brief Whether `Y` must point into the output image given to the owning
+   * kernel, because the transform uses its position within that image.
+   *
+   * Kernels which pass the transform a buffer of their own, and write the
+   * output image from it, assert that this is false.
+   */
+  virtual bool requires_output_image() const { return false; }
 };
 
 /**
@@ -181,6 +191,243 @@ class OT_int8 : public OutputTransformFnInt8 {
           multipliers(multipliers) {}
   };
 
+ private:
+  /**
+   * @brief This describes the channels over which this class will perform its
+   * operation(OutputTransform) and how each channel will transformed.
+   */
+  const Params *params;
+
+ public:
+  OT_int8(const Params *params) : params(params){};
+
+  int8_t *output_transform_fn(int8_t *Y, VPURingBuffer *A,
+                              int32_t output_channel_group);
+};
+
+/**
+ * @brief Output transform fusing an int8 output transform with the residual add
+ * of a ResNet-style block.
+ *
+ * Each output is first computed as `OT_int8` would, then added to the
+ * corresponding element of the residual image exactly as `add_elementwise()`
+ * would with the output of `OT_int8` as `X0` and the residual image as `X1`.
+ * The result is identical to running the convolution and then
+ * `add_elementwise()`, but the convolution's output never has to be written to
+ * and read back from memory.
+ *
+ * The residual image must have the same geometry as the output image.
+ * `set_images()` tells the transform where both images are, and must be called
+ * before the owning filter is executed. The residual image may be the output
+ * image, in which case the add is done in place.
+ *
+ * The element of the residual image read is found from the position of `Y`
+ * within the output image, so the owning filter must write the output image
+ * directly. `Filter2D_Pool2x2` and the depthwise stage of `Filter2D_DWPW`,
+ * which do not, reject this transform. When a batch is executed, the residual
+ * images must follow `R` at the same stride as the output images follow `Y`.
+ *
+ * As `add_elementwise()` reads whole vectors, up to `XS3_VPU_VREG_WIDTH_BYTES`
+ * bytes beyond the end of the residual image may be read, and each pixel of
+ * the residual image must be word aligned.
+ */
+class OT_int8_residual : public OutputTransformFnInt8 {
+ public:
+  struct Params {
+    /**
+     * Parameters of the int8 output transform applied to the accumulators.
+     */
+    const OT_int8::Params *ot_params;
+
+    /**
+     * Parameters of the residual add.
+     */
+    const nn_add_params_t *add_params;
+
+    /**
+     * @brief Construct a new Params object
+     *
+     * @param ot_params Pointer to the parameters of the int8 output transform.
+     * @param add_params Pointer to the parameters of the residual add. The
+     * output of the int8 output transform is the add's first input.
+     */
+    Params(const OT_int8::Params *ot_params, const nn_add_params_t *add_params)
+        : ot_params(ot_params), add_params(add_params) {}
+  };
+
+ private:
+  /**
+   * @brief This describes the channels over which this class will perform its
+   * operation(OutputTransform) and how each channel will transformed.
+   */
+  const Params *params;
+
+  OT_int8 ot;
+
+  /**
+   * The output and residual images of the current execution.
+   */
+  const int8_t *Y_base;
+  const int8_t *R_base;
+
+ public:
+  OT_int8_residual(const Params *params)
+      : params(params),
+        ot(params->ot_params),
+        Y_base(nullptr),
+        R_base(nullptr){};
+
+  /**
+   * @brief Set the output image `Y` which the filter will write and the
+   * residual image `R` which is to be added to it.
+   */
+  void set_images(const int8_t *Y, const int8_t *R) {
+    Y_base = Y;
+    R_base = R;
+  }
+
+  int8_t *output_transform_fn(int8_t *Y, VPURingBuffer *A,
+                              int32_t output_channel_group);
+
+  bool requires_output_image() const { return true; }
+};
+
+/**
+ * @brief Output transform fusing an int8 output transform with a nonlinear
+ * activation given as a lookup table, such as sigmoid, tanh, hard-swish or
+ * GELU.
+ *
+ * Each output is first computed as `OT_int8` would, then replaced by the entry
+ * of the 256-entry table indexed by its bit pattern, exactly as `lookup8()`
+ * would. The result is identical to running the convolution and then
+ * `lookup8()` over its output, without the output being written to and read
+ * back from memory by a separate pass.
+ *
+ * `make_table()` builds the table of a quantised activation function.
+ */
+class OT_int8_lut : public OutputTransformFnInt8 {
+ public:
+  struct Params {
+    /**
+     * Parameters of the int8 output transform applied to the accumulators.
+     */
+    const OT_int8::Params *ot_params;
+
+    /**
+     * The 256-entry table, indexed by the output of the int8 output transform
+     * reinterpreted as a `uint8_t`.
+     */
+    const int8_t *lut;
+
+    /**
+     * @brief Construct a new Params object
+     *
+     * @param ot_params Pointer to the parameters of the int8 output transform.
+     * @param lut Pointer to the 256-entry table.
+     */
+    Params(const OT_int8::Params *ot_params, const int8_t *lut)
+        : ot_params(ot_params), lut(lut) {}
+  };
+
+ private:
+  /**
+   * @brief This describes the channels over which this class will perform its
+   * operation(OutputTransform) and how each channel will transformed.
+   */
+  const Params *params;
+
+  OT_int8 ot;
+
+ public:
+  OT_int8_lut(const Params *params) : params(params), ot(params->ot_params){};
+
+  /**
+   * @brief Build the table of `activation` for int8 inputs and outputs with
+   * the given quantisation, i.e. `real = scale * (q - zero_point)`. Outputs
+   * are rounded to nearest and saturated.
+   */
+  static std::vector<int8_t> make_table(double (*activation)(double),
+                                        double input_scale,
+                                        int input_zero_point,
+                                        double output_scale,
+                                        int output_zero_point);
+
+  int8_t *output_transform_fn(int8_t *Y, VPURingBuffer *A,
+                              int32_t output_channel_group);
+};
+
+/**
+ * @brief Output transform converting the 32-bit accumulators of a 16-bit
+ * aggregator, such as `MatMulInt16x8`, to int16 or int8 outputs.
+ *
+ * Each output channel `ch` is computed as
+ *
+ *    Y[ch] = sat(((((A[ch] + biases[ch]) * multipliers[ch]) >> 30)
+ *                 >> shifts[ch]) + offsets[ch])
+ *
+ * where the bias is added with 32-bit saturation, the first shift is a floor,
+ * the second rounds, and `sat()` saturates symmetrically to the width of the
+ * output. This is the requantisation of a
+ * TFLite 16x8 convolution, with the bias in units of the accumulator and the
+ * offset being the output zero point. The VPU is used in 32-bit mode, so unlike
+ * `OT_int8` the accumulators are never reduced to 16 bits before they are
+ * scaled.
+ *
+ * The biases, multipliers, shifts and offsets must be padded to a whole number
+ * of channel groups, as done by `quantise_activation()`. An int16 output is
+ * written as two bytes per channel, so `output_channel_slice_offset` of the
+ * owning kernel is in bytes.
+ */
+class OT_int16 : public OutputTransformFn {
+ public:
+  struct Params {
+    int32_t output_slice_channel_count;
+
+    /**
+     * The bytes of each output element; 2 for int16 or 1 for int8.
+     */
+    int32_t output_bytes;
+
+    const int32_t *biases;
+    const int32_t *multipliers;
+    const uint32_t *shifts;
+    const int32_t *offsets;
+
+    /**
+     * @brief Construct a new Params object
+     *
+     * @param output_slice_channel_count The count of output channels to be
+     * computed by this parameter set.
+     * @param output_bytes The bytes of each output element; 2 or 1.
+     * @param biases Pointer to the biases, in units of the accumulators.
+     * @param multipliers Pointer to the Q30 multipliers.
+     * @param shifts Pointer to the right shifts applied after the multipliers.
+     * @param offsets Pointer to the offsets, in units of the output.
+     */
+    Params(int32_t output_slice_channel_count, int32_t output_bytes,
+           const int32_t *biases, const int32_t *multipliers,
+           const uint32_t *shifts, const int32_t *offsets)
+        : output_slice_channel_count(output_slice_channel_count),
+          output_bytes(output_bytes),
+          biases(biases),
+          multipliers(multipliers),
+          shifts(shifts),
+          offsets(offsets) {
+      assert(output_bytes == 1 || output_bytes == 2);
+    }
+  };
+
+  /**
+   * The quantised parameters of every output channel, padded to a whole
+   * number of channel groups.
+   */
+  struct Quantisation {
+    std::vector<int32_t> biases;
+    std::vector<int32_t> multipliers;
+    std::vector<uint32_t> shifts;
+    std::vector<int32_t> offsets;
+  };
+
  private:
   /**
    * @brief This describes the channels over which this class will perform its
@@ -189,10 +436,26 @@ class OT_int8 : public OutputTransformFnInt8 {
   Params *params;
 
  public:
-  OT_int8(Params *params) : params(params){};
+  OT_int16(Params *params) : params(params){};
 
   int8_t *output_transform_fn(int8_t *Y, VPURingBuffer *A,
                               int32_t output_channel_group);
+
+  /**
+   * @brief Quantise the transform `Y[ch] = (A[ch] + biases[ch]) *
+   * multipliers[ch] + offsets[ch]`. The result is within 1 of the real
+   * transform, before saturation.
+   *
+   * @param biases The bias of each channel, in units of the accumulators.
+   * @param multipliers The multiplier of each channel, each of which must have
+   * a magnitude less than 2.
+   * @param offsets The offset of each channel, in units of the output.
+   * @return Quantisation
+   */
+  static Quantisation quantise_activation(
+      const std::vector<int32_t> &biases,
+      const std::vector<double> &multipliers,
+      const std::vector<int32_t> &offsets);
 };
 
 class OTBinary_int8 : public OutputTransformFnInt8 {
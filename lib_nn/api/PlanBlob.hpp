@@ -0,0 +1,278 @@
+#ifndef LIB_NN_PLAN_BLOB_HPP_
+#define LIB_NN_PLAN_BLOB_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "AggregateFn.hpp"
+#include "MemCpyFn.hpp"
+#include "OutputTransformFn.hpp"
+
+namespace nn {
+
+/**
+ * Plan blobs hold the `Params` of a model's kernels in a binary format which
+ * can be used in place, e.g. from a memory-mapped file or directly from flash,
+ * without copying or allocating anything at load time.
+ *
+ * A blob is a `PlanBlobHeader` followed by a sequence of records. Each record
+ * is a `PlanRecordHeader` followed by the record's body, padded so that the
+ * next record begins on a `PlanBlob::Alignment` byte boundary. The body of a
+ * `Params` record is the in-memory representation of the `Params` struct, so
+ * a pointer into the blob can be handed straight to the kernel's handler.
+ * Bodies never hold pointers, so the blob is position independent; data such
+ * as reordered weights, which `Params` refer to by pointer, is stored in
+ * `PlanRecordType::Bytes` records and the pointer is filled in at load time.
+ *
+ * The `Params` structs only hold naturally aligned little-endian integers,
+ * which have the same layout on x86 and xcore, so a blob written on the host
+ * can be read on the device. The record size is checked when reading to
+ * catch any mismatch.
+ */
+namespace PlanBlob {
+
+/**
+ * The required alignment, in bytes, of the blob and of each record body.
+ */
+constexpr int Alignment = 8;
+
+/**
+ * The value of `PlanBlobHeader::magic`: "NNPB" in little-endian order.
+ */
+constexpr uint32_t Magic = 0x42504E4E;
+
+/**
+ * The version of the blob format. Blobs with a different version are
+ * rejected.
+ */
+constexpr uint16_t Version = 1;
+
+}  // namespace PlanBlob
+
+/**
+ * The kind of data held in a plan record.
+ */
+enum class PlanRecordType : uint16_t {
+  /// No more records. Never stored in a blob.
+  End = 0,
+  /// An array of bytes, e.g. reordered weights.
+  Bytes = 1,
+  DerefInputFn = 2,
+  ImToColPadded = 3,
+  ImToColValid = 4,
+  DirectWriteOutputTransform = 5,
+  ShiftInt8OutputTransform = 6,
+  MaxPoolPatchFn = 7,
+};
+
+/**
+ * The header at the start of each plan blob.
+ */
+struct PlanBlobHeader {
+  /// `PlanBlob::Magic`
+  uint32_t magic;
+  /// `PlanBlob::Version`
+  uint16_t version;
+  /// `sizeof(PlanBlobHeader)`
+  uint16_t header_bytes;
+  /// Size of the whole blob, including this header.
+  uint32_t total_bytes;
+  /// Number of records following the header.
+  uint32_t record_count;
+  /// Checksum of the `total_bytes - header_bytes` bytes after the header.
+  uint32_t payload_checksum;
+  /// Checksum of the preceding fields of the header.
+  uint32_t header_checksum;
+};
+
+/**
+ * The header at the start of each record.
+ */
+struct PlanRecordHeader {
+  /// A `PlanRecordType`
+  uint16_t type;
+  /// Version of the record body's layout, see `PlanRecordTraits`.
+  uint16_t version;
+  /// Size of the body, excluding padding.
+  uint32_t bytes;
+};
+
+static_assert(sizeof(PlanBlobHeader) % PlanBlob::Alignment == 0,
+              "PlanBlobHeader must preserve alignment");
+static_assert(sizeof(PlanRecordHeader) % PlanBlob::Alignment == 0,
+              "PlanRecordHeader must preserve alignment");
+
+/**
+ * Associates a `Params` type with its record type and body layout version.
+ *
+ * The version must be incremented whenever the members of the `Params` type
+ * change, so that stale blobs are rejected rather than misread.
+ */
+template <class T>
+struct PlanRecordTraits;
+
+template <>
+struct PlanRecordTraits<DerefInputFn::Params> {
+  static constexpr PlanRecordType Type = PlanRecordType::DerefInputFn;
+  static constexpr uint16_t Version = 1;
+};
+
+template <>
+struct PlanRecordTraits<ImToColPadded::Params> {
+  static constexpr PlanRecordType Type = PlanRecordType::ImToColPadded;
+  static constexpr uint16_t Version = 1;
+};
+
+template <>
+struct PlanRecordTraits<ImToColValid::Params> {
+  static constexpr PlanRecordType Type = PlanRecordType::ImToColValid;
+  static constexpr uint16_t Version = 1;
+};
+
+template <>
+struct PlanRecordTraits<DirectWriteOutputTransform::Params> {
+  static constexpr PlanRecordType Type =
+      PlanRecordType::DirectWriteOutputTransform;
+  static constexpr uint16_t Version = 1;
+};
+
+template <>
+struct PlanRecordTraits<ShiftInt8OutputTransform::Params> {
+  static constexpr PlanRecordType Type =
+      PlanRecordType::ShiftInt8OutputTransform;
+  static constexpr uint16_t Version = 1;
+};
+
+template <>
+struct PlanRecordTraits<MaxPoolPatchFn::Params> {
+  static constexpr PlanRecordType Type = PlanRecordType::MaxPoolPatchFn;
+  static constexpr uint16_t Version = 1;
+};
+
+/**
+ * Builds a plan blob. This is intended for use on the host when preparing a
+ * model.
+ */
+class PlanBlobWriter {
+  std::vector<uint8_t> payload;
+  uint32_t record_count;
+
+  void add_record(PlanRecordType type, uint16_t version, const void *body,
+                  size_t bytes);
+
+ public:
+  PlanBlobWriter() : record_count(0) {}
+
+  /**
+   * Append a record holding `params`.
+   */
+  template <class T>
+  void add(const T &params) {
+    static_assert(std::is_trivially_copyable<T>::value &&
+                      std::is_standard_layout<T>::value,
+                  "Only plain data can be stored in a plan blob");
+    add_record(PlanRecordTraits<T>::Type, PlanRecordTraits<T>::Version,
+               &params, sizeof(T));
+  }
+
+  /**
+   * Append a `PlanRecordType::Bytes` record holding `bytes` bytes of `data`.
+   */
+  void add_bytes(const void *data, size_t bytes) {
+    add_record(PlanRecordType::Bytes, 0, data, bytes);
+  }
+
+  /**
+   * Get the finished blob. `std::vector`'s allocator satisfies
+   * `PlanBlob::Alignment` on the supported hosts; copies of the blob must be
+   * placed on a `PlanBlob::Alignment` byte boundary.
+   */
+  std::vector<uint8_t> finish() const;
+};
+
+/**
+ * Cursor over the records of a plan blob.
+ *
+ * Construction validates the blob's header in constant time; the payload
+ * checksum is only verified on request, as it requires reading the whole blob.
+ * Records are then read in the order in which they were written. Nothing is
+ * copied: the pointers returned point into the blob, which must outlive them.
+ */
+class PlanBlobReader {
+ public:
+  enum class Status {
+    Ok,
+    /// The blob is smaller than its header claims.
+    Truncated,
+    /// The blob is not `PlanBlob::Alignment` byte aligned.
+    Misaligned,
+    BadMagic,
+    BadVersion,
+    BadHeaderChecksum,
+    BadPayloadChecksum,
+    /// A record was not of the requested type, version or size, or extends
+    /// beyond the end of the blob.
+    BadRecord,
+  };
+
+ private:
+  const uint8_t *cursor;
+  const uint8_t *end;
+  uint32_t records_left;
+  Status status;
+
+  const void *next_record(PlanRecordType type, uint16_t version, size_t *bytes);
+
+ public:
+  /**
+   * Open the `bytes` byte blob at `blob`. If `verify_payload` is true the
+   * checksum of the records is also verified.
+   */
+  PlanBlobReader(const void *blob, size_t bytes, bool verify_payload = false);
+
+  Status get_status() const { return status; }
+
+  bool ok() const { return status == Status::Ok; }
+
+  /**
+   * The number of records not yet read.
+   */
+  uint32_t get_remaining_records() const { return records_left; }
+
+  /**
+   * The type of the next record, or `PlanRecordType::End` if there are none
+   * (or the blob is invalid).
+   */
+  PlanRecordType peek_type() const;
+
+  /**
+   * Get the next record as a `T`, and advance past it.
+   *
+   * If the next record does not hold a `T` of the current layout, `nullptr`
+   * is returned and the reader's status becomes `Status::BadRecord`.
+   */
+  template <class T>
+  const T *next() {
+    static_assert(std::is_trivially_copyable<T>::value &&
+                      std::is_standard_layout<T>::value,
+                  "Only plain data can be stored in a plan blob");
+    size_t bytes = sizeof(T);
+    return static_cast<const T *>(next_record(
+        PlanRecordTraits<T>::Type, PlanRecordTraits<T>::Version, &bytes));
+  }
+
+  /**
+   * Get the contents of the next record, which must be a
+   * `PlanRecordType::Bytes` record, and advance past it. The size of the
+   * record is written to `bytes`.
+   */
+  const void *next_bytes(size_t *bytes) {
+    return next_record(PlanRecordType::Bytes, 0, bytes);
+  }
+};
+
+}  // namespace nn
+
+#endif  // LIB_NN_PLAN_BLOB_HPP_
@@ -0,0 +1,142 @@
+#ifndef LIB_NN_THREAD_POOL_EXECUTOR_HPP_
+#define LIB_NN_THREAD_POOL_EXECUTOR_HPP_
+
+#if !defined(__XS3A__)
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Filter2D.hpp"
+
+namespace nn {
+
+/**
+ * Host-side executor which runs a `Filter2D` or `Filter2D_DW` on a pool of
+ * worker threads.
+ *
+ * The output region of the filter is partitioned into row bands and, when
+ * there are too few rows to keep every worker busy, channel group slices.
+ * Each part is computed by a filter sharing the original's component handlers,
+ * so the handlers must not hold mutable state. Each worker owns a scratch
+ * buffer of `MemCpyFn::get_scratch_bytes()` bytes, which replaces the scratch
+ * memory given to the original filter.
+ *
+ * This is intended for the x86 build; it is not available on xcore.
+ */
+class ThreadPoolExecutor {
+ public:
+  /**
+   * A part of a filter's output region: the rows [`h_begin`, `h_end`) and the
+   * channel groups [`group_begin`, `group_end`), relative to the first channel
+   * group of the region.
+   */
+  struct Job {
+    int32_t h_begin, h_end;
+    int32_t group_begin, group_end;
+  };
+
+  /**
+   * The number of jobs to create per worker thread. More jobs than workers
+   * evens out the load when the parts take different amounts of time, e.g.
+   * when only some of them touch the padding.
+   */
+  static constexpr int JobsPerThread = 4;
+
+ private:
+  std::vector<std::thread> workers;
+
+  /**
+   * Per-worker scratch memory. int32_t elements keep the buffers word
+   * aligned, as required by the VPU loads.
+   */
+  std::vector<std::vector<int32_t>> scratch;
+
+  std::mutex run_mutex;
+  std::mutex mutex;
+  std::condition_variable work_ready;
+  std::condition_variable work_done;
+  std::function<void(int)> task;
+  uint64_t generation;
+  int pending;
+  bool stopping;
+
+  void worker_loop(int worker);
+
+  /**
+   * Call `task(worker)` once on every worker and wait for all of them to
+   * return.
+   */
+  void run(const std::function<void(int)> &task);
+
+  /**
+   * Get the scratch memory of `worker`, grown to at least `bytes` bytes.
+   */
+  int8_t *get_scratch(int worker, int bytes);
+
+ public:
+  /**
+   * Construct an executor with `thread_count` worker threads. If
+   * `thread_count` is not positive, one thread per hardware thread is used.
+   */
+  explicit ThreadPoolExecutor(int thread_count = 0);
+
+  ~ThreadPoolExecutor();
+
+  ThreadPoolExecutor(const ThreadPoolExecutor &) = delete;
+  ThreadPoolExecutor &operator=(const ThreadPoolExecutor &) = delete;
+
+  int get_thread_count() const { return (int)workers.size(); }
+
+  /**
+   * Partition the region described by `kparams` into at most `job_count`
+   * jobs. Row bands are preferred, as all channel groups of a pixel share a
+   * single patch copy in `Filter2D`; channel groups are only split when there
+   * are fewer rows than jobs.
+   */
+  static std::vector<Job> partition(const AbstractKernel::Params &kparams,
+                                    int job_count);
+
+  /**
+   * Execute `filter` with the output image `Y` and input image `X`, as
+   * `filter.execute(Y, X)` would, spreading the work over the worker threads.
+   *
+   * `FilterT` is `Filter2D`, `Filter2D_DW` or a class with the same
+   * constructors and accessors.
+   */
+  template <class FilterT>
+  void execute(FilterT &filter, int8_t *Y, int8_t *X);
+};
+
+template <class FilterT>
+void ThreadPoolExecutor::execute(FilterT &filter, int8_t *Y, int8_t *X) {
+  AbstractKernel::Params *kparams = filter.get_params();
+  const int channels_per_group = filter.get_output_channels_per_group();
+  const int scratch_bytes = filter.get_scratch_bytes();
+  const std::vector<Job> jobs =
+      partition(*kparams, JobsPerThread * get_thread_count());
+  std::atomic<int> next_job(0);
+
+  run([&](int worker) {
+    int8_t *scratch_mem = get_scratch(worker, scratch_bytes);
+
+    for (int j = next_job++; j < (int)jobs.size(); j = next_job++) {
+      const Job &job = jobs[j];
+      AbstractKernel::Params job_params(*kparams, job.h_begin, job.h_end,
+                                        job.group_begin, job.group_end,
+                                        channels_per_group);
+      FilterT job_filter(filter, &job_params, scratch_mem);
+      job_filter.execute(Y, X);
+    }
+  });
+}
+
+}  // namespace nn
+
+#endif  // !defined(__XS3A__)
+
+#endif  // LIB_NN_THREAD_POOL_EXECUTOR_HPP_
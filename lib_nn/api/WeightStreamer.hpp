@@ -0,0 +1,190 @@
+#ifndef LIB_NN_WEIGHT_STREAMER_HPP_
+#define LIB_NN_WEIGHT_STREAMER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+#if !defined(__XS3A__)
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#endif
+
+#include "nn_operator.h"
+
+namespace nn {
+
+/**
+ * Interface to a copy engine moving weights from flash or external RAM into
+ * SRAM, e.g. a DMA controller or a thread on another core.
+ *
+ * Copies are asynchronous: `start_copy()` may return before the copy has
+ * completed, and several copies may be in flight at once. `wait()` blocks until
+ * every copy started so far has completed. Neither the source nor the
+ * destination of a copy may be accessed until then.
+ */
+class WeightLoader {
+ public:
+  virtual ~WeightLoader() = default;
+
+  /**
+   * Start copying `bytes` bytes from `src` to `dst`.
+   */
+  virtual void start_copy(void *dst, const void *src, size_t bytes) = 0;
+
+  /**
+   * Block until every copy started with `start_copy()` has completed.
+   */
+  virtual void wait() = 0;
+};
+
+/**
+ * `WeightLoader` which completes each copy with `vpu_memcpy_ext()` before
+ * `start_copy()` returns. This hides no latency, but needs no other hardware
+ * thread.
+ */
+class MemCpyWeightLoader : public WeightLoader {
+ public:
+  void start_copy(void *dst, const void *src, size_t bytes);
+  void wait() {}
+};
+
+#if !defined(__XS3A__)
+
+/**
+ * `WeightLoader` which copies on a background thread, standing in for a DMA
+ * controller on the host.
+ *
+ * This is intended for the x86 build; it is not available on xcore.
+ */
+class ThreadWeightLoader : public WeightLoader {
+  struct Copy {
+    void *dst;
+    const void *src;
+    size_t bytes;
+  };
+
+  std::thread worker;
+  std::mutex mutex;
+  std::condition_variable copy_ready;
+  std::condition_variable copy_done;
+  std::deque<Copy> queue;
+  int in_flight;
+  bool stopping;
+
+  void worker_loop();
+
+ public:
+  ThreadWeightLoader();
+  ~ThreadWeightLoader();
+
+  ThreadWeightLoader(const ThreadWeightLoader &) = delete;
+  ThreadWeightLoader &operator=(const ThreadWeightLoader &) = delete;
+
+  void start_copy(void *dst, const void *src, size_t bytes);
+  void wait();
+};
+
+#endif  // !defined(__XS3A__)
+
+/**
+ * The operator run by a `Conv2dWeightStreamer`.
+ */
+enum class Conv2dStreamedOp {
+  /** conv2d_deep_ext() */
+  Deep,
+  /** conv2d_shallowin_ext() */
+  ShallowIn,
+};
+
+/**
+ * Executor which runs a @oper{conv2d_deep} or @oper{conv2d_shallowin} one
+ * slice of output channels at a time, with the kernel tensor and BSO array
+ * left in flash or external RAM.
+ *
+ * Each slice's part of `K` and `BSO` is copied into one of two SRAM buffers,
+ * and the job computing the slice is invoked with the `*_FLAG_SLICED_K` flag.
+ * The copy of the next slice is started before the current slice is computed,
+ * so with an asynchronous `WeightLoader` the weight load latency is hidden
+ * behind the computation of the previous slice. The peak SRAM cost is two
+ * slices of weights rather than the whole tensor.
+ */
+class Conv2dWeightStreamer {
+  Conv2dStreamedOp op;
+  nn_image_params_t x_params;
+  nn_image_params_t y_params;
+  nn_window_params_t conv_window;
+  int8_t zero_point;
+
+  /**
+   * The number of output channels computed per slice.
+   */
+  int32_t slice_channels;
+
+  /**
+   * The number of bytes of `K` per output channel.
+   */
+  int32_t kernel_channel_bytes;
+
+  /**
+   * Copy the weights of `slice` into `buffer`.
+   */
+  void load_slice(WeightLoader *loader, int8_t *buffer, const nn_tensor_t *K,
+                  const nn_bso_block_t *BSO, int32_t slice) const;
+
+  /**
+   * Compute `slice` of `Y` using the weights in `buffer`.
+   */
+  void compute_slice(nn_image_t *Y, const nn_image_t *X, const int8_t *buffer,
+                     int32_t slice) const;
+
+ public:
+  /**
+   * @brief Construct a new Conv2dWeightStreamer object
+   *
+   * @param op The operator to run.
+   * @param x_params The shape of the input image.
+   * @param y_params The shape of the output image.
+   * @param conv_window The convolution window, as given to the operator.
+   * @param zero_point The padding value, as given to the operator.
+   * @param slice_channels The number of output channels per slice, a multiple
+   * of `VPU_INT8_ACC_PERIOD`.
+   */
+  Conv2dWeightStreamer(Conv2dStreamedOp op, const nn_image_params_t &x_params,
+                       const nn_image_params_t &y_params,
+                       const nn_window_params_t &conv_window,
+                       int8_t zero_point,
+                       int32_t slice_channels = VPU_INT8_ACC_PERIOD);
+
+  /**
+   * Get the number of slices the output channels are computed in.
+   */
+  int32_t get_slice_count() const;
+
+  /**
+   * Get the size in bytes of each of the two weight buffers given to
+   * `execute()`. This includes a vector before and after each slice of `K`,
+   * which the operator may read.
+   */
+  int32_t get_buffer_bytes() const;
+
+  /**
+   * Compute the whole of `Y`, as the operator invoked without a job would.
+   *
+   * @param Y The output image.
+   * @param X The input image.
+   * @param K The full kernel tensor, which need not be addressable by the VPU.
+   * @param BSO The full BSO array, which need not be addressable by the VPU.
+   * @param loader The copy engine used to load the weights.
+   * @param buffer0 A word-aligned weight buffer of `get_buffer_bytes()` bytes.
+   * @param buffer1 A second buffer like `buffer0`.
+   */
+  void execute(nn_image_t *Y, const nn_image_t *X, const nn_tensor_t *K,
+               const nn_bso_block_t *BSO, WeightLoader *loader,
+               int8_t *buffer0, int8_t *buffer1) const;
+};
+
+}  // namespace nn
+
+#endif  // LIB_NN_WEIGHT_STREAMER_HPP_
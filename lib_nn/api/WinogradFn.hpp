@@ -0,0 +1,205 @@
+#ifndef LIB_NN_WINOGRAD_FN_HPP_
+#define LIB_NN_WINOGRAD_FN_HPP_
+
+#include <array>
+#include <climits>
+#include <vector>
+
+#include "MemCpyFn.hpp"
+#include "geom/Filter2dGeometry.hpp"
+#include "vpu.hpp"
+#include "xs3_vpu.h"
+
+namespace nn {
+
+/**
+ * Winograd F(2x2, 3x3) convolution.
+ *
+ * A 3x3, stride 1 convolution is computed a tile of 2x2 output pixels at a
+ * time. The 4x4 input pixels under a tile (`d`) and each 3x3 kernel channel
+ * (`g`) are transformed into a 16 point Winograd domain, where the products
+ * summed over the input channels take the place of the convolution:
+ *
+ *    Y = A^T [ sum_c (G g G^T) * (B^T d B) ] A
+ *
+ * with `*` the elementwise product. This needs 16 multiplies per input channel
+ * for 4 output pixels, where the direct convolution needs 36.
+ *
+ * The transformed values are too wide for int8: `B^T d B` needs 10 bits and
+ * `G g G^T` has factors of 1/2. So the kernel is transformed with `2 G` to
+ * make it integral, giving 4 times `G g G^T` in 12 bits, both operands are
+ * held as int16 and multiplied in the VPU's 16-bit mode with 32-bit
+ * accumulators. The factor of 4 is removed exactly after the inverse transform,
+ * so the accumulators are bit-identical to those of the direct convolution and
+ * any `OutputTransformFn` set up for the direct convolution can be used as-is.
+ *
+ * @see WinogradInputTransform
+ * @see MatMulWinograd
+ * @see Filter2D_Winograd
+ */
+namespace WinogradF2x3 {
+
+/**
+ * The number of output pixels along each side of a tile.
+ */
+constexpr int OutputTile = 2;
+
+/**
+ * The number of input pixels along each side of a tile.
+ */
+constexpr int InputTile = 4;
+
+/**
+ * The number of points in the Winograd domain.
+ */
+constexpr int Points = InputTile * InputTile;
+
+/**
+ * The number of input channels per VPU load of the int16 Winograd domain
+ * values. The input channels are padded to a multiple of this.
+ */
+constexpr int InputChannelsPerGroup = VPU_INT16_EPV;
+
+/**
+ * The largest magnitude of a transformed kernel value, `|4 G g G^T|`.
+ */
+constexpr int MaxKernelMagnitude = 9 * 128;
+
+/**
+ * The largest magnitude of a transformed input value, `|B^T d B|`.
+ */
+constexpr int MaxInputMagnitude = 4 * 128;
+
+/**
+ * The largest supported number of input channels; beyond this the sums in the
+ * Winograd domain could saturate the 32-bit accumulators.
+ */
+constexpr int MaxInputChannels =
+    INT_MAX / (MaxKernelMagnitude * MaxInputMagnitude);
+
+}  // namespace WinogradF2x3
+
+/**
+ * Patch handler transforming a 4x4 tile of the input image into the Winograd
+ * domain.
+ *
+ * Unlike other `MemCpyFn`s, `h` and `w` given to `memcopy_fn()` are the row and
+ * column of the output _tile_, i.e. the tile of output pixels starting at
+ * (`2h`, `2w`). The patch written is `WinogradF2x3::Points` int16 vectors of
+ * the input channels padded to `WinogradF2x3::InputChannelsPerGroup`, and must
+ * be word-aligned.
+ */
+class WinogradInputTransform : public MemCpyFn {
+ public:
+  class Params {
+   public:
+    int32_t input_height;
+    int32_t input_width;
+    int32_t input_channels;
+    int32_t input_channel_groups;
+
+    int32_t bytes_per_h_line;
+    int32_t bytes_per_pixel;
+
+    /**
+     * The input row and column under the first pixel of the output image,
+     * negative for top and left padding.
+     */
+    int32_t start_row;
+    int32_t start_col;
+
+    int32_t padding_val;
+
+    /**
+     * @brief Construct a new Params object
+     *
+     * @param filter_geometry The geometry of the convolution, which must have a
+     * 3x3 window with a stride and dilation of 1.
+     * @param padding_value The value used for input pixels outside of the
+     * input image.
+     */
+    Params(const Filter2dGeometry &filter_geometry,
+           const int8_t padding_value);
+  };
+
+ private:
+  const Params *params;
+
+ public:
+  WinogradInputTransform(const Params *p) : params(p) {}
+
+  int8_t *memcopy_fn(int8_t *T, int8_t *X, int32_t h, int32_t w,
+                     int32_t c = 0);
+  int get_scratch_bytes();
+  int get_overread_bytes();
+};
+
+/**
+ * Aggregation handler computing a tile of 2x2 output pixels from the Winograd
+ * domain patch produced by `WinogradInputTransform`.
+ *
+ * This is not an `AggregateFn`, as each call produces the accumulators of 4
+ * output pixels. They are identical to those a `MatMulDirectFn` or
+ * `MatMulInt8` computes for the same weights.
+ */
+class MatMulWinograd {
+ public:
+  class Params {
+   public:
+    /**
+     * The weights, as transformed by `transform_kernel_weights()`.
+     */
+    const int16_t *weights;
+
+    int32_t input_channel_groups;
+
+    /**
+     * @brief Construct a new Params object
+     *
+     * @param input_channels The count of input channels.
+     * @param weights A Pointer to the beginning of the transformed weights.
+     */
+    Params(const int input_channels, const int16_t *weights);
+  };
+
+ protected:
+  const Params *params;
+
+ public:
+  MatMulWinograd(const Params *params) : params(params) {}
+
+  /**
+   * Compute the accumulators of a channel group of a tile.
+   *
+   * @param A Pointer to `WinogradF2x3::OutputTile^2` ring buffers, into which
+   * the accumulators of the tile's pixels are written in row major order.
+   * @param T Pointer to the patch written by `WinogradInputTransform`.
+   * @param output_channel_group Denotes which channel group will be computed.
+   */
+  void aggregate_fn(VPURingBuffer *A, int8_t *T, int32_t output_channel_group);
+
+  /**
+   * @brief Transform the weights from their normal form ([OutputChannel, 3, 3,
+   * InputChannel]) into the Winograd domain, in the order in which the VPU
+   * loads them.
+   *
+   * For each output channel group, then each Winograd point, then each input
+   * channel group, there is a 16x16 block of int16 values holding the output
+   * channels in reverse order. Partial channel groups are padded with zeros.
+   *
+   * @param raw_weights Pointer to the raw weights.
+   * @param shape [OutputChannels, Height, Width, InputChannels]
+   * @return The transformed weights.
+   */
+  static std::vector<int16_t> transform_kernel_weights(
+      const int8_t *raw_weights, const std::array<int, 4> &shape);
+
+  /**
+   * @brief Get the size in bytes of the transformed weights.
+   */
+  static int get_weights_bytes(int input_channels, int output_channels);
+};
+
+}  // namespace nn
+
+#endif  // LIB_NN_WINOGRAD_FN_HPP_
@@ -11,6 +11,11 @@ namespace nn {
 
 /**
  * Represents the geometry of a 2D multi-channel image.
+ *
+ * By default the image is dense, i.e. its pixels and rows are contiguous in
+ * memory. An image may instead have explicit row and pixel strides, e.g. to
+ * describe a crop or a channel slice of a larger image in place (see
+ * `View()`). The channels of a pixel are always contiguous.
  */
 class ImageGeometry {
  public:
@@ -22,13 +27,24 @@ class ImageGeometry {
   int depth;
   /// Number of bytes per image element
   int channel_depth;  // asj:this might be better in bits
+  /// Bytes from the start of one row to the next, or 0 if rows are contiguous
+  int row_stride;
+  /// Bytes from the start of one pixel to the next, or 0 if pixels are
+  /// contiguous
+  int pixel_stride;
 
   /**
    * Default Constructor
    *
    * Dimensions are initialized to 0, with 1 byte per pixel.
    */
-  constexpr ImageGeometry() : height(0), width(0), depth(0), channel_depth(1) {}
+  constexpr ImageGeometry()
+      : height(0),
+        width(0),
+        depth(0),
+        channel_depth(1),
+        row_stride(0),
+        pixel_stride(0) {}
 
   /**
    * Construct an ImageGeometry with the specified dimensions.
@@ -38,7 +54,35 @@ class ImageGeometry {
       : height(rows),
         width(cols),
         depth(chans),
-        channel_depth(channel_depth_bytes) {}
+        channel_depth(channel_depth_bytes),
+        row_stride(0),
+        pixel_stride(0) {}
+
+  /**
+   * Construct an ImageGeometry with the specified dimensions and explicit row
+   * and pixel strides, in bytes.
+   */
+  constexpr ImageGeometry(int const rows, int const cols, int const chans,
+                          int const channel_depth_bytes,
+                          int const row_stride_bytes,
+                          int const pixel_stride_bytes) noexcept
+      : height(rows),
+        width(cols),
+        depth(chans),
+        channel_depth(channel_depth_bytes),
+        row_stride(row_stride_bytes),
+        pixel_stride(pixel_stride_bytes) {}
+
+  /**
+   * Get the geometry of `region` of this image, as stored within this image.
+   *
+   * The result has the dimensions of `region` and this image's strides, and
+   * its first element is `GetStride(region.StartVect())` bytes from the first
+   * element of this image. Filters and their handlers honor the strides, so a
+   * crop or channel slice can be consumed without first copying it into a
+   * dense buffer.
+   */
+  ImageGeometry View(const ImageRegion &region) const;
 
   /**
    * The total number of pixels in the image
@@ -85,6 +129,27 @@ class ImageGeometry {
     return PixelElements() * channel_depth;
   }
 
+  /**
+   * The number of bytes from the start of one pixel to the next
+   */
+  int inline const PixelStride() const {
+    return pixel_stride ? pixel_stride : PixelBytes();
+  }
+
+  /**
+   * The number of bytes from the start of one row to the next
+   */
+  int inline const RowStride() const {
+    return row_stride ? row_stride : width * PixelStride();
+  }
+
+  /**
+   * Whether the pixels and rows of the image are contiguous
+   */
+  bool inline const IsDense() const {
+    return PixelStride() == PixelBytes() && RowStride() == RowBytes();
+  }
+
   /**
    * The number of bytes per row of the image
    */
@@ -105,7 +170,8 @@ class ImageGeometry {
    *
    * The "flattened" index of an element is the index of the element when the
    * image is stored in a 1 dimensional array. This is ideal, for example, when
-   * the image is backed by a `std::vector` object.
+   * the image is backed by a `std::vector` object. The strides of the image
+   * are honored.
    *
    * This function returns -1 if the specified coordinates refer to an element
    * in padding (i.e. beyond the bounds of the image).
@@ -198,8 +264,7 @@ template <typename T>
 T &ImageGeometry::Element(T *img_base, const int row, const int col,
                           const int channel) const {
   assert(IsWithinImage(row, col, channel));
-  int index = row * this->width * this->depth + col * this->depth + channel;
-  return img_base[index];
+  return img_base[Index(row, col, channel)];
 }
 
 /////////////////////////
@@ -392,6 +392,169 @@ void conv2d_deep_ext(nn_image_t* Y, const nn_image_t* X, const nn_tensor_t* K,
                      const nn_window_op_job_params_t* job_params,
                      const nn_conv2d_deep_flags_e flags);
 
+/**
+ * @brief Invoke a @oper{conv2d_deep} job followed by a table lookup of its
+ * outputs.
+ *
+ * This computes the same output as conv2d_deep_ext() followed by lookup8() of
+ * the job's outputs, which is how nonlinear activations such as sigmoid, tanh,
+ * hard-swish or GELU are applied. Each row of outputs of each output channel
+ * group is looked up as soon as it has been computed, instead of in a separate
+ * pass over @tensor{Y}.
+ *
+ * `lut` points to the 256-entry table, indexed by each output reinterpreted as
+ * a `uint8_t`. The remaining parameters are as described for conv2d_deep_ext().
+ *
+ * @param[out]  Y           The output image @tensor{Y}
+ * @param[in]   X           The input image @tensor{X}
+ * @param[in]   K           The kernel tensor @tensor{K}
+ * @param[in]   BSO         The bias-scale-offset array
+ * @param[in]   zero_point  The value @math{z_0} to be used for padding (for all
+ * channels)
+ * @param[in]   x_params    Parameters describing the shape of input image
+ * tensor @tensor{X}
+ * @param[in]   y_params    Parameters describing the shape of output image
+ * tensor @tensor{Y}
+ * @param[in]   conv_window Parameters describing the relationship between the
+ * convolution window, the input image, and the output image
+ * @param[in]   job_params  Indicates which output elements will be computed by
+ * this invocation
+ * @param[in]   flags       Flags which modify the behavior of conv2d_deep_ext()
+ * @param[in]   lut         Look-up table applied to the outputs
+ */
+void conv2d_deep_ext_lut(nn_image_t* Y, const nn_image_t* X,
+                         const nn_tensor_t* K, const nn_bso_block_t* BSO,
+                         const int8_t zero_point,
+                         const nn_image_params_t* x_params,
+                         const nn_image_params_t* y_params,
+                         const nn_window_params_t* conv_window,
+                         const nn_window_op_job_params_t* job_params,
+                         const nn_conv2d_deep_flags_e flags,
+                         const uint8_t* lut);
+
+/**
+ * @brief Invoke a @oper{conv2d_deep} job on an input image which may be a
+ * view of a larger tensor.
+ *
+ * This is conv2d_deep_ext(), except that if `flags` includes
+ * `CONV2D_DEEP_FLAG_INPUT_VIEW`, @tensor{X} is read with the row and pixel
+ * strides in `x_strides`. Crops, channel slices and sub-images of a larger
+ * tensor can then be convolved with no copy into a dense image first.
+ *
+ * `X` points to the first pixel of the view, and `x_params` gives the view's
+ * own height, width and channel count. If the pixel stride is
+ * `x_params->channels`, as for a crop or sub-image, the view is read in place.
+ * Otherwise, as for a channel slice, the rows of each window are copied into
+ * `scratch` for each row of outputs of each output channel group.
+ *
+ * Both strides must be multiples of 4, and the pixel stride at least
+ * `x_params->channels`. `scratch` must be word-aligned and at least
+ * conv2d_deep_view_scratch_bytes() bytes, and may be NULL if the view is read
+ * in place. The remaining parameters are as described for conv2d_deep_ext().
+ *
+ * @param[out]  Y           The output image @tensor{Y}
+ * @param[in]   X           The input image @tensor{X}
+ * @param[in]   K           The kernel tensor @tensor{K}
+ * @param[in]   BSO         The bias-scale-offset array
+ * @param[in]   zero_point  The value @math{z_0} to be used for padding (for all
+ * channels)
+ * @param[in]   x_params    Parameters describing the shape of input image
+ * tensor @tensor{X}
+ * @param[in]   y_params    Parameters describing the shape of output image
+ * tensor @tensor{Y}
+ * @param[in]   conv_window Parameters describing the relationship between the
+ * convolution window, the input image, and the output image
+ * @param[in]   job_params  Indicates which output elements will be computed by
+ * this invocation
+ * @param[in]   flags       Flags which modify the behavior of conv2d_deep_ext()
+ * @param[in]   x_strides   The strides of @tensor{X}, if it is a view
+ * @param[in]   scratch     Buffer for the rows of a window, or NULL
+ */
+void conv2d_deep_ext_view(nn_image_t* Y, const nn_image_t* X,
+                          const nn_tensor_t* K, const nn_bso_block_t* BSO,
+                          const int8_t zero_point,
+                          const nn_image_params_t* x_params,
+                          const nn_image_params_t* y_params,
+                          const nn_window_params_t* conv_window,
+                          const nn_window_op_job_params_t* job_params,
+                          const nn_conv2d_deep_flags_e flags,
+                          const nn_image_strides_t* x_strides,
+                          int8_t* scratch);
+
+/**
+ * @brief Get the size of the `scratch` of conv2d_deep_ext_view().
+ *
+ * This is @math{K_h} dense rows of the input image, followed by a vector which
+ * conv2d_deep() may read beyond them.
+ *
+ * @param[in]   x_params    Parameters describing the shape of the input view
+ * @param[in]   conv_window Parameters describing the convolution window
+ * @return The number of bytes
+ */
+int32_t conv2d_deep_view_scratch_bytes(const nn_image_params_t* x_params,
+                                       const nn_window_params_t* conv_window);
+
+/**
+ * @brief Invoke a @oper{conv2d_deep} job over a batch of images.
+ *
+ * This computes the same output as calling conv2d_deep() once for each of
+ * `batch_count` images, but with the images as the inner loop of the output
+ * channel groups. Each output channel group's slice of @tensor{K} and `BSO` is
+ * applied to every image before moving on to the next.
+ *
+ * If `weights_buffer` is not NULL, each group's slice of @tensor{K} and its
+ * `BSO` block are copied into it before the group is applied to the images,
+ * which then read them from there. With the buffer in SRAM and @tensor{K} in
+ * slower memory (e.g. flash), the kernel is streamed from that memory once per
+ * batch rather than once per image. If `weights_buffer` is NULL, only the loop
+ * order differs from calling conv2d_deep() for each image, and the kernel is
+ * read in place for every image.
+ *
+ * @par Parameter Details
+ *
+ * `Y` and `X` point to the first of `batch_count` contiguous output and input
+ * images, i.e. @tensor{Y} and @tensor{X} have shapes @tensor_shape{B, Y_h, Y_w,
+ * Y_c} and @tensor_shape{B, X_h, X_w, X_c}. `weights_buffer`, if not NULL,
+ * must be word-aligned and at least conv2d_deep_batch_buffer_bytes() bytes.
+ * The remaining parameters are as described for conv2d_deep(), whose
+ * constraints also apply here.
+ *
+ * @param[out]  Y           The output images @tensor{Y}
+ * @param[in]   X           The input images @tensor{X}
+ * @param[in]   K           The kernel tensor @tensor{K}
+ * @param[in]   BSO         The bias-scale-offset array
+ * @param[in]   zero_point  The value @math{z_0} to be used for padding (for all
+ * channels)
+ * @param[in]   x_params    Parameters describing the shape of each input image
+ * @param[in]   y_params    Parameters describing the shape of each output image
+ * @param[in]   conv_window Parameters describing the relationship between the
+ * convolution window, the input image, and the output image
+ * @param[in]   batch_count The number of images, @math{B}
+ * @param[in]   weights_buffer Buffer into which each channel group's kernel is
+ * copied, or NULL
+ */
+void conv2d_deep_batch(nn_image_t* Y, const nn_image_t* X,
+                       const nn_tensor_t* K, const nn_bso_block_t* BSO,
+                       const int8_t zero_point,
+                       const nn_image_params_t* x_params,
+                       const nn_image_params_t* y_params,
+                       const nn_window_params_t* conv_window,
+                       const unsigned batch_count, int8_t* weights_buffer);
+
+/**
+ * @brief Get the size of the `weights_buffer` of conv2d_deep_batch().
+ *
+ * This is the kernel of a channel group and a BSO block, with a vector of
+ * padding either side of the kernel as conv2d_deep() may read slightly beyond
+ * it.
+ *
+ * @param[in]   x_params    Parameters describing the shape of each input image
+ * @param[in]   conv_window Parameters describing the convolution window
+ * @return The number of bytes
+ */
+int32_t conv2d_deep_batch_buffer_bytes(const nn_image_params_t* x_params,
+                                       const nn_window_params_t* conv_window);
+
 /**
  * @brief Invoke a @oper{conv2d_shallowin} job.
  *
@@ -929,6 +1092,134 @@ void conv2d_1x1_ext(nn_image_t* Y, const nn_image_t* X, const nn_tensor_t* K,
                     const nn_conv2d_1x1_job_params_t* job_params,
                     const nn_conv2d_1x1_flags_e flags);
 
+/**
+ * @brief Invoke a @oper{conv2d_1x1} job followed by a table lookup of its
+ * outputs.
+ *
+ * This computes the same output as conv2d_1x1_ext() followed by lookup8() of
+ * the job's outputs. The job is computed by conv2d_1x1_ext() at most a row of
+ * output pixels at a time, and each of these is looked up as soon as it has
+ * been computed, instead of in a separate pass over @tensor{Y}.
+ *
+ * `lut` points to the 256-entry table, indexed by each output reinterpreted as
+ * a `uint8_t`. The remaining parameters are as described for conv2d_1x1_ext().
+ *
+ * @param[out]  Y           The output image @tensor{Y}
+ * @param[in]   X           The input image @tensor{X}
+ * @param[in]   K           The kernel tensor @tensor{K}
+ * @param[in]   BSO         The bias-scale-offset array
+ * @param[in]   x_params    Parameters describing the shape of input image
+ * tensor @tensor{X}
+ * @param[in]   y_params    Parameters describing the shape of output image
+ * tensor @tensor{Y}
+ * @param[in]   job_params  Indicates which output elements will be computed by
+ * this invocation
+ * @param[in]   flags       Flags which modify the behavior of conv2d_1x1_ext()
+ * @param[in]   lut         Look-up table applied to the outputs
+ */
+void conv2d_1x1_ext_lut(nn_image_t* Y, const nn_image_t* X,
+                        const nn_tensor_t* K, const nn_bso_block_t* BSO,
+                        const nn_image_params_t* x_params,
+                        const nn_image_params_t* y_params,
+                        const nn_conv2d_1x1_job_params_t* job_params,
+                        const nn_conv2d_1x1_flags_e flags,
+                        const uint8_t* lut);
+
+/**
+ * @brief Invoke a @oper{conv2d_1x1} job on an input image which may be a view
+ * of a larger tensor.
+ *
+ * This is conv2d_1x1_ext(), except that if `flags` includes
+ * `CONV2D_1X1_FLAG_INPUT_VIEW`, @tensor{X} is read with the row and pixel
+ * strides in `x_strides`. Crops, channel slices and sub-images of a larger
+ * tensor can then be convolved with no copy into a dense image first.
+ *
+ * `X` points to the first pixel of the view, and `x_params` gives the view's
+ * own height, width and channel count. Each row of the job is computed by
+ * conv2d_1x1_ext(). If the pixel stride is `x_params->channels`, as for a crop
+ * or sub-image, the row is read in place. Otherwise, as for a channel slice,
+ * the row's pixels are first copied into `scratch`.
+ *
+ * Both strides must be multiples of 4, and the pixel stride at least
+ * `x_params->channels`. `scratch` must be word-aligned and at least
+ * @math{(X_w \cdot X_c + 32)} bytes, and may be NULL if the view is read in
+ * place. The remaining parameters are as described for conv2d_1x1_ext().
+ *
+ * @param[out]  Y           The output image @tensor{Y}
+ * @param[in]   X           The input image @tensor{X}
+ * @param[in]   K           The kernel tensor @tensor{K}
+ * @param[in]   BSO         The bias-scale-offset array
+ * @param[in]   x_params    Parameters describing the shape of input image
+ * tensor @tensor{X}
+ * @param[in]   y_params    Parameters describing the shape of output image
+ * tensor @tensor{Y}
+ * @param[in]   job_params  Indicates which output elements will be computed by
+ * this invocation
+ * @param[in]   flags       Flags which modify the behavior of conv2d_1x1_ext()
+ * @param[in]   x_strides   The strides of @tensor{X}, if it is a view
+ * @param[in]   scratch     Buffer for the gathered input pixels of a row, or
+ * NULL
+ */
+void conv2d_1x1_ext_view(nn_image_t* Y, const nn_image_t* X,
+                         const nn_tensor_t* K, const nn_bso_block_t* BSO,
+                         const nn_image_params_t* x_params,
+                         const nn_image_params_t* y_params,
+                         const nn_conv2d_1x1_job_params_t* job_params,
+                         const nn_conv2d_1x1_flags_e flags,
+                         const nn_image_strides_t* x_strides,
+                         nn_image_t* scratch);
+
+/**
+ * @brief Invoke a strided @oper{conv2d_1x1}.
+ *
+ * This is the 1x1 convolution of conv2d_1x1(), with the convolution window
+ * moving `stride_rows` rows and `stride_cols` columns of @tensor{X} between
+ * output pixels, as in the downsampling 1x1 convolutions of a residual
+ * network. Output pixel @math{Y[r,c]} is computed from input pixel
+ * @math{X[r \cdot s_r, c \cdot s_c]}.
+ *
+ * This is conv2d_1x1_ext_view() of the view of every @math{s_r}-th row and
+ * @math{s_c}-th column of @tensor{X}. When `stride_cols` is @math{1} the input
+ * pixels of a row are already contiguous and are used in place. Otherwise they
+ * are first gathered into `scratch` with vectorized copies, so that the
+ * addressing cost is paid once per input pixel rather than once per input
+ * pixel per output channel group.
+ *
+ * @par Parameter Details
+ *
+ * `Y`, `X`, `K` and `BSO` are as described for conv2d_1x1().
+ *
+ * `scratch` points to a buffer of at least @math{(Y_w \cdot X_c + 32)} bytes.
+ * It may be `NULL` if `stride_cols` is @math{1}.
+ *
+ * @par Parameter Constraints
+ *
+ * The constraints of conv2d_1x1() apply, except that the spatial dimensions of
+ * @tensor{Y} must be those of a stride @math{(s_r, s_c)} 1x1 convolution of
+ * @tensor{X} without padding, i.e. @math{Y_h = \lceil X_h / s_r \rceil} and
+ * @math{Y_w = \lceil X_w / s_c \rceil}.
+ *
+ * `scratch` must point to a word-aligned address.
+ *
+ * @param[out]  Y           The output image @tensor{Y}
+ * @param[in]   X           The input image @tensor{X}
+ * @param[in]   K           The kernel tensor @tensor{K}
+ * @param[in]   BSO         The bias-scale-offset array
+ * @param[in]   x_params    Parameters describing the shape of input image
+ * tensor @tensor{X}
+ * @param[in]   y_params    Parameters describing the shape of output image
+ * tensor @tensor{Y}
+ * @param[in]   stride_rows The vertical stride @math{s_r}
+ * @param[in]   stride_cols The horizontal stride @math{s_c}
+ * @param[in]   scratch     Buffer for the gathered input pixels of a row
+ */
+void conv2d_1x1_strided(nn_image_t* Y, const nn_image_t* X,
+                        const nn_tensor_t* K, const nn_bso_block_t* BSO,
+                        const nn_image_params_t* x_params,
+                        const nn_image_params_t* y_params,
+                        const unsigned stride_rows, const unsigned stride_cols,
+                        nn_image_t* scratch);
+
 /**
  * @brief Invoke a @oper{conv2d_depthwise} job.
  *
@@ -1224,6 +1515,93 @@ void conv2d_depthwise_ext(int8_t* Y, const int8_t* X, const int8_t* K,
                           const nn_window_op_job_params_t* job_params,
                           const nn_conv2d_depthwise_flags_e flags);
 
+/**
+ * @brief Invoke a @oper{conv2d_depthwise} job followed by a table lookup of its
+ * outputs.
+ *
+ * This computes the same output as conv2d_depthwise_ext() followed by
+ * lookup8() of the job's outputs. Each row of outputs of each output channel
+ * group is looked up as soon as it has been computed, instead of in a separate
+ * pass over @tensor{Y}.
+ *
+ * `lut` points to the 256-entry table, indexed by each output reinterpreted as
+ * a `uint8_t`. The remaining parameters are as described for
+ * conv2d_depthwise_ext().
+ *
+ * @param[out]  Y           The output image @tensor{Y}
+ * @param[in]   X           The input image @tensor{X}
+ * @param[in]   K           The kernel tensor @tensor{K}
+ * @param[in]   BSO         The bias-scale-offset array
+ * @param[in]   zero_point  The value @math{z_0} to be used for padding (for all
+ * channels)
+ * @param[in]   x_params    Parameters describing the shape of input image
+ * tensor @tensor{X}
+ * @param[in]   y_params    Parameters describing the shape of output image
+ * tensor @tensor{Y}
+ * @param[in]   conv_window Parameters describing the relationship between the
+ * convolution window, the input image, and the output image
+ * @param[in]   job_params  Indicates which output elements will be computed by
+ * this invocation
+ * @param[in]   flags       Flags which modify the behavior of
+ * conv2d_depthwise_ext()
+ * @param[in]   lut         Look-up table applied to the outputs
+ */
+void conv2d_depthwise_ext_lut(int8_t* Y, const int8_t* X, const int8_t* K,
+                              const nn_bso_block_t* BSO,
+                              const int8_t zero_point,
+                              const nn_image_params_t* x_params,
+                              const nn_image_params_t* y_params,
+                              const nn_window_params_t* conv_window,
+                              const nn_window_op_job_params_t* job_params,
+                              const nn_conv2d_depthwise_flags_e flags,
+                              const uint8_t* lut);
+
+/**
+ * @brief Invoke a @oper{conv2d_depthwise} job on an input image which may be a
+ * view of a larger tensor.
+ *
+ * This is conv2d_depthwise_ext(), except that if `flags` includes
+ * `CONV2D_DEPTHWISE_FLAG_INPUT_VIEW`, @tensor{X} is read with the row and
+ * pixel strides in `x_strides`. Crops, channel slices and sub-images of a
+ * larger tensor can then be convolved with no copy into a dense image first.
+ *
+ * `X` points to the first pixel of the view, and `x_params` gives the view's
+ * own height, width and channel count. The view is always read in place, as
+ * the depthwise strip functions step between pixels and rows by arbitrary
+ * strides.
+ *
+ * Both strides must be multiples of 4, and the pixel stride at least
+ * `x_params->channels`. The remaining parameters are as described for
+ * conv2d_depthwise_ext().
+ *
+ * @param[out]  Y           The output image @tensor{Y}
+ * @param[in]   X           The input image @tensor{X}
+ * @param[in]   K           The kernel tensor @tensor{K}
+ * @param[in]   BSO         The bias-scale-offset array
+ * @param[in]   zero_point  The value @math{z_0} to be used for padding (for all
+ * channels)
+ * @param[in]   x_params    Parameters describing the shape of input image
+ * tensor @tensor{X}
+ * @param[in]   y_params    Parameters describing the shape of output image
+ * tensor @tensor{Y}
+ * @param[in]   conv_window Parameters describing the relationship between the
+ * convolution window, the input image, and the output image
+ * @param[in]   job_params  Indicates which output elements will be computed by
+ * this invocation
+ * @param[in]   flags       Flags which modify the behavior of
+ * conv2d_depthwise_ext()
+ * @param[in]   x_strides   The strides of @tensor{X}, if it is a view
+ */
+void conv2d_depthwise_ext_view(int8_t* Y, const int8_t* X, const int8_t* K,
+                               const nn_bso_block_t* BSO,
+                               const int8_t zero_point,
+                               const nn_image_params_t* x_params,
+                               const nn_image_params_t* y_params,
+                               const nn_window_params_t* conv_window,
+                               const nn_window_op_job_params_t* job_params,
+                               const nn_conv2d_depthwise_flags_e flags,
+                               const nn_image_strides_t* x_strides);
+
 /**
  * @brief Perform a 2D convolution of a shallow input image.
  *
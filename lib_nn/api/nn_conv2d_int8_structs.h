@@ -59,6 +59,37 @@ typedef enum {
    * `nn_bso_block_t` must be provided.
    */
   CONV2D_DEEP_FLAG_SLICED_K = (1 << 0),
+
+  /**
+   * If non-zero, this flag signals to conv2d_deep_ext() that @tensor{Y} is a
+   * view of the channels of a larger tensor, such as the output of a channel
+   * concatenation.
+   *
+   * If this is set, `Y` points to the channel of the larger tensor at which
+   * this operator's output begins, and `y_params->channels` is the channel
+   * count of the larger tensor rather than of this operator. Output channel
+   * @math{p} of this operator is written to channel @math{p} of the view, and
+   * `job_params` refers to this operator's output channels. Several operators
+   * can then each write directly into their own channels of the larger tensor,
+   * with no copy to concatenate them afterwards.
+   *
+   * The view must begin a multiple of 4 channels into the larger tensor, so
+   * that `Y` remains word-aligned. Only the job's channels are written.
+   */
+  CONV2D_DEEP_FLAG_OUTPUT_VIEW = (1 << 1),
+
+  /**
+   * If non-zero, this flag signals to conv2d_deep_ext_view() that @tensor{X}
+   * is a view of a larger tensor, such as a crop, a channel slice or a
+   * sub-image, whose rows and pixels are laid out as given by its `x_strides`
+   * argument. `X` points to the first pixel of the view, and `x_params`
+   * describes the view itself.
+   *
+   * If the pixel stride is the channel count, the view is read in place.
+   * Otherwise the rows of each convolution window are first copied into dense
+   * rows of a scratch buffer.
+   */
+  CONV2D_DEEP_FLAG_INPUT_VIEW = (1 << 2),
 } nn_conv2d_deep_flags_e;
 
 /**
@@ -208,6 +239,34 @@ typedef enum {
    * `nn_bso_block_t` must be provided.
    */
   CONV2D_1X1_FLAG_SLICED_K = (1 << 0),
+
+  /**
+   * If non-zero, this flag signals to conv2d_1x1_ext() that @tensor{Y} is a
+   * view of the channels of a larger tensor, such as the output of a channel
+   * concatenation.
+   *
+   * If this is set, `Y` points to the channel of the larger tensor at which
+   * this operator's output begins, and `y_params->channels` is the channel
+   * count of the larger tensor rather than of this operator. Output channel
+   * @math{p} of this operator is written to channel @math{p} of the view, and
+   * `job_params` refers to this operator's output channels.
+   *
+   * The view must begin a multiple of 4 channels into the larger tensor, so
+   * that `Y` remains word-aligned. Only the job's channels are written.
+   */
+  CONV2D_1X1_FLAG_OUTPUT_VIEW = (1 << 1),
+
+  /**
+   * If non-zero, this flag signals to conv2d_1x1_ext_view() that @tensor{X} is
+   * a view of a larger tensor, such as a crop, a channel slice or a sub-image,
+   * whose rows and pixels are laid out as given by its `x_strides` argument.
+   * `X` points to the first pixel of the view, and `x_params` describes the
+   * view itself.
+   *
+   * If the pixel stride is the channel count, the view is read in place.
+   * Otherwise each row of pixels is first copied into a scratch buffer.
+   */
+  CONV2D_1X1_FLAG_INPUT_VIEW = (1 << 2),
 } nn_conv2d_1x1_flags_e;
 
 /**
@@ -271,6 +330,32 @@ typedef enum {
    * `nn_bso_block_t` must be provided.
    */
   CONV2D_DEPTHWISE_FLAG_SLICED_K = (1 << 0),
+
+  /**
+   * If non-zero, this flag signals to conv2d_depthwise_ext() that @tensor{Y}
+   * is a view of the channels of a larger tensor, such as the output of a
+   * channel concatenation.
+   *
+   * If this is set, `Y` points to the channel of the larger tensor at which
+   * this operator's output begins, and `y_params->channels` is the channel
+   * count of the larger tensor rather than of this operator, whose channel
+   * count is then `x_params->channels`. Channel @math{p} of this operator is
+   * written to channel @math{p} of the view, and `job_params` refers to this
+   * operator's channels.
+   *
+   * The view must begin a multiple of 4 channels into the larger tensor, so
+   * that `Y` remains word-aligned. Only the job's channels are written.
+   */
+  CONV2D_DEPTHWISE_FLAG_OUTPUT_VIEW = (1 << 1),
+
+  /**
+   * If non-zero, this flag signals to conv2d_depthwise_ext_view() that
+   * @tensor{X} is a view of a larger tensor, such as a crop, a channel slice or
+   * a sub-image, whose rows and pixels are laid out as given by its `x_strides`
+   * argument. `X` points to the first pixel of the view, and `x_params`
+   * describes the view itself. The view is always read in place.
+   */
+  CONV2D_DEPTHWISE_FLAG_INPUT_VIEW = (1 << 2),
 } nn_conv2d_depthwise_flags_e;
 
 #ifdef __XC__
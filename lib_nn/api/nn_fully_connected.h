@@ -126,6 +126,73 @@ void fully_connected_8(int8_t* Y, const int8_t* W, const int8_t* X,
                        const channel_count_t output_start,
                        const channel_count_t output_count);
 
+/**
+ * @brief Invoke a @oper{fully_connected_8} job over a batch of input vectors.
+ *
+ * This computes the same outputs as calling fully_connected_8() once for each
+ * of `batch_count` input vectors, but with the vectors as the inner loop of
+ * the output channel groups. Each group of 16 rows of @tensor{W} is applied to
+ * every input vector before moving on to the next.
+ *
+ * If `weights_buffer` is not NULL, each group's rows of @tensor{W} and its
+ * `BSO` block are copied into it before the group is applied to the vectors,
+ * which then read them from there. With the buffer in SRAM and @tensor{W} in
+ * slower memory (e.g. flash), the weights are streamed from that memory once
+ * per batch rather than once per vector. If `weights_buffer` is NULL, only the
+ * loop order differs from calling fully_connected_8() for each vector, and
+ * the weights are read in place for every vector.
+ *
+ * @par Parameter Details
+ *
+ * `Y` points to @math{B} contiguous output vectors, each of length
+ * @tensor_shape{M}.
+ *
+ * `X` points to @math{B} contiguous input vectors, each of length
+ * @tensor_shape{N}.
+ *
+ * `M` is the number of outputs of each vector, i.e. the distance in elements
+ * from one output vector to the next.
+ *
+ * `weights_buffer`, if not NULL, must be word-aligned and at least
+ * fully_connected_8_batch_buffer_bytes() bytes.
+ *
+ * The remaining parameters, and their constraints, are as described for
+ * fully_connected_8(). As every output vector must be word-aligned, @math{M}
+ * must be a multiple of @math{4}.
+ *
+ * @param [out] Y               The output vectors @tensor{y}
+ * @param [in]  W               The weight matrix @tensor{W}
+ * @param [in]  X               The input vectors @tensor{x}
+ * @param [in]  BSO             The bias-scale-offset array
+ * @param [in]  N               The number of input channels, @math{N}
+ * @param [in]  M               The number of output channels, @math{M}
+ * @param [in]  output_start    The first output element to compute (index of
+ * @tensor{y})
+ * @param [in]  output_count    The number of output elements to compute
+ * @param [in]  batch_count     The number of vectors, @math{B}
+ * @param [in]  weights_buffer  Buffer into which each group's weights are
+ * copied, or NULL
+ */
+void fully_connected_8_batch(int8_t* Y, const int8_t* W, const int8_t* X,
+                             const nn_bso_block_t* BSO,
+                             const channel_count_t N, const channel_count_t M,
+                             const channel_count_t output_start,
+                             const channel_count_t output_count,
+                             const unsigned batch_count,
+                             int8_t* weights_buffer);
+
+/**
+ * @brief Get the size of the `weights_buffer` of fully_connected_8_batch().
+ *
+ * This is a group of 16 rows of @tensor{W} and a BSO block, with a vector of
+ * padding either side of the rows as fully_connected_8() may read slightly
+ * beyond them.
+ *
+ * @param [in]  N   The number of input channels, @math{N}
+ * @return The number of bytes
+ */
+int32_t fully_connected_8_batch_buffer_bytes(const channel_count_t N);
+
 /**
  * @brief Invoke a @oper{fully_connected_16} job.
  *
@@ -23,4 +23,23 @@ typedef struct {
   channel_count_t channels;
 } nn_image_params_t;
 
+/**
+ * This struct describes where the pixels of an image which is a view of a
+ * larger tensor, such as a crop, a channel slice or a sub-image, lie in memory.
+ *
+ * A dense image has a pixel stride of its channel count and a row stride of
+ * its width times that.
+ */
+typedef struct {
+  /**
+   * Bytes from the start of one row of the image to the start of the next
+   */
+  mem_stride_t row;
+  /**
+   * Bytes from the start of one pixel of the image to the start of the next
+   * pixel in its row
+   */
+  mem_stride_t pixel;
+} nn_image_strides_t;
+
 #endif  // IMAGE_H_
\ No newline at end of file
@@ -113,6 +113,193 @@ void add_elementwise(int8_t Y[], const int8_t X0[], const int8_t X1[],
                      const nn_add_params_t* params, const unsigned elm_start,
                      const unsigned elm_count);
 
+/**
+ * The operation applied by broadcast_elementwise() to each pair of scaled input
+ * elements.
+ */
+typedef enum {
+  /** @math{a = v_0 + v_1} */
+  ELEMENTWISE_OP_ADD = 0,
+  /** @math{a = v_0 - v_1} */
+  ELEMENTWISE_OP_SUB,
+  /** @math{a = round(v_0 \cdot v_1 \cdot 2^{-s_p})} */
+  ELEMENTWISE_OP_MUL,
+  /** @math{a = min(v_0, v_1)} */
+  ELEMENTWISE_OP_MIN,
+  /** @math{a = max(v_0, v_1)} */
+  ELEMENTWISE_OP_MAX,
+  /** @math{a = round(sat_{32}(v_0 - v_1)^2 \cdot 2^{-s_p})} */
+  ELEMENTWISE_OP_SQUARED_DIFFERENCE,
+} nn_elementwise_op_e;
+
+/**
+ * How an input of broadcast_elementwise() is broadcast to the shape of the
+ * output.
+ */
+typedef enum {
+  /** The input has the shape of the output. */
+  ELEMENTWISE_BROADCAST_NONE = 0,
+  /**
+   * The input has one element per channel, which is applied to that channel
+   * of every pixel of the output.
+   */
+  ELEMENTWISE_BROADCAST_CHANNEL,
+  /** The input has one element, which is applied to every output element. */
+  ELEMENTWISE_BROADCAST_SCALAR,
+} nn_elementwise_broadcast_e;
+
+/**
+ * Describes the parameters needed for a @oper{broadcast_elementwise} operator.
+ * @see broadcast_elementwise().
+ */
+typedef struct {
+  /**
+   * The operation applied to each pair of scaled input elements.
+   */
+  nn_elementwise_op_e op;
+
+  /**
+   * The input shifts @math{s_k} and multipliers @math{m_k}, and the output
+   * bias @math{b} and shift @math{s_{out}}, which are as described for
+   * add_elementwise().
+   */
+  nn_add_params_t scale;
+
+  /**
+   * `input_offset[k]` is the 32-bit offset @math{c_k} added to the scaled
+   * elements of @tensor{x_k}. This is usually derived from the zero point of
+   * @tensor{x_k}, and may be zero for `ELEMENTWISE_OP_ADD` and
+   * `ELEMENTWISE_OP_SUB`, where it can be folded into @math{b}.
+   */
+  int32_t input_offset[2];
+
+  /**
+   * `product_shr` is the shift @math{s_p} applied to the products of
+   * `ELEMENTWISE_OP_MUL` and `ELEMENTWISE_OP_SQUARED_DIFFERENCE`. It is
+   * ignored by the other operations.
+   */
+  uint8_t product_shr;
+
+  /**
+   * `broadcast[k]` is how @tensor{x_k} is broadcast to the shape of the
+   * output.
+   */
+  nn_elementwise_broadcast_e broadcast[2];
+
+  /**
+   * `channels` is the number of channels @math{C} of the output, which is the
+   * length of an input broadcast with `ELEMENTWISE_BROADCAST_CHANNEL`.
+   */
+  uint32_t channels;
+} nn_elementwise_params_t;
+
+/**
+ * @brief Invoke a @oper{broadcast_elementwise} job.
+ *
+ * The @oper{broadcast_elementwise} operator combines two quantized 8-bit input
+ * tensors, @tensor{x_0} and @tensor{x_1}, element-by-element to produce the
+ * output vector @tensor{y}. Either input may be broadcast, as a single element
+ * per channel or a single scalar, to the shape of the output. The inputs are
+ * rescaled as in add_elementwise(), and then added, subtracted, multiplied,
+ * compared or subtracted and squared.
+ *
+ * @par Operation Performed
+ *
+ * @f[
+ *
+ *      v_i[k] \leftarrow sat_{32}\!\left( m_i \cdot sat_{16}\!\left(
+ *                         floor\!\left( x_i[\beta_i(k)] \cdot 2^{-s_i}
+ *                         \right) \right) + c_i \right) \\
+ *
+ *      y[k] \leftarrow   sat_{8}\!\left( round\!\left(sat_{32}\!\left(b +
+ * a(v_0[k], v_1[k])\right) \cdot 2^{-s_{out}} \right) \right)
+ *
+ * @f]
+ *
+ * where
+ *
+ * @par
+ * @math{\beta_i(k)} is @math{k}, @math{k \bmod C} or @math{0} if
+ * @tensor{x_i} is not broadcast, broadcast per channel or broadcast as a
+ * scalar respectively,
+ *
+ * @par
+ * @math{a(\cdot,\cdot)} is the operation given by `params->op`, described by
+ * nn_elementwise_op_e, and
+ *
+ * @par
+ * the remaining symbols are as described for add_elementwise().
+ *
+ * With `ELEMENTWISE_OP_ADD`, zero offsets and neither input broadcast this is
+ * exactly add_elementwise(), which is used to compute it.
+ *
+ * @par Vectorization
+ *
+ * Operations are computed on the VPU whenever no intermediate value above can
+ * saturate, @math{s_i \ge -8} and @math{0 \lt s_{out} \lt 32}. Broadcast
+ * inputs are first expanded into a buffer on the stack.
+ *
+ * `ELEMENTWISE_OP_ADD` and `ELEMENTWISE_OP_SUB` are computed with
+ * add_elementwise(), provided no intermediate value exceeds 32 bits.
+ *
+ * `ELEMENTWISE_OP_MIN` and `ELEMENTWISE_OP_MAX` requantize each input with
+ * add_elementwise() (the output scaling is monotonic, so it commutes with
+ * @math{min} and @math{max}) and then select between the results.
+ *
+ * `ELEMENTWISE_OP_MUL` and `ELEMENTWISE_OP_SQUARED_DIFFERENCE` are computed
+ * with 16-bit VPU arithmetic, provided @math{s_i \ge -7} and the scaled
+ * inputs, their difference and the product shifted right by @math{s_p} all
+ * fit in 16 bits, as they do for typical quantized tensors.
+ *
+ * Anything else is computed in plain C, and is not vectorized.
+ *
+ * @par Parameter Details
+ *
+ * `Y` points to the output vector @tensor{y} with shape @tensor_shape{N}. If
+ * the output is an image, @math{N} is its number of pixels times @math{C}.
+ *
+ * `X0` and `X1` respectively point to the first and second input tensors
+ * @tensor{x_0} and @tensor{x_1}, each with shape @tensor_shape{N},
+ * @tensor_shape{C} or @tensor_shape{1} according to `params->broadcast`.
+ *
+ * `params` describes the operation, broadcasting and the parameters
+ * @math{s_i}, @math{m_i}, @math{c_i}, @math{s_p}, @math{b} and @math{s_{out}}
+ * which are applied for each output element.
+ *
+ * `elm_start` and `elm_count` together specify which output elements
+ * @math{y[k]} should be calculated by this invocation. Specifically, this
+ * invocation will calculate @math{y[k]} for which `elm_start` @math{\le k \lt}
+ * `(elm_start + elm_count)`.
+ *
+ * @par Splitting the Workload
+ *
+ * The output elements may be split into any number of jobs, of any size, which
+ * may be run in parallel. A job computing elements that are not a whole number
+ * of pixels is handled correctly.
+ *
+ * @par In-Place Operation
+ *
+ * `Y` may point to `X0` or `X1`, provided that input is not broadcast. The
+ * output may also be written in place by parallel jobs, as each job reads only
+ * the input elements of its own outputs.
+ *
+ * @par Parameter Constraints
+ *
+ * Up to @math{32} bytes past the end of each input which is not broadcast may
+ * be read, as for add_elementwise().
+ *
+ * @param[out]  Y           The output vector @tensor{y}
+ * @param[in]   X0          The first input tensor @tensor{x_0}
+ * @param[in]   X1          The second input tensor @tensor{x_1}
+ * @param[in]   params      The operation, broadcasting, scaling and bias
+ * parameters
+ * @param[in]   elm_start   Index of first output element to be computed
+ * @param[in]   elm_count   Number of output elements to be computed
+ */
+void broadcast_elementwise(int8_t Y[], const int8_t X0[], const int8_t X1[],
+                           const nn_elementwise_params_t* params,
+                           const unsigned elm_start, const unsigned elm_count);
+
 /**
  * @brief Invoke an @oper{argmax_16} job.
  *
@@ -154,6 +341,108 @@ void add_elementwise(int8_t Y[], const int8_t X0[], const int8_t X1[],
  */
 void argmax_16(int32_t* Y, const int16_t* X, const int32_t N);
 
+/**
+ * Describes the parameters needed for a @oper{softmax} operator. @see
+ * softmax_prepare(), softmax_16() and softmax_8().
+ */
+typedef struct {
+  /**
+   * `exp_lo[d]` is @math{e^{-s \cdot d}} in Q15 fixed point, where @math{s} is
+   * the scale of the input and @math{d} is the low byte of the difference
+   * between an input element and the maximum input element.
+   */
+  uint16_t exp_lo[256];
+
+  /**
+   * `exp_hi[d]` is @math{e^{-256 \cdot s \cdot d}} in Q15 fixed point, where
+   * @math{d} is the high byte of the difference.
+   */
+  uint16_t exp_hi[256];
+} nn_softmax_params_t;
+
+/**
+ * @brief Initialize the parameters of a @oper{softmax} operator.
+ *
+ * Fills in the exponent tables of `params` for inputs with the scale
+ * `input_scale`, i.e. whose element @math{x[k]} represents the real value
+ * @math{s \cdot x[k]}. Any softmax temperature @math{\beta} should be folded
+ * into the scale, i.e. `input_scale` should be @math{\beta \cdot s}.
+ *
+ * This need only be called once for each set of inputs with the same scale.
+ *
+ * @param[out]  params      The parameters to be initialized
+ * @param[in]   input_scale The scale @math{s} of the input elements
+ */
+void softmax_prepare(nn_softmax_params_t* params, const float input_scale);
+
+/**
+ * @brief Invoke a @oper{softmax} operator on a 16-bit input vector.
+ *
+ * The @oper{softmax} operator computes the softmax of the quantized input
+ * vector @tensor{x}, such as the 16-bit output of fully_connected_16(), as a
+ * vector of 8-bit probabilities with scale @math{2^{-8}} and zero point
+ * @math{-128}.
+ *
+ * @par Operation Performed
+ *
+ * @f[
+ *      d[k] \leftarrow max_{j}\{ x[j] \} - x[k] \\
+ *      e[k] \leftarrow \left( E_{hi}[d[k] \gg 8] \cdot E_{lo}[d[k] \bmod 256]
+ *                      \right) \cdot 2^{-15} \\
+ *      y[k] \leftarrow min\!\left( round\!\left( \frac{256 \cdot e[k]}
+ *                      {\sum_{j} e[j]} \right), 255 \right) - 128
+ * @f]
+ *
+ * where @math{E_{hi}} and @math{E_{lo}} are the exponent tables of `params`.
+ * Subtracting the maximum keeps every exponent at most @math{1}, so that it can
+ * be looked up in the tables, and the normalization is a single fixed-point
+ * reciprocal of the sum applied to every element.
+ *
+ * @par Parameter Details
+ *
+ * `Y` points to the output vector @tensor{y} with shape @tensor_shape{N}.
+ *
+ * `X` points to the input vector @tensor{x} with shape @tensor_shape{N}.
+ *
+ * `params` holds the exponent tables, initialized by softmax_prepare().
+ *
+ * @par Splitting the Workload
+ *
+ * The whole vector is needed to normalize any element, so the operator cannot
+ * be split into jobs. It is intended for the short vectors of a classifier.
+ *
+ * @par Vectorization
+ *
+ * This operator is not vectorized. Each element needs its own table lookups,
+ * which the VPU cannot do, so the maximum, sum and output passes are all plain
+ * C loops over the elements.
+ *
+ * @param[out]  Y       The output vector @tensor{y}
+ * @param[in]   X       The input vector @tensor{x}
+ * @param[in]   params  The exponent tables
+ * @param[in]   N       The number of elements @math{N} of @tensor{x}
+ */
+void softmax_16(int8_t* Y, const int16_t* X, const nn_softmax_params_t* params,
+                const unsigned N);
+
+/**
+ * @brief Invoke a @oper{softmax} operator on an 8-bit input vector.
+ *
+ * This is softmax_16() for an 8-bit input vector @tensor{x}. The differences
+ * @math{d[k]} are less than @math{256}, so only @math{E_{lo}} is used.
+ *
+ * Like softmax_16(), this is not vectorized. If @math{N} exceeds the number of
+ * values between the least and greatest elements of @tensor{x}, the output for
+ * each of those values is computed once, and the output pass is lookup8().
+ *
+ * @param[out]  Y       The output vector @tensor{y}
+ * @param[in]   X       The input vector @tensor{x}
+ * @param[in]   params  The exponent tables
+ * @param[in]   N       The number of elements @math{N} of @tensor{x}
+ */
+void softmax_8(int8_t* Y, const int8_t* X, const nn_softmax_params_t* params,
+               const unsigned N);
+
 /**
  * @brief Invoke a @oper{lookup8} job.
  *
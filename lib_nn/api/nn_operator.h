@@ -3,7 +3,7 @@
 #ifndef NN_OPERATOR_H_
 #define NN_OPERATOR_H_
 
-#ifdef __XC__
+#if defined(__XC__) || defined(__cplusplus)
 extern "C" {
 #endif
 
@@ -14,7 +14,7 @@ extern "C" {
 #include "nn_op_utils.h"
 #include "nn_pooling.h"
 
-#ifdef __XC__
+#if defined(__XC__) || defined(__cplusplus)
 }  // extern "C"
 #endif
 
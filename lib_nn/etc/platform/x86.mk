@@ -16,6 +16,17 @@ else
 endif
 
 PLATFORM_FLAGS := $(PLATFORM_FLAGS_DEFAULT) -DTF_LITE_DISABLE_X86_NEON
+
+# Host SIMD level used by the VPU simulator, e.g. VPU_SIM_ARCH=native or
+# VPU_SIM_ARCH=haswell. Without it the SSE2 baseline of x86-64 is used.
+ifneq ($(VPU_SIM_ARCH),)
+  PLATFORM_FLAGS += -march=$(VPU_SIM_ARCH)
+endif
+
+# Force the plain C VPU simulator
+ifeq ($(VPU_SIM_SCALAR),true)
+  PLATFORM_FLAGS += -DNN_VPU_SIM_SCALAR
+endif
 # PLATFORM_FLAGS := $(PLATFORM_FLAGS_DEFAULT) -DTF_LITE_DISABLE_X86_NEON -Wall -fsanitize=undefined -fsanitize=integer -fsanitize=implicit-conversion -fsanitize=address -fsanitize-recover=address
 
 
@@ -26,9 +37,9 @@ CXX := c++
 AR_FLAGS := -r
 CC_FLAGS  := -g -O3
 XCC_FLAGS := -g -O3
-CXX_FLAGS := -g -O3 -std=c++11
+CXX_FLAGS := -g -O3 -std=c++11 -pthread
 
-LD_FLAGS  := -L/usr/local/lib -lm -lstdc++
+LD_FLAGS  := -L/usr/local/lib -lm -lstdc++ -pthread
 
 XSCOPE_CONFIG := 
 
@@ -0,0 +1,612 @@
+// Copyright 2020-2021 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../asm/asm_constants.h"
+#include "../nn_op_helper.h"
+#include "nn_operator.h"
+#include "vpu_sim.h"
+#include "xs3_vpu.h"
+
+#ifdef CONFIG_SYMMETRIC_SATURATION_GLOBAL
+#define CONFIG_SYMMETRIC_SATURATION_broadcast_elementwise \
+  CONFIG_SYMMETRIC_SATURATION_GLOBAL
+#else
+#ifndef CONFIG_SYMMETRIC_SATURATION_broadcast_elementwise
+#define CONFIG_SYMMETRIC_SATURATION_broadcast_elementwise (0)
+#endif
+#endif
+
+#if CONFIG_SYMMETRIC_SATURATION_broadcast_elementwise
+#define NEG_SAT_VAL (-127)
+#else
+#define NEG_SAT_VAL (-128)
+#endif
+
+#define MAX(A, B) (((A) >= (B)) ? (A) : (B))
+#define MIN(A, B) (((A) <= (B)) ? (A) : (B))
+
+// Elements are computed a vector's worth at a time, so that the inner loops
+// over each chunk have no branches and a fixed maximum length
+#define CHUNK_ELMS (VPU_INT8_EPV)
+
+// Broadcast inputs to the VPU kernels are expanded this many elements at a
+// time. The kernels may read a vector past the end of each.
+#define VPU_CHUNK_ELMS (4 * VPU_INT8_EPV)
+
+/**
+ * The vectors used by broadcast_elementwise_product() to compute
+ * `ELEMENTWISE_OP_MUL` or `ELEMENTWISE_OP_SQUARED_DIFFERENCE`. Its layout is
+ * relied on by broadcast_elementwise_product.S.
+ */
+typedef struct {
+  // Word offset = 0
+  int16_t multiplier[2][VPU_INT16_EPV];
+  // Word offset = 16
+  int16_t offset_hi[2][VPU_INT16_EPV];
+  // Word offset = 32
+  int16_t offset_lo[2][VPU_INT16_EPV];
+  // Word offset = 48
+  int16_t bias_hi[VPU_INT16_EPV];
+  // Word offset = 56
+  int16_t bias_lo[VPU_INT16_EPV];
+  // Word offset = 64
+  int16_t ones[VPU_INT16_EPV];
+  // Word offset = 72
+  int16_t product_shr[VPU_INT16_EPV];
+  // Word offset = 80
+  int16_t output_shr[VPU_INT16_EPV];
+  // Word offset = 88
+  int32_t input_shr[2];
+  // Word offset = 90
+  int32_t squared_difference;
+} nn_elementwise_product_plan_t;
+
+/**
+ * How broadcast_elementwise() computes an operation with the VPU.
+ */
+typedef struct {
+  /// `ELEMENTWISE_OP_ADD` and `ELEMENTWISE_OP_SUB`: the parameters with which
+  /// add_elementwise() computes the outputs.
+  nn_add_params_t add;
+  /// `ELEMENTWISE_OP_MIN` and `ELEMENTWISE_OP_MAX`: the parameters with which
+  /// add_elementwise() computes the output for each input alone.
+  nn_add_params_t input[2];
+  /// `ELEMENTWISE_OP_MUL` and `ELEMENTWISE_OP_SQUARED_DIFFERENCE`
+  nn_elementwise_product_plan_t product;
+} nn_elementwise_vpu_plan_t;
+
+/**
+ * Compute `elm_count` outputs of `ELEMENTWISE_OP_MUL` or
+ * `ELEMENTWISE_OP_SQUARED_DIFFERENCE` from unbroadcast inputs with 16-bit VPU
+ * arithmetic. Each input may be read up to a vector past its end, and `Y` may
+ * be either input.
+ */
+void broadcast_elementwise_product(int8_t Y[], const int8_t X0[],
+                                   const int8_t X1[],
+                                   const nn_elementwise_product_plan_t* plan,
+                                   const unsigned elm_count);
+
+/**
+ * Set each of the `elm_count` elements of `Y` to the maximum (if `take_max`)
+ * or minimum of the corresponding elements of `A` and `B`. Each input may be
+ * read up to a vector past its end.
+ */
+void broadcast_elementwise_select(int8_t Y[], const int8_t A[],
+                                  const int8_t B[], const unsigned take_max,
+                                  const unsigned elm_count);
+
+static inline int64_t round_shr64(const int64_t a, const unsigned shr) {
+  if (shr == 0) return a;
+  return (a + (((int64_t)1) << (shr - 1))) >> shr;
+}
+
+static inline int32_t scale_input(const int8_t x, const int16_t shr,
+                                  const int16_t multiplier,
+                                  const int32_t offset) {
+  const int32_t shifted = (shr >= 0) ? (x >> shr) : ((int32_t)x * (1 << -shr));
+  return sat_s32((int64_t)sat_s16(shifted) * multiplier + offset);
+}
+
+/**
+ * Scale the `count` elements of input `k` for the outputs starting at
+ * `elm_start` into `V`.
+ */
+static void scale_chunk(int32_t V[], const int8_t X[],
+                        const nn_elementwise_params_t* params, const int k,
+                        const unsigned elm_start, const unsigned count) {
+  const int16_t shr = params->scale.input[k].shr;
+  const int16_t multiplier = params->scale.input[k].multiplier;
+  const int32_t offset = params->input_offset[k];
+
+  switch (params->broadcast[k]) {
+    case ELEMENTWISE_BROADCAST_NONE:
+      X = ADDR(X, elm_start);
+      for (unsigned i = 0; i < count; i++)
+        V[i] = scale_input(X[i], shr, multiplier, offset);
+      break;
+    case ELEMENTWISE_BROADCAST_CHANNEL: {
+      unsigned c = elm_start % params->channels;
+      for (unsigned i = 0; i < count; i++) {
+        V[i] = scale_input(X[c], shr, multiplier, offset);
+        if (++c == params->channels) c = 0;
+      }
+      break;
+    }
+    case ELEMENTWISE_BROADCAST_SCALAR: {
+      const int32_t v = scale_input(X[0], shr, multiplier, offset);
+      for (unsigned i = 0; i < count; i++) V[i] = v;
+      break;
+    }
+  }
+}
+
+/**
+ * Set `add` so that add_elementwise() computes the outputs of `params`, whose
+ * operation must be `ELEMENTWISE_OP_ADD` or `ELEMENTWISE_OP_SUB`.
+ *
+ * add_elementwise() does not saturate its intermediate values, and the VPU
+ * accumulates them in 32 bits, so this is only possible if none of them can
+ * exceed 32 bits. Returns 0 if it is not.
+ */
+/**
+ * The largest |x >> shr| of an int8 x, which is reached by -128 as the shift
+ * rounds towards minus infinity. It is 1 for any shr >= 7.
+ */
+static inline int64_t shifted_input_max(const int16_t shr) {
+  const int16_t s = MIN(shr, 8);
+  return (s >= 0) ? ((128 + (1 << s) - 1) >> s) : ((int64_t)128 << -s);
+}
+
+static int to_add_params(nn_add_params_t* add,
+                         const nn_elementwise_params_t* params) {
+  *add = params->scale;
+  if (params->op == ELEMENTWISE_OP_SUB) {
+    if (add->input[1].multiplier == INT16_MIN) return 0;
+    add->input[1].multiplier = -add->input[1].multiplier;
+  }
+  if (add->output.shr == 0 || add->output.shr > 31) return 0;
+
+  int64_t bound = (int64_t)params->scale.output.bias;
+  if (bound < 0) bound = -bound;
+  for (int k = 0; k < 2; k++) {
+    // Inputs shifted left by more than 8 bits may saturate to 16 bits
+    const int16_t shr = add->input[k].shr;
+    if (shr < -8) return 0;
+    const int64_t x_max = shifted_input_max(shr);
+    int64_t mul = add->input[k].multiplier;
+    int64_t offset = params->input_offset[k];
+    if (mul < 0) mul = -mul;
+    if (offset < 0) offset = -offset;
+    bound += x_max * mul + offset;
+  }
+  if (bound > INT32_MAX) return 0;
+
+  add->output.bias += params->input_offset[0];
+  add->output.bias += (params->op == ELEMENTWISE_OP_SUB)
+                          ? -params->input_offset[1]
+                          : params->input_offset[1];
+  return 1;
+}
+
+/**
+ * Set `input` so that add_elementwise() computes the output for each input of
+ * `params` alone, as if it were both operands of `ELEMENTWISE_OP_MIN` or
+ * `ELEMENTWISE_OP_MAX`.
+ *
+ * The rest of the operation, `sat8(round(sat32(b + a) >> s_out))`, never
+ * decreases as `a` increases, so the least or greatest of those two outputs
+ * is the output of the minimum or maximum. This holds under the same
+ * conditions as to_add_params(). Returns 0 if they are not met.
+ */
+static int to_compare_params(nn_add_params_t input[2],
+                             const nn_elementwise_params_t* params) {
+  if (params->scale.output.shr == 0 || params->scale.output.shr > 31)
+    return 0;
+
+  for (int k = 0; k < 2; k++) {
+    const int16_t shr = params->scale.input[k].shr;
+    if (shr < -8) return 0;
+    int64_t bound = (int64_t)params->scale.output.bias;
+    int64_t mul = params->scale.input[k].multiplier;
+    int64_t offset = params->input_offset[k];
+    if (bound < 0) bound = -bound;
+    if (mul < 0) mul = -mul;
+    if (offset < 0) offset = -offset;
+    if (bound + shifted_input_max(shr) * mul + offset > INT32_MAX) return 0;
+
+    input[k] = params->scale;
+    input[k].input[1 - k].shr = 0;
+    input[k].input[1 - k].multiplier = 0;
+    input[k].output.bias += params->input_offset[k];
+  }
+  return 1;
+}
+
+/**
+ * Fill `plan` so that broadcast_elementwise_product() computes the outputs of
+ * `params`, whose operation must be `ELEMENTWISE_OP_MUL` or
+ * `ELEMENTWISE_OP_SQUARED_DIFFERENCE`.
+ *
+ * The scaled inputs, their difference and the shifted product are held in 16
+ * bits, which the VPU saturates to +/-0x7FFF, so this is only possible if none
+ * of them can exceed that. Returns 0 if they can.
+ */
+static int to_product_plan(nn_elementwise_product_plan_t* plan,
+                           const nn_elementwise_params_t* params) {
+  const unsigned product_shr = params->product_shr;
+  const unsigned output_shr = params->scale.output.shr;
+  if (product_shr > 31 || output_shr > 31) return 0;
+
+  int64_t v_max[2];
+  for (int k = 0; k < 2; k++) {
+    // -128 << 8 would saturate to -0x7FFF rather than -0x8000
+    const int16_t shr = params->scale.input[k].shr;
+    if (shr < -7) return 0;
+    int64_t mul = params->scale.input[k].multiplier;
+    int64_t offset = params->input_offset[k];
+    if (mul < 0) mul = -mul;
+    if (offset < 0) offset = -offset;
+    v_max[k] = shifted_input_max(shr) * mul + offset;
+    if (v_max[k] > VPU_INT16_MAX) return 0;
+  }
+
+  const int squared_difference =
+      (params->op == ELEMENTWISE_OP_SQUARED_DIFFERENCE);
+  int64_t p_max = v_max[0] * v_max[1];
+  if (squared_difference) {
+    const int64_t d_max = v_max[0] + v_max[1];
+    if (d_max > VPU_INT16_MAX) return 0;
+    p_max = d_max * d_max;
+  }
+
+  // The rounded product is at most one more than the truncated one
+  const int64_t a_max = (p_max >> product_shr) + 1;
+  if (a_max > VPU_INT16_MAX) return 0;
+
+  int64_t bias = params->scale.output.bias;
+  if (bias < 0) bias = -bias;
+  const int64_t round = (output_shr > 0) ? ((int64_t)1 << (output_shr - 1)) : 0;
+  if (bias + a_max + round > INT32_MAX) return 0;
+
+  const int32_t b = params->scale.output.bias;
+  for (int i = 0; i < VPU_INT16_EPV; i++) {
+    for (int k = 0; k < 2; k++) {
+      const int32_t c = params->input_offset[k];
+      plan->multiplier[k][i] = params->scale.input[k].multiplier;
+      plan->offset_hi[k][i] = (int16_t)(c >> VPU_INT8_ACC_VR_BITS);
+      plan->offset_lo[k][i] = (int16_t)(c & 0xFFFF);
+    }
+    plan->bias_hi[i] = (int16_t)(b >> VPU_INT8_ACC_VR_BITS);
+    plan->bias_lo[i] = (int16_t)(b & 0xFFFF);
+    plan->ones[i] = 1;
+    plan->product_shr[i] = product_shr;
+    plan->output_shr[i] = output_shr;
+  }
+  plan->input_shr[0] = params->scale.input[0].shr;
+  plan->input_shr[1] = params->scale.input[1].shr;
+  plan->squared_difference = squared_difference;
+  return 1;
+}
+
+/**
+ * Fill `plan` so that vpu_broadcast() computes the outputs of `params`.
+ * Returns 0 if the VPU cannot compute them exactly.
+ */
+static int to_vpu_plan(nn_elementwise_vpu_plan_t* plan,
+                       const nn_elementwise_params_t* params) {
+  switch (params->op) {
+    case ELEMENTWISE_OP_ADD:
+    case ELEMENTWISE_OP_SUB:
+      return to_add_params(&plan->add, params);
+    case ELEMENTWISE_OP_MIN:
+    case ELEMENTWISE_OP_MAX:
+      return to_compare_params(plan->input, params);
+    case ELEMENTWISE_OP_MUL:
+    case ELEMENTWISE_OP_SQUARED_DIFFERENCE:
+      return to_product_plan(&plan->product, params);
+  }
+  return 0;
+}
+
+/**
+ * Point `*X_chunk` at the `count` elements of input `k` for the outputs
+ * starting at `elm_start`, expanding them into `buff` if the input is
+ * broadcast.
+ */
+static void expand_chunk(const int8_t** X_chunk, int8_t buff[],
+                         const int8_t X[],
+                         const nn_elementwise_params_t* params, const int k,
+                         const unsigned elm_start, const unsigned count) {
+  switch (params->broadcast[k]) {
+    case ELEMENTWISE_BROADCAST_NONE:
+      *X_chunk = ADDR(X, elm_start);
+      return;
+    case ELEMENTWISE_BROADCAST_CHANNEL: {
+      unsigned c = elm_start % params->channels;
+      for (unsigned i = 0; i < count;) {
+        const unsigned run = MIN(params->channels - c, count - i);
+        memcpy(&buff[i], &X[c], run);
+        i += run;
+        c = 0;
+      }
+      break;
+    }
+    case ELEMENTWISE_BROADCAST_SCALAR:
+      memset(buff, X[0], count);
+      break;
+  }
+  *X_chunk = buff;
+}
+
+/**
+ * Compute the outputs of `params` with the VPU kernels, following `plan`,
+ * expanding broadcast inputs a chunk at a time.
+ */
+static void vpu_broadcast(int8_t Y[], const int8_t X0[], const int8_t X1[],
+                          const nn_elementwise_params_t* params,
+                          const nn_elementwise_vpu_plan_t* plan,
+                          const unsigned elm_start, const unsigned elm_count) {
+  int8_t buff0[VPU_CHUNK_ELMS + VPU_INT8_EPV];
+  int8_t buff1[VPU_CHUNK_ELMS + VPU_INT8_EPV];
+  int8_t Y0[VPU_CHUNK_ELMS];
+  int8_t Y1[VPU_CHUNK_ELMS];
+
+  for (unsigned start = elm_start; start < elm_start + elm_count;
+       start += VPU_CHUNK_ELMS) {
+    const unsigned remaining = elm_start + elm_count - start;
+    const unsigned count = MIN(remaining, VPU_CHUNK_ELMS);
+    int8_t* Y_chunk = ADDR(Y, start);
+
+    const int8_t* X0_chunk;
+    const int8_t* X1_chunk;
+    expand_chunk(&X0_chunk, buff0, X0, params, 0, start, count);
+    expand_chunk(&X1_chunk, buff1, X1, params, 1, start, count);
+
+    switch (params->op) {
+      case ELEMENTWISE_OP_ADD:
+      case ELEMENTWISE_OP_SUB:
+        add_elementwise(Y_chunk, X0_chunk, X1_chunk, &plan->add, 0, count);
+        break;
+      case ELEMENTWISE_OP_MIN:
+      case ELEMENTWISE_OP_MAX:
+        add_elementwise(Y0, X0_chunk, X0_chunk, &plan->input[0], 0, count);
+        add_elementwise(Y1, X1_chunk, X1_chunk, &plan->input[1], 0, count);
+        broadcast_elementwise_select(Y_chunk, Y0, Y1,
+                                     params->op == ELEMENTWISE_OP_MAX, count);
+        break;
+      case ELEMENTWISE_OP_MUL:
+      case ELEMENTWISE_OP_SQUARED_DIFFERENCE:
+        broadcast_elementwise_product(Y_chunk, X0_chunk, X1_chunk,
+                                      &plan->product, count);
+        break;
+    }
+  }
+}
+
+void broadcast_elementwise(int8_t Y[], const int8_t X0[], const int8_t X1[],
+                           const nn_elementwise_params_t* params,
+                           const unsigned elm_start, const unsigned elm_count) {
+  assert(params->channels > 0 ||
+         (params->broadcast[0] != ELEMENTWISE_BROADCAST_CHANNEL &&
+          params->broadcast[1] != ELEMENTWISE_BROADCAST_CHANNEL));
+
+  // A plain addition is add_elementwise()
+  if (params->op == ELEMENTWISE_OP_ADD &&
+      params->broadcast[0] == ELEMENTWISE_BROADCAST_NONE &&
+      params->broadcast[1] == ELEMENTWISE_BROADCAST_NONE &&
+      params->input_offset[0] == 0 && params->input_offset[1] == 0) {
+    add_elementwise(Y, X0, X1, &params->scale, elm_start, elm_count);
+    return;
+  }
+
+  // Otherwise the VPU kernels are used unless an intermediate value might
+  // saturate, in which case the operation is computed in plain C
+  nn_elementwise_vpu_plan_t plan;
+  if (to_vpu_plan(&plan, params)) {
+    vpu_broadcast(Y, X0, X1, params, &plan, elm_start, elm_count);
+    return;
+  }
+
+  const int32_t bias = params->scale.output.bias;
+  const unsigned out_shr = params->scale.output.shr;
+  const unsigned product_shr = params->product_shr;
+
+  int32_t V0[CHUNK_ELMS];
+  int32_t V1[CHUNK_ELMS];
+  int64_t acc[CHUNK_ELMS];
+
+  for (unsigned start = elm_start; start < elm_start + elm_count;
+       start += CHUNK_ELMS) {
+    const unsigned remaining = elm_start + elm_count - start;
+    const unsigned count = MIN(remaining, CHUNK_ELMS);
+
+    // Both inputs are read before any output is written, so Y may be an input
+    scale_chunk(V0, X0, params, 0, start, count);
+    scale_chunk(V1, X1, params, 1, start, count);
+
+    switch (params->op) {
+      case ELEMENTWISE_OP_ADD:
+        for (unsigned i = 0; i < count; i++)
+          acc[i] = (int64_t)V0[i] + V1[i];
+        break;
+      case ELEMENTWISE_OP_SUB:
+        for (unsigned i = 0; i < count; i++)
+          acc[i] = (int64_t)V0[i] - V1[i];
+        break;
+      case ELEMENTWISE_OP_MUL:
+        for (unsigned i = 0; i < count; i++)
+          acc[i] = round_shr64((int64_t)V0[i] * V1[i], product_shr);
+        break;
+      case ELEMENTWISE_OP_MIN:
+        for (unsigned i = 0; i < count; i++) acc[i] = MIN(V0[i], V1[i]);
+        break;
+      case ELEMENTWISE_OP_MAX:
+        for (unsigned i = 0; i < count; i++) acc[i] = MAX(V0[i], V1[i]);
+        break;
+      case ELEMENTWISE_OP_SQUARED_DIFFERENCE:
+        for (unsigned i = 0; i < count; i++) {
+          const int64_t d = sat_s32((int64_t)V0[i] - V1[i]);
+          acc[i] = round_shr64(d * d, product_shr);
+        }
+        break;
+    }
+
+    int8_t* Y_chunk = ADDR(Y, start);
+    for (unsigned i = 0; i < count; i++) {
+      int64_t y = round_shr64(sat_s32(bias + acc[i]), out_shr);
+      y = MIN(y, VPU_INT8_MAX);
+      y = MAX(y, NEG_SAT_VAL);
+      Y_chunk[i] = (int8_t)y;
+    }
+  }
+}
+
+void broadcast_elementwise_product_ref(
+    int8_t Y[], const int8_t X0[], const int8_t X1[],
+    const nn_elementwise_product_plan_t* plan, const unsigned elm_count) {
+  xs3_vpu vpu;
+  vpu_vector_t vec_x[2];
+  vpu_vector_t vec_v[2];
+  vpu_vector_t vec_tmp;
+  vpu_vector_t vec_y;
+#if !CONFIG_SYMMETRIC_SATURATION_broadcast_elementwise
+  vpu_vector_t vec_acc_hi;
+  vpu_vector_t vec_acc_lo;
+#endif
+
+  memset(vec_x, 0, sizeof(vec_x));
+
+  for (unsigned start = 0; start < elm_count; start += VPU_INT16_EPV) {
+    const unsigned count = MIN(elm_count - start, VPU_INT16_EPV);
+    const unsigned mask = (1 << count) - 1;
+
+    // Both inputs are read before any output is written, so Y may be an input
+    memcpy(vec_x[0].s8, &X0[start], count);
+    memcpy(vec_x[1].s8, &X1[start], count);
+
+    for (int k = 0; k < 2; k++) {
+      // Extend the inputs to 16 bits and shift them
+      VSETC(&vpu, MODE_S8);
+      VCLRDR(&vpu);
+      VLDC(&vpu, vpu_vects.vec_0x01);
+      VLMACC(&vpu, vec_x[k].s8);
+      VSTR(&vpu, vec_tmp.s16);
+      VSETC(&vpu, MODE_S16);
+      VLASHR(&vpu, vec_tmp.s16, plan->input_shr[k]);
+      VSTR(&vpu, vec_tmp.s16);
+
+      // v_k = c_k + m_k * x_k fits in 16 bits, so it is the low half of the
+      // accumulators
+      VLDD(&vpu, plan->offset_hi[k]);
+      VLDR(&vpu, plan->offset_lo[k]);
+      VLDC(&vpu, plan->multiplier[k]);
+      VLMACC(&vpu, vec_tmp.s16);
+      VSTR(&vpu, vec_v[k].s16);
+    }
+
+    if (plan->squared_difference) {
+      VLDR(&vpu, vec_v[0].s16);
+      VLSUB(&vpu, vec_v[1].s16);
+      VSTR(&vpu, vec_tmp.s16);
+      VCLRDR(&vpu);
+      VLDC(&vpu, vec_tmp.s16);
+      VLMACC(&vpu, vec_tmp.s16);
+    } else {
+      VCLRDR(&vpu);
+      VLDC(&vpu, vec_v[0].s16);
+      VLMACC(&vpu, vec_v[1].s16);
+    }
+    VLSAT(&vpu, plan->product_shr);
+    VSTR(&vpu, vec_tmp.s16);
+
+    VLDD(&vpu, plan->bias_hi);
+    VLDR(&vpu, plan->bias_lo);
+    VLDC(&vpu, plan->ones);
+    VLMACC(&vpu, vec_tmp.s16);
+
+#if !CONFIG_SYMMETRIC_SATURATION_broadcast_elementwise
+    // Outputs below -127 are found in 16 bits, as VLSAT saturates them to
+    // -127 in 8 bits
+    VSTD(&vpu, vec_acc_hi.s16);
+    VSTR(&vpu, vec_acc_lo.s16);
+    VLSAT(&vpu, plan->output_shr);
+    VLADD(&vpu, vpu_vects.vec_0x007F);
+    VDEPTH1(&vpu);
+    VSTR(&vpu, vec_tmp.s32);
+    const unsigned neg_mask = vec_tmp.u32[0] & mask;
+    VLDD(&vpu, vec_acc_hi.s16);
+    VLDR(&vpu, vec_acc_lo.s16);
+#endif
+
+    VSETC(&vpu, MODE_S8);
+    VLSAT(&vpu, plan->output_shr);
+    VSTRPV(&vpu, vec_y.s8, mask);
+
+#if !CONFIG_SYMMETRIC_SATURATION_broadcast_elementwise
+    VLDR(&vpu, vpu_vects.vec_0x80);
+    VSTRPV(&vpu, vec_y.s8, neg_mask);
+#endif
+
+    memcpy(&Y[start], vec_y.s8, count);
+  }
+}
+
+void broadcast_elementwise_select_ref(int8_t Y[], const int8_t A[],
+                                      const int8_t B[],
+                                      const unsigned take_max,
+                                      const unsigned elm_count) {
+  xs3_vpu vpu;
+  vpu_vector_t vec_a;
+  vpu_vector_t vec_b;
+  vpu_vector_t vec_y;
+
+  VSETC(&vpu, MODE_S8);
+  memset(&vec_a, 0, sizeof(vec_a));
+  memset(&vec_b, 0, sizeof(vec_b));
+
+  for (unsigned start = 0; start < elm_count; start += VPU_INT8_EPV) {
+    const unsigned count = MIN(elm_count - start, VPU_INT8_EPV);
+    const unsigned mask =
+        (count == VPU_INT8_EPV) ? 0xFFFFFFFF : ((1u << count) - 1);
+
+    memcpy(vec_a.s8, &A[start], count);
+    memcpy(vec_b.s8, &B[start], count);
+
+    // The sign of a - b, which is not changed by saturation
+    VLDR(&vpu, vec_b.s8);
+    VLSUB(&vpu, vec_a.s8);
+    VDEPTH1(&vpu);
+    VSTR(&vpu, vec_y.s8);
+    const unsigned a_less = vec_y.u32[0] & mask;
+
+    VLDR(&vpu, take_max ? vec_a.s8 : vec_b.s8);
+    VSTRPV(&vpu, vec_y.s8, mask);
+    VLDR(&vpu, take_max ? vec_b.s8 : vec_a.s8);
+    VSTRPV(&vpu, vec_y.s8, a_less);
+
+    memcpy(&Y[start], vec_y.s8, count);
+  }
+}
+
+#ifdef NN_USE_REF
+
+void broadcast_elementwise_product(int8_t Y[], const int8_t X0[],
+                                   const int8_t X1[],
+                                   const nn_elementwise_product_plan_t* plan,
+                                   const unsigned elm_count) {
+  broadcast_elementwise_product_ref(Y, X0, X1, plan, elm_count);
+}
+
+void broadcast_elementwise_select(int8_t Y[], const int8_t A[],
+                                  const int8_t B[], const unsigned take_max,
+                                  const unsigned elm_count) {
+  broadcast_elementwise_select_ref(Y, A, B, take_max, elm_count);
+}
+
+#endif  // NN_USE_REF
@@ -97,6 +97,132 @@ void conv2d_1x1(nn_image_t* Y, const nn_image_t* X, const nn_tensor_t* K,
   conv2d_1x1_ext(Y, X, K, BSO, x_params, y_params, &full_job, 0);
 }
 
+void conv2d_1x1_ext_view(nn_image_t* Y, const nn_image_t* X,
+                         const nn_tensor_t* K, const nn_bso_block_t* BSO,
+                         const nn_image_params_t* x_params,
+                         const nn_image_params_t* y_params,
+                         const nn_conv2d_1x1_job_params_t* job_params,
+                         const nn_conv2d_1x1_flags_e flags,
+                         const nn_image_strides_t* x_strides,
+                         nn_image_t* scratch) {
+  if (!(flags & CONV2D_1X1_FLAG_INPUT_VIEW)) {
+    conv2d_1x1_ext(Y, X, K, BSO, x_params, y_params, job_params, flags);
+    return;
+  }
+
+  const unsigned gather =
+      x_strides->pixel != (mem_stride_t)x_params->channels;
+
+  if (CONV2D_INIT_ERROR_DETECTION_ENABLE) {
+    assert(x_params->height == y_params->height);
+    assert(x_params->width == y_params->width);
+    assert(x_strides->row % 4 == 0);
+    assert(x_strides->pixel % 4 == 0);
+    assert(x_strides->pixel >= (mem_stride_t)x_params->channels);
+    assert(!gather || scratch != NULL);
+  }
+
+  // Each row of the job is a 1x1 convolution of a single row image
+  const nn_image_params_t row_x_params = {1, x_params->width,
+                                          x_params->channels};
+  const nn_image_params_t row_y_params = {1, y_params->width,
+                                          y_params->channels};
+  const nn_conv2d_1x1_flags_e row_flags =
+      (nn_conv2d_1x1_flags_e)(flags & ~CONV2D_1X1_FLAG_INPUT_VIEW);
+  const mem_stride_t y_row_stride = y_params->width * y_params->channels;
+
+  const uint32_t start_pix =
+      job_params->start.rows * y_params->width + job_params->start.cols;
+  const uint32_t end_pix = start_pix + job_params->size.pixels;
+
+  nn_conv2d_1x1_job_params_t row_job = *job_params;
+  row_job.start.rows = 0;
+
+  for (uint32_t pix = start_pix; pix < end_pix; pix += row_job.size.pixels) {
+    const uint32_t row = pix / y_params->width;
+    const uint32_t col = pix % y_params->width;
+    row_job.start.cols = col;
+    row_job.size.pixels = (end_pix - pix < y_params->width - col)
+                              ? end_pix - pix
+                              : y_params->width - col;
+
+    const nn_image_t* X_row = ADDR(X, row * x_strides->row);
+
+    if (gather) {
+      // Gather the job's input pixels of this row into their dense positions
+      const nn_image_t* X_pix = ADDR(X_row, col * x_strides->pixel);
+      for (uint32_t c = col; c < col + row_job.size.pixels; c++) {
+        vpu_memcpy(&scratch[c * x_params->channels], X_pix,
+                   x_params->channels);
+        X_pix = ADDR(X_pix, x_strides->pixel);
+      }
+      X_row = scratch;
+    }
+
+    conv2d_1x1_ext(ADDR(Y, row * y_row_stride), X_row, K, BSO, &row_x_params,
+                   &row_y_params, &row_job, row_flags);
+  }
+}
+
+void conv2d_1x1_strided(nn_image_t* Y, const nn_image_t* X,
+                        const nn_tensor_t* K, const nn_bso_block_t* BSO,
+                        const nn_image_params_t* x_params,
+                        const nn_image_params_t* y_params,
+                        const unsigned stride_rows, const unsigned stride_cols,
+                        nn_image_t* scratch) {
+  if (CONV2D_INIT_ERROR_DETECTION_ENABLE) {
+    assert(stride_rows > 0 && stride_cols > 0);
+    assert(y_params->height ==
+           (x_params->height + stride_rows - 1) / stride_rows);
+    assert(y_params->width ==
+           (x_params->width + stride_cols - 1) / stride_cols);
+    assert(stride_cols == 1 || scratch != NULL);
+  }
+
+  // The input pixels used are a view of every stride'th row and column of X
+  const nn_image_params_t view_params = {y_params->height, y_params->width,
+                                         x_params->channels};
+  const nn_image_strides_t view_strides = {
+      stride_rows * x_params->width * x_params->channels,
+      stride_cols * x_params->channels};
+  const nn_conv2d_1x1_job_params_t full_job = {
+      {0, 0, 0}, {y_params->height * y_params->width, y_params->channels}};
+
+  conv2d_1x1_ext_view(Y, X, K, BSO, &view_params, y_params, &full_job,
+                      CONV2D_1X1_FLAG_INPUT_VIEW, &view_strides, scratch);
+}
+
+void conv2d_1x1_ext_lut(nn_image_t* Y, const nn_image_t* X,
+                        const nn_tensor_t* K, const nn_bso_block_t* BSO,
+                        const nn_image_params_t* x_params,
+                        const nn_image_params_t* y_params,
+                        const nn_conv2d_1x1_job_params_t* job_params,
+                        const nn_conv2d_1x1_flags_e flags,
+                        const uint8_t* lut) {
+  const uint32_t start_pix =
+      job_params->start.rows * y_params->width + job_params->start.cols;
+
+  // The job is computed at most a row of pixels at a time, each of which is
+  // looked up as soon as it has been computed
+  nn_conv2d_1x1_job_params_t chunk = *job_params;
+  chunk.start.rows = 0;
+
+  for (uint32_t pix = 0; pix < job_params->size.pixels;
+       pix += chunk.size.pixels) {
+    const uint32_t remaining = job_params->size.pixels - pix;
+    chunk.start.cols = start_pix + pix;
+    chunk.size.pixels = remaining < y_params->width ? remaining
+                                                    : y_params->width;
+
+    conv2d_1x1_ext(Y, X, K, BSO, x_params, y_params, &chunk, flags);
+
+    lookup8_strip(ADDR(Y, chunk.start.cols * y_params->channels +
+                              job_params->start.channels),
+                  lut, chunk.size.pixels, job_params->size.channels,
+                  y_params->channels);
+  }
+}
+
 void conv2d_1x1_ext_ref(nn_image_t* Y, const nn_image_t* X,
                         const nn_tensor_t* K, const nn_bso_block_t* BSO,
                         const nn_image_params_t* x_params,
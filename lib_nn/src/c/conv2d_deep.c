@@ -90,8 +90,8 @@ static void conv2d_deep_adjust_starts(int8_t** Y, const int8_t** X,
                                       const nn_image_params_t* y_params,
                                       const nn_window_params_t* conv_window,
                                       const nn_conv2d_job_params_t* job_params,
-                                      const nn_conv2d_deep_flags_e flags) {
-  const unsigned x_row_bytes = x_params->width * x_params->channels;
+                                      const nn_conv2d_deep_flags_e flags,
+                                      const mem_stride_t x_row_bytes) {
   const unsigned y_row_bytes = y_params->width * y_params->channels;
 
   const int32_t window_start_offset =
@@ -128,7 +128,8 @@ void conv2d_deep_prepare(nn_conv2d_deep_job_t* job,
                          const nn_image_params_t* x_params,
                          const nn_image_params_t* y_params,
                          const nn_window_params_t* conv_window,
-                         const nn_conv2d_job_params_t* job_params) {
+                         const nn_conv2d_job_params_t* job_params,
+                         const mem_stride_t x_row_bytes) {
   if (CONV2D_INIT_ERROR_DETECTION_ENABLE) {
     assert(x_params->channels % 4 ==
            0);  // Input channel count must be multiple of 4.
@@ -175,7 +176,6 @@ void conv2d_deep_prepare(nn_conv2d_deep_job_t* job,
     }
   }
 
-  const unsigned x_row_bytes = x_params->width * x_params->channels;
   const unsigned y_row_bytes = y_params->width * y_params->channels;
   const unsigned patch_width_bytes =
       conv_window->shape.width * x_params->channels;
@@ -183,8 +183,7 @@ void conv2d_deep_prepare(nn_conv2d_deep_job_t* job,
   job->stride.row.X = x_row_bytes - patch_width_bytes;
   job->stride.row.window = x_row_bytes * conv_window->stride.vertical;
   job->stride.row.Y = y_row_bytes;
-  job->stride.chan_group.Y =
-      VPU_INT8_ACC_PERIOD - y_row_bytes * job_params->size.rows;
+  job->stride.chan_group.Y = VPU_INT8_ACC_PERIOD;
   job->stride.chan_group.K =
       conv_window->shape.height * conv_window->shape.width * x_params->channels;
 }
@@ -201,24 +200,90 @@ void conv2d_deep(int8_t* Y, const int8_t* X, const int8_t* K,
                   &full_job, 0);
 }
 
-void conv2d_deep_ext(nn_image_t* Y, const nn_image_t* X, const nn_tensor_t* K,
-                     const nn_bso_block_t* BSO, const int8_t zero_point,
-                     const nn_image_params_t* x_params,
-                     const nn_image_params_t* y_params,
-                     const nn_window_params_t* conv_window,
-                     const nn_window_op_job_params_t* job_params,
-                     const nn_conv2d_deep_flags_e flags) {
+/**
+ * Copy the rows `top` to `top + rows - 1` of the view `X` which are inside the
+ * image into dense rows of `scratch`, where they are read by the strip
+ * functions in place of the view's.
+ */
+static void conv2d_deep_gather_rows(int8_t* scratch, const nn_image_t* X,
+                                    const nn_image_params_t* x_params,
+                                    const nn_image_strides_t* x_strides,
+                                    const int top, const unsigned rows) {
+  const mem_stride_t row_bytes = x_params->width * x_params->channels;
+
+  for (int r = 0; r < rows; r++) {
+    const int x_row = top + r;
+    if (x_row < 0 || x_row >= (int)x_params->height) continue;
+
+    const nn_image_t* X_pix = ADDR(X, x_row * x_strides->row);
+    int8_t* S_pix = ADDR(scratch, r * row_bytes);
+    for (int col = 0; col < x_params->width; col++) {
+      vpu_memcpy(S_pix, X_pix, x_params->channels);
+      X_pix = ADDR(X_pix, x_strides->pixel);
+      S_pix = ADDR(S_pix, x_params->channels);
+    }
+  }
+}
+
+/**
+ * Compute the job for each of `batch_count` contiguous images. The images are
+ * the inner loop of the output channel groups, so a channel group's kernel is
+ * applied to every image before moving on to the next channel group.
+ *
+ * If `weights_buffer` is not NULL, each channel group's kernel and BSO block
+ * are copied into it once, and read from there for every image.
+ *
+ * If `x_strides` is not NULL, the single input image is a view with those
+ * strides. If its pixels are not contiguous, `scratch` receives the rows of
+ * each window.
+ *
+ * If `lut` is not NULL, each strip of outputs is looked up in it as soon as it
+ * has been computed.
+ */
+static void conv2d_deep_batch_impl(
+    nn_image_t* Y, const nn_image_t* X, const nn_tensor_t* K,
+    const nn_bso_block_t* BSO, const int8_t zero_point,
+    const nn_image_params_t* x_params, const nn_image_params_t* y_params,
+    const nn_window_params_t* conv_window,
+    const nn_window_op_job_params_t* job_params,
+    const nn_conv2d_deep_flags_e flags, const unsigned batch_count,
+    int8_t* weights_buffer, const nn_image_strides_t* x_strides,
+    int8_t* scratch, const uint8_t* lut) {
   // nn_image_t (*Y_matrix)[y_params->width][y_params->channels] = (nn_image_t
   // (*)[y_params->width][y_params->channels]) Y;
 
   // printf("Testing: %d!\n", Y_mat[0][0][0]);
 
+  const mem_stride_t x_image_bytes =
+      x_params->height * x_params->width * x_params->channels;
+  const mem_stride_t y_image_bytes =
+      y_params->height * y_params->width * y_params->channels;
+
+  // A view whose pixels are contiguous is read in place, with its own row
+  // stride. Otherwise each window's rows are gathered into dense rows.
+  const unsigned gather =
+      (x_strides != NULL) &&
+      (x_strides->pixel != (mem_stride_t)x_params->channels);
+  const mem_stride_t x_row_bytes = (x_strides != NULL && !gather)
+                                       ? x_strides->row
+                                       : x_params->width * x_params->channels;
+  const nn_image_t* X_view = X;
+
+  if (x_strides != NULL) {
+    assert(batch_count == 1);
+    assert(x_strides->row % 4 == 0);
+    assert(x_strides->pixel % 4 == 0);
+    assert(x_strides->pixel >= (mem_stride_t)x_params->channels);
+    assert(!gather || scratch != NULL);
+  }
+
   conv2d_deep_adjust_starts(&Y, &X, &K, &BSO, x_params, y_params, conv_window,
-                            job_params, flags);
+                            job_params, flags, x_row_bytes);
 
   nn_conv2d_deep_job_t job;
 
-  conv2d_deep_prepare(&job, x_params, y_params, conv_window, job_params);
+  conv2d_deep_prepare(&job, x_params, y_params, conv_window, job_params,
+                      x_row_bytes);
 
   int8_t zero_point_vec[VPU_INT8_EPV];
   memset(zero_point_vec, zero_point, sizeof(zero_point_vec));
@@ -234,7 +299,11 @@ void conv2d_deep_ext(nn_image_t* Y, const nn_image_t* X, const nn_tensor_t* K,
                               &init_padding.left, &init_padding.right, x_params,
                               conv_window, job_params);
 
-  const unsigned C_out_tail = y_params->channels % VPU_INT8_ACC_PERIOD;
+  // A view's final channel group ends with the job, not with the tensor
+  const unsigned C_out_tail =
+      ((flags & CONV2D_DEEP_FLAG_OUTPUT_VIEW) ? job_params->size.channels
+                                               : y_params->channels) %
+      VPU_INT8_ACC_PERIOD;
 
   for (int out_chan = 0; out_chan < job_params->size.channels;
        out_chan += VPU_INT8_ACC_PERIOD) {
@@ -243,70 +312,171 @@ void conv2d_deep_ext(nn_image_t* Y, const nn_image_t* X, const nn_tensor_t* K,
             ? VPU_INT8_VLMACC_ELMS
             : job_params->size.channels - out_chan;
 
-    int pad_t = init_padding.top;
-    int pad_b = init_padding.bottom;
+    const nn_tensor_t* K_cog = K;
+    const nn_bso_block_t* BSO_cog = BSO;
+
+    if (weights_buffer != NULL) {
+      int8_t* K_buf = ADDR(weights_buffer, VPU_INT8_EPV);
+      nn_bso_block_t* BSO_buf = (nn_bso_block_t*)ADDR(
+          K_buf, job.stride.chan_group.K * VPU_INT8_ACC_PERIOD + VPU_INT8_EPV);
+      vpu_memcpy_ext(K_buf, K, job.stride.chan_group.K * cur_chans);
+      vpu_memcpy_ext(BSO_buf, BSO, sizeof(nn_bso_block_t));
+      K_cog = K_buf;
+      BSO_cog = BSO_buf;
+    }
 
-    K = ADDR(K, job.stride.chan_group.K * (cur_chans - 1));
+    // The channels are walked from the last of the group
+    K_cog = ADDR(K_cog, job.stride.chan_group.K * (cur_chans - 1));
 
-    const nn_image_t* X_cog = X;
+    for (unsigned image = 0; image < batch_count; image++) {
+      int pad_t = init_padding.top;
+      int pad_b = init_padding.bottom;
 
-    for (int out_row = 0; out_row < job_params->size.rows; out_row++) {
-      int pad_l = init_padding.left;
-      int pad_r = init_padding.right;
+      const nn_image_t* X_cog = ADDR(X, image * x_image_bytes);
+      nn_image_t* Y_cog = ADDR(Y, image * y_image_bytes);
 
-      const int pad_lr_delta =
-          conv_window->stride.horizontal * (job_params->size.cols - 1);
-      const int final_pad_l = pad_l - pad_lr_delta;
-      const int final_pad_r = pad_r + pad_lr_delta;
+      for (int out_row = 0; out_row < job_params->size.rows; out_row++) {
+        int pad_l = init_padding.left;
+        int pad_r = init_padding.right;
 
-      const int cur_pad_t = (pad_t > 0) ? pad_t : 0;
-      const int cur_pad_b = (pad_b > 0) ? pad_b : 0;
+        const int pad_lr_delta =
+            conv_window->stride.horizontal * (job_params->size.cols - 1);
+        const int final_pad_l = pad_l - pad_lr_delta;
+        const int final_pad_r = pad_r + pad_lr_delta;
 
-      const unsigned requires_padding = (pad_l > 0) || (pad_r > 0) ||
-                                        (cur_pad_t > 0) || (cur_pad_b > 0) ||
-                                        (final_pad_l > 0) || (final_pad_r > 0);
+        const int cur_pad_t = (pad_t > 0) ? pad_t : 0;
+        const int cur_pad_b = (pad_b > 0) ? pad_b : 0;
 
-      if (cur_chans == VPU_INT8_ACC_PERIOD) {
-        if (requires_padding) {
-          nn_conv2d_hstrip_deep_padded(
-              Y, X_cog, K, BSO, conv_window->shape.height,
-              conv_window->shape.width, conv_window->stride.horizontal,
-              x_params->channels, cur_pad_t, cur_pad_b, pad_l, pad_r,
-              job.stride.row.X, -job.stride.chan_group.K, y_params->channels,
-              job_params->size.cols, zero_point_vec);
-        } else {
-          nn_conv2d_hstrip_deep(
-              Y, X_cog, K, BSO, conv_window->shape.height,
-              conv_window->shape.width, conv_window->stride.horizontal,
-              x_params->channels, job.stride.row.X, -job.stride.chan_group.K,
-              y_params->channels, job_params->size.cols);
+        const unsigned requires_padding =
+            (pad_l > 0) || (pad_r > 0) || (cur_pad_t > 0) || (cur_pad_b > 0) ||
+            (final_pad_l > 0) || (final_pad_r > 0);
+
+        // The window's top row is row -pad_t of the image
+        if (gather) {
+          conv2d_deep_gather_rows(scratch, X_view, x_params, x_strides, -pad_t,
+                                  conv_window->shape.height);
+          X_cog = ADDR(scratch, -pad_l * (int)x_params->channels);
         }
-      } else {
-        if (requires_padding) {
-          nn_conv2d_hstrip_tail_deep_padded(
-              Y, X_cog, K, BSO, conv_window->shape.height,
-              conv_window->shape.width, conv_window->stride.horizontal,
-              x_params->channels, cur_pad_t, cur_pad_b, pad_l, pad_r,
-              job.stride.row.X, -job.stride.chan_group.K, y_params->channels,
-              job_params->size.cols, zero_point_vec, C_out_tail);
+
+        if (cur_chans == VPU_INT8_ACC_PERIOD) {
+          if (requires_padding) {
+            nn_conv2d_hstrip_deep_padded(
+                Y_cog, X_cog, K_cog, BSO_cog, conv_window->shape.height,
+                conv_window->shape.width, conv_window->stride.horizontal,
+                x_params->channels, cur_pad_t, cur_pad_b, pad_l, pad_r,
+                job.stride.row.X, -job.stride.chan_group.K, y_params->channels,
+                job_params->size.cols, zero_point_vec);
+          } else {
+            nn_conv2d_hstrip_deep(
+                Y_cog, X_cog, K_cog, BSO_cog, conv_window->shape.height,
+                conv_window->shape.width, conv_window->stride.horizontal,
+                x_params->channels, job.stride.row.X, -job.stride.chan_group.K,
+                y_params->channels, job_params->size.cols);
+          }
         } else {
-          nn_conv2d_hstrip_tail_deep(
-              Y, X_cog, K, BSO, conv_window->shape.height,
-              conv_window->shape.width, conv_window->stride.horizontal,
-              x_params->channels, job.stride.row.X, -job.stride.chan_group.K,
-              y_params->channels, job_params->size.cols, C_out_tail);
+          if (requires_padding) {
+            nn_conv2d_hstrip_tail_deep_padded(
+                Y_cog, X_cog, K_cog, BSO_cog, conv_window->shape.height,
+                conv_window->shape.width, conv_window->stride.horizontal,
+                x_params->channels, cur_pad_t, cur_pad_b, pad_l, pad_r,
+                job.stride.row.X, -job.stride.chan_group.K, y_params->channels,
+                job_params->size.cols, zero_point_vec, C_out_tail);
+          } else {
+            nn_conv2d_hstrip_tail_deep(
+                Y_cog, X_cog, K_cog, BSO_cog, conv_window->shape.height,
+                conv_window->shape.width, conv_window->stride.horizontal,
+                x_params->channels, job.stride.row.X, -job.stride.chan_group.K,
+                y_params->channels, job_params->size.cols, C_out_tail);
+          }
         }
-      }
 
-      pad_t -= conv_window->stride.vertical;
-      pad_b += conv_window->stride.vertical;
+        if (lut != NULL)
+          lookup8_strip(Y_cog, lut, job_params->size.cols, cur_chans,
+                        y_params->channels);
+
+        pad_t -= conv_window->stride.vertical;
+        pad_b += conv_window->stride.vertical;
 
-      X_cog = ADDR(X_cog, job.stride.row.window);
-      Y = ADDR(Y, job.stride.row.Y);
+        X_cog = ADDR(X_cog, job.stride.row.window);
+        Y_cog = ADDR(Y_cog, job.stride.row.Y);
+      }
     }
 
-    K = ADDR(K, job.stride.chan_group.K);
+    K = ADDR(K, job.stride.chan_group.K * cur_chans);
     Y = ADDR(Y, job.stride.chan_group.Y);
     BSO = ADDR(BSO, 1);
   }
-}
\ No newline at end of file
+}
+
+void conv2d_deep_ext(nn_image_t* Y, const nn_image_t* X, const nn_tensor_t* K,
+                     const nn_bso_block_t* BSO, const int8_t zero_point,
+                     const nn_image_params_t* x_params,
+                     const nn_image_params_t* y_params,
+                     const nn_window_params_t* conv_window,
+                     const nn_window_op_job_params_t* job_params,
+                     const nn_conv2d_deep_flags_e flags) {
+  conv2d_deep_batch_impl(Y, X, K, BSO, zero_point, x_params, y_params,
+                         conv_window, job_params, flags, 1, NULL, NULL, NULL,
+                         NULL);
+}
+
+void conv2d_deep_ext_lut(nn_image_t* Y, const nn_image_t* X,
+                         const nn_tensor_t* K, const nn_bso_block_t* BSO,
+                         const int8_t zero_point,
+                         const nn_image_params_t* x_params,
+                         const nn_image_params_t* y_params,
+                         const nn_window_params_t* conv_window,
+                         const nn_window_op_job_params_t* job_params,
+                         const nn_conv2d_deep_flags_e flags,
+                         const uint8_t* lut) {
+  conv2d_deep_batch_impl(Y, X, K, BSO, zero_point, x_params, y_params,
+                         conv_window, job_params, flags, 1, NULL, NULL, NULL,
+                         lut);
+}
+
+void conv2d_deep_batch(nn_image_t* Y, const nn_image_t* X,
+                       const nn_tensor_t* K, const nn_bso_block_t* BSO,
+                       const int8_t zero_point,
+                       const nn_image_params_t* x_params,
+                       const nn_image_params_t* y_params,
+                       const nn_window_params_t* conv_window,
+                       const unsigned batch_count, int8_t* weights_buffer) {
+  const nn_conv2d_job_params_t full_job = {
+      {0, 0, 0}, {y_params->height, y_params->width, y_params->channels}};
+
+  conv2d_deep_batch_impl(Y, X, K, BSO, zero_point, x_params, y_params,
+                         conv_window, &full_job, 0, batch_count,
+                         weights_buffer, NULL, NULL, NULL);
+}
+
+void conv2d_deep_ext_view(nn_image_t* Y, const nn_image_t* X,
+                          const nn_tensor_t* K, const nn_bso_block_t* BSO,
+                          const int8_t zero_point,
+                          const nn_image_params_t* x_params,
+                          const nn_image_params_t* y_params,
+                          const nn_window_params_t* conv_window,
+                          const nn_window_op_job_params_t* job_params,
+                          const nn_conv2d_deep_flags_e flags,
+                          const nn_image_strides_t* x_strides,
+                          int8_t* scratch) {
+  conv2d_deep_batch_impl(
+      Y, X, K, BSO, zero_point, x_params, y_params, conv_window, job_params,
+      flags, 1, NULL, (flags & CONV2D_DEEP_FLAG_INPUT_VIEW) ? x_strides : NULL,
+      scratch, NULL);
+}
+
+int32_t conv2d_deep_view_scratch_bytes(const nn_image_params_t* x_params,
+                                       const nn_window_params_t* conv_window) {
+  // The strip functions may read up to a vector past the final window row
+  return conv_window->shape.height * x_params->width * x_params->channels +
+         VPU_INT8_EPV;
+}
+
+int32_t conv2d_deep_batch_buffer_bytes(const nn_image_params_t* x_params,
+                                       const nn_window_params_t* conv_window) {
+  // The kernel is preceded and followed by a vector, which may be overread
+  const int32_t kernel_bytes = conv_window->shape.height *
+                               conv_window->shape.width * x_params->channels;
+  return VPU_INT8_EPV + VPU_INT8_ACC_PERIOD * kernel_bytes + VPU_INT8_EPV +
+         sizeof(nn_bso_block_t);
+}
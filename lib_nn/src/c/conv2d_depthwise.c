@@ -104,19 +104,18 @@ static void conv2d_depthwise_adjust_starts(
     const nn_image_params_t* x_params, const nn_image_params_t* y_params,
     const nn_window_params_t* conv_window,
     const nn_conv2d_job_params_t* job_params,
-    const nn_conv2d_depthwise_flags_e flags) {
-  const unsigned x_row_bytes = x_params->width * x_params->channels;
+    const nn_conv2d_depthwise_flags_e flags, const mem_stride_t x_row_bytes,
+    const mem_stride_t x_pixel_bytes) {
   const unsigned y_row_bytes = y_params->width * y_params->channels;
 
   const int32_t window_start_offset =
       conv_window->start.row * x_row_bytes +
-      x_params->channels * conv_window->start.column;
+      x_pixel_bytes * conv_window->start.column;
 
   int32_t start_X =
       window_start_offset +
       job_params->start.rows * conv_window->stride.vertical * x_row_bytes +
-      job_params->start.cols * conv_window->stride.horizontal *
-          x_params->channels +
+      job_params->start.cols * conv_window->stride.horizontal * x_pixel_bytes +
       job_params->start.channels;
   int32_t start_Y = job_params->start.rows * y_row_bytes +
                     y_params->channels * job_params->start.cols +
@@ -138,17 +137,27 @@ static void conv2d_depthwise_prepare(nn_conv2d_depthwise_job_t* job,
                                      const nn_image_params_t* x_params,
                                      const nn_image_params_t* y_params,
                                      const nn_window_params_t* conv_window,
-                                     const nn_conv2d_job_params_t* job_params) {
+                                     const nn_conv2d_job_params_t* job_params,
+                                     const nn_conv2d_depthwise_flags_e flags,
+                                     const mem_stride_t x_row_bytes,
+                                     const mem_stride_t x_pixel_bytes) {
   if (CONV2D_PREPARE_ERROR_DETECTION_ENABLE) {
     assert(x_params->channels % 4 == 0);
-    assert(x_params->channels == y_params->channels);
+
+    // A view holds this operator's channels among those of a larger tensor
+    if (flags & CONV2D_DEPTHWISE_FLAG_OUTPUT_VIEW) {
+      assert(y_params->channels % 4 == 0);
+      assert(x_params->channels <= y_params->channels);
+    } else {
+      assert(x_params->channels == y_params->channels);
+    }
 
     assert(job_params->start.rows >= 0 && job_params->start.cols >= 0 &&
            job_params->start.channels >= 0);
     assert(job_params->start.rows + job_params->size.rows <= y_params->height);
     assert(job_params->start.cols + job_params->size.cols <= y_params->width);
     assert(job_params->start.channels + job_params->size.channels <=
-           y_params->channels);
+           x_params->channels);
 
     // Make sure the convolution window is never entirely outside the input
     // image.
@@ -171,13 +180,11 @@ static void conv2d_depthwise_prepare(nn_conv2d_depthwise_job_t* job,
     }
   }
 
-  const unsigned x_row_bytes = x_params->width * x_params->channels;
   const unsigned y_row_bytes = y_params->width * y_params->channels;
   const unsigned k_row_bytes = conv_window->shape.width * y_params->channels;
 
-  job->stride.row.X =
-      x_row_bytes - x_params->channels * conv_window->shape.width;
-  job->stride.col.window = x_params->channels * conv_window->stride.horizontal;
+  job->stride.row.X = x_row_bytes - x_pixel_bytes * conv_window->shape.width;
+  job->stride.col.window = x_pixel_bytes * conv_window->stride.horizontal;
 
   job->stride.row.window = x_row_bytes * conv_window->stride.vertical;
   job->stride.row.Y = y_row_bytes;
@@ -201,21 +208,43 @@ void conv2d_depthwise(int8_t* Y, const int8_t* X, const int8_t* K,
                        conv_window, &full_job, 0);
 }
 
-void conv2d_depthwise_ext(int8_t* Y, const int8_t* X, const int8_t* K,
-                          const nn_bso_block_t* BSO, const int8_t zero_point,
-                          const nn_image_params_t* x_params,
-                          const nn_image_params_t* y_params,
-                          const nn_window_params_t* conv_window,
-                          const nn_window_op_job_params_t* job_params,
-                          const nn_conv2d_depthwise_flags_e flags) {
+/**
+ * Compute the job. If `x_strides` is not NULL, the input is a view with those
+ * strides. If `lut` is not NULL, each strip of outputs is looked up in it as
+ * soon as it has been computed.
+ */
+static void conv2d_depthwise_impl(int8_t* Y, const int8_t* X, const int8_t* K,
+                                  const nn_bso_block_t* BSO,
+                                  const int8_t zero_point,
+                                  const nn_image_params_t* x_params,
+                                  const nn_image_params_t* y_params,
+                                  const nn_window_params_t* conv_window,
+                                  const nn_window_op_job_params_t* job_params,
+                                  const nn_conv2d_depthwise_flags_e flags,
+                                  const nn_image_strides_t* x_strides,
+                                  const uint8_t* lut) {
+  // The strip functions take the input's pixel and row strides, so a view is
+  // always read in place
+  mem_stride_t x_row_bytes = x_params->width * x_params->channels;
+  mem_stride_t x_pixel_bytes = x_params->channels;
+  if (x_strides != NULL) {
+    assert(x_strides->row % 4 == 0);
+    assert(x_strides->pixel % 4 == 0);
+    assert(x_strides->pixel >= (mem_stride_t)x_params->channels);
+    x_row_bytes = x_strides->row;
+    x_pixel_bytes = x_strides->pixel;
+  }
+
   conv2d_depthwise_adjust_starts(&Y, &X, &K, &BSO, x_params, y_params,
-                                 conv_window, job_params, flags);
+                                 conv_window, job_params, flags, x_row_bytes,
+                                 x_pixel_bytes);
 
   int8_t zero_point_vec[VPU_INT8_VLMACC_ELMS];
   memset(zero_point_vec, zero_point, sizeof(zero_point_vec));
 
   nn_conv2d_depthwise_job_t job;
-  conv2d_depthwise_prepare(&job, x_params, y_params, conv_window, job_params);
+  conv2d_depthwise_prepare(&job, x_params, y_params, conv_window, job_params,
+                           flags, x_row_bytes, x_pixel_bytes);
 
   channel_count_t k_channels = x_params->channels;
   if (flags & CONV2D_DEPTHWISE_FLAG_SLICED_K) {
@@ -250,7 +279,7 @@ void conv2d_depthwise_ext(int8_t* Y, const int8_t* X, const int8_t* K,
 
       if (init_padding.unpadded_lr && cur_pad_t == 0 && cur_pad_b == 0) {
         nn_conv2d_hstrip_depthwise(Y, X, K, BSO, conv_window->shape.height,
-                                   conv_window->shape.width, x_params->channels,
+                                   conv_window->shape.width, x_pixel_bytes,
                                    k_channels, job.stride.row.X,
                                    job.stride.col.window, y_params->channels,
                                    job_params->size.cols, cur_chans);
@@ -258,11 +287,15 @@ void conv2d_depthwise_ext(int8_t* Y, const int8_t* X, const int8_t* K,
         nn_conv2d_hstrip_depthwise_padded(
             Y, X, K, BSO, conv_window->shape.height, conv_window->shape.width,
             cur_pad_t, init_padding.left, cur_pad_b, init_padding.right,
-            x_params->channels, k_channels, job.stride.row.X,
+            x_pixel_bytes, k_channels, job.stride.row.X,
             job.stride.col.window, y_params->channels, job_params->size.cols,
             cur_chans, zero_point_vec);
       }
 
+      if (lut != NULL)
+        lookup8_strip(Y, lut, job_params->size.cols, cur_chans,
+                      y_params->channels);
+
       pad_t -= conv_window->stride.vertical;
       pad_b += conv_window->stride.vertical;
 
@@ -277,3 +310,42 @@ void conv2d_depthwise_ext(int8_t* Y, const int8_t* X, const int8_t* K,
     K = ADDR(K, VPU_INT8_VLMACC_ELMS);
   }
 }
+
+void conv2d_depthwise_ext(int8_t* Y, const int8_t* X, const int8_t* K,
+                          const nn_bso_block_t* BSO, const int8_t zero_point,
+                          const nn_image_params_t* x_params,
+                          const nn_image_params_t* y_params,
+                          const nn_window_params_t* conv_window,
+                          const nn_window_op_job_params_t* job_params,
+                          const nn_conv2d_depthwise_flags_e flags) {
+  conv2d_depthwise_impl(Y, X, K, BSO, zero_point, x_params, y_params,
+                        conv_window, job_params, flags, NULL, NULL);
+}
+
+void conv2d_depthwise_ext_lut(int8_t* Y, const int8_t* X, const int8_t* K,
+                              const nn_bso_block_t* BSO,
+                              const int8_t zero_point,
+                              const nn_image_params_t* x_params,
+                              const nn_image_params_t* y_params,
+                              const nn_window_params_t* conv_window,
+                              const nn_window_op_job_params_t* job_params,
+                              const nn_conv2d_depthwise_flags_e flags,
+                              const uint8_t* lut) {
+  conv2d_depthwise_impl(Y, X, K, BSO, zero_point, x_params, y_params,
+                        conv_window, job_params, flags, NULL, lut);
+}
+
+void conv2d_depthwise_ext_view(int8_t* Y, const int8_t* X, const int8_t* K,
+                               const nn_bso_block_t* BSO,
+                               const int8_t zero_point,
+                               const nn_image_params_t* x_params,
+                               const nn_image_params_t* y_params,
+                               const nn_window_params_t* conv_window,
+                               const nn_window_op_job_params_t* job_params,
+                               const nn_conv2d_depthwise_flags_e flags,
+                               const nn_image_strides_t* x_strides) {
+  conv2d_depthwise_impl(
+      Y, X, K, BSO, zero_point, x_params, y_params, conv_window, job_params,
+      flags, (flags & CONV2D_DEPTHWISE_FLAG_INPUT_VIEW) ? x_strides : NULL,
+      NULL);
+}
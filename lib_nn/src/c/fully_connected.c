@@ -230,6 +230,51 @@ void fully_connected_8_ref(int8_t* Y, const int8_t* W, const int8_t* X,
   }
 }
 
+int32_t fully_connected_8_batch_buffer_bytes(const channel_count_t N) {
+  // The rows are preceded and followed by a vector, which may be overread
+  return VPU_INT8_EPV + VPU_INT8_ACC_PERIOD * N + VPU_INT8_EPV +
+         sizeof(nn_bso_block_t);
+}
+
+void fully_connected_8_batch(int8_t* Y, const int8_t* W, const int8_t* X,
+                             const nn_bso_block_t* BSO,
+                             const channel_count_t N, const channel_count_t M,
+                             const channel_count_t output_start,
+                             const channel_count_t output_count,
+                             const unsigned batch_count,
+                             int8_t* weights_buffer) {
+  assert(M % 4 == 0);
+
+  // One output channel group at a time, for every vector of the batch
+  for (channel_count_t start = output_start;
+       start < output_start + output_count; start += VPU_INT8_ACC_PERIOD) {
+    const channel_count_t remaining = output_start + output_count - start;
+    const channel_count_t count = (remaining < VPU_INT8_ACC_PERIOD)
+                                      ? remaining
+                                      : VPU_INT8_ACC_PERIOD;
+
+    if (weights_buffer == NULL) {
+      for (unsigned b = 0; b < batch_count; b++)
+        fully_connected_8(ADDR(Y, b * M), W, ADDR(X, b * N), BSO, N, start,
+                          count);
+      continue;
+    }
+
+    // Stage the group's rows and BSO block, and compute it as outputs
+    // [0, count) of the staged matrix
+    int8_t* W_group = ADDR(weights_buffer, VPU_INT8_EPV);
+    nn_bso_block_t* BSO_group =
+        (nn_bso_block_t*)ADDR(W_group, VPU_INT8_ACC_PERIOD * N + VPU_INT8_EPV);
+    vpu_memcpy_ext(W_group, ADDR(W, start * N), count * N);
+    vpu_memcpy_ext(BSO_group, &BSO[start / VPU_INT8_ACC_PERIOD],
+                   sizeof(nn_bso_block_t));
+
+    for (unsigned b = 0; b < batch_count; b++)
+      fully_connected_8(ADDR(Y, b * M + start), W_group, ADDR(X, b * N),
+                        BSO_group, N, 0, count);
+  }
+}
+
 #ifdef NN_USE_REF
 
 void fc_deepin_shallowout_16(const int8_t* W, const int32_t* B, const int8_t* X,
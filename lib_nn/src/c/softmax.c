@@ -0,0 +1,102 @@
+// Copyright 2020-2021 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../nn_op_helper.h"
+#include "nn_operator.h"
+#include "xs3_vpu.h"
+
+// Exponents are Q15, so e^0 is 2^15
+#define EXP_SHR (15)
+
+// The reciprocal of the sum is scaled so that e * recip >> RECIP_SHR is the
+// output probability with scale 2^-8
+#define RECIP_SHR (46)
+#define OUTPUT_SHR (RECIP_SHR - 8)
+
+void softmax_prepare(nn_softmax_params_t* params, const float input_scale) {
+  assert(input_scale > 0);
+
+  for (int d = 0; d < 256; d++) {
+    params->exp_lo[d] =
+        (uint16_t)lround(ldexp(exp(-(double)input_scale * d), EXP_SHR));
+    params->exp_hi[d] =
+        (uint16_t)lround(ldexp(exp(-(double)input_scale * d * 256), EXP_SHR));
+  }
+}
+
+static inline uint32_t softmax_exp(const nn_softmax_params_t* params,
+                                   const uint32_t d) {
+  return ((uint32_t)params->exp_hi[d >> 8] * params->exp_lo[d & 0xFF]) >>
+         EXP_SHR;
+}
+
+// Every exponent is at most 2^15 and at least one is 2^15, so the reciprocal
+// of the sum fits in 32 bits and each product with it in 47. Keeping it in 32
+// bits makes that product a single 32x32-bit multiply.
+static inline uint32_t softmax_recip(const uint32_t sum) {
+  return (uint32_t)((((uint64_t)1) << RECIP_SHR) / sum);
+}
+
+static inline int8_t softmax_output(const uint32_t e, const uint32_t recip) {
+  const uint64_t round = ((uint64_t)1) << (OUTPUT_SHR - 1);
+  uint64_t y = ((uint64_t)e * recip + round) >> OUTPUT_SHR;
+  if (y > 255) y = 255;
+  return (int8_t)((int32_t)y - 128);
+}
+
+void softmax_16(int8_t* Y, const int16_t* X, const nn_softmax_params_t* params,
+                const unsigned N) {
+  if (N == 0) return;
+  assert(N <= (1 << 16));
+
+  int32_t max = X[0];
+  for (unsigned k = 1; k < N; k++) max = (X[k] > max) ? X[k] : max;
+
+  uint32_t sum = 0;
+  for (unsigned k = 0; k < N; k++) sum += softmax_exp(params, max - X[k]);
+
+  const uint32_t recip = softmax_recip(sum);
+
+  // The exponents are looked up again rather than kept in a scratch buffer
+  for (unsigned k = 0; k < N; k++)
+    Y[k] = softmax_output(softmax_exp(params, max - X[k]), recip);
+}
+
+void softmax_8(int8_t* Y, const int8_t* X, const nn_softmax_params_t* params,
+               const unsigned N) {
+  if (N == 0) return;
+  assert(N <= (1 << 16));
+
+  int32_t max = X[0];
+  int32_t min = X[0];
+  for (unsigned k = 1; k < N; k++) {
+    max = (X[k] > max) ? X[k] : max;
+    min = (X[k] < min) ? X[k] : min;
+  }
+
+  // Differences of 8-bit inputs are at most 255, and exp_hi[0] is exactly 1
+  uint32_t sum = 0;
+  for (unsigned k = 0; k < N; k++) sum += params->exp_lo[max - X[k]];
+
+  const uint32_t recip = softmax_recip(sum);
+
+  // If there are fewer distinct input values than elements, each output value
+  // is computed once and the elements are mapped to them by lookup8()
+  if (max - min + 1 < (int32_t)N) {
+    uint8_t lut[256];
+    for (int32_t x = min; x <= max; x++)
+      lut[(uint8_t)x] = (uint8_t)softmax_output(params->exp_lo[max - x], recip);
+    lookup8((uint8_t*)Y, (const uint8_t*)X, lut, 0, N);
+    return;
+  }
+
+  for (unsigned k = 0; k < N; k++)
+    Y[k] = softmax_output(params->exp_lo[max - X[k]], recip);
+}
@@ -6,6 +6,27 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+/*
+ * Host SIMD backend.
+ *
+ * On x86 hosts the hot instructions are emulated with SSE2 (always available
+ * on x86-64), AVX2 or AVX-512BW intrinsics. The level is picked at compile time
+ * from the target flags (see VPU_SIM_ARCH in etc/platform/x86.mk). Defining
+ * NN_VPU_SIM_SCALAR forces the plain C implementation. Every path is bit-exact
+ * with the scalar one; where the scalar code relies on out of range shifts the
+ * SIMD path falls back to it.
+ */
+#if !defined(NN_VPU_SIM_SCALAR) && defined(__SSE2__)
+#define VPU_SIM_SSE2 1
+#include <immintrin.h>
+#if defined(__AVX2__)
+#define VPU_SIM_AVX2 1
+#endif
+#if defined(__AVX512BW__)
+#define VPU_SIM_AVX512 1
+#endif
+#endif
+
 void assert_word_aligned(const void *address) {
   assert(((uintptr_t)address & 0x3) == 0);
 }
@@ -33,8 +54,13 @@ static int64_t GetAccumulator(const xs3_vpu *vpu, unsigned index) {
     acc.s16[0] = vpu->vR.s16[index];
 
     return acc.s32;
+  } else if (vpu->mode == MODE_S32) {
+    assert(index < VPU_INT32_ACC_PERIOD);
+    // The high word is in vD and the low word in vR
+    return (int64_t)(((uint64_t)vpu->vD.s32[index] << 32) |
+                     vpu->vR.u32[index]);
   } else {
-    assert(0);  // TODO
+    assert(0);  // How'd this happen?
   }
 }
 
@@ -48,8 +74,11 @@ static void SetAccumulator(xs3_vpu *vpu, unsigned index, int64_t acc) {
     mask = mask << VPU_INT8_ACC_VR_BITS;
     vpu->vD.s16[index] =
         (int16_t)(((unsigned)acc & mask) >> VPU_INT8_ACC_VR_BITS);
+  } else if (vpu->mode == MODE_S32) {
+    vpu->vR.u32[index] = (uint32_t)acc;
+    vpu->vD.s32[index] = (int32_t)(acc >> 32);
   } else {
-    assert(0);  // TODO
+    assert(0);  // How'd this happen?
   }
 }
 
@@ -60,19 +89,19 @@ static void rotate_accumulators(xs3_vpu *vpu) {
   if (vpu->mode == MODE_S8 || vpu->mode == MODE_S16) {
     data16_t tmpD = vpu->vD.u16[VPU_INT8_ACC_PERIOD - 1];
     data16_t tmpR = vpu->vR.u16[VPU_INT8_ACC_PERIOD - 1];
-    for (int i = VPU_INT8_ACC_PERIOD - 1; i > 0; i--) {
-      vpu->vD.u16[i] = vpu->vD.u16[i - 1];
-      vpu->vR.u16[i] = vpu->vR.u16[i - 1];
-    }
+    memmove(&vpu->vD.u16[1], &vpu->vD.u16[0],
+            (VPU_INT8_ACC_PERIOD - 1) * sizeof(data16_t));
+    memmove(&vpu->vR.u16[1], &vpu->vR.u16[0],
+            (VPU_INT8_ACC_PERIOD - 1) * sizeof(data16_t));
     vpu->vD.u16[0] = tmpD;
     vpu->vR.u16[0] = tmpR;
   } else if (vpu->mode == MODE_S32) {
     uint32_t tmpD = vpu->vD.u32[VPU_INT32_ACC_PERIOD - 1];
     uint32_t tmpR = vpu->vR.u32[VPU_INT32_ACC_PERIOD - 1];
-    for (int i = VPU_INT32_ACC_PERIOD - 1; i > 0; i--) {
-      vpu->vD.u32[i] = vpu->vD.u32[i - 1];
-      vpu->vR.u32[i] = vpu->vR.u32[i - 1];
-    }
+    memmove(&vpu->vD.u32[1], &vpu->vD.u32[0],
+            (VPU_INT32_ACC_PERIOD - 1) * sizeof(uint32_t));
+    memmove(&vpu->vR.u32[1], &vpu->vR.u32[0],
+            (VPU_INT32_ACC_PERIOD - 1) * sizeof(uint32_t));
     vpu->vD.u32[0] = tmpD;
     vpu->vR.u32[0] = tmpR;
   } else {
@@ -80,6 +109,134 @@ static void rotate_accumulators(xs3_vpu *vpu) {
   }
 }
 
+#if defined(VPU_SIM_SSE2)
+
+// Sign extend the low/high half of a vector to the next wider lane size.
+static inline __m128i sse_s8_lo_to_s16(__m128i x) {
+  return _mm_srai_epi16(_mm_unpacklo_epi8(x, x), 8);
+}
+static inline __m128i sse_s8_hi_to_s16(__m128i x) {
+  return _mm_srai_epi16(_mm_unpackhi_epi8(x, x), 8);
+}
+static inline __m128i sse_s16_lo_to_s32(__m128i x) {
+  return _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+}
+static inline __m128i sse_s16_hi_to_s32(__m128i x) {
+  return _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+}
+
+static inline int32_t sse_hsum_s32(__m128i x) {
+  x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2)));
+  x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(x);
+}
+
+// Clamp int16 lanes to [-bound, bound].
+static inline __m128i sse_clamp_s16(__m128i x, int16_t bound) {
+  x = _mm_max_epi16(x, _mm_set1_epi16(-bound));
+  return _mm_min_epi16(x, _mm_set1_epi16(bound));
+}
+
+/**
+ * The 16 accumulators of the 8 and 16 bit modes as four vectors of int32,
+ * vR holding the low and vD the high half of each.
+ */
+static inline void sse_load_acc(const xs3_vpu *vpu, __m128i acc[4]) {
+  for (int h = 0; h < 2; h++) {
+    __m128i r = _mm_loadu_si128((const __m128i *)&vpu->vR.s16[8 * h]);
+    __m128i d = _mm_loadu_si128((const __m128i *)&vpu->vD.s16[8 * h]);
+    acc[2 * h + 0] = _mm_unpacklo_epi16(r, d);
+    acc[2 * h + 1] = _mm_unpackhi_epi16(r, d);
+  }
+}
+
+static inline void sse_store_acc(xs3_vpu *vpu, const __m128i acc[4]) {
+  for (int h = 0; h < 2; h++) {
+    __m128i a0 = acc[2 * h + 0];
+    __m128i a1 = acc[2 * h + 1];
+    // Both halves are sign extended first so the saturating pack is exact
+    __m128i r = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(a0, 16), 16),
+                                _mm_srai_epi32(_mm_slli_epi32(a1, 16), 16));
+    __m128i d = _mm_packs_epi32(_mm_srai_epi32(a0, 16), _mm_srai_epi32(a1, 16));
+    _mm_storeu_si128((__m128i *)&vpu->vR.s16[8 * h], r);
+    _mm_storeu_si128((__m128i *)&vpu->vD.s16[8 * h], d);
+  }
+}
+
+/**
+ * a + b with the symmetric 32 bit saturation of vpu_saturate().
+ */
+static inline __m128i sse_add_sat_s32(__m128i a, __m128i b) {
+  __m128i r = _mm_add_epi32(a, b);
+  __m128i ovf = _mm_srai_epi32(
+      _mm_and_si128(_mm_xor_si128(a, r), _mm_xor_si128(b, r)), 31);
+  __m128i sign = _mm_srai_epi32(a, 31);
+  __m128i sat =
+      _mm_sub_epi32(_mm_xor_si128(_mm_set1_epi32(VPU_INT32_MAX), sign), sign);
+  r = _mm_or_si128(_mm_and_si128(ovf, sat), _mm_andnot_si128(ovf, r));
+  // INT32_MIN is outside the symmetric range
+  return _mm_sub_epi32(r, _mm_cmpeq_epi32(r, _mm_set1_epi32(INT32_MIN)));
+}
+
+// Arithmetic shift right by shr, or logical shift left by -shr, of int32 lanes.
+static inline __m128i sse_ashr_s32(__m128i x, int32_t shr, __m128i count) {
+  return (shr >= 0) ? _mm_sra_epi32(x, count) : _mm_sll_epi32(x, count);
+}
+
+/**
+ * Sum of the products of 32 int8 pairs. This is exact as |sum| <= 2^19.
+ */
+static int32_t simd_dot_s8(const int8_t *a, const int8_t *b) {
+#if defined(VPU_SIM_AVX512)
+  __m512i a16 = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i *)a));
+  __m512i b16 = _mm512_cvtepi8_epi16(_mm256_loadu_si256((const __m256i *)b));
+  return _mm512_reduce_add_epi32(_mm512_madd_epi16(a16, b16));
+#elif defined(VPU_SIM_AVX2)
+  __m256i lo = _mm256_madd_epi16(
+      _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)a)),
+      _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)b)));
+  __m256i hi = _mm256_madd_epi16(
+      _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(a + 16))),
+      _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(b + 16))));
+  __m256i sum = _mm256_add_epi32(lo, hi);
+  return sse_hsum_s32(_mm_add_epi32(_mm256_castsi256_si128(sum),
+                                    _mm256_extracti128_si256(sum, 1)));
+#else
+  __m128i sum = _mm_setzero_si128();
+  for (int h = 0; h < 2; h++) {
+    __m128i x = _mm_loadu_si128((const __m128i *)(a + 16 * h));
+    __m128i y = _mm_loadu_si128((const __m128i *)(b + 16 * h));
+    sum = _mm_add_epi32(
+        sum, _mm_madd_epi16(sse_s8_lo_to_s16(x), sse_s8_lo_to_s16(y)));
+    sum = _mm_add_epi32(
+        sum, _mm_madd_epi16(sse_s8_hi_to_s16(x), sse_s8_hi_to_s16(y)));
+  }
+  return sse_hsum_s32(sum);
+#endif
+}
+
+/**
+ * Sum of the products of 16 int16 pairs.
+ */
+static int64_t simd_dot_s16(const int16_t *a, const int16_t *b) {
+  int32_t pairs[8];
+  _mm_storeu_si128((__m128i *)&pairs[0],
+                   _mm_madd_epi16(_mm_loadu_si128((const __m128i *)&a[0]),
+                                  _mm_loadu_si128((const __m128i *)&b[0])));
+  _mm_storeu_si128((__m128i *)&pairs[4],
+                   _mm_madd_epi16(_mm_loadu_si128((const __m128i *)&a[8]),
+                                  _mm_loadu_si128((const __m128i *)&b[8])));
+
+  // A pair sum only wraps for (-2^15)^2 + (-2^15)^2 = 2^31, which gives
+  // INT32_MIN; that value is otherwise unreachable.
+  int64_t sum = 0;
+  for (int i = 0; i < 8; i++)
+    sum += (pairs[i] == INT32_MIN) ? ((int64_t)1 << 31) : pairs[i];
+  return sum;
+}
+
+#endif  // VPU_SIM_SSE2
+
 void VSETC(xs3_vpu *vpu, const vector_mode mode) { vpu->mode = mode; }
 
 void VCLRDR(xs3_vpu *vpu) {
@@ -121,6 +278,13 @@ void VSTRPV(const xs3_vpu *vpu, void *addr, unsigned mask) {
   assert_word_aligned(addr);
   int8_t *addr8 = (int8_t *)addr;
 
+  // Masks selecting a prefix of the vector are by far the most common
+  if ((mask & (mask + 1)) == 0) {
+    unsigned len = (~mask == 0) ? 32 : __builtin_ctz(~mask);
+    memcpy(addr8, &vpu->vR.s8[0], len);
+    return;
+  }
+
   for (int i = 0; i < 32; i++) {
     if (mask & (1UL << i)) {
       addr8[i] = vpu->vR.s8[i];
@@ -130,6 +294,38 @@ void VSTRPV(const xs3_vpu *vpu, void *addr, unsigned mask) {
 
 void VLMACC(xs3_vpu *vpu, const void *addr) {
   assert_word_aligned(addr);
+#if defined(VPU_SIM_SSE2)
+  if (vpu->mode == MODE_S8) {
+    __m128i acc[4];
+    sse_load_acc(vpu, acc);
+    __m128i c = _mm_loadu_si128((const __m128i *)&vpu->vC.s8[0]);
+    __m128i x = _mm_loadu_si128((const __m128i *)addr);
+    // |int8 * int8| <= 2^14 so the products fit in int16
+    __m128i p_lo = _mm_mullo_epi16(sse_s8_lo_to_s16(c), sse_s8_lo_to_s16(x));
+    __m128i p_hi = _mm_mullo_epi16(sse_s8_hi_to_s16(c), sse_s8_hi_to_s16(x));
+    acc[0] = sse_add_sat_s32(acc[0], sse_s16_lo_to_s32(p_lo));
+    acc[1] = sse_add_sat_s32(acc[1], sse_s16_hi_to_s32(p_lo));
+    acc[2] = sse_add_sat_s32(acc[2], sse_s16_lo_to_s32(p_hi));
+    acc[3] = sse_add_sat_s32(acc[3], sse_s16_hi_to_s32(p_hi));
+    sse_store_acc(vpu, acc);
+    return;
+  } else if (vpu->mode == MODE_S16) {
+    __m128i acc[4];
+    sse_load_acc(vpu, acc);
+    for (int h = 0; h < 2; h++) {
+      __m128i c = _mm_loadu_si128((const __m128i *)&vpu->vC.s16[8 * h]);
+      __m128i x = _mm_loadu_si128((const __m128i *)addr + h);
+      __m128i p_lo = _mm_mullo_epi16(c, x);
+      __m128i p_hi = _mm_mulhi_epi16(c, x);
+      acc[2 * h + 0] =
+          sse_add_sat_s32(acc[2 * h + 0], _mm_unpacklo_epi16(p_lo, p_hi));
+      acc[2 * h + 1] =
+          sse_add_sat_s32(acc[2 * h + 1], _mm_unpackhi_epi16(p_lo, p_hi));
+    }
+    sse_store_acc(vpu, acc);
+    return;
+  }
+#endif
   if (vpu->mode == MODE_S8) {
     const int8_t *addr8 = (const int8_t *)addr;
 
@@ -168,8 +364,12 @@ void VLMACCR(xs3_vpu *vpu, const void *addr) {
     const int8_t *addr8 = (const int8_t *)addr;
     int64_t acc = GetAccumulator(vpu, VPU_INT8_ACC_PERIOD - 1);
 
+#if defined(VPU_SIM_SSE2)
+    acc = acc + simd_dot_s8(&vpu->vC.s8[0], addr8);
+#else
     for (int i = 0; i < VPU_INT8_EPV; i++)
       acc = acc + (((int32_t)vpu->vC.s8[i]) * addr8[i]);
+#endif
 
     acc = vpu_saturate(acc, 32);
     rotate_accumulators(vpu);
@@ -178,18 +378,22 @@ void VLMACCR(xs3_vpu *vpu, const void *addr) {
     const int16_t *addr16 = (const int16_t *)addr;
     int64_t acc = GetAccumulator(vpu, VPU_INT16_ACC_PERIOD - 1);
 
+#if defined(VPU_SIM_SSE2)
+    acc = acc + simd_dot_s16(&vpu->vC.s16[0], addr16);
+#else
     for (int i = 0; i < VPU_INT16_EPV; i++)
       acc = acc + (((int32_t)vpu->vC.s16[i]) * addr16[i]);
+#endif
 
     acc = vpu_saturate(acc, 32);
     rotate_accumulators(vpu);
     SetAccumulator(vpu, 0, acc);
   } else if (vpu->mode == MODE_S32) {
     const int32_t *addr32 = (const int32_t *)addr;
-    int32_t acc = GetAccumulator(vpu, VPU_INT32_ACC_PERIOD - 1);
+    int64_t acc = GetAccumulator(vpu, VPU_INT32_ACC_PERIOD - 1);
 
     for (int i = 0; i < VPU_INT32_EPV; i++)
-      acc = acc + (((int32_t)vpu->vC.s32[i]) * addr32[i]);
+      acc = acc + (((int64_t)vpu->vC.s32[i]) * addr32[i]);
 
     acc = vpu_saturate(acc, 40);
     rotate_accumulators(vpu);
@@ -201,13 +405,28 @@ void VLMACCR(xs3_vpu *vpu, const void *addr) {
 
 void VLMACCR1(xs3_vpu *vpu, const void *addr) {
   assert_word_aligned(addr);
+  assert(vpu->mode != MODE_S32);
   const int32_t *addr32 = (const int32_t *)addr;
   int64_t acc = GetAccumulator(vpu, VPU_BIN_ACC_PERIOD - 1);
 
+#if defined(VPU_SIM_SSE2)
+  // Each word contributes popcount(~v) - 16
+  uint64_t xnor[4];
+  for (int h = 0; h < 2; h++) {
+    __m128i v = _mm_xor_si128(
+        _mm_loadu_si128((const __m128i *)&vpu->vC.s32[4 * h]),
+        _mm_loadu_si128((const __m128i *)addr32 + h));
+    _mm_storeu_si128((__m128i *)&xnor[2 * h],
+                     _mm_xor_si128(v, _mm_set1_epi32(-1)));
+  }
+  for (int i = 0; i < 4; i++) acc += __builtin_popcountll(xnor[i]);
+  acc -= 16 * VPU_INT32_EPV;
+#else
   for (int i = 0; i < VPU_INT32_EPV; i++) {
     int v = (((int32_t)vpu->vC.s32[i]) ^ addr32[i]);
     acc += (2 * __builtin_popcount(~v) - 32) / 2;
   }
+#endif
 
   acc = vpu_saturate(acc, 32);
   rotate_accumulators(vpu);
@@ -216,6 +435,48 @@ void VLMACCR1(xs3_vpu *vpu, const void *addr) {
 
 void VLSAT(xs3_vpu *vpu, const void *addr) {
   assert_word_aligned(addr);
+#if defined(VPU_SIM_AVX2)
+  if (vpu->mode == MODE_S8 || vpu->mode == MODE_S16) {
+    const __m128i *addr128 = (const __m128i *)addr;
+    __m256i shr[2] = {_mm256_cvtepu16_epi32(_mm_loadu_si128(addr128 + 0)),
+                      _mm256_cvtepu16_epi32(_mm_loadu_si128(addr128 + 1))};
+    __m256i too_far =
+        _mm256_or_si256(_mm256_cmpgt_epi32(shr[0], _mm256_set1_epi32(31)),
+                        _mm256_cmpgt_epi32(shr[1], _mm256_set1_epi32(31)));
+
+    // Shifts of 32 or more are left to the C implementation below
+    if (_mm256_testz_si256(too_far, too_far)) {
+      const int16_t bound =
+          (vpu->mode == MODE_S8) ? VPU_INT8_MAX : VPU_INT16_MAX;
+      const __m256i one = _mm256_set1_epi32(1);
+      __m128i acc[4];
+      __m128i res[2];
+      sse_load_acc(vpu, acc);
+
+      for (int h = 0; h < 2; h++) {
+        __m256i a = _mm256_set_m128i(acc[2 * h + 1], acc[2 * h + 0]);
+        // For a zero shift the count is out of range and the rounding is 0
+        a = _mm256_add_epi32(
+            a, _mm256_sllv_epi32(one, _mm256_sub_epi32(shr[h], one)));
+        a = _mm256_srav_epi32(a, shr[h]);
+        res[h] = sse_clamp_s16(_mm_packs_epi32(_mm256_castsi256_si128(a),
+                                               _mm256_extracti128_si256(a, 1)),
+                               bound);
+      }
+
+      if (vpu->mode == MODE_S8) {
+        _mm_storeu_si128((__m128i *)&vpu->vR.s8[0],
+                         _mm_packs_epi16(res[0], res[1]));
+        memset(&vpu->vR.u8[VPU_INT8_ACC_PERIOD], 0, VPU_INT8_ACC_PERIOD);
+      } else {
+        _mm_storeu_si128((__m128i *)&vpu->vR.s16[0], res[0]);
+        _mm_storeu_si128((__m128i *)&vpu->vR.s16[8], res[1]);
+      }
+      memset(&vpu->vD.u8[0], 0, XS3_VPU_VREG_WIDTH_BYTES);
+      return;
+    }
+  }
+#endif
   if (vpu->mode == MODE_S8) {
     const uint16_t *addr16 = (const uint16_t *)addr;
 
@@ -249,9 +510,10 @@ void VLSAT(xs3_vpu *vpu, const void *addr) {
 
     for (int i = 0; i < VPU_INT32_ACC_PERIOD; i++) {
       int64_t acc = GetAccumulator(vpu, i);
-      if (addr32[i] != 0) acc = acc + (1 << (addr32[i] - 1));  // Round
-      acc = acc >> addr32[i];                                  // Shift
-      int32_t val = vpu_saturate(acc, 32);                     // vpu_saturate
+      if (addr32[i] != 0)
+        acc = acc + ((int64_t)1 << (addr32[i] - 1));  // Round
+      acc = acc >> addr32[i];                         // Shift
+      int32_t val = vpu_saturate(acc, 32);            // vpu_saturate
 
       vpu->vR.s32[i] = val;
     }
@@ -263,6 +525,38 @@ void VLSAT(xs3_vpu *vpu, const void *addr) {
 
 void VLASHR(xs3_vpu *vpu, const void *addr, const int32_t shr) {
   assert_word_aligned(addr);
+#if defined(VPU_SIM_SSE2)
+  // Left shifts of 32 or more are left to the C implementation below
+  if ((vpu->mode == MODE_S8 || vpu->mode == MODE_S16) && shr > -32) {
+    // Right shifts past the element width just replicate the sign bit
+    const __m128i count =
+        _mm_cvtsi32_si128((shr >= 0) ? ((shr > 31) ? 31 : shr) : -shr);
+    const __m128i *addr128 = (const __m128i *)addr;
+
+    for (int h = 0; h < 2; h++) {
+      __m128i x = _mm_loadu_si128(addr128 + h);
+      if (vpu->mode == MODE_S8) {
+        __m128i lo = sse_s8_lo_to_s16(x);
+        __m128i hi = sse_s8_hi_to_s16(x);
+        lo = _mm_packs_epi32(
+            sse_ashr_s32(sse_s16_lo_to_s32(lo), shr, count),
+            sse_ashr_s32(sse_s16_hi_to_s32(lo), shr, count));
+        hi = _mm_packs_epi32(
+            sse_ashr_s32(sse_s16_lo_to_s32(hi), shr, count),
+            sse_ashr_s32(sse_s16_hi_to_s32(hi), shr, count));
+        _mm_storeu_si128((__m128i *)&vpu->vR.s8[16 * h],
+                         _mm_packs_epi16(sse_clamp_s16(lo, VPU_INT8_MAX),
+                                         sse_clamp_s16(hi, VPU_INT8_MAX)));
+      } else {
+        x = _mm_packs_epi32(sse_ashr_s32(sse_s16_lo_to_s32(x), shr, count),
+                            sse_ashr_s32(sse_s16_hi_to_s32(x), shr, count));
+        _mm_storeu_si128((__m128i *)&vpu->vR.s16[8 * h],
+                         sse_clamp_s16(x, VPU_INT16_MAX));
+      }
+    }
+    return;
+  }
+#endif
   if (vpu->mode == MODE_S8) {
     const int8_t *addr8 = (const int8_t *)addr;
 
@@ -300,8 +594,10 @@ void VLASHR(xs3_vpu *vpu, const void *addr, const int32_t shr) {
         val = (val < 0) ? -1 : 0;
       else if (shr >= 0)
         val = val >> shr;
+      else if (shr > -32)
+        val = (int64_t)((uint64_t)val << (-shr));
       else
-        val = (unsigned)val << (-shr);
+        val = (val < 0) ? INT64_MIN : (val > 0) ? INT64_MAX : 0;
       vpu->vR.s32[i] = vpu_saturate(val, 32);
     }
   } else {
@@ -396,6 +692,22 @@ void VLMUL(xs3_vpu *vpu, const void *addr) {
 void VDEPTH1(xs3_vpu *vpu) {
   uint32_t bits = 0;
 
+#if defined(VPU_SIM_SSE2)
+  if (vpu->mode == MODE_S8 || vpu->mode == MODE_S16) {
+    __m128i x0 = _mm_loadu_si128((const __m128i *)&vpu->vR.s8[0]);
+    __m128i x1 = _mm_loadu_si128((const __m128i *)&vpu->vR.s8[16]);
+    if (vpu->mode == MODE_S8)
+      bits = (uint32_t)_mm_movemask_epi8(x0) |
+             ((uint32_t)_mm_movemask_epi8(x1) << 16);
+    else
+      bits = (uint32_t)_mm_movemask_epi8(_mm_packs_epi16(x0, x1));
+
+    memset(&(vpu->vR), 0, sizeof(vpu_vector_t));
+    vpu->vR.s32[0] = bits;
+    return;
+  }
+#endif
+
   if (vpu->mode == MODE_S8) {
     for (int i = 0; i < VPU_INT8_EPV; i++) {
       if (vpu->vR.s8[i] < 0) bits |= (1 << i);
@@ -417,6 +729,21 @@ void VDEPTH1(xs3_vpu *vpu) {
 }
 
 void VDEPTH8(xs3_vpu *vpu) {
+#if defined(VPU_SIM_SSE2)
+  if (vpu->mode == MODE_S16) {
+    __m128i res[2];
+    for (int h = 0; h < 2; h++) {
+      __m128i x = _mm_loadu_si128((const __m128i *)&vpu->vR.s16[8 * h]);
+      // (x + 2^7) >> 8 without leaving 16 bits
+      x = _mm_add_epi16(_mm_srai_epi16(x, 8),
+                        _mm_and_si128(_mm_srli_epi16(x, 7), _mm_set1_epi16(1)));
+      res[h] = sse_clamp_s16(x, VPU_INT8_MAX);
+    }
+    _mm_storeu_si128((__m128i *)&vpu->vR.s8[0], _mm_packs_epi16(res[0], res[1]));
+    memset(&vpu->vR.s8[VPU_INT16_EPV], 0, VPU_INT16_EPV);
+    return;
+  }
+#endif
   vpu_vector_t vec_tmp;
   memcpy(&vec_tmp, &(vpu->vR), sizeof(vpu_vector_t));
   memset(&(vpu->vR), 0, sizeof(vpu_vector_t));
@@ -1,5 +1,8 @@
 #include "AggregateFn.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <limits>
 
 #include "vpu_sim.h"
@@ -129,8 +132,9 @@ MatMulInt8::Params::Params(const int output_slice_channel_count,
   // maybe compute k_p_adjust and input_channel_group_count
 }
 
-void mat_mul_int8_generic_impl(MatMulInt8::Params *params, VPURingBuffer *A,
-                               int8_t *T, int32_t output_channel_group) {
+void mat_mul_int8_generic_impl(const MatMulInt8::Params *params,
+                               VPURingBuffer *A, int8_t *T,
+                               int32_t output_channel_group) {
   xs3_vpu vpu_mem;
   xs3_vpu *vpu = &vpu_mem;
 
@@ -212,16 +216,17 @@ MatMulDirectFn::Params::Params(const ImageGeometry &X, const WindowGeometry &K,
   bytes_per_kernel_channel =
       K.shape.height * K.shape.width * X.depth * VPU_INT16_EPV;
 
-  int bytes_per_pixel = X.PixelBytes();
+  int bytes_per_pixel = X.PixelStride();
 
   inner_x_h_step =
       bytes_per_pixel * K.dilation.col - bytes_per_copy_per_channel;
-  inner_x_v_step = bytes_per_pixel * (int)X.width * (int)K.dilation.row -
+  inner_x_v_step = X.RowStride() * (int)K.dilation.row -
                    (int)K.shape.width * bytes_per_pixel * (int)K.dilation.col;
 }
 
-void mat_mul_direct_impl(MatMulDirectFn::Params *params, VPURingBuffer *A,
-                         int8_t *X, int32_t output_channel_group) {
+void mat_mul_direct_impl(const MatMulDirectFn::Params *params,
+                         VPURingBuffer *A, int8_t *X,
+                         int32_t output_channel_group) {
   xs3_vpu vpu_mem;
   xs3_vpu *vpu = &vpu_mem;
 
@@ -288,10 +293,487 @@ void MatMulBinaryDirectFn::mat_mul_direct_impl(VPURingBuffer *A, int8_t *X,
   VSTD(vpu, &A->vD);
 }
 
-C_API void mat_mul_direct_impl_asm(MatMulDirectFn::Params *params,
+MatMulDirectFn_DW::Params::Params(const ImageGeometry &X,
+                                  const WindowGeometry &K,
+                                  const int8_t *weights)
+    : weights(weights),
+      k_height(K.shape.height),
+      k_width(K.shape.width),
+      bytes_per_kernel_channel_group(K.shape.height * K.shape.width *
+                                     VPU_INT8_ACC_PERIOD) {
+  inner_x_h_step = X.PixelStride() * K.dilation.col;
+  inner_x_v_step =
+      X.RowStride() * K.dilation.row - K.shape.width * inner_x_h_step;
+}
+
+MatMulDirectFn_DW::Params::Params(const WindowGeometry &K,
+                                  const int8_t *weights)
+    : weights(weights),
+      k_height(K.shape.height),
+      k_width(K.shape.width),
+      bytes_per_kernel_channel_group(K.shape.height * K.shape.width *
+                                     VPU_INT8_ACC_PERIOD),
+      inner_x_h_step(VPU_INT8_ACC_PERIOD),
+      inner_x_v_step(0) {}
+
+int MatMulDirectFn_DW::get_weights_bytes(int k_height, int k_width,
+                                         int channels) {
+  const int groups =
+      (channels + VPU_INT8_ACC_PERIOD - 1) / VPU_INT8_ACC_PERIOD;
+  // The final load may read a whole vector
+  return groups * k_height * k_width * VPU_INT8_ACC_PERIOD +
+         XS3_VPU_VREG_WIDTH_BYTES - VPU_INT8_ACC_PERIOD;
+}
+
+std::vector<int8_t> MatMulDirectFn_DW::reorder_kernel_weights(
+    const int8_t *raw_weights, const std::array<int, 4> &shape) {
+  assert(shape[0] == 1);
+
+  const int k_height = shape[1];
+  const int k_width = shape[2];
+  const int channels = shape[3];
+
+  std::vector<int8_t> weights(get_weights_bytes(k_height, k_width, channels),
+                              0);
+
+  for (int r = 0; r < k_height; r++) {
+    for (int s = 0; s < k_width; s++) {
+      for (int c = 0; c < channels; c++) {
+        const int group = c / VPU_INT8_ACC_PERIOD;
+        const int index =
+            ((group * k_height + r) * k_width + s) * VPU_INT8_ACC_PERIOD +
+            c % VPU_INT8_ACC_PERIOD;
+        weights[index] = raw_weights[(r * k_width + s) * channels + c];
+      }
+    }
+  }
+
+  return weights;
+}
+
+void mat_mul_direct_dw_impl(MatMulDirectFn_DW::Params *params,
+                            VPURingBuffer *A, int8_t *X,
+                            int32_t output_channel_group) {
+  xs3_vpu vpu_mem;
+  xs3_vpu *vpu = &vpu_mem;
+
+  VSETC(vpu, MODE_S8);
+  VCLRDR(vpu);
+
+  int8_t *X_cur_p = X;
+
+  const int8_t *K_p = params->weights + params->bytes_per_kernel_channel_group *
+                                            output_channel_group;
+
+  for (int kh = params->k_height; kh > 0; kh--) {
+    for (int kw = params->k_width; kw > 0; kw--) {
+      VLDC(vpu, X_cur_p);
+      VLMACC(vpu, K_p);
+
+      K_p += VPU_INT8_ACC_PERIOD;
+      X_cur_p += params->inner_x_h_step;
+    }
+    X_cur_p += params->inner_x_v_step;
+  }
+
+  // save off the accumulator
+  VSTR(vpu, &A->vR);
+  VSTD(vpu, &A->vD);
+}
+
+void MatMulDirectFn_DW::aggregate_fn(VPURingBuffer *A, int8_t *T,
+                                     int32_t output_channel_group) {
+  mat_mul_direct_dw_impl(this->params, A, T, output_channel_group);
+}
+
+constexpr int MatMulBlockSparseInt8::BlockBytes;
+
+MatMulBlockSparseInt8::Params::Params(const Conv2dBlockSparseWeights &weights)
+    : weights(weights.weights.data()),
+      block_indices(weights.block_indices.data()),
+      group_offsets(weights.group_offsets.data()) {}
+
+Conv2dBlockSparseWeights MatMulBlockSparseInt8::reorder_kernel_weights(
+    const int8_t *raw_weights, const std::array<int, 4> &shape) {
+  const int vpu_ring_buffer_length = VPU_INT16_EPV;
+  const int vpu_bytes_per_word = XS3_VPU_VREG_WIDTH_BYTES;
+
+  const int output_channel_count = shape[0];
+  const int bytes_per_output_channel = shape[1] * shape[2] * shape[3];
+
+  const int output_channel_groups =
+      (output_channel_count + vpu_ring_buffer_length - 1) /
+      vpu_ring_buffer_length;
+  const int input_channel_groups =
+      (bytes_per_output_channel + vpu_bytes_per_word - 1) /
+      vpu_bytes_per_word;
+
+  assert(input_channel_groups <= std::numeric_limits<int16_t>::max());
+
+  Conv2dBlockSparseWeights reordered;
+  reordered.group_offsets.push_back(0);
+
+  std::vector<int8_t> block(BlockBytes);
+
+  for (int ocg = 0; ocg < output_channel_groups; ++ocg) {
+    const int ocg_offset = ocg * vpu_ring_buffer_length;
+    const int output_channels_per_ocg = std::min(
+        output_channel_count - ocg_offset, vpu_ring_buffer_length);
+
+    for (int icg = 0; icg < input_channel_groups; ++icg) {
+      const int bytes_in_this_vpu_copy =
+          std::min(bytes_per_output_channel - icg * vpu_bytes_per_word,
+                   vpu_bytes_per_word);
+
+      std::fill(block.begin(), block.end(), 0);
+      bool non_zero = false;
+
+      // Output channels in reverse order, with the first vectors of a partial
+      // channel group left zero
+      for (int out_ch = 0; out_ch < output_channels_per_ocg; ++out_ch) {
+        const int8_t *src =
+            deref2d((int8_t *)raw_weights, bytes_per_output_channel,
+                    ocg_offset + out_ch, vpu_bytes_per_word * icg);
+        int8_t *dst = &block[(vpu_ring_buffer_length - 1 - out_ch) *
+                             vpu_bytes_per_word];
+
+        for (int i = 0; i < bytes_in_this_vpu_copy; ++i) {
+          dst[i] = src[i];
+          non_zero |= (src[i] != 0);
+        }
+      }
+
+      if (non_zero) {
+        reordered.weights.insert(reordered.weights.end(), block.begin(),
+                                 block.end());
+        reordered.block_indices.push_back(icg);
+      }
+    }
+
+    reordered.group_offsets.push_back(reordered.block_indices.size());
+  }
+
+  return reordered;
+}
+
+void mat_mul_block_sparse_int8_impl(const int8_t *K_p,
+                                    const int16_t *block_indices,
+                                    int32_t block_count, VPURingBuffer *A,
+                                    int8_t *T) {
+  xs3_vpu vpu_mem;
+  xs3_vpu *vpu = &vpu_mem;
+
+  VSETC(vpu, MODE_S8);
+  VCLRDR(vpu);
+
+  // Each block rotates the ring buffer by a whole period, so skipped blocks
+  // leave the accumulators where they are.
+  for (int32_t b = 0; b < block_count; ++b) {
+    VLDC(vpu, T + block_indices[b] * XS3_VPU_VREG_WIDTH_BYTES);
+
+    for (int l = 0; l < VPU_INT16_EPV; l++) {
+      VLMACCR(vpu, K_p);
+      K_p += XS3_VPU_VREG_WIDTH_BYTES;
+    }
+  }
+
+  VSTR(vpu, &A->vR);
+  VSTD(vpu, &A->vD);
+}
+
+void MatMulBlockSparseInt8::aggregate_fn(VPURingBuffer *A, int8_t *T,
+                                         int32_t output_channel_group) {
+  const int32_t first_block = params->group_offsets[output_channel_group];
+  mat_mul_block_sparse_int8_impl(
+      params->weights + first_block * BlockBytes,
+      params->block_indices + first_block,
+      params->group_offsets[output_channel_group + 1] - first_block, A, T);
+}
+
+const int8_t *MatMulBlockSparseInt8::get_channel_group_weights(
+    int32_t output_channel_group, int32_t *bytes) {
+  const int32_t first_block = params->group_offsets[output_channel_group];
+  *bytes = (params->group_offsets[output_channel_group + 1] - first_block) *
+           BlockBytes;
+  return params->weights + first_block * BlockBytes;
+}
+
+void MatMulBlockSparseInt8::aggregate_fn_sliced(VPURingBuffer *A, int8_t *T,
+                                                int32_t output_channel_group,
+                                                const int8_t *weights) {
+  const int32_t first_block = params->group_offsets[output_channel_group];
+  mat_mul_block_sparse_int8_impl(
+      weights, params->block_indices + first_block,
+      params->group_offsets[output_channel_group + 1] - first_block, A, T);
+}
+
+constexpr int MatMulInt4::BlockBytes;
+
+MatMulInt4::Params::Params(const int32_t bytes_per_kernel_channel,
+                           const int8_t *weights)
+    : weights(weights), bytes_per_kernel_channel(bytes_per_kernel_channel) {}
+
+int MatMulInt4::get_weights_bytes(int input_bytes, int output_channel_count) {
+  const int vpu_bytes = XS3_VPU_VREG_WIDTH_BYTES;
+  const int output_channel_groups =
+      (output_channel_count + VPU_INT16_EPV - 1) / VPU_INT16_EPV;
+  const int input_channel_groups = (input_bytes + vpu_bytes - 1) / vpu_bytes;
+  return output_channel_groups * input_channel_groups * BlockBytes;
+}
+
+Conv2dInt4Weights MatMulInt4::reorder_kernel_weights(
+    const int8_t *raw_weights, const std::array<int, 4> &shape) {
+  const int vpu_ring_buffer_length = VPU_INT16_EPV;
+  const int vpu_bytes_per_word = XS3_VPU_VREG_WIDTH_BYTES;
+
+  const int output_channel_count = shape[0];
+  const int bytes_per_output_channel = shape[1] * shape[2] * shape[3];
+
+  const int output_channel_groups =
+      (output_channel_count + vpu_ring_buffer_length - 1) /
+      vpu_ring_buffer_length;
+  const int input_channel_groups =
+      (bytes_per_output_channel + vpu_bytes_per_word - 1) /
+      vpu_bytes_per_word;
+
+  Conv2dInt4Weights reordered;
+  reordered.weights.assign(
+      get_weights_bytes(bytes_per_output_channel, output_channel_count), 0);
+  reordered.scales.resize(output_channel_count);
+
+  // Quantize each output channel
+  std::vector<int8_t> quantized(output_channel_count *
+                                bytes_per_output_channel);
+
+  for (int ch = 0; ch < output_channel_count; ++ch) {
+    const int8_t *src = raw_weights + ch * bytes_per_output_channel;
+    int8_t *dst = &quantized[ch * bytes_per_output_channel];
+
+    int min_w = 0, max_w = 0;
+    for (int i = 0; i < bytes_per_output_channel; ++i) {
+      min_w = std::min(min_w, (int)src[i]);
+      max_w = std::max(max_w, (int)src[i]);
+    }
+
+    float scale = 1.0f;
+    if (min_w < -8 || max_w > 7) scale = std::max(-min_w, max_w) / 7.0f;
+    reordered.scales[ch] = scale;
+
+    for (int i = 0; i < bytes_per_output_channel; ++i) {
+      int q = (int)std::round(src[i] / scale);
+      dst[i] = std::max(-8, std::min(7, q));
+    }
+  }
+
+  // Reorder as MatMulInt8, packing two weights per byte
+  int8_t *dst = reordered.weights.data();
+
+  for (int ocg = 0; ocg < output_channel_groups; ++ocg) {
+    const int ocg_offset = ocg * vpu_ring_buffer_length;
+    const int output_channels_per_ocg = std::min(
+        output_channel_count - ocg_offset, vpu_ring_buffer_length);
+
+    for (int icg = 0; icg < input_channel_groups; ++icg) {
+      const int bytes_in_this_vpu_copy =
+          std::min(bytes_per_output_channel - icg * vpu_bytes_per_word,
+                   vpu_bytes_per_word);
+
+      // Output channels in reverse order, with the first vectors of a partial
+      // channel group left zero
+      for (int out_ch = 0; out_ch < output_channels_per_ocg; ++out_ch) {
+        const int8_t *src =
+            deref2d(quantized.data(), bytes_per_output_channel,
+                    ocg_offset + out_ch, vpu_bytes_per_word * icg);
+        int8_t *v = dst + (vpu_ring_buffer_length - 1 - out_ch) *
+                              vpu_bytes_per_word / 2;
+
+        for (int i = 0; i < bytes_in_this_vpu_copy; ++i)
+          v[i / 2] |= (src[i] & 0xf) << (4 * (i % 2));
+      }
+
+      dst += BlockBytes;
+    }
+  }
+
+  return reordered;
+}
+
+/*
+  Unpack the 4-bit weights multiplied with one patch vector into int8 vectors.
+*/
+static void unpack_int4_block(int8_t *dst, const int8_t *src) {
+  for (int i = 0; i < MatMulInt4::BlockBytes; ++i) {
+    dst[2 * i] = (int8_t)((uint8_t)src[i] << 4) >> 4;
+    dst[2 * i + 1] = src[i] >> 4;
+  }
+}
+
+void mat_mul_int4_impl(const int8_t *K_p, int32_t input_channel_group_count,
+                       VPURingBuffer *A, int8_t *T) {
+  xs3_vpu vpu_mem;
+  xs3_vpu *vpu = &vpu_mem;
+
+  alignas(4) int8_t block[2 * MatMulInt4::BlockBytes];
+
+  VSETC(vpu, MODE_S8);
+  VCLRDR(vpu);
+
+  for (int32_t p = 0; p < input_channel_group_count; ++p) {
+    unpack_int4_block(block, K_p);
+    K_p += MatMulInt4::BlockBytes;
+
+    VLDC(vpu, T);
+    T += XS3_VPU_VREG_WIDTH_BYTES;
+
+    for (int l = 0; l < VPU_INT16_EPV; l++)
+      VLMACCR(vpu, &block[l * XS3_VPU_VREG_WIDTH_BYTES]);
+  }
+
+  VSTR(vpu, &A->vR);
+  VSTD(vpu, &A->vD);
+}
+
+const int8_t *MatMulInt4::get_channel_group_weights(
+    int32_t output_channel_group, int32_t *bytes) {
+  // Every channel group has the same, whole, number of blocks
+  *bytes = get_weights_bytes(params->bytes_per_kernel_channel, VPU_INT16_EPV);
+  return params->weights + *bytes * output_channel_group;
+}
+
+void MatMulInt4::aggregate_fn(VPURingBuffer *A, int8_t *T,
+                              int32_t output_channel_group) {
+  int32_t bytes;
+  const int8_t *weights =
+      get_channel_group_weights(output_channel_group, &bytes);
+  mat_mul_int4_impl(weights, bytes / BlockBytes, A, T);
+}
+
+void MatMulInt4::aggregate_fn_sliced(VPURingBuffer *A, int8_t *T,
+                                     int32_t output_channel_group,
+                                     const int8_t *weights) {
+  const int32_t bytes =
+      get_weights_bytes(params->bytes_per_kernel_channel, VPU_INT16_EPV);
+  mat_mul_int4_impl(weights, bytes / BlockBytes, A, T);
+}
+
+constexpr int MatMulInt16x8::BlockBytes;
+
+MatMulInt16x8::Params::Params(const int32_t elements_per_kernel_channel,
+                              const int8_t *weights)
+    : weights(weights),
+      elements_per_kernel_channel(elements_per_kernel_channel) {}
+
+int MatMulInt16x8::get_weights_bytes(int input_elements,
+                                     int output_channel_count) {
+  const int output_channel_groups =
+      (output_channel_count + VPU_INT16_EPV - 1) / VPU_INT16_EPV;
+  const int input_channel_groups =
+      (input_elements + VPU_INT16_EPV - 1) / VPU_INT16_EPV;
+  return output_channel_groups * input_channel_groups * BlockBytes;
+}
+
+std::vector<int8_t> MatMulInt16x8::reorder_kernel_weights(
+    const int8_t *raw_weights, const std::array<int, 4> &shape) {
+  const int vpu_ring_buffer_length = VPU_INT16_EPV;
+  const int elements_per_vector = VPU_INT16_EPV;
+
+  const int output_channel_count = shape[0];
+  const int elements_per_output_channel = shape[1] * shape[2] * shape[3];
+
+  const int output_channel_groups =
+      (output_channel_count + vpu_ring_buffer_length - 1) /
+      vpu_ring_buffer_length;
+  const int input_channel_groups =
+      (elements_per_output_channel + elements_per_vector - 1) /
+      elements_per_vector;
+
+  std::vector<int8_t> reordered(
+      get_weights_bytes(elements_per_output_channel, output_channel_count), 0);
+  int8_t *dst = reordered.data();
+
+  for (int ocg = 0; ocg < output_channel_groups; ++ocg) {
+    const int ocg_offset = ocg * vpu_ring_buffer_length;
+    const int output_channels_per_ocg = std::min(
+        output_channel_count - ocg_offset, vpu_ring_buffer_length);
+
+    for (int icg = 0; icg < input_channel_groups; ++icg) {
+      const int elements_in_this_vpu_copy =
+          std::min(elements_per_output_channel - icg * elements_per_vector,
+                   elements_per_vector);
+
+      // Output channels in reverse order, with the first vectors of a partial
+      // channel group left zero
+      for (int out_ch = 0; out_ch < output_channels_per_ocg; ++out_ch) {
+        const int8_t *src =
+            raw_weights + (ocg_offset + out_ch) * elements_per_output_channel +
+            elements_per_vector * icg;
+        int8_t *v =
+            dst + (vpu_ring_buffer_length - 1 - out_ch) * elements_per_vector;
+        std::memcpy(v, src, elements_in_this_vpu_copy);
+      }
+
+      dst += BlockBytes;
+    }
+  }
+
+  return reordered;
+}
+
+void mat_mul_int16x8_impl(const int8_t *K_p,
+                          int32_t input_channel_group_count, VPURingBuffer *A,
+                          int8_t *T) {
+  xs3_vpu vpu_mem;
+  xs3_vpu *vpu = &vpu_mem;
+
+  alignas(4) int16_t block[MatMulInt16x8::BlockBytes];
+
+  VSETC(vpu, MODE_S16);
+  VCLRDR(vpu);
+
+  for (int32_t p = 0; p < input_channel_group_count; ++p) {
+    // Widen the weights to int16
+    for (int i = 0; i < MatMulInt16x8::BlockBytes; ++i) block[i] = K_p[i];
+    K_p += MatMulInt16x8::BlockBytes;
+
+    VLDC(vpu, T);
+    T += XS3_VPU_VREG_WIDTH_BYTES;
+
+    for (int l = 0; l < VPU_INT16_ACC_PERIOD; l++)
+      VLMACCR(vpu, &block[l * VPU_INT16_EPV]);
+  }
+
+  VSTR(vpu, &A->vR);
+  VSTD(vpu, &A->vD);
+}
+
+const int8_t *MatMulInt16x8::get_channel_group_weights(
+    int32_t output_channel_group, int32_t *bytes) {
+  // Every channel group has the same, whole, number of blocks
+  *bytes =
+      get_weights_bytes(params->elements_per_kernel_channel, VPU_INT16_EPV);
+  return params->weights + *bytes * output_channel_group;
+}
+
+void MatMulInt16x8::aggregate_fn(VPURingBuffer *A, int8_t *T,
+                                 int32_t output_channel_group) {
+  int32_t bytes;
+  const int8_t *weights =
+      get_channel_group_weights(output_channel_group, &bytes);
+  mat_mul_int16x8_impl(weights, bytes / BlockBytes, A, T);
+}
+
+void MatMulInt16x8::aggregate_fn_sliced(VPURingBuffer *A, int8_t *T,
+                                        int32_t output_channel_group,
+                                        const int8_t *weights) {
+  const int32_t bytes =
+      get_weights_bytes(params->elements_per_kernel_channel, VPU_INT16_EPV);
+  mat_mul_int16x8_impl(weights, bytes / BlockBytes, A, T);
+}
+
+C_API void mat_mul_direct_impl_asm(const MatMulDirectFn::Params *params,
                                    VPURingBuffer *A, int8_t *X,
                                    int32_t output_channel_group);
-C_API void mat_mul_int8_generic_impl_asm(MatMulInt8::Params *params,
+C_API void mat_mul_int8_generic_impl_asm(const MatMulInt8::Params *params,
                                          VPURingBuffer *A, int8_t *X,
                                          int32_t output_channel_group);
 
@@ -312,3 +794,59 @@ void MatMulInt8::aggregate_fn(VPURingBuffer *A, int8_t *T,
   mat_mul_int8_generic_impl_asm(this->params, A, T, output_channel_group);
 #endif  // NN_USE_REF
 }
+
+const int8_t *MatMulDirectFn::get_channel_group_weights(
+    int32_t output_channel_group, int32_t *bytes) {
+  // Each channel group's weights are contiguous and read exactly
+  *bytes = params->bytes_per_kernel_channel;
+  return params->weights +
+         params->bytes_per_kernel_channel * output_channel_group;
+}
+
+void MatMulDirectFn::aggregate_fn_sliced(VPURingBuffer *A, int8_t *T,
+                                         int32_t output_channel_group,
+                                         const int8_t *weights) {
+  Params sliced = *params;
+  sliced.weights = weights;
+#ifdef NN_USE_REF
+  mat_mul_direct_impl(&sliced, A, T, 0);
+#else
+  mat_mul_direct_impl_asm(&sliced, A, T, 0);
+#endif  // NN_USE_REF
+}
+
+const int8_t *MatMulInt8::get_channel_group_weights(
+    int32_t output_channel_group, int32_t *bytes) {
+  const int32_t offset = params->bytes_per_kernel_channel * VPU_INT16_EPV *
+                         output_channel_group;
+
+  // The final load of a channel group reads into the next channel group's
+  // weights, and the accumulators are compensated for what it reads there, so
+  // that is copied too. It never reads beyond the end of the weights.
+  const int32_t total = get_weights_bytes(params->bytes_per_kernel_channel,
+                                          params->output_slice_channel_count);
+  *bytes = std::min(params->bytes_per_kernel_channel * VPU_INT16_EPV +
+                        XS3_VPU_VREG_WIDTH_BYTES,
+                    total - offset);
+  return params->weights + offset;
+}
+
+void MatMulInt8::aggregate_fn_sliced(VPURingBuffer *A, int8_t *T,
+                                     int32_t output_channel_group,
+                                     const int8_t *weights) {
+  Params sliced(std::min(params->output_slice_channel_count -
+                             output_channel_group * VPU_INT16_EPV,
+                         (int32_t)VPU_INT16_EPV),
+                params->bytes_per_kernel_channel, weights);
+#ifdef NN_USE_REF
+  mat_mul_int8_generic_impl(&sliced, A, T, 0);
+#else
+  mat_mul_int8_generic_impl_asm(&sliced, A, T, 0);
+#endif  // NN_USE_REF
+}
+
+MaxPoolPatchFn::Params::Params(const int32_t pixel_count)
+    : pixel_count(pixel_count) {}
+
+MaxPoolPatchFn::Params::Params(const nn::WindowGeometry &window)
+    : pixel_count(window.shape.height * window.shape.width) {}
@@ -0,0 +1,211 @@
+#include "ConvDispatcher.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#include "xs3_vpu.h"
+
+using namespace nn;
+
+/*
+  The models count the instructions of each implementation's loops, at one
+  instruction per cycle:
+
+  - A MAC vector is a VLDC and 16 VLMACCRs, plus pointer updates.
+  - The operators requantize a channel group through the BSO block in about 30
+    instructions. The Filter2D compositions make two virtual calls per channel
+    group, and OT_int8 and MatMulInt8's tail handling cost a little more.
+  - conv2d_deep() and conv2d_shallowin() adjust for padding at each pixel.
+  - ImToColPadded checks bounds and calls memcpy() for each window pixel,
+    where ImToColValid copies whole rows of vectors.
+  - conv2d_deep_ext_view() and conv2d_1x1_ext_view() call vpu_memcpy() for
+    each input pixel they gather from a view whose pixels are not contiguous.
+*/
+static const std::array<ConvCostModel, ConvImplCount> default_cost_models = {{
+    // per_call, per_pixel, per_window_pixel, per_patch_vector,
+    // per_channel_group, per_mac_vector
+    {300, 40, 20, 4, 30, 18},   // Conv2dDeep
+    {300, 40, 0, 0, 30, 18},    // Conv2dShallowIn
+    {150, 10, 20, 4, 30, 18},   // Conv2d1x1
+    {500, 50, 20, 4, 30, 18},   // Conv2dIm2col
+    {150, 20, 0, 0, 60, 18},    // Filter2dDirect
+    {150, 30, 8, 3, 80, 18},    // Filter2dIm2colValid
+    {150, 30, 40, 10, 80, 18},  // Filter2dIm2colPadded
+}};
+
+ConvDispatcher::ConvDispatcher() : costs(default_cost_models) {}
+
+ConvDispatcher::ConvDispatcher(
+    const std::array<ConvCostModel, ConvImplCount> &costs)
+    : costs(costs) {}
+
+const std::array<ConvCostModel, ConvImplCount> &
+ConvDispatcher::default_costs() {
+  return default_cost_models;
+}
+
+const char *ConvDispatcher::get_name(ConvImpl impl) {
+  switch (impl) {
+    case ConvImpl::Conv2dDeep:
+      return "conv2d_deep";
+    case ConvImpl::Conv2dShallowIn:
+      return "conv2d_shallowin";
+    case ConvImpl::Conv2d1x1:
+      return "conv2d_1x1";
+    case ConvImpl::Conv2dIm2col:
+      return "conv2d_im2col";
+    case ConvImpl::Filter2dDirect:
+      return "Filter2D(DerefInputFn, MatMulDirectFn)";
+    case ConvImpl::Filter2dIm2colValid:
+      return "Filter2D(ImToColValid, MatMulInt8)";
+    case ConvImpl::Filter2dIm2colPadded:
+      return "Filter2D(ImToColPadded, MatMulInt8)";
+    case ConvImpl::None:
+      return "none";
+  }
+  return "";
+}
+
+bool ConvDispatcher::is_legal(ConvImpl impl, const Filter2dGeometry &filter) {
+  const ImageGeometry &X = filter.input;
+  const ImageGeometry &Y = filter.output;
+  const WindowGeometry &K = filter.window;
+
+  if (filter.IsDepthwise()) return false;
+  if (Y.depth % 4 != 0) return false;
+
+  const padding_t padding = filter.Padding();
+  const bool padded = padding.top > 0 || padding.left > 0 ||
+                      padding.bottom > 0 || padding.right > 0;
+  const bool dilated = K.dilation.row != 1 || K.dilation.col != 1;
+
+  // conv2d_deep() and conv2d_1x1() read an input view with their _ext_view()
+  // variants, and write a channel slice of a larger output with their
+  // OUTPUT_VIEW flags. The other C operators take dense images only.
+  const bool dense = X.IsDense() && Y.IsDense();
+  const bool viewable = X.PixelStride() % 4 == 0 && X.RowStride() % 4 == 0 &&
+                        Y.PixelStride() % 4 == 0 &&
+                        Y.RowStride() == Y.width * Y.PixelStride();
+
+  // No output pixel may have its window entirely in the padding
+  const bool window_overlaps =
+      padding.top < K.shape.height && padding.left < K.shape.width &&
+      padding.bottom < K.shape.height && padding.right < K.shape.width;
+
+  switch (impl) {
+    case ConvImpl::Conv2dDeep:
+      return viewable && X.depth % 4 == 0 && !dilated && window_overlaps;
+    case ConvImpl::Conv2dShallowIn:
+      return dense && X.depth % 4 == 0 &&
+             X.depth * K.shape.width <= VPU_INT8_EPV && !dilated &&
+             window_overlaps;
+    case ConvImpl::Conv2d1x1:
+      return viewable && X.depth % 4 == 0 && K.shape.height == 1 &&
+             K.shape.width == 1 && K.stride.row == 1 && K.stride.col == 1 &&
+             K.start.row == 0 && K.start.col == 0 && X.height == Y.height &&
+             X.width == Y.width;
+    case ConvImpl::Conv2dIm2col:
+      // Any input channel count, as the patch is copied with memcpy()
+      return dense && !dilated && window_overlaps;
+    case ConvImpl::Filter2dDirect:
+      return X.depth % XS3_VPU_VREG_WIDTH_BYTES == 0 && !padded;
+    case ConvImpl::Filter2dIm2colValid:
+      return X.depth % 4 == 0 && !padded;
+    case ConvImpl::Filter2dIm2colPadded:
+      return X.depth % 4 == 0;
+    case ConvImpl::None:
+      return false;
+  }
+  return false;
+}
+
+int64_t ConvDispatcher::estimate_cycles(ConvImpl impl,
+                                        const Filter2dGeometry &filter) const {
+  assert(is_legal(impl, filter));
+
+  const ConvCostModel &model = costs[(int)impl];
+
+  const int64_t K_h = filter.window.shape.height;
+  const int64_t K_w = filter.window.shape.width;
+  const int64_t X_c = filter.input.depth;
+  const int64_t vpu_bytes = XS3_VPU_VREG_WIDTH_BYTES;
+
+  const int64_t pixels = (int64_t)filter.output.height * filter.output.width;
+  const int64_t groups =
+      (filter.output.depth + VPU_INT8_ACC_PERIOD - 1) / VPU_INT8_ACC_PERIOD;
+  const int64_t pixel_vectors = (X_c + vpu_bytes - 1) / vpu_bytes;
+  const int64_t patch_vectors = (K_h * K_w * X_c + vpu_bytes - 1) / vpu_bytes;
+
+  // An input view whose pixels are not contiguous is gathered by the C
+  // operators
+  const bool gathered = filter.input.PixelStride() != filter.input.depth;
+
+  int64_t window_pixels = 0;
+  int64_t copied_vectors = 0;
+  int64_t mac_vectors = 0;
+
+  switch (impl) {
+    case ConvImpl::Conv2dDeep:
+      mac_vectors = K_h * K_w * pixel_vectors;
+      // The K_h input rows of each output row, for each channel group
+      if (gathered) {
+        const int64_t Y_w = filter.output.width;
+        window_pixels = (groups * K_h * filter.input.width + Y_w - 1) / Y_w;
+        copied_vectors = window_pixels * pixel_vectors;
+      }
+      break;
+    case ConvImpl::Filter2dDirect:
+      mac_vectors = K_h * K_w * pixel_vectors;
+      break;
+    case ConvImpl::Conv2dShallowIn:
+      // A whole row of the window is one vector
+      mac_vectors = K_h;
+      break;
+    case ConvImpl::Conv2d1x1:
+      mac_vectors = pixel_vectors;
+      if (gathered) {
+        window_pixels = 1;
+        copied_vectors = pixel_vectors;
+      }
+      break;
+    case ConvImpl::Conv2dIm2col:
+    case ConvImpl::Filter2dIm2colValid:
+    case ConvImpl::Filter2dIm2colPadded:
+      window_pixels = K_h * K_w;
+      copied_vectors = K_h * K_w * pixel_vectors;
+      mac_vectors = patch_vectors;
+      break;
+    case ConvImpl::None:
+      break;
+  }
+
+  return model.per_call +
+         pixels * (model.per_pixel + window_pixels * model.per_window_pixel +
+                   copied_vectors * model.per_patch_vector) +
+         pixels * groups *
+             (model.per_channel_group + mac_vectors * model.per_mac_vector);
+}
+
+std::vector<ConvDispatch> ConvDispatcher::rank(
+    const Filter2dGeometry &filter) const {
+  std::vector<ConvDispatch> dispatches;
+
+  for (int i = 0; i < ConvImplCount; i++) {
+    const ConvImpl impl = (ConvImpl)i;
+    if (is_legal(impl, filter))
+      dispatches.push_back(ConvDispatch{impl, estimate_cycles(impl, filter)});
+  }
+
+  // Stable, so ties go to the implementation listed first in ConvImpl
+  std::stable_sort(dispatches.begin(), dispatches.end(),
+                   [](const ConvDispatch &a, const ConvDispatch &b) {
+                     return a.cycles < b.cycles;
+                   });
+  return dispatches;
+}
+
+ConvDispatch ConvDispatcher::choose(const Filter2dGeometry &filter) const {
+  std::vector<ConvDispatch> dispatches = rank(filter);
+  if (dispatches.empty()) return ConvDispatch{ConvImpl::None, -1};
+  return dispatches.front();
+}
@@ -1,43 +1,15 @@
 #include "Filter2D.hpp"
 
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
 #include "vpu.hpp"
 
 using namespace nn;
 
-constexpr bool Filter2D::UsesPerGroupMemCopy;
 constexpr bool Filter2D_DW::UsesPerGroupMemCopy;
 
-Filter2D::Filter2D(AbstractKernel::Params *kparams, MemCpyFn *memcpy_handler,
-                   AggregateFn *aggregate_handler,
-                   OutputTransformFn *ot_handler, int8_t *scratch_mem)
-    : AbstractKernel(kparams),
-      memcpy_handler(memcpy_handler),
-      aggregate_handler(aggregate_handler),
-      ot_handler(ot_handler),
-      scratch_mem(scratch_mem) {}
-
-/*
-  This is going to compute the output for output_channel_group_count channel
-  groups of the output. The pointer is going to be set to the begining on the
-  next output by output_w_mem_stride. This allows it to address sub-channel
-  regions.
-*/
-void Filter2D::calc_output_pixel_slice(int8_t *Y, int8_t *X, int32_t h,
-                                       int32_t w) {
-  int8_t *input_img = memcpy_handler->memcopy_fn(
-      scratch_mem, X, h,
-      w);  // copy all input channels, channel start is implicitly 0.
-
-  for (int32_t chan_group = 0; chan_group < kparams->output_channel_group_count;
-       chan_group++) {
-    VPURingBuffer A;
-
-    aggregate_handler->aggregate_fn(&A, input_img, chan_group);
-
-    Y = ot_handler->output_transform_fn(Y, &A, chan_group);
-  }
-}
-
 Filter2D_DW::Filter2D_DW(AbstractKernel::Params *kparams,
                          MemCpyFn *memcpy_handler,
                          AggregateFn *aggregate_handler,
@@ -48,29 +20,305 @@ Filter2D_DW::Filter2D_DW(AbstractKernel::Params *kparams,
       aggregate_handler(aggregate_handler),
       ot_handler(ot_handler),
       output_channels_per_group(output_channels_per_group),
-      scratch_mem(scratch_mem) {}
+      scratch_mem(scratch_mem),
+      output_channel_group_offset(0) {}
+
+Filter2D_DW::Filter2D_DW(const Filter2D_DW &parent,
+                         AbstractKernel::Params *kparams, int8_t *scratch_mem)
+    : AbstractKernel(kparams),
+      memcpy_handler(parent.memcpy_handler),
+      aggregate_handler(parent.aggregate_handler),
+      ot_handler(parent.ot_handler),
+      output_channels_per_group(parent.output_channels_per_group),
+      scratch_mem(scratch_mem),
+      output_channel_group_offset(
+          parent.output_channel_group_offset +
+          (kparams->output_channel_slice_offset -
+           parent.kparams->output_channel_slice_offset) /
+              parent.output_channels_per_group) {}
 
 // This is an example of a depthwise conv or max pool
 void Filter2D_DW::calc_output_pixel_slice(int8_t *Y, int8_t *X, int32_t h,
                                           int32_t w) {
   const auto output_groups = this->kparams->output_channel_group_count;
 
+  // AbstractKernel::execute() has no hook at its start, so reset at each row
+  if (w == this->kparams->w_begin)
+    this->memcpy_handler->reset_scratch(this->scratch_mem);
+
   for (int32_t chan_group = 0; chan_group < output_groups; chan_group++) {
     VPURingBuffer A;
 
-    int c = this->kparams->output_channel_slice_offset +
+    // The input channel, which a view's offset does not apply to
+    int c = this->kparams->output_channel_slice_offset -
+            this->kparams->output_channel_view_offset +
             chan_group * this->output_channels_per_group;
 
     // This will know how many channels it is copying
     int8_t *input_img =
         this->memcpy_handler->memcopy_fn(this->scratch_mem, X, h, w, c);
 
-    this->aggregate_handler->aggregate_fn(&A, input_img, chan_group);
+    this->aggregate_handler->aggregate_fn(
+        &A, input_img, this->output_channel_group_offset + chan_group);
 
     // must calc size of current channel group
     // offset from Y in order to write out result
     // number of bytes to write to result
     // offset into transform specific arrays
-    Y = this->ot_handler->output_transform_fn(Y, &A, chan_group);
+    Y = this->ot_handler->output_transform_fn(
+        Y, &A, this->output_channel_group_offset + chan_group);
+  }
+}
+
+constexpr bool Filter2D_Pool2x2::UsesPerGroupMemCopy;
+
+Filter2D_Pool2x2::Filter2D_Pool2x2(AbstractKernel::Params *kparams,
+                                   MemCpyFn *memcpy_handler,
+                                   AggregateFn *aggregate_handler,
+                                   OutputTransformFn *ot_handler,
+                                   PoolType pool_type, int8_t *scratch_mem)
+    : AbstractKernel(kparams),
+      memcpy_handler(memcpy_handler),
+      aggregate_handler(aggregate_handler),
+      ot_handler(ot_handler),
+      pool_type(pool_type),
+      scratch_mem(scratch_mem),
+      output_channel_group_offset(0) {
+  // The outputs are pooled from a buffer on the stack
+  assert(!ot_handler->requires_output_image());
+}
+
+Filter2D_Pool2x2::Filter2D_Pool2x2(const Filter2D_Pool2x2 &parent,
+                                   AbstractKernel::Params *kparams,
+                                   int8_t *scratch_mem)
+    : AbstractKernel(kparams),
+      memcpy_handler(parent.memcpy_handler),
+      aggregate_handler(parent.aggregate_handler),
+      ot_handler(parent.ot_handler),
+      pool_type(parent.pool_type),
+      scratch_mem(scratch_mem),
+      output_channel_group_offset(
+          parent.output_channel_group_offset +
+          (kparams->output_channel_slice_offset -
+           parent.kparams->output_channel_slice_offset) /
+              VPU_INT8_ACC_PERIOD) {}
+
+void Filter2D_Pool2x2::calc_output_pixel_slice(int8_t *Y, int8_t *X, int32_t h,
+                                               int32_t w) {
+  const int patch_bytes = get_patch_bytes();
+
+  // AbstractKernel::execute() has no hook at its start, so reset at each row
+  if (w == this->kparams->w_begin)
+    for (int i = 0; i < 4; i++)
+      this->memcpy_handler->reset_scratch(this->scratch_mem + i * patch_bytes);
+
+  // The patches of the 2x2 block of filter outputs, in row major order
+  int8_t *patches[4];
+  for (int i = 0; i < 4; i++)
+    patches[i] = this->memcpy_handler->memcopy_fn(
+        this->scratch_mem + i * patch_bytes, X, 2 * h + i / 2, 2 * w + i % 2);
+
+  for (int32_t chan_group = 0;
+       chan_group < this->kparams->output_channel_group_count; chan_group++) {
+    const int32_t cog = this->output_channel_group_offset + chan_group;
+
+    // Whole vectors, as the output transform may store one
+    alignas(4) int8_t outputs[4][XS3_VPU_VREG_WIDTH_BYTES];
+    int32_t count = 0;
+
+    for (int i = 0; i < 4; i++) {
+      VPURingBuffer A;
+      this->aggregate_handler->aggregate_fn(&A, patches[i], cog);
+      count = this->ot_handler->output_transform_fn(outputs[i], &A, cog) -
+              outputs[i];
+    }
+
+    if (pool_type == PoolType::Max) {
+      for (int k = 0; k < count; k++)
+        Y[k] = std::max(std::max(outputs[0][k], outputs[1][k]),
+                        std::max(outputs[2][k], outputs[3][k]));
+    } else {
+      for (int k = 0; k < count; k++) {
+        int32_t sum = (int32_t)outputs[0][k] + outputs[1][k] + outputs[2][k] +
+                      outputs[3][k];
+        Y[k] = (int8_t)((sum + 2) >> 2);
+      }
+    }
+
+    Y += count;
+  }
+}
+
+constexpr bool Filter2D_DWPW::UsesPerGroupMemCopy;
+
+Filter2D_DWPW::Filter2D_DWPW(AbstractKernel::Params *kparams,
+                             MemCpyFn *dw_memcpy_handler,
+                             AggregateFn *dw_aggregate_handler,
+                             OutputTransformFn *dw_ot_handler,
+                             int32_t depthwise_channels,
+                             AggregateFn *pw_aggregate_handler,
+                             OutputTransformFn *pw_ot_handler,
+                             int8_t *scratch_mem)
+    : AbstractKernel(kparams),
+      dw_memcpy_handler(dw_memcpy_handler),
+      dw_aggregate_handler(dw_aggregate_handler),
+      dw_ot_handler(dw_ot_handler),
+      pw_aggregate_handler(pw_aggregate_handler),
+      pw_ot_handler(pw_ot_handler),
+      depthwise_channels(depthwise_channels),
+      scratch_mem(scratch_mem),
+      output_channel_group_offset(0) {
+  // The depthwise outputs go to the scratch memory
+  assert(!dw_ot_handler->requires_output_image());
+}
+
+Filter2D_DWPW::Filter2D_DWPW(const Filter2D_DWPW &parent,
+                             AbstractKernel::Params *kparams,
+                             int8_t *scratch_mem)
+    : AbstractKernel(kparams),
+      dw_memcpy_handler(parent.dw_memcpy_handler),
+      dw_aggregate_handler(parent.dw_aggregate_handler),
+      dw_ot_handler(parent.dw_ot_handler),
+      pw_aggregate_handler(parent.pw_aggregate_handler),
+      pw_ot_handler(parent.pw_ot_handler),
+      depthwise_channels(parent.depthwise_channels),
+      scratch_mem(scratch_mem),
+      output_channel_group_offset(
+          parent.output_channel_group_offset +
+          (kparams->output_channel_slice_offset -
+           parent.kparams->output_channel_slice_offset) /
+              VPU_INT8_ACC_PERIOD) {}
+
+void Filter2D_DWPW::calc_output_pixel_slice(int8_t *Y, int8_t *X, int32_t h,
+                                            int32_t w) {
+  int8_t *patch_mem = this->scratch_mem;
+  int8_t *V = this->scratch_mem + get_patch_bytes();
+
+  // AbstractKernel::execute() has no hook at its start, so reset at each row
+  if (w == this->kparams->w_begin)
+    this->dw_memcpy_handler->reset_scratch(patch_mem);
+
+  // Depthwise, all channels of the intermediate pixel
+  const int32_t dw_groups =
+      (depthwise_channels + VPU_INT8_ACC_PERIOD - 1) / VPU_INT8_ACC_PERIOD;
+
+  int8_t *V_p = V;
+  for (int32_t chan_group = 0; chan_group < dw_groups; chan_group++) {
+    VPURingBuffer A;
+
+    int8_t *patch = this->dw_memcpy_handler->memcopy_fn(
+        patch_mem, X, h, w, chan_group * VPU_INT8_ACC_PERIOD);
+    this->dw_aggregate_handler->aggregate_fn(&A, patch, chan_group);
+    V_p = this->dw_ot_handler->output_transform_fn(V_p, &A, chan_group);
+  }
+
+  // The final vector load of the pointwise aggregation may read past the
+  // intermediate channels, as it does past an im2col patch
+  memset(V + depthwise_channels, 0, XS3_VPU_VREG_WIDTH_BYTES);
+
+  // Pointwise
+  for (int32_t chan_group = 0;
+       chan_group < this->kparams->output_channel_group_count; chan_group++) {
+    VPURingBuffer A;
+    const int32_t cog = this->output_channel_group_offset + chan_group;
+
+    this->pw_aggregate_handler->aggregate_fn(&A, V, cog);
+    Y = this->pw_ot_handler->output_transform_fn(Y, &A, cog);
+  }
+}
+
+constexpr bool Filter2D_Winograd::UsesPerGroupMemCopy;
+
+Filter2D_Winograd::Filter2D_Winograd(const ImageGeometry &output_image,
+                                     AbstractKernel::Params *kparams,
+                                     WinogradInputTransform *input_handler,
+                                     MatMulWinograd *aggregate_handler,
+                                     OutputTransformFn *ot_handler,
+                                     int8_t *scratch_mem)
+    : AbstractKernel(kparams),
+      input_handler(input_handler),
+      aggregate_handler(aggregate_handler),
+      ot_handler(ot_handler),
+      scratch_mem(scratch_mem),
+      output_channel_group_offset(0),
+      output_height(output_image.height),
+      output_width(output_image.width),
+      output_row_bytes(output_image.RowStride()),
+      output_pixel_bytes(output_image.PixelStride()) {}
+
+Filter2D_Winograd::Filter2D_Winograd(const Filter2D_Winograd &parent,
+                                     AbstractKernel::Params *kparams,
+                                     int8_t *scratch_mem)
+    : AbstractKernel(kparams),
+      input_handler(parent.input_handler),
+      aggregate_handler(parent.aggregate_handler),
+      ot_handler(parent.ot_handler),
+      scratch_mem(scratch_mem),
+      output_channel_group_offset(
+          parent.output_channel_group_offset +
+          (kparams->output_channel_slice_offset -
+           parent.kparams->output_channel_slice_offset) /
+              VPU_INT8_ACC_PERIOD),
+      output_height(parent.output_height),
+      output_width(parent.output_width),
+      output_row_bytes(parent.output_row_bytes),
+      output_pixel_bytes(parent.output_pixel_bytes) {}
+
+AbstractKernel::Params Filter2D_Winograd::get_tile_params(
+    const ImageGeometry &output_image, const ImageRegion &output_region) {
+  const int tile = WinogradF2x3::OutputTile;
+
+  assert(output_region.start.row % tile == 0);
+  assert(output_region.start.col % tile == 0);
+  assert(output_region.shape.height % tile == 0 ||
+         output_region.EndVect().row == output_image.height);
+  assert(output_region.shape.width % tile == 0 ||
+         output_region.EndVect().col == output_image.width);
+
+  ImageGeometry tiles((output_image.height + tile - 1) / tile,
+                      (output_image.width + tile - 1) / tile,
+                      output_image.depth);
+  ImageRegion tile_region(output_region.start.row / tile,
+                          output_region.start.col / tile,
+                          output_region.start.channel,
+                          (output_region.shape.height + tile - 1) / tile,
+                          (output_region.shape.width + tile - 1) / tile,
+                          output_region.shape.depth);
+
+  AbstractKernel::Params kparams(tiles, tile_region, VPU_INT8_ACC_PERIOD);
+  kparams.output_w_mem_stride = tile * output_image.PixelStride();
+  kparams.output_h_mem_stride =
+      tile * output_image.RowStride() -
+      tile_region.shape.width * kparams.output_w_mem_stride;
+  return kparams;
+}
+
+void Filter2D_Winograd::calc_output_pixel_slice(int8_t *Y, int8_t *X,
+                                                int32_t h, int32_t w) {
+  const int tile = WinogradF2x3::OutputTile;
+
+  int8_t *T = this->input_handler->memcopy_fn(this->scratch_mem, X, h, w);
+
+  const int rows = std::min(tile, output_height - tile * h);
+  const int cols = std::min(tile, output_width - tile * w);
+
+  for (int32_t chan_group = 0;
+       chan_group < this->kparams->output_channel_group_count; chan_group++) {
+    const int32_t cog = this->output_channel_group_offset + chan_group;
+
+    VPURingBuffer A[tile * tile];
+    this->aggregate_handler->aggregate_fn(A, T, cog);
+
+    int8_t *Y_next = Y;
+    for (int i = rows - 1; i >= 0; i--) {
+      for (int j = cols - 1; j >= 0; j--) {
+        int8_t *Y_pixel = Y + i * output_row_bytes + j * output_pixel_bytes;
+        Y_next = this->ot_handler->output_transform_fn(
+            Y_pixel, &A[i * tile + j], cog);
+      }
+    }
+
+    // The first pixel was written last
+    Y = Y_next;
   }
 }
@@ -0,0 +1,135 @@
+#include "InteriorBorderPlanner.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace nn;
+
+InteriorBorderPlanner::Regions InteriorBorderPlanner::split(
+    const Filter2dGeometry &filter) {
+  const ImageGeometry &X = filter.input;
+  const ImageGeometry &Y = filter.output;
+
+  // The interior rows and columns are each contiguous, as the window moves
+  // monotonically across the input image.
+  int row_begin = Y.height, row_end = 0;
+  for (int row = 0; row < Y.height; row++) {
+    WindowLocation loc = filter.GetWindow(row, 0, 0);
+    if (loc.InputStart().row >= 0 && loc.InputEnd().row < X.height) {
+      row_begin = std::min(row_begin, row);
+      row_end = row + 1;
+    }
+  }
+
+  int col_begin = Y.width, col_end = 0;
+  for (int col = 0; col < Y.width; col++) {
+    WindowLocation loc = filter.GetWindow(0, col, 0);
+    if (loc.InputStart().col >= 0 && loc.InputEnd().col < X.width) {
+      col_begin = std::min(col_begin, col);
+      col_end = col + 1;
+    }
+  }
+
+  if (row_begin >= row_end || col_begin >= col_end) {
+    Regions regions(ImageRegion(0, 0, 0, 0, 0, 0));
+    regions.border.push_back(
+        ImageRegion(0, 0, 0, Y.height, Y.width, Y.depth));
+    return regions;
+  }
+
+  const int rows = row_end - row_begin;
+
+  Regions regions(ImageRegion(row_begin, col_begin, 0, rows,
+                              col_end - col_begin, Y.depth));
+
+  if (row_begin > 0)
+    regions.border.push_back(ImageRegion(0, 0, 0, row_begin, Y.width, Y.depth));
+  if (col_begin > 0)
+    regions.border.push_back(
+        ImageRegion(row_begin, 0, 0, rows, col_begin, Y.depth));
+  if (col_end < Y.width)
+    regions.border.push_back(ImageRegion(row_begin, col_end, 0, rows,
+                                         Y.width - col_end, Y.depth));
+  if (row_end < Y.height)
+    regions.border.push_back(ImageRegion(row_end, 0, 0, Y.height - row_end,
+                                         Y.width, Y.depth));
+  return regions;
+}
+
+InteriorBorderPlanner::InteriorBorderPlanner(
+    const Filter2dGeometry &filter, int8_t padding_value,
+    InteriorCopy interior_copy, AggregateFn *interior_aggregate_handler,
+    AggregateFn *border_aggregate_handler, OutputTransformFn *ot_handler,
+    int8_t *scratch_mem) {
+  // Only dense filters are supported
+  assert(filter.window.shape.depth == filter.input.depth);
+
+  const ImageGeometry &X = filter.input;
+  const ImageGeometry &Y = filter.output;
+  const WindowGeometry &K = filter.window;
+
+  const Regions regions = split(filter);
+
+  padded_params.reset(new ImToColPadded::Params(X, K, filter.Padding(),
+                                                X.depth, padding_value));
+  border_memcpy.reset(new ImToColPadded(padded_params.get()));
+
+  MemCpyFn *interior_memcpy;
+  if (interior_copy == InteriorCopy::Deref) {
+    deref_params.reset(new DerefInputFn::Params(X, K));
+    deref_memcpy.reset(new DerefInputFn(deref_params.get()));
+    interior_memcpy = deref_memcpy.get();
+  } else {
+    valid_params.reset(new ImToColValid::Params(X, K, X.depth));
+    valid_memcpy.reset(new ImToColValid(valid_params.get()));
+    interior_memcpy = valid_memcpy.get();
+  }
+
+  if (regions.interior.shape.height > 0) {
+    // The interior is executed as an image starting at its first pixel, so
+    // that the valid-only handlers never address outside the input image.
+    const ImageRegion &interior = regions.interior;
+    const ImageVect input_start =
+        filter.GetWindow(interior.start.row, interior.start.col, 0)
+            .InputStart();
+
+    add_kernel(Y,
+               ImageRegion(0, 0, 0, interior.shape.height,
+                           interior.shape.width, interior.shape.depth),
+               interior, false,
+               Y.Index(interior.start.row, interior.start.col, 0),
+               X.Index(input_start.row, input_start.col, 0),
+               interior_memcpy, interior_aggregate_handler, ot_handler,
+               scratch_mem);
+  }
+
+  for (auto &border : regions.border)
+    add_kernel(Y, border, border, true, 0, 0, border_memcpy.get(),
+               border_aggregate_handler, ot_handler, scratch_mem);
+}
+
+void InteriorBorderPlanner::add_kernel(
+    const ImageGeometry &Y, const ImageRegion &region,
+    const ImageRegion &output_region, bool padded, int32_t output_offset,
+    int32_t input_offset, MemCpyFn *memcpy_handler,
+    AggregateFn *aggregate_handler, OutputTransformFn *ot_handler,
+    int8_t *scratch_mem) {
+  kparams.emplace_back(
+      new AbstractKernel::Params(Y, region, VPU_INT8_ACC_PERIOD));
+  filters.emplace_back(new Filter2D(kparams.back().get(), memcpy_handler,
+                                    aggregate_handler, ot_handler,
+                                    scratch_mem));
+  kernels.push_back(Kernel{output_region, padded, output_offset, input_offset,
+                           filters.back().get()});
+}
+
+int InteriorBorderPlanner::get_scratch_bytes() {
+  int bytes = 0;
+  for (auto &kernel : kernels)
+    bytes = std::max(bytes, kernel.filter->get_scratch_bytes());
+  return bytes;
+}
+
+void InteriorBorderPlanner::execute(int8_t *Y, int8_t *X) {
+  for (auto &kernel : kernels) kernel.execute(Y, X);
+}
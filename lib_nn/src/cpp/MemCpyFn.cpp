@@ -1,5 +1,7 @@
 #include "MemCpyFn.hpp"
 
+#include <cstring>
+
 #include "vpu_sim.h"
 
 using namespace nn;
@@ -46,13 +48,6 @@ void DerefInputFn::Params::Serialize(std::ostream &stream) const {
 int DerefInputFn::get_scratch_bytes() { return 0; }
 int DerefInputFn::get_overread_bytes() { return 0; }
 
-int8_t *DerefInputFn::memcopy_fn(int8_t *T, int8_t *X, int32_t output_v_coord,
-                                 int32_t output_h_coord,
-                                 int32_t output_c_coord) {
-  return X + (int)(output_v_coord * params->bytes_per_h_line +
-                   output_h_coord * params->bytes_per_pixel + output_c_coord);
-}
-
 int ImToColPadded::get_scratch_bytes() {
   return params->kernel_height * params->kernel_width *
              params->bytes_per_copy_per_channel +
@@ -81,8 +76,8 @@ ImToColPadded::Params::Params(const ImageGeometry &X, const WindowGeometry &K,
 
   padding_val = pad_val;
 
-  bytes_per_pixel = X.PixelBytes();
-  bytes_per_h_line = X.RowBytes();
+  bytes_per_pixel = X.PixelStride();
+  bytes_per_h_line = X.RowStride();
 
   padding_top = padding.top;
   padding_left = padding.left;
@@ -117,8 +112,8 @@ ImToColPadded::Params::Params(const Filter2dGeometry &filter,
 
   padding_val = pad_val;
 
-  bytes_per_pixel = filter.input.PixelBytes();
-  bytes_per_h_line = filter.input.RowBytes();
+  bytes_per_pixel = filter.input.PixelStride();
+  bytes_per_h_line = filter.input.RowStride();
 
   // horizontal_mem_stride = filter.input.RowBytes();
 
@@ -242,6 +237,80 @@ int8_t *ImToColPadded::memcopy_fn_impl(int8_t *T, int8_t *X,
   return T_in;
 }
 
+ImToColPaddedInt16::Params::Params(const ImageGeometry &X,
+                                   const WindowGeometry &K,
+                                   const padding_t &padding,
+                                   const int input_ch_per_output,
+                                   const int16_t pad_val)
+    : ImToColPadded::Params(X, K, padding, input_ch_per_output, 0) {
+  assert(X.channel_depth == sizeof(int16_t));
+  padding_val = pad_val;
+  bytes_per_copy_per_channel = input_ch_per_output * sizeof(int16_t);
+}
+
+int ImToColPaddedInt16::get_scratch_bytes() {
+  return params->kernel_height * params->kernel_width *
+             params->bytes_per_copy_per_channel +
+         XS3_VPU_VREG_WIDTH_BYTES;
+}
+
+int ImToColPaddedInt16::get_overread_bytes() {
+  return XS3_VPU_VREG_WIDTH_BYTES;
+}
+
+int8_t *ImToColPaddedInt16::memcopy_fn(int8_t *T, int8_t *X,
+                                       int32_t output_v_coord,
+                                       int32_t output_h_coord,
+                                       int32_t output_c_coord) {
+  int8_t *T_in = T;
+
+  const int32_t elements_per_copy =
+      params->bytes_per_copy_per_channel / sizeof(int16_t);
+
+  int32_t input_v_coord =
+      output_v_coord * params->vertical_stride - params->padding_top;
+  int32_t strided_h_coord =
+      output_h_coord * params->horizontal_stride - params->padding_left;
+  int8_t *X_cur_p =
+      X + (int)(strided_h_coord * params->bytes_per_pixel +
+                output_c_coord * sizeof(int16_t) +
+                input_v_coord * params->bytes_per_h_line);
+
+  for (int32_t k_height = 0; k_height < params->kernel_height; k_height++) {
+    int p = input_v_coord < 0;
+    p |= input_v_coord >= params->input_v_length;
+
+    int32_t input_h_coord = strided_h_coord;
+
+    for (int32_t k_width = 0; k_width < params->kernel_width; k_width++) {
+      int q = p;
+      q |= input_h_coord < 0;
+      q |= input_h_coord >= params->input_h_length;
+
+      if (q) {
+        int16_t *T16 = (int16_t *)T;
+        for (int32_t i = 0; i < elements_per_copy; i++)
+          T16[i] = (int16_t)params->padding_val;
+      } else {
+        memcpy(T, X_cur_p, params->bytes_per_copy_per_channel);
+      }
+
+      T += params->bytes_per_copy_per_channel;
+
+      X_cur_p += params->x_h_mem_stride;
+
+      input_h_coord += params->horizontal_dilation;
+    }
+    input_v_coord += params->vertical_dilation;
+
+    X_cur_p += params->x_v_mem_stride;
+  }
+
+  memset(T, 0, XS3_VPU_VREG_WIDTH_BYTES);
+
+  return T_in;
+}
+
 /*
 This constructor is used for testing
 */
@@ -252,10 +321,10 @@ ImToColValid::Params::Params(const ImageGeometry &X, const WindowGeometry &K,
   // / CHAR_BIT;
   int bytes_per_copy_per_channel = (input_ch_per_output * CHAR_BIT) / CHAR_BIT;
 
-  bytes_per_pixel = X.PixelBytes();
-  bytes_per_h_line = X.RowBytes();
+  bytes_per_pixel = X.PixelStride();
+  bytes_per_h_line = X.RowStride();
 
-  assert(X.RowBytes() == X.width * bytes_per_pixel);
+  assert(bytes_per_h_line >= X.width * bytes_per_pixel);
 
   // This is the amount to copy in vpu words (round up)
   input_channel_groups =
@@ -333,8 +402,8 @@ int8_t *ImToColValid::memcopy_fn_impl(int8_t *T, int8_t *X,
   return T_in;
 }
 
-extern "C" int8_t *im_to_col_valid_impl_asm(void *params, int8_t *T, int8_t *X,
-                                            int32_t output_v_coord,
+extern "C" int8_t *im_to_col_valid_impl_asm(const void *params, int8_t *T,
+                                            int8_t *X, int32_t output_v_coord,
                                             int32_t output_h_coord,
                                             int32_t output_c_coord);
 int8_t *ImToColValid::memcopy_fn(int8_t *T, int8_t *X, int32_t output_v_coord,
@@ -353,3 +422,171 @@ int8_t *ImToColPadded::memcopy_fn(int8_t *T, int8_t *X, int32_t output_v_coord,
                                   int32_t output_c_coord) {
   return memcopy_fn_impl(T, X, output_v_coord, output_h_coord, output_c_coord);
 }
+
+namespace {
+
+/*
+  The header of an ImToColSliding scratch buffer. It is accessed with memcpy()
+  as the scratch buffer is only word aligned.
+*/
+struct SlidingState {
+  // The image, row, column and channel of the last copy, or a null image if
+  // the next copy must be of the whole patch.
+  int8_t *X;
+  int32_t h;
+  int32_t w;
+  int32_t c;
+  // The buffer column at which the last patch started
+  int32_t first_column;
+};
+
+constexpr int sliding_state_bytes = (sizeof(SlidingState) + 3) & ~3;
+
+}  // namespace
+
+ImToColSliding::Params::Params(const Filter2dGeometry &filter,
+                               const int8_t pad_val, const int window_count) {
+  // Only dense filters copy whole input pixels
+  assert(filter.window.shape.depth == filter.input.depth);
+  assert(window_count >= 2);
+
+  kernel_height = filter.window.shape.height;
+  kernel_width = filter.window.shape.width;
+
+  input_v_length = filter.input.height;
+  input_h_length = filter.input.width;
+
+  vertical_stride = filter.window.stride.row;
+  horizontal_stride = filter.window.stride.col;
+  vertical_dilation = filter.window.dilation.row;
+  horizontal_dilation = filter.window.dilation.col;
+
+  padding_top = filter.Padding().top;
+  padding_left = filter.Padding().left;
+  padding_val = pad_val;
+
+  bytes_per_h_line = filter.input.RowStride();
+  bytes_per_pixel = filter.input.PixelStride();
+
+  bytes_per_copy_per_channel = filter.input.PixelBytes();
+  bytes_per_column = kernel_height * bytes_per_copy_per_channel;
+  buffer_columns = window_count * kernel_width;
+
+  output_width = filter.output.width;
+
+  slides = horizontal_stride == 1 && horizontal_dilation == 1;
+}
+
+int ImToColSliding::get_scratch_bytes() {
+  return sliding_state_bytes +
+         params->buffer_columns * params->bytes_per_column +
+         XS3_VPU_VREG_WIDTH_BYTES;
+}
+
+int ImToColSliding::get_overread_bytes() { return 0; }
+
+void ImToColSliding::reset_scratch(int8_t *T) {
+  SlidingState state = {nullptr, 0, 0, 0, 0};
+  memcpy(T, &state, sizeof(state));
+}
+
+void ImToColSliding::copy_column(int8_t *T, int8_t *X, int32_t output_v_coord,
+                                 int32_t input_h_coord, int32_t c) {
+  const int q = input_h_coord < 0 || input_h_coord >= params->input_h_length;
+
+  int32_t input_v_coord =
+      output_v_coord * params->vertical_stride - params->padding_top;
+
+  for (int32_t k_height = 0; k_height < params->kernel_height; k_height++) {
+    if (q || input_v_coord < 0 || input_v_coord >= params->input_v_length) {
+      memset(T, params->padding_val, params->bytes_per_copy_per_channel);
+    } else {
+      memcpy(T,
+             X + (int)(input_v_coord * params->bytes_per_h_line +
+                       input_h_coord * params->bytes_per_pixel + c),
+             params->bytes_per_copy_per_channel);
+    }
+
+    T += params->bytes_per_copy_per_channel;
+    input_v_coord += params->vertical_dilation;
+  }
+}
+
+int8_t *ImToColSliding::memcopy_fn(int8_t *T, int8_t *X,
+                                   int32_t output_v_coord,
+                                   int32_t output_h_coord,
+                                   int32_t output_c_coord) {
+  SlidingState state;
+  memcpy(&state, T, sizeof(state));
+
+  int8_t *columns = T + sliding_state_bytes;
+  const int32_t column_bytes = params->bytes_per_column;
+
+  const int32_t input_h_coord =
+      output_h_coord * params->horizontal_stride - params->padding_left;
+
+  if (params->slides && state.X == X && state.h == output_v_coord &&
+      state.c == output_c_coord && state.w + 1 == output_h_coord) {
+    int32_t first_column = state.first_column + 1;
+
+    if (first_column + params->kernel_width > params->buffer_columns) {
+      // The buffer holds at least two windows, so these never overlap
+      memcpy(columns, columns + first_column * column_bytes,
+             (params->kernel_width - 1) * column_bytes);
+      first_column = 0;
+    }
+
+    const int32_t last_column = params->kernel_width - 1;
+    copy_column(columns + (first_column + last_column) * column_bytes, X,
+                output_v_coord, input_h_coord + last_column, output_c_coord);
+
+    state.first_column = first_column;
+  } else {
+    for (int32_t k_width = 0; k_width < params->kernel_width; k_width++)
+      copy_column(columns + k_width * column_bytes, X, output_v_coord,
+                  input_h_coord + k_width * params->horizontal_dilation,
+                  output_c_coord);
+
+    state.first_column = 0;
+  }
+
+  state.X = output_h_coord + 1 < params->output_width ? X : nullptr;
+  state.h = output_v_coord;
+  state.w = output_h_coord;
+  state.c = output_c_coord;
+  memcpy(T, &state, sizeof(state));
+
+  int8_t *patch = columns + state.first_column * column_bytes;
+
+  // Write padding to the tail, zeros is fastest. This only overwrites columns
+  // which have not been copied yet.
+  memset(patch + params->kernel_width * column_bytes, 0,
+         XS3_VPU_VREG_WIDTH_BYTES);
+
+  return patch;
+}
+
+std::vector<int8_t> ImToColSliding::transpose_kernel_weights(
+    const int8_t *raw_weights, const std::array<int, 4> &shape) {
+  const int output_channels = shape[0];
+  const int kernel_height = shape[1];
+  const int kernel_width = shape[2];
+  const int input_channels = shape[3];
+
+  std::vector<int8_t> weights(output_channels * kernel_height * kernel_width *
+                              input_channels);
+
+  int8_t *dst = weights.data();
+  for (int oc = 0; oc < output_channels; oc++) {
+    const int8_t *kernel =
+        raw_weights + oc * kernel_height * kernel_width * input_channels;
+    for (int kw = 0; kw < kernel_width; kw++) {
+      for (int kh = 0; kh < kernel_height; kh++) {
+        memcpy(dst, kernel + (kh * kernel_width + kw) * input_channels,
+               input_channels);
+        dst += input_channels;
+      }
+    }
+  }
+  return weights;
+}
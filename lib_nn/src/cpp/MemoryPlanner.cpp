@@ -0,0 +1,154 @@
+#include "MemoryPlanner.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace nn;
+
+constexpr int MemoryPlanner::Alignment;
+
+static int align_bytes(int bytes) {
+  const int align = MemoryPlanner::Alignment;
+  return (bytes + align - 1) & ~(align - 1);
+}
+
+MemoryPlanner::TensorId MemoryPlanner::add_tensor(int bytes) {
+  assert(bytes >= 0);
+  tensors.push_back(Tensor{bytes, 0, -1, -1, false});
+  return (TensorId)tensors.size() - 1;
+}
+
+void MemoryPlanner::mark_output(TensorId tensor) {
+  assert(tensor >= 0 && tensor < (int)tensors.size());
+  tensors[tensor].is_output = true;
+}
+
+int MemoryPlanner::add_op(const std::vector<TensorId> &inputs,
+                          const std::vector<TensorId> &outputs,
+                          int scratch_bytes, int overread_bytes) {
+  assert(scratch_bytes >= 0);
+  assert(overread_bytes >= 0);
+
+  const int op = (int)ops.size();
+
+  for (auto t : inputs) {
+    assert(t >= 0 && t < (int)tensors.size());
+    Tensor &tensor = tensors[t];
+    tensor.last_consumer = op;
+    tensor.overread_bytes = std::max(tensor.overread_bytes, overread_bytes);
+  }
+
+  for (auto t : outputs) {
+    assert(t >= 0 && t < (int)tensors.size());
+    Tensor &tensor = tensors[t];
+    // Each tensor is written by one operator, before it is read
+    assert(tensor.producer == -1);
+    assert(tensor.last_consumer == -1);
+    tensor.producer = op;
+  }
+
+  ops.push_back(Op{scratch_bytes});
+  return op;
+}
+
+int MemoryPlanner::get_unshared_bytes() const {
+  int bytes = 0;
+  for (auto &tensor : tensors) bytes += align_bytes(tensor.bytes);
+  for (auto &op : ops) bytes += align_bytes(op.scratch_bytes);
+  return bytes;
+}
+
+namespace {
+
+/**
+ * A buffer to be placed in the arena, live from operator `first` to operator
+ * `last` inclusive.
+ */
+struct Buffer {
+  int bytes;
+  int overread_bytes;
+  int first, last;
+  int offset;
+
+  bool overlaps(const Buffer &other) const {
+    return first <= other.last && other.first <= last;
+  }
+};
+
+}  // namespace
+
+MemoryPlanner::Plan MemoryPlanner::plan() const {
+  const int last_op = std::max((int)ops.size() - 1, 0);
+
+  std::vector<Buffer> buffers;
+  buffers.reserve(tensors.size() + ops.size());
+
+  for (auto &tensor : tensors) {
+    const int first = (tensor.producer == -1) ? 0 : tensor.producer;
+    int last = std::max(first, tensor.last_consumer);
+    if (tensor.is_output) last = last_op;
+    buffers.push_back(Buffer{align_bytes(tensor.bytes), tensor.overread_bytes,
+                             first, last, -1});
+  }
+
+  for (int op = 0; op < (int)ops.size(); ++op)
+    buffers.push_back(
+        Buffer{align_bytes(ops[op].scratch_bytes), 0, op, op, -1});
+
+  std::vector<int> order;
+  for (int i = 0; i < (int)buffers.size(); ++i)
+    if (buffers[i].bytes > 0) order.push_back(i);
+
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+    return buffers[a].bytes > buffers[b].bytes;
+  });
+
+  std::vector<int> placed;
+  std::vector<const Buffer *> live;
+
+  for (auto index : order) {
+    Buffer &buffer = buffers[index];
+
+    live.clear();
+    for (auto p : placed)
+      if (buffer.overlaps(buffers[p])) live.push_back(&buffers[p]);
+
+    std::sort(live.begin(), live.end(), [](const Buffer *a, const Buffer *b) {
+      return a->offset < b->offset;
+    });
+
+    // The lowest gap between live buffers which can hold this one. All
+    // offsets and sizes are aligned, so the gaps are too.
+    int offset = 0;
+    for (auto other : live) {
+      if (other->offset - offset >= buffer.bytes) break;
+      offset = std::max(offset, other->offset + other->bytes);
+    }
+
+    buffer.offset = offset;
+    placed.push_back(index);
+  }
+
+  Plan plan;
+  plan.arena_bytes = 0;
+
+  for (auto &buffer : buffers) {
+    if (buffer.offset < 0) {
+      buffer.offset = 0;
+      continue;
+    }
+    plan.arena_bytes = std::max(
+        plan.arena_bytes, buffer.offset + buffer.bytes + buffer.overread_bytes);
+  }
+  plan.arena_bytes = align_bytes(plan.arena_bytes);
+
+  for (int t = 0; t < (int)tensors.size(); ++t)
+    plan.tensor_offsets.push_back(buffers[t].offset);
+
+  for (int op = 0; op < (int)ops.size(); ++op)
+    plan.scratch_offsets.push_back((ops[op].scratch_bytes == 0)
+                                       ? -1
+                                       : buffers[tensors.size() + op].offset);
+
+  return plan;
+}
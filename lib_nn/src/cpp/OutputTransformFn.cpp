@@ -4,6 +4,7 @@
 #include <cassert>
 #include <cmath>
 #include <cstdint>
+#include <limits>
 #include <tuple>
 
 #include "../src/asm/asm_constants.h"
@@ -382,6 +383,145 @@ int8_t *OT_int8::output_transform_fn(int8_t *Y, VPURingBuffer *A,
   return output_transform_fn_impl_asm(this->params, Y, A, output_channel_group);
 #endif  // NN_USE_REF
 }
+int8_t *OT_int8_residual::output_transform_fn(int8_t *Y, VPURingBuffer *A,
+                                              int32_t output_channel_group) {
+  assert(Y_base != nullptr && R_base != nullptr);
+
+  // add_elementwise() loads whole vectors from its inputs
+  vpu_vector_t conv_out;
+
+  int8_t *T = (int8_t *)&conv_out;
+  const int32_t count = ot.output_transform_fn(T, A, output_channel_group) - T;
+
+  const int8_t *R = R_base + (Y - Y_base);
+  add_elementwise(Y, T, R, params->add_params, 0, count);
+
+  return Y + count;
+}
+
+std::vector<int8_t> OT_int8_lut::make_table(double (*activation)(double),
+                                            double input_scale,
+                                            int input_zero_point,
+                                            double output_scale,
+                                            int output_zero_point) {
+  std::vector<int8_t> lut(1 << 8);
+
+  for (int i = INT8_MIN; i <= INT8_MAX; i++) {
+    const double y = activation(input_scale * (i - input_zero_point));
+    const int64_t q = std::llround(y / output_scale) + output_zero_point;
+    lut[(uint8_t)i] = (int8_t)saturate_non_sym(q, 8);
+  }
+
+  return lut;
+}
+
+int8_t *OT_int8_lut::output_transform_fn(int8_t *Y, VPURingBuffer *A,
+                                         int32_t output_channel_group) {
+  int8_t *Y_end = ot.output_transform_fn(Y, A, output_channel_group);
+
+  // The outputs have only just been written, so are looked up in place
+  lookup8((uint8_t *)Y, (const uint8_t *)Y, (const uint8_t *)params->lut, 0,
+          Y_end - Y);
+
+  return Y_end;
+}
+
+OT_int16::Quantisation OT_int16::quantise_activation(
+    const std::vector<int32_t> &biases,
+    const std::vector<double> &multipliers,
+    const std::vector<int32_t> &offsets) {
+  assert(multipliers.size() == biases.size());
+  assert(multipliers.size() == offsets.size());
+
+  const int channels = multipliers.size();
+  const int padded_channels =
+      (channels + VPU_INT16_EPV - 1) / VPU_INT16_EPV * VPU_INT16_EPV;
+
+  Quantisation q;
+  q.biases = biases;
+  q.biases.resize(padded_channels, 0);
+  q.offsets = offsets;
+  q.offsets.resize(padded_channels, 0);
+  q.multipliers.assign(padded_channels, 0);
+  q.shifts.assign(padded_channels, 0);
+
+  for (int ch = 0; ch < channels; ch++) {
+    const double m = multipliers[ch];
+    assert(std::abs(m) < 2.0);
+
+    int exp;
+    const double mantissa = std::frexp(m, &exp);
+
+    if (exp > 0) {
+      q.multipliers[ch] = saturate_non_sym(std::llround(m * (1 << 30)), 32);
+    } else {
+      // A shift beyond the accumulator leaves nothing but the rounding
+      q.multipliers[ch] = (int32_t)std::round(mantissa * (1 << 30));
+      q.shifts[ch] = std::min(-exp, 39);
+    }
+  }
+
+  return q;
+}
+
+int8_t *OT_int16::output_transform_fn(int8_t *Y, VPURingBuffer *A,
+                                      int32_t output_channel_group) {
+  xs3_vpu vpu_mem;
+  xs3_vpu *vpu = &vpu_mem;
+
+  const int32_t first_channel = output_channel_group * VPU_INT16_EPV;
+  const int output_count =
+      std::min(params->output_slice_channel_count - first_channel,
+               (int32_t)VPU_INT16_EPV);
+
+  VSETC(vpu, MODE_S32);
+
+  alignas(4) int32_t ones[VPU_INT32_EPV];
+  std::fill_n(ones, VPU_INT32_EPV, 1);
+
+  vpu_vector_t temp_mem;
+
+  // The 16 accumulators are transformed in two halves of VPU_INT32_EPV
+  for (int ch = 0; ch < output_count; ch += VPU_INT32_EPV) {
+    const int32_t c = first_channel + ch;
+
+    for (int i = 0; i < VPU_INT32_EPV; i++)
+      temp_mem.s32[i] = A->GetAccu(ch + i);
+
+    // Add the bias and scale by the Q30 multiplier
+    VLDR(vpu, &temp_mem);
+    VLADD(vpu, &params->biases[c]);
+    VLMUL(vpu, &params->multipliers[c]);
+    VSTR(vpu, &temp_mem);
+
+    // Move to the 40 bit accumulators for a rounding shift per channel
+    VCLRDR(vpu);
+    VLDC(vpu, &temp_mem);
+    VLMACC(vpu, ones);
+    VLSAT(vpu, &params->shifts[c]);
+
+    VLADD(vpu, &params->offsets[c]);
+    VSTR(vpu, &temp_mem);
+
+    // Saturate to the output width in the top bits of each word, then keep
+    // just those bits
+    if (params->output_bytes == 2) {
+      VLASHR(vpu, &temp_mem, -16);
+      VDEPTH16(vpu);
+    } else {
+      VLASHR(vpu, &temp_mem, -24);
+      VDEPTH8(vpu);
+    }
+
+    const int count = std::min(output_count - ch, (int)VPU_INT32_EPV);
+    const int bytes = count * params->output_bytes;
+    VSTRPV(vpu, Y, (1 << bytes) - 1);
+    Y += bytes;
+  }
+
+  return Y;
+}
+
 OTBinary_int8::Params::Params(int32_t output_slice_channel_count,
                               OutputTransformValuesClamping *otv,
                               int16_t *biases, int16_t *multipliers,
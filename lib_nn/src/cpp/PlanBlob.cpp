@@ -0,0 +1,158 @@
+#include "PlanBlob.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+
+using namespace nn;
+
+constexpr PlanRecordType PlanRecordTraits<DerefInputFn::Params>::Type;
+constexpr uint16_t PlanRecordTraits<DerefInputFn::Params>::Version;
+constexpr PlanRecordType PlanRecordTraits<ImToColPadded::Params>::Type;
+constexpr uint16_t PlanRecordTraits<ImToColPadded::Params>::Version;
+constexpr PlanRecordType PlanRecordTraits<ImToColValid::Params>::Type;
+constexpr uint16_t PlanRecordTraits<ImToColValid::Params>::Version;
+constexpr PlanRecordType
+    PlanRecordTraits<DirectWriteOutputTransform::Params>::Type;
+constexpr uint16_t
+    PlanRecordTraits<DirectWriteOutputTransform::Params>::Version;
+constexpr PlanRecordType
+    PlanRecordTraits<ShiftInt8OutputTransform::Params>::Type;
+constexpr uint16_t PlanRecordTraits<ShiftInt8OutputTransform::Params>::Version;
+constexpr PlanRecordType PlanRecordTraits<MaxPoolPatchFn::Params>::Type;
+constexpr uint16_t PlanRecordTraits<MaxPoolPatchFn::Params>::Version;
+
+/**
+ * 32-bit FNV-1a hash.
+ */
+static uint32_t plan_checksum(const void *data, size_t bytes) {
+  const uint8_t *p = static_cast<const uint8_t *>(data);
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < bytes; ++i) {
+    hash ^= p[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static uint32_t header_checksum(const PlanBlobHeader &header) {
+  return plan_checksum(&header, offsetof(PlanBlobHeader, header_checksum));
+}
+
+static size_t padded_bytes(size_t bytes) {
+  return (bytes + PlanBlob::Alignment - 1) & ~(size_t)(PlanBlob::Alignment - 1);
+}
+
+void PlanBlobWriter::add_record(PlanRecordType type, uint16_t version,
+                                const void *body, size_t bytes) {
+  assert(bytes <= UINT32_MAX);
+
+  PlanRecordHeader header;
+  header.type = (uint16_t)type;
+  header.version = version;
+  header.bytes = (uint32_t)bytes;
+
+  const size_t offset = payload.size();
+  payload.resize(offset + sizeof(header) + padded_bytes(bytes), 0);
+  std::memcpy(&payload[offset], &header, sizeof(header));
+  if (bytes) std::memcpy(&payload[offset + sizeof(header)], body, bytes);
+
+  record_count++;
+}
+
+std::vector<uint8_t> PlanBlobWriter::finish() const {
+  PlanBlobHeader header;
+  std::memset(&header, 0, sizeof(header));
+  header.magic = PlanBlob::Magic;
+  header.version = PlanBlob::Version;
+  header.header_bytes = sizeof(PlanBlobHeader);
+  header.total_bytes = (uint32_t)(sizeof(PlanBlobHeader) + payload.size());
+  header.record_count = record_count;
+  header.payload_checksum = plan_checksum(payload.data(), payload.size());
+  header.header_checksum = header_checksum(header);
+
+  std::vector<uint8_t> blob(sizeof(header) + payload.size());
+  std::memcpy(blob.data(), &header, sizeof(header));
+  if (!payload.empty())
+    std::memcpy(&blob[sizeof(header)], payload.data(), payload.size());
+  return blob;
+}
+
+PlanBlobReader::PlanBlobReader(const void *blob, size_t bytes,
+                               bool verify_payload)
+    : cursor(nullptr), end(nullptr), records_left(0), status(Status::Ok) {
+  if (((uintptr_t)blob) % PlanBlob::Alignment) {
+    status = Status::Misaligned;
+    return;
+  }
+  if (bytes < sizeof(PlanBlobHeader)) {
+    status = Status::Truncated;
+    return;
+  }
+
+  const PlanBlobHeader *header = static_cast<const PlanBlobHeader *>(blob);
+
+  if (header->magic != PlanBlob::Magic) {
+    status = Status::BadMagic;
+    return;
+  }
+  if (header_checksum(*header) != header->header_checksum) {
+    status = Status::BadHeaderChecksum;
+    return;
+  }
+  if (header->version != PlanBlob::Version ||
+      header->header_bytes != sizeof(PlanBlobHeader)) {
+    status = Status::BadVersion;
+    return;
+  }
+  if (header->total_bytes > bytes || header->total_bytes < sizeof(*header)) {
+    status = Status::Truncated;
+    return;
+  }
+
+  cursor = static_cast<const uint8_t *>(blob) + sizeof(PlanBlobHeader);
+  end = static_cast<const uint8_t *>(blob) + header->total_bytes;
+
+  if (verify_payload &&
+      plan_checksum(cursor, end - cursor) != header->payload_checksum) {
+    status = Status::BadPayloadChecksum;
+    cursor = end = nullptr;
+    return;
+  }
+
+  records_left = header->record_count;
+}
+
+PlanRecordType PlanBlobReader::peek_type() const {
+  if (!ok() || records_left == 0 ||
+      (size_t)(end - cursor) < sizeof(PlanRecordHeader))
+    return PlanRecordType::End;
+
+  return (PlanRecordType)((const PlanRecordHeader *)cursor)->type;
+}
+
+const void *PlanBlobReader::next_record(PlanRecordType type, uint16_t version,
+                                        size_t *bytes) {
+  if (!ok() || records_left == 0) return nullptr;
+
+  const size_t available = end - cursor;
+  const PlanRecordHeader *header = (const PlanRecordHeader *)cursor;
+
+  // Only a Bytes record may be of any size
+  const bool sized = (type != PlanRecordType::Bytes);
+
+  if (available < sizeof(PlanRecordHeader) ||
+      header->type != (uint16_t)type || header->version != version ||
+      (sized && header->bytes != *bytes) ||
+      padded_bytes(header->bytes) > available - sizeof(PlanRecordHeader)) {
+    status = Status::BadRecord;
+    return nullptr;
+  }
+
+  const void *body = cursor + sizeof(PlanRecordHeader);
+  *bytes = header->bytes;
+  cursor += sizeof(PlanRecordHeader) + padded_bytes(header->bytes);
+  records_left--;
+
+  return body;
+}
@@ -0,0 +1,103 @@
+#if !defined(__XS3A__)
+
+#include "ThreadPoolExecutor.hpp"
+
+#include <algorithm>
+
+using namespace nn;
+
+constexpr int ThreadPoolExecutor::JobsPerThread;
+
+ThreadPoolExecutor::ThreadPoolExecutor(int thread_count)
+    : generation(0), pending(0), stopping(false) {
+  if (thread_count <= 0)
+    thread_count = std::max<int>(1, std::thread::hardware_concurrency());
+
+  scratch.resize(thread_count);
+
+  for (int worker = 0; worker < thread_count; worker++)
+    workers.emplace_back(&ThreadPoolExecutor::worker_loop, this, worker);
+}
+
+ThreadPoolExecutor::~ThreadPoolExecutor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  work_ready.notify_all();
+
+  for (auto &t : workers) t.join();
+}
+
+void ThreadPoolExecutor::worker_loop(int worker) {
+  uint64_t seen_generation = 0;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      work_ready.wait(
+          lock, [&] { return stopping || generation != seen_generation; });
+      if (stopping) return;
+      seen_generation = generation;
+    }
+
+    // task is not modified again until every worker has finished with it
+    task(worker);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--pending == 0) work_done.notify_all();
+    }
+  }
+}
+
+void ThreadPoolExecutor::run(const std::function<void(int)> &task) {
+  std::lock_guard<std::mutex> run_lock(run_mutex);
+  std::unique_lock<std::mutex> lock(mutex);
+
+  this->task = task;
+  pending = (int)workers.size();
+  generation++;
+  work_ready.notify_all();
+
+  work_done.wait(lock, [&] { return pending == 0; });
+}
+
+int8_t *ThreadPoolExecutor::get_scratch(int worker, int bytes) {
+  if (bytes <= 0) return nullptr;
+
+  std::vector<int32_t> &mem = scratch[worker];
+  const size_t words = (bytes + sizeof(int32_t) - 1) / sizeof(int32_t);
+  if (mem.size() < words) mem.resize(words);
+
+  return (int8_t *)mem.data();
+}
+
+std::vector<ThreadPoolExecutor::Job> ThreadPoolExecutor::partition(
+    const AbstractKernel::Params &kparams, int job_count) {
+  const int32_t rows = kparams.h_end - kparams.h_begin;
+  const int32_t groups = kparams.output_channel_group_count;
+
+  std::vector<Job> jobs;
+  if (rows <= 0 || groups <= 0 || kparams.w_end <= kparams.w_begin)
+    return jobs;
+
+  job_count = std::max(job_count, 1);
+  const int32_t bands = std::min(rows, job_count);
+  const int32_t slices = std::min(groups, job_count / bands);
+
+  for (int32_t b = 0; b < bands; b++) {
+    const int32_t h_begin = kparams.h_begin + (rows * b) / bands;
+    const int32_t h_end = kparams.h_begin + (rows * (b + 1)) / bands;
+
+    for (int32_t s = 0; s < slices; s++) {
+      const int32_t group_begin = (groups * s) / slices;
+      const int32_t group_end = (groups * (s + 1)) / slices;
+      jobs.push_back(Job{h_begin, h_end, group_begin, group_end});
+    }
+  }
+
+  return jobs;
+}
+
+#endif  // !defined(__XS3A__)
@@ -0,0 +1,178 @@
+#include "WeightStreamer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+using namespace nn;
+
+void MemCpyWeightLoader::start_copy(void *dst, const void *src, size_t bytes) {
+  vpu_memcpy_ext(dst, src, bytes);
+}
+
+#if !defined(__XS3A__)
+
+ThreadWeightLoader::ThreadWeightLoader() : in_flight(0), stopping(false) {
+  worker = std::thread(&ThreadWeightLoader::worker_loop, this);
+}
+
+ThreadWeightLoader::~ThreadWeightLoader() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  copy_ready.notify_all();
+
+  worker.join();
+}
+
+void ThreadWeightLoader::worker_loop() {
+  while (true) {
+    Copy copy;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      copy_ready.wait(lock, [&] { return stopping || !queue.empty(); });
+      if (queue.empty()) return;
+      copy = queue.front();
+      queue.pop_front();
+    }
+
+    std::memcpy(copy.dst, copy.src, copy.bytes);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--in_flight == 0) copy_done.notify_all();
+    }
+  }
+}
+
+void ThreadWeightLoader::start_copy(void *dst, const void *src, size_t bytes) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    queue.push_back(Copy{dst, src, bytes});
+    in_flight++;
+  }
+  copy_ready.notify_one();
+}
+
+void ThreadWeightLoader::wait() {
+  std::unique_lock<std::mutex> lock(mutex);
+  copy_done.wait(lock, [&] { return in_flight == 0; });
+}
+
+#endif  // !defined(__XS3A__)
+
+Conv2dWeightStreamer::Conv2dWeightStreamer(
+    Conv2dStreamedOp op, const nn_image_params_t &x_params,
+    const nn_image_params_t &y_params, const nn_window_params_t &conv_window,
+    int8_t zero_point, int32_t slice_channels)
+    : op(op),
+      x_params(x_params),
+      y_params(y_params),
+      conv_window(conv_window),
+      zero_point(zero_point),
+      slice_channels(slice_channels) {
+  assert(slice_channels > 0);
+  assert(slice_channels % VPU_INT8_ACC_PERIOD == 0);
+
+  switch (op) {
+    case Conv2dStreamedOp::Deep:
+      kernel_channel_bytes = conv_window.shape.height *
+                             conv_window.shape.width * x_params.channels;
+      break;
+    case Conv2dStreamedOp::ShallowIn:
+      // The kernel width is augmented to fill a vector
+      kernel_channel_bytes = conv_window.shape.height * VPU_INT8_EPV;
+      break;
+  }
+}
+
+int32_t Conv2dWeightStreamer::get_slice_count() const {
+  return (y_params.channels + slice_channels - 1) / slice_channels;
+}
+
+int32_t Conv2dWeightStreamer::get_buffer_bytes() const {
+  const int32_t slice = std::min<int32_t>(slice_channels, y_params.channels);
+  const int32_t bso_blocks =
+      (slice + VPU_INT8_ACC_PERIOD - 1) / VPU_INT8_ACC_PERIOD;
+  // The kernel is preceded and followed by a vector, which may be overread
+  return VPU_INT8_EPV + slice * kernel_channel_bytes + VPU_INT8_EPV +
+         bso_blocks * sizeof(nn_bso_block_t);
+}
+
+/*
+  A buffer holds the slice of K followed by the slice of BSO, with a vector of
+  margin before and after the kernel. The kernel bytes of a slice are a
+  multiple of 16, so the BSO blocks stay word-aligned.
+*/
+void Conv2dWeightStreamer::load_slice(WeightLoader *loader, int8_t *buffer,
+                                      const nn_tensor_t *K,
+                                      const nn_bso_block_t *BSO,
+                                      int32_t slice) const {
+  const int32_t start = slice * slice_channels;
+  const int32_t channels =
+      std::min<int32_t>(slice_channels, y_params.channels - start);
+  const int32_t kernel_bytes = channels * kernel_channel_bytes;
+  const int32_t bso_blocks =
+      (channels + VPU_INT8_ACC_PERIOD - 1) / VPU_INT8_ACC_PERIOD;
+
+  int8_t *buffer_K = buffer + VPU_INT8_EPV;
+  int8_t *buffer_BSO = buffer_K + kernel_bytes + VPU_INT8_EPV;
+
+  loader->start_copy(buffer_K, K + start * kernel_channel_bytes, kernel_bytes);
+  loader->start_copy(buffer_BSO, BSO + start / VPU_INT8_ACC_PERIOD,
+                     bso_blocks * sizeof(nn_bso_block_t));
+}
+
+void Conv2dWeightStreamer::compute_slice(nn_image_t *Y, const nn_image_t *X,
+                                         const int8_t *buffer,
+                                         int32_t slice) const {
+  const int32_t start = slice * slice_channels;
+  const int32_t channels =
+      std::min<int32_t>(slice_channels, y_params.channels - start);
+
+  const nn_tensor_t *K = (const nn_tensor_t *)(buffer + VPU_INT8_EPV);
+  const nn_bso_block_t *BSO =
+      (const nn_bso_block_t *)(K + channels * kernel_channel_bytes +
+                               VPU_INT8_EPV);
+
+  nn_window_op_job_params_t job = {
+      {0, 0, start},
+      {(int32_t)y_params.height, (int32_t)y_params.width, channels}};
+
+  switch (op) {
+    case Conv2dStreamedOp::Deep:
+      conv2d_deep_ext(Y, X, K, BSO, zero_point, &x_params, &y_params,
+                      &conv_window, &job, CONV2D_DEEP_FLAG_SLICED_K);
+      break;
+    case Conv2dStreamedOp::ShallowIn:
+      conv2d_shallowin_ext(Y, X, K, BSO, zero_point, &x_params, &y_params,
+                           &conv_window, &job, CONV2D_SHALLOWIN_FLAG_SLICED_K);
+      break;
+  }
+}
+
+void Conv2dWeightStreamer::execute(nn_image_t *Y, const nn_image_t *X,
+                                   const nn_tensor_t *K,
+                                   const nn_bso_block_t *BSO,
+                                   WeightLoader *loader, int8_t *buffer0,
+                                   int8_t *buffer1) const {
+  assert((((uintptr_t)buffer0) & 0x3) == 0);
+  assert((((uintptr_t)buffer1) & 0x3) == 0);
+
+  int8_t *buffers[2] = {buffer0, buffer1};
+  const int32_t slices = get_slice_count();
+  if (slices == 0) return;
+
+  load_slice(loader, buffers[0], K, BSO, 0);
+
+  for (int32_t s = 0; s < slices; s++) {
+    loader->wait();
+
+    // The other buffer was last read by slice s - 1, which has completed
+    if (s + 1 < slices)
+      load_slice(loader, buffers[(s + 1) & 1], K, BSO, s + 1);
+
+    compute_slice(Y, X, buffers[s & 1], s);
+  }
+}
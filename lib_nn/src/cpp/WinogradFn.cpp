@@ -0,0 +1,266 @@
+#include "WinogradFn.hpp"
+
+#include <cassert>
+
+#include "vpu_sim.h"
+
+using namespace nn;
+using namespace nn::WinogradF2x3;
+
+WinogradInputTransform::Params::Params(const Filter2dGeometry &filter,
+                                       const int8_t padding_value) {
+  assert(filter.window.shape.height == 3 && filter.window.shape.width == 3);
+  assert(filter.window.stride.row == 1 && filter.window.stride.col == 1);
+  assert(filter.window.dilation.row == 1 && filter.window.dilation.col == 1);
+  assert(filter.input.depth <= MaxInputChannels);
+
+  input_height = filter.input.height;
+  input_width = filter.input.width;
+  input_channels = filter.input.depth;
+  input_channel_groups = (input_channels + InputChannelsPerGroup - 1) /
+                         InputChannelsPerGroup;
+
+  bytes_per_h_line = filter.input.RowStride();
+  bytes_per_pixel = filter.input.PixelStride();
+
+  start_row = filter.window.start.row;
+  start_col = filter.window.start.col;
+
+  padding_val = padding_value;
+}
+
+int WinogradInputTransform::get_scratch_bytes() {
+  return Points * params->input_channel_groups * InputChannelsPerGroup *
+         sizeof(int16_t);
+}
+
+int WinogradInputTransform::get_overread_bytes() { return 0; }
+
+/*
+  B^T = [ 1  0 -1  0 ]
+        [ 0  1  1  0 ]
+        [ 0 -1  1  0 ]
+        [ 0  1  0 -1 ]
+
+  B^T d B is computed as B^T applied to the rows of the tile, written to the
+  patch, and then B^T applied to its columns in place.
+*/
+int8_t *WinogradInputTransform::memcopy_fn(int8_t *T, int8_t *X, int32_t h,
+                                           int32_t w, int32_t c) {
+  assert(c == 0);
+  assert((((uintptr_t)T) & 0x3) == 0);
+
+  const int32_t channels = params->input_channels;
+  const int32_t point_stride = params->input_channel_groups *
+                               InputChannelsPerGroup;
+
+  int16_t *V = (int16_t *)T;
+
+  const int32_t row0 = params->start_row + OutputTile * h;
+  const int32_t col0 = params->start_col + OutputTile * w;
+
+  for (int i = 0; i < InputTile; i++) {
+    const int32_t row = row0 + i;
+    const bool row_valid = (row >= 0) && (row < params->input_height);
+
+    const int8_t *d[InputTile];
+    for (int j = 0; j < InputTile; j++) {
+      const int32_t col = col0 + j;
+      const bool valid = row_valid && (col >= 0) && (col < params->input_width);
+      d[j] = valid ? X + row * params->bytes_per_h_line +
+                         col * params->bytes_per_pixel
+                   : nullptr;
+    }
+
+    int16_t *v = V + i * InputTile * point_stride;
+    const int16_t pad = params->padding_val;
+
+    for (int k = 0; k < channels; k++) {
+      const int16_t d0 = d[0] ? d[0][k] : pad;
+      const int16_t d1 = d[1] ? d[1][k] : pad;
+      const int16_t d2 = d[2] ? d[2][k] : pad;
+      const int16_t d3 = d[3] ? d[3][k] : pad;
+
+      v[0 * point_stride + k] = d0 - d2;
+      v[1 * point_stride + k] = d1 + d2;
+      v[2 * point_stride + k] = d2 - d1;
+      v[3 * point_stride + k] = d1 - d3;
+    }
+  }
+
+  for (int j = 0; j < InputTile; j++) {
+    int16_t *v0 = V + (0 * InputTile + j) * point_stride;
+    int16_t *v1 = V + (1 * InputTile + j) * point_stride;
+    int16_t *v2 = V + (2 * InputTile + j) * point_stride;
+    int16_t *v3 = V + (3 * InputTile + j) * point_stride;
+
+    for (int k = 0; k < channels; k++) {
+      const int16_t t0 = v0[k], t1 = v1[k], t2 = v2[k], t3 = v3[k];
+      v0[k] = t0 - t2;
+      v1[k] = t1 + t2;
+      v2[k] = t2 - t1;
+      v3[k] = t1 - t3;
+    }
+
+    // The padding channels are multiplied by zero weights, but must not hold
+    // garbage which could saturate the accumulators
+    for (int k = channels; k < point_stride; k++)
+      v0[k] = v1[k] = v2[k] = v3[k] = 0;
+  }
+
+  return T;
+}
+
+MatMulWinograd::Params::Params(const int input_channels,
+                               const int16_t *weights)
+    : weights(weights),
+      input_channel_groups((input_channels + InputChannelsPerGroup - 1) /
+                           InputChannelsPerGroup) {
+  assert(input_channels <= MaxInputChannels);
+}
+
+int MatMulWinograd::get_weights_bytes(int input_channels,
+                                      int output_channels) {
+  const int input_groups =
+      (input_channels + InputChannelsPerGroup - 1) / InputChannelsPerGroup;
+  const int output_groups =
+      (output_channels + VPU_INT16_ACC_PERIOD - 1) / VPU_INT16_ACC_PERIOD;
+  return output_groups * Points * input_groups * VPU_INT16_ACC_PERIOD *
+         InputChannelsPerGroup * sizeof(int16_t);
+}
+
+/*
+  G' = 2 G = [ 2  0  0 ]
+             [ 1  1  1 ]
+             [ 1 -1  1 ]
+             [ 0  0  2 ]
+*/
+std::vector<int16_t> MatMulWinograd::transform_kernel_weights(
+    const int8_t *raw_weights, const std::array<int, 4> &shape) {
+  assert(shape[1] == 3 && shape[2] == 3);
+
+  static const int8_t G[InputTile][3] = {
+      {2, 0, 0}, {1, 1, 1}, {1, -1, 1}, {0, 0, 2}};
+
+  const int output_channels = shape[0];
+  const int input_channels = shape[3];
+  const int input_groups =
+      (input_channels + InputChannelsPerGroup - 1) / InputChannelsPerGroup;
+
+  std::vector<int16_t> weights(
+      get_weights_bytes(input_channels, output_channels) / sizeof(int16_t), 0);
+
+  for (int oc = 0; oc < output_channels; oc++) {
+    const int ocg = oc / VPU_INT16_ACC_PERIOD;
+    // reverse order of output channels
+    const int reversed_oc =
+        VPU_INT16_ACC_PERIOD - 1 - (oc % VPU_INT16_ACC_PERIOD);
+
+    for (int ic = 0; ic < input_channels; ic++) {
+      const int icg = ic / InputChannelsPerGroup;
+
+      int32_t g[3][3];
+      for (int r = 0; r < 3; r++)
+        for (int s = 0; s < 3; s++)
+          g[r][s] = raw_weights[((oc * 3 + r) * 3 + s) * input_channels + ic];
+
+      // G' g
+      int32_t t[InputTile][3];
+      for (int i = 0; i < InputTile; i++)
+        for (int s = 0; s < 3; s++)
+          t[i][s] = G[i][0] * g[0][s] + G[i][1] * g[1][s] + G[i][2] * g[2][s];
+
+      // (G' g) G'^T
+      for (int i = 0; i < InputTile; i++) {
+        for (int j = 0; j < InputTile; j++) {
+          const int32_t u =
+              t[i][0] * G[j][0] + t[i][1] * G[j][1] + t[i][2] * G[j][2];
+          const int p = i * InputTile + j;
+
+          const int index =
+              (((ocg * Points + p) * input_groups + icg) *
+                   VPU_INT16_ACC_PERIOD +
+               reversed_oc) *
+                  InputChannelsPerGroup +
+              ic % InputChannelsPerGroup;
+          weights[index] = (int16_t)u;
+        }
+      }
+    }
+  }
+
+  return weights;
+}
+
+/*
+  A^T = [ 1  1  1  0 ]
+        [ 0  1 -1 -1 ]
+
+  The inverse transform is done in 32-bit modular arithmetic: the intermediate
+  sums may wrap, but the result, 4 times the accumulator of the direct
+  convolution, does not.
+*/
+static void winograd_output_transform(VPURingBuffer *A,
+                                      const VPURingBuffer *M) {
+  for (int ch = 0; ch < VPU_INT16_ACC_PERIOD; ch++) {
+    uint32_t m[Points];
+    for (int p = 0; p < Points; p++) m[p] = (uint32_t)M[p].GetAccu(ch);
+
+    uint32_t t[OutputTile][InputTile];
+    for (int j = 0; j < InputTile; j++) {
+      t[0][j] = m[0 * InputTile + j] + m[1 * InputTile + j] +
+                m[2 * InputTile + j];
+      t[1][j] = m[1 * InputTile + j] - m[2 * InputTile + j] -
+                m[3 * InputTile + j];
+    }
+
+    for (int i = 0; i < OutputTile; i++) {
+      const uint32_t y0 = t[i][0] + t[i][1] + t[i][2];
+      const uint32_t y1 = t[i][1] - t[i][2] - t[i][3];
+      A[i * OutputTile + 0].SetAccu(ch, ((int32_t)y0) >> 2);
+      A[i * OutputTile + 1].SetAccu(ch, ((int32_t)y1) >> 2);
+    }
+  }
+}
+
+void mat_mul_winograd_impl(const MatMulWinograd::Params *params,
+                           VPURingBuffer *A, int8_t *T,
+                           int32_t output_channel_group) {
+  xs3_vpu vpu_mem;
+  xs3_vpu *vpu = &vpu_mem;
+
+  VSETC(vpu, MODE_S16);
+
+  const int32_t groups = params->input_channel_groups;
+  const int32_t block = VPU_INT16_ACC_PERIOD * InputChannelsPerGroup;
+
+  const int16_t *K_p =
+      params->weights + output_channel_group * Points * groups * block;
+  const int16_t *V_p = (const int16_t *)T;
+
+  VPURingBuffer M[Points];
+
+  for (int p = 0; p < Points; p++) {
+    VCLRDR(vpu);
+
+    for (int g = 0; g < groups; g++) {
+      VLDC(vpu, V_p);
+      V_p += InputChannelsPerGroup;
+
+      for (int l = 0; l < VPU_INT16_ACC_PERIOD; l++) {
+        VLMACCR(vpu, K_p);
+        K_p += InputChannelsPerGroup;
+      }
+    }
+
+    VSTR(vpu, &M[p].vR);
+    VSTD(vpu, &M[p].vD);
+  }
+
+  winograd_output_transform(A, M);
+}
+
+void MatMulWinograd::aggregate_fn(VPURingBuffer *A, int8_t *T,
+                                  int32_t output_channel_group) {
+  mat_mul_winograd_impl(this->params, A, T, output_channel_group);
+}
@@ -8,20 +8,34 @@ int ImageGeometry::Index(const int row, const int col,
   if (col < 0 || col >= this->width) return -1;
   if (channel < 0 || channel >= this->depth) return -1;
 
-  return this->depth * (this->width * row + col) + channel;
+  return (row * this->RowStride() + col * this->PixelStride()) /
+             this->channel_depth +
+         channel;
 }
 
 int ImageGeometry::Index(const ImageVect &input_coords) const {
   return this->Index(input_coords.row, input_coords.col, input_coords.channel);
 }
 
+ImageGeometry ImageGeometry::View(const ImageRegion &region) const {
+  assert(region.start.row >= 0 && region.start.col >= 0 &&
+         region.start.channel >= 0);
+  assert(region.EndVect().row <= this->height);
+  assert(region.EndVect().col <= this->width);
+  assert(region.EndVect().channel <= this->depth);
+
+  return ImageGeometry(region.shape.height, region.shape.width,
+                       region.shape.depth, this->channel_depth,
+                       this->RowStride(), this->PixelStride());
+}
+
 mem_stride_t ImageGeometry::GetStride(const ImageVect &vect) const {
   return this->GetStride(vect.row, vect.col, vect.channel);
 }
 
 mem_stride_t ImageGeometry::GetStride(const int rows, const int cols,
                                       const int chans) const {
-  return rows * this->RowBytes() + cols * this->PixelBytes() +
+  return rows * this->RowStride() + cols * this->PixelStride() +
          chans * channel_depth;
 }
 
@@ -34,7 +48,9 @@ mem_stride_t ImageGeometry::GetStride(const ImageVect &from,
 bool ImageGeometry::operator==(ImageGeometry other) const {
   return this->height == other.height && this->width == other.width &&
          this->depth == other.depth &&
-         this->channel_depth == other.channel_depth;
+         this->channel_depth == other.channel_depth &&
+         this->RowStride() == other.RowStride() &&
+         this->PixelStride() == other.PixelStride();
 }
 
 bool ImageGeometry::IsWithinImage(const ImageVect &coords) const {
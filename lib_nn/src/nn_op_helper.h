@@ -86,6 +86,22 @@ static inline unsigned in_bounds(
          region_left > bounds_right || region_right < bounds_left;
 }
 
+/** Look up a strip of outputs in a 256-entry table, in place.
+ *
+ * Each of the first `channels` elements of `pixels` output pixels, the first
+ * of which is at `Y` and each `pixel_stride` bytes after the last, is replaced
+ * by the entry of `lut` indexed by its bit pattern, as lookup8() would.
+ */
+static inline void lookup8_strip(int8_t* Y, const uint8_t* lut,
+                                 const unsigned pixels,
+                                 const unsigned channels,
+                                 const int32_t pixel_stride) {
+  for (unsigned pix = 0; pix < pixels; pix++) {
+    for (unsigned c = 0; c < channels; c++) Y[c] = lut[(uint8_t)Y[c]];
+    Y = ADDR(Y, pixel_stride);
+  }
+}
+
 static inline unsigned clip(const unsigned low, const unsigned val,
                             const unsigned high) {
   if (val <= low)
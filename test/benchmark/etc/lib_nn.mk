@@ -25,7 +25,7 @@ SOURCE_DIRS := src
 ###### 
 ### [optional] Source file extentions. Defaults to: c cc xc cpp S
 ###
-SOURCE_FILE_EXTS := c
+SOURCE_FILE_EXTS := c cpp
 
 ifeq ($(PLATFORM),xcore)
 
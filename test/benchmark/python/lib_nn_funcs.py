@@ -272,3 +272,191 @@ def avgpool2d(measure, args):
         plt.show()
     else:
         plt.savefig(os.path.join(args.out_dir, f"avgpool2d_{name}.png"))
+
+
+@func_handler
+def filter2d(measure, args):
+
+    params = []
+
+    for x_chans in (4, 8, 32):
+        for y_chans in (16, 32):
+            for k in (1, 3):
+                params.append((8, 8, x_chans, y_chans, k, k))
+
+    flattened_params = [y for x in params for y in x]
+
+    # The virtual and template filters are traced in turn for each case, with
+    # the VPU handlers and then with the dispatch-bound handlers.
+    names = [
+        "filter2d_virtual",
+        "filter2d_template",
+        "filter2d_dispatch_virtual",
+        "filter2d_dispatch_template",
+    ]
+    cycles = measure(flattened_params, names)
+    virtual_cycles = cycles[0::4]
+    template_cycles = cycles[1::4]
+    dispatch_virtual_cycles = cycles[2::4]
+    dispatch_template_cycles = cycles[3::4]
+
+    plt.figure()
+    plt.plot(virtual_cycles, marker="o", label="Filter2D")
+    plt.plot(template_cycles, marker="o", label="Filter2DT")
+    plt.title("filter2d")
+    plt.xlabel("case")
+    plt.ylabel("Thread Cycles")
+    plt.legend()
+    plt.grid()
+
+    for p, v, t in zip(params, virtual_cycles, template_cycles):
+        print(f"{p}: {v} -> {t} cycles ({v / t:.3f}x)")
+
+    print("dispatch-bound handlers:")
+    for p, v, t in zip(params, dispatch_virtual_cycles, dispatch_template_cycles):
+        print(f"{p}: {v} -> {t} cycles ({v / t:.3f}x)")
+
+    if args.show_plot:
+        plt.show()
+    else:
+        plt.savefig(os.path.join(args.out_dir, "filter2d.png"))
+
+
+@func_handler
+def winograd(measure, args):
+
+    params = []
+
+    for size in (4, 8, 16):
+        for x_chans in (16, 32, 64):
+            for y_chans in (16, 32, 64):
+                params.append((size, size, x_chans, y_chans))
+
+    flattened_params = [y for x in params for y in x]
+
+    # The three implementations are traced in turn for each case
+    names = ["filter2d_winograd", "filter2d_im2col", "conv2d_deep"]
+    cycles = measure(flattened_params, names)
+    series = {name: cycles[i :: len(names)] for i, name in enumerate(names)}
+
+    plt.figure()
+    for name in names:
+        plt.plot(series[name], marker="o", label=name)
+    plt.title("winograd")
+    plt.xlabel("case")
+    plt.ylabel("Thread Cycles")
+    plt.legend()
+    plt.grid()
+
+    for p, w, i, d in zip(params, *(series[name] for name in names)):
+        print(
+            f"{p}: winograd {w}, im2col {i} ({i / w:.3f}x), "
+            f"conv2d_deep {d} ({d / w:.3f}x)"
+        )
+
+    if args.show_plot:
+        plt.show()
+    else:
+        plt.savefig(os.path.join(args.out_dir, "winograd.png"))
+
+
+@func_handler
+def block_sparse(measure, args):
+
+    params = []
+
+    for x_chans in (16, 32, 64):
+        for y_chans in (16, 32, 64):
+            for sparsity in (0, 25, 50, 75):
+                params.append((8, 8, x_chans, y_chans, 3, sparsity))
+
+    flattened_params = [y for x in params for y in x]
+
+    # The dense and block-sparse filters are traced alternately for each case.
+    # The weight sizes of each are printed by the application.
+    names = ["filter2d_dense", "filter2d_block_sparse"]
+    cycles = measure(flattened_params, names)
+    dense_cycles = cycles[0::2]
+    sparse_cycles = cycles[1::2]
+
+    plt.figure()
+    plt.plot(dense_cycles, marker="o", label="MatMulInt8")
+    plt.plot(sparse_cycles, marker="o", label="MatMulBlockSparseInt8")
+    plt.title("block_sparse")
+    plt.xlabel("case")
+    plt.ylabel("Thread Cycles")
+    plt.legend()
+    plt.grid()
+
+    for p, d, s in zip(params, dense_cycles, sparse_cycles):
+        print(f"{p}: {d} -> {s} cycles ({d / s:.3f}x)")
+
+    if args.show_plot:
+        plt.show()
+    else:
+        plt.savefig(os.path.join(args.out_dir, "block_sparse.png"))
+
+
+@func_handler
+def conv2d_1x1_strided(measure, args):
+
+    params = []
+
+    for size in (8, 16, 32):
+        for x_chans in (16, 32, 64):
+            for y_chans in (16, 32, 64):
+                params.append((size, size, x_chans, y_chans, 2))
+
+    flattened_params = [y for x in params for y in x]
+
+    # The fast and generic routes are traced alternately for each case.
+    names = ["conv2d_1x1_strided_fast", "conv2d_1x1_strided_generic"]
+    cycles = measure(flattened_params, names)
+    fast_cycles = cycles[0::2]
+    generic_cycles = cycles[1::2]
+
+    plt.figure()
+    plt.plot(generic_cycles, marker="o", label="conv2d_deep")
+    plt.plot(fast_cycles, marker="o", label="conv2d_1x1_strided")
+    plt.title("conv2d_1x1_strided")
+    plt.xlabel("case")
+    plt.ylabel("Thread Cycles")
+    plt.legend()
+    plt.grid()
+
+    for p, g, f in zip(params, generic_cycles, fast_cycles):
+        print(f"{p}: {g} -> {f} cycles ({g / f:.3f}x)")
+
+    if args.show_plot:
+        plt.show()
+    else:
+        plt.savefig(os.path.join(args.out_dir, "conv2d_1x1_strided.png"))
+
+
+@func_handler
+def softmax(measure, args):
+
+    params = [2, 4, 8, 10, 16, 32, 64, 100, 128, 256, 512, 1000]
+
+    # The integer and float paths are traced alternately for each length.
+    names = ["softmax_16_int", "softmax_16_float"]
+    cycles = measure(params, names)
+    int_cycles = cycles[0::2]
+    float_cycles = cycles[1::2]
+
+    plt.figure()
+    plt.plot(params, float_cycles, marker="o", label="float")
+    plt.plot(params, int_cycles, marker="o", label="softmax_16")
+    plt.title("softmax")
+    plt.xlabel("N")
+    plt.ylabel("Thread Cycles")
+    plt.legend()
+    plt.grid()
+
+    for p, f, i in zip(params, float_cycles, int_cycles):
+        print(f"{p}: {f} -> {i} cycles ({f / i:.3f}x)")
+
+    if args.show_plot:
+        plt.show()
+    else:
+        plt.savefig(os.path.join(args.out_dir, "softmax.png"))
@@ -0,0 +1,134 @@
+// Copyright 2020-2021 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Filter2D.hpp"
+
+using namespace nn;
+
+/*
+  A "same" padded KxK convolution computed with a Filter2D using ImToColPadded
+  and either MatMulInt8 or MatMulBlockSparseInt8, over the same random inputs
+  and weights. `sparsity` percent of the weight blocks (a VPU vector of 16
+  output channels) are zero.
+
+  Both filters share an OT_int8 so their outputs must be identical; the number
+  of mismatched outputs is printed as the accuracy check, along with the bytes
+  of weights each aggregator needs.
+*/
+
+extern "C" __attribute__((noinline)) void filter2d_dense(Filter2D *filter,
+                                                         int8_t *Y,
+                                                         int8_t *X) {
+  filter->execute(Y, X);
+}
+
+extern "C" __attribute__((noinline)) void filter2d_block_sparse(
+    Filter2D *filter, int8_t *Y, int8_t *X) {
+  filter->execute(Y, X);
+}
+
+static void benchmark_block_sparse_case(int height, int width, int x_channels,
+                                        int y_channels, int k, int sparsity) {
+  ImageGeometry X(height, width, x_channels);
+  WindowGeometry K(k, k, 1, -(k / 2), -(k / 2));
+  ImageGeometry Y(height, width, y_channels);
+  Filter2dGeometry geom(X, Y, K);
+  ImageRegion region(0, 0, 0, Y.height, Y.width, Y.depth);
+
+  const int vpu_bytes = XS3_VPU_VREG_WIDTH_BYTES;
+  const int input_bytes = k * k * x_channels;
+  const int y_channel_groups =
+      (y_channels + VPU_INT8_ACC_PERIOD - 1) / VPU_INT8_ACC_PERIOD;
+
+  std::vector<int8_t> raw_weights(y_channels * input_bytes);
+  std::vector<int8_t> X_mem(X.ImageBytes() + vpu_bytes);
+  for (auto &v : raw_weights) v = (int8_t)rand();
+  for (auto &v : X_mem) v = (int8_t)rand();
+
+  // Zero whole blocks
+  const int blocks_per_group = (input_bytes + vpu_bytes - 1) / vpu_bytes;
+  std::vector<int> zero_block(y_channel_groups * blocks_per_group);
+  for (auto &z : zero_block) z = rand() % 100 < sparsity;
+
+  for (int ch = 0; ch < y_channels; ch++) {
+    const int ocg = ch / VPU_INT8_ACC_PERIOD;
+    for (int i = 0; i < input_bytes; i++)
+      if (zero_block[ocg * blocks_per_group + i / vpu_bytes])
+        raw_weights[ch * input_bytes + i] = 0;
+  }
+
+  // acc >> 12, saturated
+  OutputTransformValues otv;
+  std::memset(&otv, 0, sizeof(otv));
+  for (int i = 0; i < VPU_INT16_EPV; i++) otv.accu_shr[i] = 4;
+  std::vector<int16_t> biases(y_channel_groups * VPU_INT16_EPV, 0);
+  std::vector<int16_t> multipliers(y_channel_groups * VPU_INT16_EPV, 1);
+  OT_int8::Params ot_params(y_channels, &otv, biases.data(),
+                            multipliers.data());
+  OT_int8 ot_handler(&ot_params);
+
+  ImToColPadded::Params im2col_params(X, K, geom.Padding(), x_channels, 0);
+  ImToColPadded im2col(&im2col_params);
+  std::vector<int32_t> scratch((im2col.get_scratch_bytes() + 3) / 4);
+  AbstractKernel::Params kparams(Y, region, VPU_INT8_ACC_PERIOD);
+
+  // Dense
+  std::array<int, 4> shape = {y_channels, k, k, x_channels};
+  Conv2dReorderedWeights rw = MatMulInt8::reorder_kernel_weights(
+      raw_weights.data(), shape, 8, 0);
+  MatMulInt8::Params dense_params(y_channels, input_bytes, rw.weights.data());
+  MatMulInt8 dense_agg(&dense_params);
+  Filter2D dense(&kparams, &im2col, &dense_agg, &ot_handler,
+                 (int8_t *)scratch.data());
+
+  // Block-sparse
+  Conv2dBlockSparseWeights sw =
+      MatMulBlockSparseInt8::reorder_kernel_weights(raw_weights.data(), shape);
+  MatMulBlockSparseInt8::Params sparse_params(sw);
+  MatMulBlockSparseInt8 sparse_agg(&sparse_params);
+  Filter2D sparse(&kparams, &im2col, &sparse_agg, &ot_handler,
+                  (int8_t *)scratch.data());
+
+  std::vector<int8_t> Y_dense(Y.ImageBytes());
+  std::vector<int8_t> Y_sparse(Y.ImageBytes());
+
+  filter2d_dense(&dense, Y_dense.data(), X_mem.data());
+  filter2d_block_sparse(&sparse, Y_sparse.data(), X_mem.data());
+
+  int mismatches = 0;
+  for (int i = 0; i < Y.ImageBytes(); i++)
+    mismatches += (Y_dense[i] != Y_sparse[i]);
+  printf("block_sparse mismatches: %d / %d\n", mismatches, Y.ImageBytes());
+  printf("block_sparse weights: dense %d bytes, sparse %d bytes (%d blocks)\n",
+         (int)rw.weights.size(), sw.get_bytes(), (int)sw.block_indices.size());
+}
+
+#define REQ_ARGS (6)
+
+extern "C" void benchmark_block_sparse(int argc, char **argv) {
+  assert(argc >= REQ_ARGS);
+
+  while (argc >= REQ_ARGS) {
+    int i = 0;
+    int height = atoi(argv[i++]);
+    int width = atoi(argv[i++]);
+    int x_channels = atoi(argv[i++]);
+    int y_channels = atoi(argv[i++]);
+    int k = atoi(argv[i++]);
+    int sparsity = atoi(argv[i++]);
+
+    benchmark_block_sparse_case(height, width, x_channels, y_channels, k,
+                                sparsity);
+
+    argc -= REQ_ARGS;
+    argv = &(argv[REQ_ARGS]);
+  }
+}
@@ -0,0 +1,101 @@
+// Copyright 2020-2021 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nn_operator.h"
+#include "xs3_vpu.h"
+
+/*
+  A strided 1x1 convolution computed with conv2d_1x1_strided() and with the
+  generic route, conv2d_deep() with a 1x1 window, over the same random inputs
+  and weights. The number of mismatched outputs is printed as the accuracy
+  check.
+*/
+
+__attribute__((noinline)) void conv2d_1x1_strided_fast(
+    nn_image_t* Y, const nn_image_t* X, const nn_tensor_t* K,
+    const nn_bso_block_t* BSO, const nn_image_params_t* x_params,
+    const nn_image_params_t* y_params, unsigned stride, nn_image_t* scratch) {
+  conv2d_1x1_strided(Y, X, K, BSO, x_params, y_params, stride, stride,
+                     scratch);
+}
+
+__attribute__((noinline)) void conv2d_1x1_strided_generic(
+    nn_image_t* Y, const nn_image_t* X, const nn_tensor_t* K,
+    const nn_bso_block_t* BSO, const nn_image_params_t* x_params,
+    const nn_image_params_t* y_params, const nn_window_params_t* window) {
+  conv2d_deep(Y, X, K, BSO, 0, x_params, y_params, window);
+}
+
+static void benchmark_conv2d_1x1_strided_case(unsigned height, unsigned width,
+                                              unsigned x_chans,
+                                              unsigned y_chans,
+                                              unsigned stride) {
+  nn_image_params_t x_params = {height, width, x_chans};
+  nn_image_params_t y_params = {(height + stride - 1) / stride,
+                                (width + stride - 1) / stride, y_chans};
+  nn_window_params_t window = {{1, 1}, {0, 0}, {stride, stride}, {1, 1}};
+
+  const unsigned X_bytes = height * width * x_chans + VPU_INT8_EPV;
+  const unsigned Y_bytes = y_params.height * y_params.width * y_chans;
+  const unsigned K_bytes = y_chans * x_chans + VPU_INT8_EPV;
+  const unsigned BSO_bytes =
+      ((y_chans + VPU_INT8_ACC_PERIOD - 1) / VPU_INT8_ACC_PERIOD) *
+      sizeof(nn_bso_block_t);
+  const unsigned scratch_bytes = y_params.width * x_chans + VPU_INT8_EPV;
+
+  nn_image_t* X = (nn_image_t*)malloc(X_bytes);
+  nn_tensor_t* K = (nn_tensor_t*)malloc(K_bytes);
+  nn_image_t* Y_fast = (nn_image_t*)malloc(Y_bytes);
+  nn_image_t* Y_generic = (nn_image_t*)malloc(Y_bytes);
+  nn_bso_block_t* BSO = (nn_bso_block_t*)malloc(BSO_bytes);
+  nn_image_t* scratch = (nn_image_t*)malloc(scratch_bytes);
+
+  assert(X && K && Y_fast && Y_generic && BSO && scratch);
+
+  for (unsigned i = 0; i < X_bytes; i++) X[i] = (int8_t)rand();
+  for (unsigned i = 0; i < K_bytes; i++) K[i] = (int8_t)rand();
+  memset(BSO, 0, BSO_bytes);
+
+  conv2d_1x1_strided_fast(Y_fast, X, K, BSO, &x_params, &y_params, stride,
+                          scratch);
+  conv2d_1x1_strided_generic(Y_generic, X, K, BSO, &x_params, &y_params,
+                             &window);
+
+  unsigned mismatches = 0;
+  for (unsigned i = 0; i < Y_bytes; i++)
+    mismatches += (Y_fast[i] != Y_generic[i]);
+  printf("conv2d_1x1_strided mismatches: %u / %u\n", mismatches, Y_bytes);
+
+  free(X);
+  free(K);
+  free(Y_fast);
+  free(Y_generic);
+  free(BSO);
+  free(scratch);
+}
+
+#define REQ_ARGS (5)
+
+void benchmark_conv2d_1x1_strided(int argc, char** argv) {
+  assert(argc >= REQ_ARGS);
+
+  while (argc >= REQ_ARGS) {
+    int i = 0;
+    unsigned height = atoi(argv[i++]);
+    unsigned width = atoi(argv[i++]);
+    unsigned x_chans = atoi(argv[i++]);
+    unsigned y_chans = atoi(argv[i++]);
+    unsigned stride = atoi(argv[i++]);
+
+    benchmark_conv2d_1x1_strided_case(height, width, x_chans, y_chans, stride);
+
+    argc -= REQ_ARGS;
+    argv = &(argv[REQ_ARGS]);
+  }
+}
@@ -0,0 +1,206 @@
+// Copyright 2020-2021 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#ifndef __xcore__
+#include <chrono>
+#endif
+
+#include "AggregateFn.hpp"
+#include "Filter2D.hpp"
+#include "MemCpyFn.hpp"
+#include "OutputTransformFn.hpp"
+
+using namespace nn;
+
+/*
+  Filter2D (virtual handler calls) against Filter2DT composed from the same
+  concrete handlers. DerefInputFn + MatMulDirectFn + OT_int8 is used as the
+  per-pixel work is small for few channels, which is where the dispatch
+  overhead shows.
+*/
+typedef Filter2DT<DerefInputFn, MatMulDirectFn, OT_int8> Filter2D_Direct;
+
+extern "C" __attribute__((noinline)) void filter2d_virtual(Filter2D *filter,
+                                                           int8_t *Y,
+                                                           int8_t *X) {
+  filter->execute(Y, X);
+}
+
+extern "C" __attribute__((noinline)) void filter2d_template(
+    Filter2D_Direct *filter, int8_t *Y, int8_t *X) {
+  filter->execute(Y, X);
+}
+
+/*
+  Handlers whose per-pixel work is a few scalar operations, so that the cost of
+  a filter built from them is that of calling them. This isolates the dispatch
+  overhead which Filter2DT removes; with the VPU handlers above it is hidden by
+  the cost of the VPU work.
+*/
+class PixelPointerFn : public MemCpyFn {
+  int32_t row_bytes;
+  int32_t pixel_bytes;
+
+ public:
+  PixelPointerFn(int32_t row_bytes, int32_t pixel_bytes)
+      : row_bytes(row_bytes), pixel_bytes(pixel_bytes) {}
+
+  int8_t *memcopy_fn(int8_t *T, int8_t *X, int32_t h, int32_t w,
+                     int32_t c = 0) {
+    return X + h * row_bytes + w * pixel_bytes + c;
+  }
+  int get_scratch_bytes() { return 0; }
+  int get_overread_bytes() { return 0; }
+};
+
+class FirstElementFn : public AggregateFn {
+ public:
+  void aggregate_fn(VPURingBuffer *A, int8_t *T, int32_t output_channel_group) {
+    A->vR[0] = T[0] + output_channel_group;
+  }
+};
+
+class StoreFirstFn : public OutputTransformFn {
+  int32_t channels;
+
+ public:
+  StoreFirstFn(int32_t channels) : channels(channels) {}
+
+  int8_t *output_transform_fn(int8_t *Y, VPURingBuffer *A,
+                              int32_t output_channel_group) {
+    Y[0] = (int8_t)A->vR[0];
+    return Y + channels;
+  }
+};
+
+typedef Filter2DT<PixelPointerFn, FirstElementFn, StoreFirstFn>
+    Filter2D_Dispatch;
+
+extern "C" __attribute__((noinline)) void filter2d_dispatch_virtual(
+    Filter2D *filter, int8_t *Y, int8_t *X) {
+  filter->execute(Y, X);
+}
+
+extern "C" __attribute__((noinline)) void filter2d_dispatch_template(
+    Filter2D_Dispatch *filter, int8_t *Y, int8_t *X) {
+  filter->execute(Y, X);
+}
+
+#ifndef __xcore__
+/*
+  On the host there is no trace to measure, so each filter is timed with the
+  steady clock instead, averaged over `reps` calls.
+*/
+template <class Filter, class Fn>
+static double time_execute(Fn fn, Filter *filter, int8_t *Y, int8_t *X,
+                           int reps) {
+  fn(filter, Y, X);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < reps; ++i) fn(filter, Y, X);
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / reps;
+}
+
+#define HOST_REPS (1000)
+#endif  // __xcore__
+
+static void benchmark_filter2d_case(int x_height, int x_width, int x_channels,
+                                    int y_channels, int k_height,
+                                    int k_width) {
+  ImageGeometry X(x_height, x_width, x_channels);
+  WindowGeometry K(k_height, k_width, x_channels);
+  ImageGeometry Y(x_height - k_height + 1, x_width - k_width + 1, y_channels);
+  ImageRegion region(0, 0, 0, Y.height, Y.width, Y.depth);
+
+  const int y_channel_groups =
+      (y_channels + VPU_INT8_ACC_PERIOD - 1) / VPU_INT8_ACC_PERIOD;
+
+  std::vector<int8_t> raw_weights(y_channels * k_height * k_width * x_channels);
+  std::array<int, 4> shape = {y_channels, k_height, k_width, x_channels};
+  Conv2dReorderedWeights rw = MatMulInt8::reorder_kernel_weights(
+      raw_weights.data(), shape, 8, 0);
+
+  OutputTransformValues otv;
+  std::memset(&otv, 0, sizeof(otv));
+  std::vector<int16_t> biases(y_channel_groups * VPU_INT16_EPV);
+  std::vector<int16_t> multipliers(y_channel_groups * VPU_INT16_EPV);
+
+  DerefInputFn::Params memcpy_params(X, K);
+  MatMulDirectFn::Params agg_params(X, K, x_channels, rw.weights.data());
+  OT_int8::Params ot_params(y_channels, &otv, biases.data(),
+                            multipliers.data());
+
+  DerefInputFn memcpy_handler(&memcpy_params);
+  MatMulDirectFn aggregate_handler(&agg_params);
+  OT_int8 ot_handler(&ot_params);
+
+  AbstractKernel::Params kparams(Y, region, VPU_INT8_ACC_PERIOD);
+
+  Filter2D filter(&kparams, &memcpy_handler, &aggregate_handler, &ot_handler);
+  Filter2D_Direct filter_t(&kparams, &memcpy_handler, &aggregate_handler,
+                           &ot_handler);
+
+  std::vector<int8_t> X_mem(X.ImageBytes() + XS3_VPU_VREG_WIDTH_BYTES);
+  std::vector<int8_t> Y_mem(Y.ImageBytes());
+
+#ifdef __xcore__
+  filter2d_virtual(&filter, Y_mem.data(), X_mem.data());
+  filter2d_template(&filter_t, Y_mem.data(), X_mem.data());
+#else
+  printf("filter2d %dx%dx%d -> %d, %dx%d: virtual %.0f ns, template %.0f ns\n",
+         x_height, x_width, x_channels, y_channels, k_height, k_width,
+         time_execute(filter2d_virtual, &filter, Y_mem.data(), X_mem.data(),
+                      HOST_REPS),
+         time_execute(filter2d_template, &filter_t, Y_mem.data(),
+                      X_mem.data(), HOST_REPS));
+#endif  // __xcore__
+
+  PixelPointerFn dispatch_memcpy(X.RowBytes(), X.PixelBytes());
+  FirstElementFn dispatch_aggregate;
+  StoreFirstFn dispatch_ot(y_channels);
+  Filter2D dispatch(&kparams, &dispatch_memcpy, &dispatch_aggregate,
+                    &dispatch_ot);
+  Filter2D_Dispatch dispatch_t(&kparams, &dispatch_memcpy, &dispatch_aggregate,
+                               &dispatch_ot);
+
+#ifdef __xcore__
+  filter2d_dispatch_virtual(&dispatch, Y_mem.data(), X_mem.data());
+  filter2d_dispatch_template(&dispatch_t, Y_mem.data(), X_mem.data());
+#else
+  printf("filter2d dispatch only: virtual %.0f ns, template %.0f ns\n",
+         time_execute(filter2d_dispatch_virtual, &dispatch, Y_mem.data(),
+                      X_mem.data(), HOST_REPS),
+         time_execute(filter2d_dispatch_template, &dispatch_t, Y_mem.data(),
+                      X_mem.data(), HOST_REPS));
+#endif  // __xcore__
+}
+
+#define REQ_ARGS (6)
+
+extern "C" void benchmark_filter2d(int argc, char** argv) {
+  assert(argc >= REQ_ARGS);
+
+  while (argc >= REQ_ARGS) {
+    int i = 0;
+    int x_height = atoi(argv[i++]);
+    int x_width = atoi(argv[i++]);
+    int x_channels = atoi(argv[i++]);
+    int y_channels = atoi(argv[i++]);
+    int k_height = atoi(argv[i++]);
+    int k_width = atoi(argv[i++]);
+
+    benchmark_filter2d_case(x_height, x_width, x_channels, y_channels, k_height,
+                            k_width);
+
+    argc -= REQ_ARGS;
+    argv = &(argv[REQ_ARGS]);
+  }
+}
@@ -0,0 +1,90 @@
+// Copyright 2020-2021 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nn_operator.h"
+#include "xs3_vpu.h"
+
+/*
+  The softmax of a random 16-bit vector, as from fully_connected_16(), computed
+  with softmax_16() and with the float path it replaces. The largest difference
+  between their outputs is printed as the accuracy check.
+*/
+
+__attribute__((noinline)) void softmax_16_int(int8_t* Y, const int16_t* X,
+                                              const nn_softmax_params_t* params,
+                                              unsigned N) {
+  softmax_16(Y, X, params, N);
+}
+
+__attribute__((noinline)) void softmax_16_float(int8_t* Y, const int16_t* X,
+                                                float scale, float* scratch,
+                                                unsigned N) {
+  int16_t max = X[0];
+  for (unsigned k = 1; k < N; k++) max = (X[k] > max) ? X[k] : max;
+
+  float sum = 0;
+  for (unsigned k = 0; k < N; k++) {
+    scratch[k] = expf(scale * (X[k] - max));
+    sum += scratch[k];
+  }
+
+  for (unsigned k = 0; k < N; k++) {
+    const long y = lroundf(scratch[k] / sum * 256);
+    Y[k] = (int8_t)((y > 255 ? 255 : y) - 128);
+  }
+}
+
+static void benchmark_softmax_case(unsigned N) {
+  const float scale = 1.0f / 256;
+
+  int16_t* X = (int16_t*)malloc(N * sizeof(int16_t));
+  int8_t* Y_int = (int8_t*)malloc(N);
+  int8_t* Y_float = (int8_t*)malloc(N);
+  float* scratch = (float*)malloc(N * sizeof(float));
+  nn_softmax_params_t* params =
+      (nn_softmax_params_t*)malloc(sizeof(nn_softmax_params_t));
+
+  assert(X && Y_int && Y_float && scratch && params);
+
+  for (unsigned k = 0; k < N; k++) X[k] = (int16_t)(rand() % 2048 - 1024);
+
+  softmax_prepare(params, scale);
+
+  softmax_16_int(Y_int, X, params, N);
+  softmax_16_float(Y_float, X, scale, scratch, N);
+
+  int max_diff = 0;
+  for (unsigned k = 0; k < N; k++) {
+    const int diff = abs(Y_int[k] - Y_float[k]);
+    max_diff = (diff > max_diff) ? diff : max_diff;
+  }
+  printf("softmax_16 max difference: %d\n", max_diff);
+
+  free(X);
+  free(Y_int);
+  free(Y_float);
+  free(scratch);
+  free(params);
+}
+
+#define REQ_ARGS (1)
+
+void benchmark_softmax(int argc, char** argv) {
+  assert(argc >= REQ_ARGS);
+
+  while (argc >= REQ_ARGS) {
+    unsigned N = atoi(argv[0]);
+
+    benchmark_softmax_case(N);
+
+    argc -= REQ_ARGS;
+    argv = &(argv[REQ_ARGS]);
+  }
+}
@@ -0,0 +1,139 @@
+// Copyright 2020-2021 XMOS LIMITED.
+// This Software is subject to the terms of the XMOS Public Licence: Version 1.
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Filter2D.hpp"
+#include "WinogradFn.hpp"
+#include "nn_operator.h"
+
+using namespace nn;
+
+/*
+  3x3, stride 1, "same" padded convolution computed three ways: with
+  Filter2D_Winograd, with a Filter2D using the im2col path (ImToColPadded +
+  MatMulInt8), and with conv2d_deep(). All three use the same random inputs
+  and weights.
+
+  The two filters share an OT_int8 so their outputs must be identical; the
+  number of mismatched outputs is printed as the accuracy check. conv2d_deep()
+  quantizes through a BSO block instead and is only timed.
+*/
+
+extern "C" __attribute__((noinline)) void filter2d_winograd(
+    Filter2D_Winograd *filter, int8_t *Y, int8_t *X) {
+  filter->execute(Y, X);
+}
+
+extern "C" __attribute__((noinline)) void filter2d_im2col(Filter2D *filter,
+                                                          int8_t *Y,
+                                                          int8_t *X) {
+  filter->execute(Y, X);
+}
+
+static void benchmark_winograd_case(int height, int width, int x_channels,
+                                    int y_channels) {
+  ImageGeometry X(height, width, x_channels);
+  WindowGeometry K(3, 3, 1, -1, -1);
+  ImageGeometry Y(height, width, y_channels);
+  Filter2dGeometry geom(X, Y, K);
+  ImageRegion region(0, 0, 0, Y.height, Y.width, Y.depth);
+
+  const int y_channel_groups =
+      (y_channels + VPU_INT8_ACC_PERIOD - 1) / VPU_INT8_ACC_PERIOD;
+
+  std::vector<int8_t> raw_weights(y_channels * 9 * x_channels);
+  std::vector<int8_t> X_mem(X.ImageBytes() + XS3_VPU_VREG_WIDTH_BYTES);
+  for (auto &v : raw_weights) v = (int8_t)rand();
+  for (auto &v : X_mem) v = (int8_t)rand();
+
+  // acc >> 12, saturated
+  OutputTransformValues otv;
+  std::memset(&otv, 0, sizeof(otv));
+  for (int k = 0; k < VPU_INT16_EPV; k++) otv.accu_shr[k] = 4;
+  std::vector<int16_t> biases(y_channel_groups * VPU_INT16_EPV, 0);
+  std::vector<int16_t> multipliers(y_channel_groups * VPU_INT16_EPV, 1);
+  OT_int8::Params ot_params(y_channels, &otv, biases.data(),
+                            multipliers.data());
+  OT_int8 ot_handler(&ot_params);
+
+  // Winograd
+  std::array<int, 4> shape = {y_channels, 3, 3, x_channels};
+  std::vector<int16_t> wino_weights =
+      MatMulWinograd::transform_kernel_weights(raw_weights.data(), shape);
+
+  WinogradInputTransform::Params wino_input_params(geom, 0);
+  MatMulWinograd::Params wino_agg_params(x_channels, wino_weights.data());
+  WinogradInputTransform wino_input(&wino_input_params);
+  MatMulWinograd wino_agg(&wino_agg_params);
+
+  std::vector<int32_t> wino_scratch(wino_input.get_scratch_bytes() / 4);
+  auto wino_kparams = Filter2D_Winograd::get_tile_params(Y, region);
+  Filter2D_Winograd wino(Y, &wino_kparams, &wino_input, &wino_agg,
+                         &ot_handler, (int8_t *)wino_scratch.data());
+
+  // im2col
+  Conv2dReorderedWeights rw = MatMulInt8::reorder_kernel_weights(
+      raw_weights.data(), shape, 8, 0);
+
+  ImToColPadded::Params im2col_params(geom, 0, x_channels);
+  MatMulInt8::Params matmul_params(y_channels, 9 * x_channels,
+                                   rw.weights.data());
+  ImToColPadded im2col(&im2col_params);
+  MatMulInt8 matmul(&matmul_params);
+
+  std::vector<int32_t> im2col_scratch((im2col.get_scratch_bytes() + 3) / 4);
+  AbstractKernel::Params kparams(Y, region, VPU_INT8_ACC_PERIOD);
+  Filter2D direct(&kparams, &im2col, &matmul, &ot_handler,
+                  (int8_t *)im2col_scratch.data());
+
+  std::vector<int8_t> Y_wino(Y.ImageBytes());
+  std::vector<int8_t> Y_direct(Y.ImageBytes());
+
+  filter2d_winograd(&wino, Y_wino.data(), X_mem.data());
+  filter2d_im2col(&direct, Y_direct.data(), X_mem.data());
+
+  int mismatches = 0;
+  for (int i = 0; i < Y.ImageBytes(); i++)
+    mismatches += (Y_wino[i] != Y_direct[i]);
+  printf("winograd mismatches: %d / %d\n", mismatches, Y.ImageBytes());
+
+  // conv2d_deep
+  nn_image_params_t x_params = {(uint32_t)height, (uint32_t)width,
+                                (channel_count_t)x_channels};
+  nn_image_params_t y_params = {(uint32_t)height, (uint32_t)width,
+                                (channel_count_t)y_channels};
+  nn_window_params_t window = {{3, 3}, {-1, -1}, {1, 1}, {1, 1}};
+
+  std::vector<nn_bso_block_t> bso(y_channel_groups);
+  std::memset(bso.data(), 0, bso.size() * sizeof(nn_bso_block_t));
+
+  conv2d_deep((nn_image_t *)Y_direct.data(), (nn_image_t *)X_mem.data(),
+              (nn_tensor_t *)raw_weights.data(), bso.data(), 0, &x_params,
+              &y_params, &window);
+}
+
+#define REQ_ARGS (4)
+
+extern "C" void benchmark_winograd(int argc, char **argv) {
+  assert(argc >= REQ_ARGS);
+
+  while (argc >= REQ_ARGS) {
+    int i = 0;
+    int height = atoi(argv[i++]);
+    int width = atoi(argv[i++]);
+    int x_channels = atoi(argv[i++]);
+    int y_channels = atoi(argv[i++]);
+
+    benchmark_winograd_case(height, width, x_channels, y_channels);
+
+    argc -= REQ_ARGS;
+    argv = &(argv[REQ_ARGS]);
+  }
+}
@@ -14,6 +14,11 @@ DECLARE(conv2d_deep);
 DECLARE(avgpool2d);
 DECLARE(nn_conv2d_hstrip_deep);
 DECLARE(bconv2d_bin_DIput);
+DECLARE(filter2d);
+DECLARE(winograd);
+DECLARE(block_sparse);
+DECLARE(conv2d_1x1_strided);
+DECLARE(softmax);
 
 #define elseif(FUNC) \
   else if (strcmp(#FUNC, argv[1]) == 0) benchmark_##FUNC(argc - 2, &(argv[2]))
@@ -29,6 +34,11 @@ int main(int argc, char** argv) {
   elseif(conv2d_deep);
   elseif(conv2d_deep);
   elseif(bconv2d_bin_DIput);
+  elseif(filter2d);
+  elseif(winograd);
+  elseif(block_sparse);
+  elseif(conv2d_1x1_strided);
+  elseif(softmax);
   else {
     printf("Function '%s' unknown.\n", argv[1]);
     assert(0);
@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <list>
 #include <tuple>
+#include <vector>
 
 #include "AggregateFn.hpp"
 #include "Rand.hpp"
@@ -371,4 +373,235 @@ TEST_F(Test_Kernel_Reordering, BasicTest) {
   }
 }
 
+class Test_MatMulBlockSparseInt8 : public ::testing::Test {};
+/*
+  With weights in which whole blocks, and individual weights, are zero, the
+  block-sparse aggregator must give the accumulators of MatMulInt8 for the
+  same patch, both directly and from a copy of a channel group's weights.
+*/
+TEST_F(Test_MatMulBlockSparseInt8, BasicTest) {
+  const int vpu_bytes = XS3_VPU_VREG_WIDTH_BYTES;
+
+  for (int input_bytes = 4; input_bytes <= 4 * vpu_bytes; input_bytes += 12) {
+    for (int output_channels = 4; output_channels <= 40;
+         output_channels += 12) {
+      for (int sparsity = 0; sparsity <= 100; sparsity += 25) {
+        const int input_channel_groups =
+            (input_bytes + vpu_bytes - 1) / vpu_bytes;
+        const int output_channel_groups =
+            (output_channels + VPU_INT16_EPV - 1) / VPU_INT16_EPV;
+
+        std::array<int, 4> shape = {output_channels, 1, 1, input_bytes};
+        std::vector<int8_t> raw_weights(output_channels * input_bytes);
+
+        // Zero whole blocks with probability `sparsity` percent
+        int expected_blocks = 0;
+        for (int ocg = 0; ocg < output_channel_groups; ++ocg) {
+          for (int icg = 0; icg < input_channel_groups; ++icg) {
+            const bool zero = rng.rand<int>(0, 99) < sparsity;
+            expected_blocks += !zero;
+            for (int ch = ocg * VPU_INT16_EPV;
+                 ch < std::min(output_channels, (ocg + 1) * VPU_INT16_EPV);
+                 ++ch) {
+              for (int i = icg * vpu_bytes;
+                   i < std::min(input_bytes, (icg + 1) * vpu_bytes); ++i) {
+                raw_weights[ch * input_bytes + i] =
+                    zero ? 0 : rng.rand<int8_t>();
+              }
+            }
+            // Keep a non-zero weight in each kept block
+            if (!zero)
+              raw_weights[ocg * VPU_INT16_EPV * input_bytes + icg * vpu_bytes] =
+                  1;
+          }
+        }
+
+        Conv2dReorderedWeights rw =
+            MatMulInt8::reorder_kernel_weights(raw_weights.data(), shape, 8, 0);
+        Conv2dBlockSparseWeights sw =
+            MatMulBlockSparseInt8::reorder_kernel_weights(raw_weights.data(),
+                                                          shape);
+
+        ASSERT_EQ(expected_blocks, (int)sw.block_indices.size());
+        ASSERT_EQ(expected_blocks * MatMulBlockSparseInt8::BlockBytes,
+                  (int)sw.weights.size());
+        ASSERT_EQ(output_channel_groups + 1, (int)sw.group_offsets.size());
+
+        MatMulInt8::Params dense_params(output_channels, input_bytes,
+                                        rw.weights.data());
+        MatMulInt8 dense(&dense_params);
+        MatMulBlockSparseInt8::Params sparse_params(sw);
+        MatMulBlockSparseInt8 sparse(&sparse_params);
+
+        // The patch, as written by ImToColPadded, with zeros after it
+        std::vector<int8_t> T(input_channel_groups * vpu_bytes + vpu_bytes, 0);
+        for (int i = 0; i < input_bytes; ++i) T[i] = rng.rand<int8_t>();
+
+        for (int ocg = 0; ocg < output_channel_groups; ++ocg) {
+          VPURingBuffer A, B, C;
+          dense.aggregate_fn(&A, T.data(), ocg);
+          sparse.aggregate_fn(&B, T.data(), ocg);
+
+          int32_t bytes;
+          const int8_t *group_weights =
+              sparse.get_channel_group_weights(ocg, &bytes);
+          std::vector<int8_t> copy(group_weights, group_weights + bytes);
+          sparse.aggregate_fn_sliced(&C, T.data(), ocg, copy.data());
+
+          const int count = std::min(output_channels - ocg * VPU_INT16_EPV,
+                                     (int)VPU_INT16_EPV);
+          for (int ch = 0; ch < count; ++ch) {
+            ASSERT_EQ(A.GetAccu(ch), B.GetAccu(ch))
+                << "ocg: " << ocg << " | ch: " << ch;
+            ASSERT_EQ(A.GetAccu(ch), C.GetAccu(ch))
+                << "ocg: " << ocg << " | ch: " << ch;
+          }
+        }
+      }
+    }
+  }
+}
+
+class Test_MatMulInt4 : public ::testing::Test {};
+/*
+  With each channel's weights a multiple of 4-bit values, the 4-bit aggregator
+  must find that multiple as the channel's scale, and give the accumulators of
+  MatMulInt8 divided by it, both directly and from a copy of a channel group's
+  weights.
+*/
+TEST_F(Test_MatMulInt4, BasicTest) {
+  const int vpu_bytes = XS3_VPU_VREG_WIDTH_BYTES;
+
+  for (int input_bytes = 4; input_bytes <= 4 * vpu_bytes; input_bytes += 12) {
+    for (int output_channels = 4; output_channels <= 40;
+         output_channels += 12) {
+      const int input_channel_groups =
+          (input_bytes + vpu_bytes - 1) / vpu_bytes;
+      const int output_channel_groups =
+          (output_channels + VPU_INT16_EPV - 1) / VPU_INT16_EPV;
+
+      std::array<int, 4> shape = {output_channels, 1, 1, input_bytes};
+      std::vector<int8_t> raw_weights(output_channels * input_bytes);
+      std::vector<int> multiples(output_channels);
+
+      for (int ch = 0; ch < output_channels; ++ch) {
+        multiples[ch] = 1 + ch % 4;
+        for (int i = 0; i < input_bytes; ++i)
+          raw_weights[ch * input_bytes + i] =
+              multiples[ch] * rng.rand<int>(-7, 7);
+        raw_weights[ch * input_bytes + rng.rand<int>(0, input_bytes - 1)] =
+            multiples[ch] * (ch % 2 ? 7 : -7);
+      }
+
+      Conv2dReorderedWeights rw =
+          MatMulInt8::reorder_kernel_weights(raw_weights.data(), shape, 8, 0);
+      Conv2dInt4Weights qw =
+          MatMulInt4::reorder_kernel_weights(raw_weights.data(), shape);
+
+      ASSERT_EQ(MatMulInt4::get_weights_bytes(input_bytes, output_channels),
+                (int)qw.weights.size());
+      ASSERT_EQ(output_channel_groups * input_channel_groups * vpu_bytes *
+                    VPU_INT16_EPV / 2,
+                (int)qw.weights.size());
+      for (int ch = 0; ch < output_channels; ++ch)
+        ASSERT_FLOAT_EQ((float)multiples[ch], qw.scales[ch]) << "ch: " << ch;
+
+      MatMulInt8::Params int8_params(output_channels, input_bytes,
+                                     rw.weights.data());
+      MatMulInt8 int8_agg(&int8_params);
+      MatMulInt4::Params int4_params(input_bytes, qw.weights.data());
+      MatMulInt4 int4_agg(&int4_params);
+
+      // The patch, as written by ImToColPadded, with zeros after it
+      std::vector<int8_t> T(input_channel_groups * vpu_bytes + vpu_bytes, 0);
+      for (int i = 0; i < input_bytes; ++i) T[i] = rng.rand<int8_t>();
+
+      for (int ocg = 0; ocg < output_channel_groups; ++ocg) {
+        VPURingBuffer A, B, C;
+        int8_agg.aggregate_fn(&A, T.data(), ocg);
+        int4_agg.aggregate_fn(&B, T.data(), ocg);
+
+        int32_t bytes;
+        const int8_t *group_weights =
+            int4_agg.get_channel_group_weights(ocg, &bytes);
+        std::vector<int8_t> copy(group_weights, group_weights + bytes);
+        int4_agg.aggregate_fn_sliced(&C, T.data(), ocg, copy.data());
+
+        const int count = std::min(output_channels - ocg * VPU_INT16_EPV,
+                                   (int)VPU_INT16_EPV);
+        for (int ch = 0; ch < count; ++ch) {
+          const int multiple = multiples[ocg * VPU_INT16_EPV + ch];
+          ASSERT_EQ(A.GetAccu(ch), multiple * B.GetAccu(ch))
+              << "ocg: " << ocg << " | ch: " << ch;
+          ASSERT_EQ(B.GetAccu(ch), C.GetAccu(ch))
+              << "ocg: " << ocg << " | ch: " << ch;
+        }
+      }
+    }
+  }
+}
+
+class Test_MatMulInt16x8 : public ::testing::Test {};
+/*
+  The accumulators of the 16x8 aggregator must be the dot products of the
+  int16 patch with each channel's int8 weights, both directly and from a copy
+  of a channel group's weights.
+*/
+TEST_F(Test_MatMulInt16x8, BasicTest) {
+  for (int input_elements = 4; input_elements <= 4 * VPU_INT16_EPV;
+       input_elements += 10) {
+    for (int output_channels = 4; output_channels <= 40;
+         output_channels += 12) {
+      const int input_channel_groups =
+          (input_elements + VPU_INT16_EPV - 1) / VPU_INT16_EPV;
+      const int output_channel_groups =
+          (output_channels + VPU_INT16_EPV - 1) / VPU_INT16_EPV;
+
+      std::array<int, 4> shape = {output_channels, 1, 1, input_elements};
+      std::vector<int8_t> raw_weights(output_channels * input_elements);
+      for (auto &w : raw_weights) w = rng.rand<int8_t>();
+
+      std::vector<int8_t> weights =
+          MatMulInt16x8::reorder_kernel_weights(raw_weights.data(), shape);
+      ASSERT_EQ(MatMulInt16x8::get_weights_bytes(input_elements,
+                                                 output_channels),
+                (int)weights.size());
+
+      MatMulInt16x8::Params params(input_elements, weights.data());
+      MatMulInt16x8 agg(&params);
+
+      // The patch, as written by ImToColPaddedInt16, with a vector after it
+      // that the aggregator must ignore
+      std::vector<int16_t> T((input_channel_groups + 1) * VPU_INT16_EPV);
+      for (auto &t : T) t = rng.rand<int16_t>();
+
+      for (int ocg = 0; ocg < output_channel_groups; ++ocg) {
+        VPURingBuffer A, B;
+        agg.aggregate_fn(&A, (int8_t *)T.data(), ocg);
+
+        int32_t bytes;
+        const int8_t *group_weights =
+            agg.get_channel_group_weights(ocg, &bytes);
+        std::vector<int8_t> copy(group_weights, group_weights + bytes);
+        agg.aggregate_fn_sliced(&B, (int8_t *)T.data(), ocg, copy.data());
+
+        const int count = std::min(output_channels - ocg * VPU_INT16_EPV,
+                                   (int)VPU_INT16_EPV);
+        for (int ch = 0; ch < count; ++ch) {
+          const int out_ch = ocg * VPU_INT16_EPV + ch;
+          int32_t expected = 0;
+          for (int i = 0; i < input_elements; ++i)
+            expected +=
+                (int32_t)T[i] * raw_weights[out_ch * input_elements + i];
+
+          ASSERT_EQ(expected, A.GetAccu(ch))
+              << "ocg: " << ocg << " | ch: " << ch;
+          ASSERT_EQ(expected, B.GetAccu(ch))
+              << "ocg: " << ocg << " | ch: " << ch;
+        }
+      }
+    }
+  }
+}
+
 }  // namespace nn
@@ -0,0 +1,254 @@
+#include <array>
+#include <cstring>
+#include <vector>
+
+#include "Filter2D.hpp"
+#include "OutputTransformFixture.hpp"
+#include "Rand.hpp"
+#include "gtest/gtest.h"
+#include "nn_operator.h"
+
+namespace nn {
+
+static auto rng = test::Rand(13579);
+
+class Test_Batch : public ::testing::Test,
+                   protected test::OutputTransformFixture {};
+
+/*
+  A batched Filter2D must give each image the output of executing it alone,
+  in either loop order and with or without a weights buffer.
+*/
+TEST_F(Test_Batch, Filter2D) {
+  const int batch_count = 3;
+
+  for (int y_channels = 16; y_channels <= 40; y_channels += 12) {
+    ImageGeometry X(5, 4, 8);
+    WindowGeometry K(3, 3, 8, -1, -1);
+    ImageGeometry Y(5, 4, y_channels);
+    Filter2dGeometry geom(X, Y, K);
+
+    std::vector<int8_t> x(batch_count * X.ImageBytes() +
+                          XS3_VPU_VREG_WIDTH_BYTES);
+    for (auto &v : x) v = rng.rand<int8_t>();
+
+    std::array<int, 4> shape = {y_channels, 3, 3, 8};
+    std::vector<int8_t> raw_weights(y_channels * 3 * 3 * 8);
+    for (auto &v : raw_weights) v = rng.rand<int8_t>();
+    Conv2dReorderedWeights rw =
+        MatMulInt8::reorder_kernel_weights(raw_weights.data(), shape, 8, 0);
+    MatMulInt8::Params mm_params(y_channels, 3 * 3 * 8, rw.weights.data());
+    MatMulInt8 mm(&mm_params);
+
+    OT_int8::Params ot_params = make_ot_params(y_channels, &rng);
+    OT_int8 ot(&ot_params);
+
+    ImToColPadded::Params im2col_params(X, K, geom.Padding(), 8, 0);
+    ImToColPadded im2col(&im2col_params);
+    std::vector<int32_t> scratch((im2col.get_scratch_bytes() + 3) / 4);
+    ImageRegion region(0, 0, 0, Y.height, Y.width, Y.depth);
+    AbstractKernel::Params kparams(Y, region, VPU_INT8_ACC_PERIOD);
+    Filter2D filter(&kparams, &im2col, &mm, &ot, (int8_t *)scratch.data());
+
+    std::vector<int8_t> expected(batch_count * Y.ImageBytes());
+    for (int b = 0; b < batch_count; b++)
+      filter.execute(&expected[b * Y.ImageBytes()], &x[b * X.ImageBytes()]);
+
+    std::vector<int32_t> buffer((filter.get_weights_buffer_bytes() + 3) / 4);
+
+    for (int order = 0; order < 3; order++) {
+      filter.set_weights_buffer(order == 2 ? (int8_t *)buffer.data() : nullptr,
+                                filter.get_weights_buffer_bytes());
+      filter.set_loop_order(order == 0 ? Filter2DLoopOrder::PixelOuter
+                                       : Filter2DLoopOrder::ChannelGroupOuter);
+
+      std::vector<int8_t> actual(batch_count * Y.ImageBytes());
+      filter.execute(actual.data(), x.data(), batch_count, Y.ImageBytes(),
+                     X.ImageBytes());
+      ASSERT_EQ(expected, actual) << "Y: " << Y << " | order: " << order;
+
+      // Through the base class, which must not lose the loop order
+      AbstractKernel &kernel = filter;
+      std::fill(actual.begin(), actual.end(), 0);
+      kernel.execute(actual.data(), x.data(), batch_count, Y.ImageBytes(),
+                     X.ImageBytes());
+      ASSERT_EQ(expected, actual) << "Y: " << Y << " | order: " << order;
+    }
+  }
+}
+
+/*
+  A Filter2DT executed through an AbstractKernel reference must follow its own
+  loop order, for single images and batches.
+*/
+TEST_F(Test_Batch, AbstractKernelDispatch) {
+  // Records the channel group of each patch copied, which tells the orders
+  // apart, and does no arithmetic
+  class RecordingFn : public MemCpyFn {
+   public:
+    std::vector<int32_t> groups;
+    int32_t group = 0;
+    int8_t *memcopy_fn(int8_t *T, int8_t *X, int32_t h, int32_t w,
+                       int32_t c) {
+      groups.push_back(group);
+      return X;
+    }
+    int get_scratch_bytes() { return 0; }
+    int get_overread_bytes() { return 0; }
+  };
+  class GroupFn : public AggregateFn {
+    RecordingFn *memcpy_fn;
+
+   public:
+    GroupFn(RecordingFn *memcpy_fn) : memcpy_fn(memcpy_fn) {}
+    void aggregate_fn(VPURingBuffer *A, int8_t *T, int32_t group) {
+      memcpy_fn->group = group + 1;
+    }
+  };
+  class SkipFn : public OutputTransformFn {
+   public:
+    int8_t *output_transform_fn(int8_t *Y, VPURingBuffer *A, int32_t group) {
+      return Y + VPU_INT8_ACC_PERIOD;
+    }
+  };
+
+  ImageGeometry Y(2, 2, 32);
+  ImageRegion region(0, 0, 0, 2, 2, 32);
+  AbstractKernel::Params kparams(Y, region, VPU_INT8_ACC_PERIOD);
+  RecordingFn memcpy_fn;
+  GroupFn aggregate_fn(&memcpy_fn);
+  SkipFn ot_fn;
+  Filter2D filter(&kparams, &memcpy_fn, &aggregate_fn, &ot_fn);
+  filter.set_loop_order(Filter2DLoopOrder::ChannelGroupOuter);
+
+  std::vector<int8_t> x(2), y(2 * Y.ImageBytes());
+  AbstractKernel &kernel = filter;
+
+  // Every pixel is copied for each of the two channel groups in turn, the
+  // first copy of the second group following the aggregation of the first
+  const std::vector<int32_t> one = {0, 1, 1, 1, 1, 2, 2, 2};
+  kernel.execute(y.data(), x.data());
+  EXPECT_EQ(one, memcpy_fn.groups);
+
+  memcpy_fn.groups.clear();
+  memcpy_fn.group = 0;
+  const std::vector<int32_t> two = {0, 1, 1, 1, 1, 1, 1, 1,
+                                    1, 2, 2, 2, 2, 2, 2, 2};
+  kernel.execute(y.data(), x.data(), 2, Y.ImageBytes(), 1);
+  EXPECT_EQ(two, memcpy_fn.groups);
+}
+
+/*
+  With a weights buffer, the weights are copied once per batch rather than
+  once per image, so a large enough batch favours the channel groups as the
+  outer loop.
+*/
+TEST_F(Test_Batch, Filter2DLoopOrder) {
+  ImageGeometry X(1, 1, 64);
+  WindowGeometry K(1, 1, 64);
+  ImageGeometry Y(1, 1, 64);
+
+  std::vector<int8_t> weights(MatMulInt8::get_weights_bytes(64, 64));
+  MatMulInt8::Params mm_params(64, 64, weights.data());
+  MatMulInt8 mm(&mm_params);
+  OT_int8::Params ot_params(64, nullptr, nullptr, nullptr);
+  OT_int8 ot(&ot_params);
+  ImToColValid::Params im2col_params(X, K, 64);
+  ImToColValid im2col(&im2col_params);
+  ImageRegion region(0, 0, 0, 1, 1, 64);
+  AbstractKernel::Params kparams(Y, region, VPU_INT8_ACC_PERIOD);
+  Filter2D filter(&kparams, &im2col, &mm, &ot);
+
+  std::vector<int32_t> buffer((filter.get_weights_buffer_bytes() + 3) / 4);
+  filter.set_weights_buffer((int8_t *)buffer.data(),
+                            filter.get_weights_buffer_bytes());
+
+  // Flash-like weights; the patch and SRAM are cheap
+  const Filter2DMemoryCosts costs = {8, 1, 1};
+  EXPECT_EQ(Filter2DLoopOrder::PixelOuter, filter.choose_loop_order(costs));
+  EXPECT_EQ(Filter2DLoopOrder::ChannelGroupOuter,
+            filter.choose_loop_order(costs, 16));
+}
+
+/*
+  conv2d_deep_batch() must give each image the output of conv2d_deep().
+*/
+TEST_F(Test_Batch, Conv2dDeep) {
+  const unsigned batch_count = 3;
+
+  for (int y_channels = 4; y_channels <= 36; y_channels += 16) {
+    nn_image_params_t x_params = {5, 6, 32};
+    nn_image_params_t y_params = {5, 6, (channel_count_t)y_channels};
+    nn_window_params_t window = {{3, 3}, {-1, -1}, {1, 1}, {1, 1}};
+    const int8_t zero_point = rng.rand<int8_t>();
+    const int x_bytes = x_params.height * x_params.width * x_params.channels;
+    const int y_bytes = y_params.height * y_params.width * y_params.channels;
+
+    std::vector<int8_t> x(batch_count * x_bytes);
+    std::vector<int8_t> K(y_channels * 9 * x_params.channels);
+    for (auto &v : x) v = rng.rand<int8_t>();
+    for (auto &v : K) v = rng.rand<int8_t>();
+    std::vector<nn_bso_block_t> bso = make_bso(rng, y_channels);
+
+    std::vector<int8_t> expected(batch_count * y_bytes);
+    for (unsigned b = 0; b < batch_count; b++)
+      conv2d_deep(&expected[b * y_bytes], &x[b * x_bytes], K.data(),
+                  bso.data(), zero_point, &x_params, &y_params, &window);
+
+    // Garbage around the staged kernel must not matter
+    std::vector<int32_t> buffer(
+        (conv2d_deep_batch_buffer_bytes(&x_params, &window) + 3) / 4);
+    for (auto &v : buffer) v = rng.rand<int32_t>();
+
+    for (int buffered = 0; buffered < 2; buffered++) {
+      std::vector<int8_t> actual(batch_count * y_bytes);
+      conv2d_deep_batch(actual.data(), x.data(), K.data(), bso.data(),
+                        zero_point, &x_params, &y_params, &window, batch_count,
+                        buffered ? (int8_t *)buffer.data() : nullptr);
+
+      ASSERT_EQ(expected, actual)
+          << "y_channels: " << y_channels << " | buffered: " << buffered;
+    }
+  }
+}
+
+/*
+  fully_connected_8_batch() must give each vector the output of
+  fully_connected_8(), over the whole output and over a slice of it.
+*/
+TEST_F(Test_Batch, FullyConnected8) {
+  const unsigned batch_count = 4;
+  const channel_count_t N = 72;
+  const channel_count_t M = 44;
+
+  std::vector<int8_t> x(batch_count * N);
+  std::vector<int8_t> W(M * N);
+  for (auto &v : x) v = rng.rand<int8_t>();
+  for (auto &v : W) v = rng.rand<int8_t>();
+  std::vector<nn_bso_block_t> bso = make_bso(rng, M);
+
+  const channel_count_t slices[][2] = {{0, M}, {16, 20}};
+
+  std::vector<int32_t> buffer((fully_connected_8_batch_buffer_bytes(N) + 3) /
+                              4);
+  for (auto &v : buffer) v = rng.rand<int32_t>();
+
+  for (auto &slice : slices) {
+    std::vector<int8_t> expected(batch_count * M, 0);
+    for (unsigned b = 0; b < batch_count; b++)
+      fully_connected_8(&expected[b * M], W.data(), &x[b * N], bso.data(), N,
+                        slice[0], slice[1]);
+
+    for (int buffered = 0; buffered < 2; buffered++) {
+      std::vector<int8_t> actual(batch_count * M, 0);
+      fully_connected_8_batch(actual.data(), W.data(), x.data(), bso.data(), N,
+                              M, slice[0], slice[1], batch_count,
+                              buffered ? (int8_t *)buffer.data() : nullptr);
+
+      ASSERT_EQ(expected, actual)
+          << "start: " << slice[0] << " | buffered: " << buffered;
+    }
+  }
+}
+
+}  // namespace nn
@@ -0,0 +1,253 @@
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "Rand.hpp"
+#include "gtest/gtest.h"
+#include "nn_operator.h"
+
+namespace nn {
+
+static auto rng = test::Rand(13579);
+
+class Test_BroadcastElementwise : public ::testing::Test {
+ protected:
+  static int64_t round_shr(int64_t a, int shr) {
+    return shr == 0 ? a : (a + ((int64_t)1 << (shr - 1))) >> shr;
+  }
+
+  static int64_t sat(int64_t a, int bits) {
+    const int64_t max = ((int64_t)1 << (bits - 1)) - 1;
+    return std::min(std::max(a, -max - 1), max);
+  }
+
+  // The operation performed, as documented, for a single output element
+  static int8_t expected_element(const nn_elementwise_params_t &p, int8_t x0,
+                                 int8_t x1) {
+    int64_t v[2];
+    const int8_t x[2] = {x0, x1};
+    for (int k = 0; k < 2; k++) {
+      const int shr = p.scale.input[k].shr;
+      const int64_t s =
+          shr >= 0 ? (x[k] >> shr) : ((int64_t)x[k] * ((int64_t)1 << -shr));
+      v[k] = sat(sat(s, 16) * p.scale.input[k].multiplier + p.input_offset[k],
+                 32);
+    }
+
+    int64_t a = 0;
+    switch (p.op) {
+      case ELEMENTWISE_OP_ADD:
+        a = v[0] + v[1];
+        break;
+      case ELEMENTWISE_OP_SUB:
+        a = v[0] - v[1];
+        break;
+      case ELEMENTWISE_OP_MUL:
+        a = round_shr(v[0] * v[1], p.product_shr);
+        break;
+      case ELEMENTWISE_OP_MIN:
+        a = std::min(v[0], v[1]);
+        break;
+      case ELEMENTWISE_OP_MAX:
+        a = std::max(v[0], v[1]);
+        break;
+      case ELEMENTWISE_OP_SQUARED_DIFFERENCE: {
+        const int64_t d = sat(v[0] - v[1], 32);
+        a = round_shr(d * d, p.product_shr);
+        break;
+      }
+    }
+
+    const int64_t y =
+        round_shr(sat(p.scale.output.bias + a, 32), p.scale.output.shr);
+    return (int8_t)sat(y, 8);
+  }
+
+  static nn_elementwise_params_t random_params(nn_elementwise_op_e op,
+                                               uint32_t channels) {
+    nn_elementwise_params_t p;
+    p.op = op;
+    for (int k = 0; k < 2; k++) {
+      p.scale.input[k].shr = rng.rand<int16_t>(-7, 0);
+      p.scale.input[k].multiplier = rng.rand<int16_t>(-0x2000, 0x2000);
+      p.input_offset[k] = rng.rand<int32_t>(-0x40000, 0x40000);
+    }
+    p.scale.output.bias = rng.rand<int32_t>(-0x100000, 0x100000);
+    p.scale.output.shr = rng.rand<int>(12, 16);
+    p.product_shr = rng.rand<int>(20, 26);
+    p.broadcast[0] = p.broadcast[1] = ELEMENTWISE_BROADCAST_NONE;
+    p.channels = channels;
+    return p;
+  }
+
+  // Parameters as for quantized tensors, where the scaled inputs and their
+  // products fit in 16 bits
+  static nn_elementwise_params_t quantized_params(nn_elementwise_op_e op,
+                                                  uint32_t channels) {
+    nn_elementwise_params_t p = random_params(op, channels);
+    for (int k = 0; k < 2; k++) {
+      p.scale.input[k].shr = rng.rand<int16_t>(0, 1);
+      p.scale.input[k].multiplier = rng.rand<int16_t>(-100, 100);
+      p.input_offset[k] = rng.rand<int8_t>();
+    }
+    p.scale.output.bias = rng.rand<int32_t>(-0x800, 0x800);
+    p.scale.output.shr = rng.rand<int>(5, 8);
+    p.product_shr = rng.rand<int>(15, 17);
+    return p;
+  }
+
+  /*
+    broadcast_elementwise() must give the documented output for `p`, with
+    each input broadcast in each way, whether computed as one job or split
+    into jobs which do not start on a pixel boundary.
+  */
+  template <class MakeParams>
+  static void check_broadcasts(nn_elementwise_op_e op,
+                               MakeParams make_params) {
+    const nn_elementwise_broadcast_e broadcasts[] = {
+        ELEMENTWISE_BROADCAST_NONE, ELEMENTWISE_BROADCAST_CHANNEL,
+        ELEMENTWISE_BROADCAST_SCALAR};
+    const uint32_t channels = 20;
+    const int pixels = 7;
+    const int N = pixels * channels;
+
+    for (auto b0 : broadcasts) {
+      for (auto b1 : broadcasts) {
+        nn_elementwise_params_t p = make_params(op, channels);
+        p.broadcast[0] = b0;
+        p.broadcast[1] = b1;
+
+        // Unbroadcast inputs may be overread as by add_elementwise()
+        std::vector<int8_t> X0(N + VPU_INT8_EPV), X1(N + VPU_INT8_EPV);
+        for (auto &x : X0) x = rng.rand<int8_t>();
+        for (auto &x : X1) x = rng.rand<int8_t>();
+
+        std::vector<int8_t> expected(N);
+        for (int k = 0; k < N; k++) {
+          const int i0 = b0 == ELEMENTWISE_BROADCAST_NONE      ? k
+                         : b0 == ELEMENTWISE_BROADCAST_CHANNEL ? k % channels
+                                                               : 0;
+          const int i1 = b1 == ELEMENTWISE_BROADCAST_NONE      ? k
+                         : b1 == ELEMENTWISE_BROADCAST_CHANNEL ? k % channels
+                                                               : 0;
+          expected[k] = expected_element(p, X0[i0], X1[i1]);
+        }
+
+        std::vector<int8_t> actual(N);
+        broadcast_elementwise(actual.data(), X0.data(), X1.data(), &p, 0, N);
+        ASSERT_EQ(expected, actual)
+            << "op: " << op << " broadcast: " << b0 << ", " << b1;
+
+        const unsigned splits[] = {0, 13, 45, 46, (unsigned)N};
+        std::vector<int8_t> jobs(N);
+        for (int j = 0; j < 4; j++)
+          broadcast_elementwise(jobs.data(), X0.data(), X1.data(), &p,
+                                splits[j], splits[j + 1] - splits[j]);
+        ASSERT_EQ(expected, jobs)
+            << "op: " << op << " broadcast: " << b0 << ", " << b1;
+      }
+    }
+  }
+};
+
+/*
+  Every operation must give the documented output.
+*/
+TEST_F(Test_BroadcastElementwise, MatchesDefinition) {
+  for (auto op : {ELEMENTWISE_OP_ADD, ELEMENTWISE_OP_SUB, ELEMENTWISE_OP_MUL,
+                  ELEMENTWISE_OP_MIN, ELEMENTWISE_OP_MAX,
+                  ELEMENTWISE_OP_SQUARED_DIFFERENCE}) {
+    check_broadcasts(op, random_params);
+    if (HasFatalFailure()) return;
+  }
+}
+
+/*
+  Products of quantized tensors, which are computed in 16 bits on the VPU,
+  must give the documented output.
+*/
+TEST_F(Test_BroadcastElementwise, QuantizedProducts) {
+  for (auto op : {ELEMENTWISE_OP_MUL, ELEMENTWISE_OP_SQUARED_DIFFERENCE}) {
+    for (int rep = 0; rep < 20; rep++) {
+      check_broadcasts(op, quantized_params);
+      if (HasFatalFailure()) return;
+    }
+  }
+}
+
+/*
+  The output may be written over an input which is not broadcast.
+*/
+TEST_F(Test_BroadcastElementwise, InPlace) {
+  const uint32_t channels = 12;
+  const int N = 9 * channels;
+
+  for (auto op : {ELEMENTWISE_OP_ADD, ELEMENTWISE_OP_SQUARED_DIFFERENCE}) {
+    for (int k = 0; k < 2; k++) {
+      nn_elementwise_params_t p = random_params(op, channels);
+      p.broadcast[1 - k] = ELEMENTWISE_BROADCAST_CHANNEL;
+
+      std::vector<int8_t> X(N + VPU_INT8_EPV), B(channels);
+      for (auto &x : X) x = rng.rand<int8_t>();
+      for (auto &b : B) b = rng.rand<int8_t>();
+
+      const int8_t *X0 = k == 0 ? X.data() : B.data();
+      const int8_t *X1 = k == 0 ? B.data() : X.data();
+      std::vector<int8_t> expected(X);
+      broadcast_elementwise(expected.data(), X0, X1, &p, 0, N);
+
+      broadcast_elementwise(X.data(), X0, X1, &p, 0, N);
+      ASSERT_EQ(expected, X) << "op: " << op << " input: " << k;
+    }
+  }
+}
+
+/*
+  Additions and subtractions whose intermediate values saturate must still
+  give the documented output.
+*/
+TEST_F(Test_BroadcastElementwise, Saturating) {
+  const uint32_t channels = 8;
+  const int N = 50 * channels;
+
+  for (auto op : {ELEMENTWISE_OP_ADD, ELEMENTWISE_OP_SUB}) {
+    for (int32_t offset : {INT32_MAX - 0x1000, INT32_MIN + 0x1000}) {
+      nn_elementwise_params_t p = random_params(op, channels);
+      p.broadcast[1] = ELEMENTWISE_BROADCAST_CHANNEL;
+      p.input_offset[0] = offset;
+      p.scale.output.shr = 24;
+
+      std::vector<int8_t> X0(N + VPU_INT8_EPV), X1(channels);
+      for (auto &x : X0) x = rng.rand<int8_t>();
+      for (auto &x : X1) x = rng.rand<int8_t>();
+
+      std::vector<int8_t> expected(N);
+      for (int k = 0; k < N; k++)
+        expected[k] = expected_element(p, X0[k], X1[k % channels]);
+
+      std::vector<int8_t> actual(N);
+      broadcast_elementwise(actual.data(), X0.data(), X1.data(), &p, 0, N);
+      ASSERT_EQ(expected, actual) << "op: " << op << " offset: " << offset;
+    }
+  }
+}
+
+/*
+  A plain addition must be exactly add_elementwise().
+*/
+TEST_F(Test_BroadcastElementwise, MatchesAddElementwise) {
+  const int N = 100;
+  nn_elementwise_params_t p = random_params(ELEMENTWISE_OP_ADD, 4);
+  p.input_offset[0] = p.input_offset[1] = 0;
+
+  std::vector<int8_t> X0(N + VPU_INT8_EPV), X1(N + VPU_INT8_EPV);
+  for (auto &x : X0) x = rng.rand<int8_t>();
+  for (auto &x : X1) x = rng.rand<int8_t>();
+
+  std::vector<int8_t> expected(N), actual(N);
+  add_elementwise(expected.data(), X0.data(), X1.data(), &p.scale, 0, N);
+  broadcast_elementwise(actual.data(), X0.data(), X1.data(), &p, 0, N);
+  ASSERT_EQ(expected, actual);
+}
+
+}  // namespace nn
@@ -0,0 +1,157 @@
+#include <vector>
+
+#include "ConvDispatcher.hpp"
+#include "gtest/gtest.h"
+
+namespace nn {
+
+class Test_ConvDispatcher : public ::testing::Test {
+ protected:
+  static std::vector<ConvImpl> legal_impls(const Filter2dGeometry &filter) {
+    std::vector<ConvImpl> impls;
+    for (int i = 0; i < ConvImplCount; i++)
+      if (ConvDispatcher::is_legal((ConvImpl)i, filter))
+        impls.push_back((ConvImpl)i);
+    return impls;
+  }
+};
+
+TEST_F(Test_ConvDispatcher, Legality) {
+  // 3x3 valid, deep
+  {
+    Filter2dGeometry filter(ImageGeometry(6, 6, 32), ImageGeometry(4, 4, 16),
+                            WindowGeometry(3, 3, 32));
+    std::vector<ConvImpl> expected = {
+        ConvImpl::Conv2dDeep, ConvImpl::Conv2dIm2col, ConvImpl::Filter2dDirect,
+        ConvImpl::Filter2dIm2colValid, ConvImpl::Filter2dIm2colPadded};
+    EXPECT_EQ(expected, legal_impls(filter));
+  }
+
+  // 3x3 padded, shallow
+  {
+    Filter2dGeometry filter(ImageGeometry(6, 6, 4), ImageGeometry(6, 6, 16),
+                            WindowGeometry(3, 3, 4, -1, -1));
+    std::vector<ConvImpl> expected = {
+        ConvImpl::Conv2dDeep, ConvImpl::Conv2dShallowIn,
+        ConvImpl::Conv2dIm2col, ConvImpl::Filter2dIm2colPadded};
+    EXPECT_EQ(expected, legal_impls(filter));
+  }
+
+  // 1x1
+  {
+    Filter2dGeometry filter(ImageGeometry(6, 6, 8), ImageGeometry(6, 6, 8),
+                            WindowGeometry(1, 1, 8));
+    std::vector<ConvImpl> expected = {
+        ConvImpl::Conv2dDeep, ConvImpl::Conv2dShallowIn, ConvImpl::Conv2d1x1,
+        ConvImpl::Conv2dIm2col, ConvImpl::Filter2dIm2colValid,
+        ConvImpl::Filter2dIm2colPadded};
+    EXPECT_EQ(expected, legal_impls(filter));
+  }
+
+  // 3 input channels
+  {
+    Filter2dGeometry filter(ImageGeometry(6, 6, 3), ImageGeometry(6, 6, 8),
+                            WindowGeometry(3, 3, 3, -1, -1));
+    std::vector<ConvImpl> expected = {ConvImpl::Conv2dIm2col};
+    EXPECT_EQ(expected, legal_impls(filter));
+  }
+
+  // Dilated
+  {
+    Filter2dGeometry filter(ImageGeometry(8, 8, 32), ImageGeometry(4, 4, 16),
+                            WindowGeometry(3, 3, 32, 0, 0, 1, 1, 0, 2, 2));
+    std::vector<ConvImpl> expected = {ConvImpl::Filter2dDirect,
+                                      ConvImpl::Filter2dIm2colValid,
+                                      ConvImpl::Filter2dIm2colPadded};
+    EXPECT_EQ(expected, legal_impls(filter));
+  }
+
+  // Depthwise
+  {
+    Filter2dGeometry filter(ImageGeometry(6, 6, 16), ImageGeometry(4, 4, 16),
+                            WindowGeometry(3, 3, 1, 0, 0, 1, 1, 1));
+    EXPECT_TRUE(legal_impls(filter).empty());
+  }
+}
+
+TEST_F(Test_ConvDispatcher, EstimateCycles) {
+  std::array<ConvCostModel, ConvImplCount> costs;
+  for (auto &model : costs) model = ConvCostModel{1000, 0, 0, 0, 0, 0};
+  costs[(int)ConvImpl::Filter2dIm2colPadded] = ConvCostModel{1, 2, 3, 4, 5, 6};
+  ConvDispatcher dispatcher(costs);
+
+  // P = 20, G = 2, W = 9, V = 9 * 2, M = ceil(9 * 36 / 32) = 11
+  Filter2dGeometry filter(ImageGeometry(4, 5, 36), ImageGeometry(4, 5, 20),
+                          WindowGeometry(3, 3, 36, -1, -1));
+  EXPECT_EQ(1 + 20 * (2 + 9 * 3 + 18 * 4) + 20 * 2 * (5 + 11 * 6),
+            dispatcher.estimate_cycles(ConvImpl::Filter2dIm2colPadded, filter));
+
+  ConvDispatch choice = dispatcher.choose(filter);
+  EXPECT_EQ(ConvImpl::Conv2dDeep, choice.impl);
+  EXPECT_EQ(1000, choice.cycles);
+}
+
+TEST_F(Test_ConvDispatcher, ChoosesCheapest) {
+  ConvDispatcher dispatcher;
+
+  Filter2dGeometry pointwise(ImageGeometry(8, 8, 64), ImageGeometry(8, 8, 64),
+                             WindowGeometry(1, 1, 64));
+  EXPECT_EQ(ConvImpl::Conv2d1x1, dispatcher.choose(pointwise).impl);
+
+  Filter2dGeometry shallow(ImageGeometry(16, 16, 4), ImageGeometry(16, 16, 32),
+                           WindowGeometry(3, 3, 4, -1, -1));
+  EXPECT_EQ(ConvImpl::Conv2dShallowIn, dispatcher.choose(shallow).impl);
+
+  Filter2dGeometry filters[] = {
+      pointwise, shallow,
+      Filter2dGeometry(ImageGeometry(10, 10, 32), ImageGeometry(8, 8, 48),
+                       WindowGeometry(3, 3, 32)),
+      Filter2dGeometry(ImageGeometry(9, 9, 3), ImageGeometry(4, 4, 16),
+                       WindowGeometry(3, 3, 3, 0, 0, 2, 2))};
+
+  for (auto &filter : filters) {
+    std::vector<ConvDispatch> ranked = dispatcher.rank(filter);
+    ASSERT_FALSE(ranked.empty()) << filter;
+
+    for (size_t i = 0; i < ranked.size(); i++) {
+      EXPECT_EQ(dispatcher.estimate_cycles(ranked[i].impl, filter),
+                ranked[i].cycles);
+      if (i > 0) {
+        EXPECT_LE(ranked[i - 1].cycles, ranked[i].cycles);
+      }
+    }
+
+    ConvDispatch choice = dispatcher.choose(filter);
+    EXPECT_TRUE(choice.is_valid()) << filter;
+    EXPECT_EQ(ranked[0].impl, choice.impl) << filter;
+    EXPECT_EQ(ranked[0].cycles, choice.cycles) << filter;
+  }
+}
+
+TEST_F(Test_ConvDispatcher, UpdatedCostModel) {
+  ConvDispatcher dispatcher;
+  dispatcher.set_cost_model(ConvImpl::Filter2dDirect,
+                            ConvCostModel{0, 0, 0, 0, 0, 1});
+
+  Filter2dGeometry valid(ImageGeometry(6, 6, 32), ImageGeometry(4, 4, 16),
+                         WindowGeometry(3, 3, 32));
+  EXPECT_EQ(ConvImpl::Filter2dDirect, dispatcher.choose(valid).impl);
+
+  // Not legal with padding
+  Filter2dGeometry padded(ImageGeometry(6, 6, 32), ImageGeometry(6, 6, 16),
+                          WindowGeometry(3, 3, 32, -1, -1));
+  EXPECT_NE(ConvImpl::Filter2dDirect, dispatcher.choose(padded).impl);
+}
+
+TEST_F(Test_ConvDispatcher, NoLegalImplementation) {
+  ConvDispatcher dispatcher;
+
+  Filter2dGeometry depthwise(ImageGeometry(6, 6, 16), ImageGeometry(4, 4, 16),
+                             WindowGeometry(3, 3, 1, 0, 0, 1, 1, 1));
+  ConvDispatch choice = dispatcher.choose(depthwise);
+  EXPECT_FALSE(choice.is_valid());
+  EXPECT_EQ(ConvImpl::None, choice.impl);
+  EXPECT_EQ(-1, choice.cycles);
+}
+
+}  // namespace nn
@@ -89,7 +89,10 @@ class MockOutputTransform : public OutputTransformFn {
 template <typename T>
 class Filter2D_Test : public ::testing::Test {};
 
-using Filter2D_Test_Types = ::testing::Types<Filter2D, Filter2D_DW>;
+using Filter2D_Test_Types =
+    ::testing::Types<Filter2D, Filter2D_DW,
+                     Filter2DT<MockMemCpyFn, MockAggregateFn,
+                               MockOutputTransform>>;
 TYPED_TEST_SUITE(Filter2D_Test, Filter2D_Test_Types);
 
 TYPED_TEST(Filter2D_Test, BasicTest) {
@@ -185,4 +188,93 @@ TYPED_TEST(Filter2D_Test, BasicTest) {
   }
 }
 
+class Filter2D_Int16x8_Test : public ::testing::Test {};
+
+/*
+  A "same" padded 3x3 convolution of int16 activations with int8 weights must
+  be within 1 of the real convolution, for both int16 and int8 outputs.
+*/
+TEST_F(Filter2D_Int16x8_Test, Conv2d) {
+  auto rng = test::Rand(1616);
+
+  for (int output_bytes = 1; output_bytes <= 2; ++output_bytes) {
+    for (int y_channels = 4; y_channels <= 36; y_channels += 16) {
+      const int x_channels = 12;
+      ImageGeometry X(5, 6, x_channels, sizeof(int16_t));
+      WindowGeometry K(3, 3, x_channels, -1, -1);
+      ImageGeometry Y(5, 6, y_channels, output_bytes);
+      padding_t padding = {1, 1, 1, 1};
+      const int elements_per_channel = 3 * 3 * x_channels;
+      const int32_t y_max = output_bytes == 2 ? INT16_MAX : INT8_MAX;
+
+      std::vector<int16_t> x(X.ImageBytes() / 2);
+      std::vector<int8_t> raw_weights(y_channels * elements_per_channel);
+      for (auto &v : x) v = rng.rand<int16_t>();
+      for (auto &v : raw_weights) v = rng.rand<int8_t>();
+
+      // Scale the accumulators to roughly the output range
+      std::vector<int32_t> biases(y_channels), offsets(y_channels);
+      std::vector<double> multipliers(y_channels);
+      for (int ch = 0; ch < y_channels; ++ch) {
+        biases[ch] = rng.rand<int32_t>(-(1 << 24), 1 << 24);
+        multipliers[ch] = y_max / (double)(1 << 26) * rng.rand<double>(1, 4);
+        offsets[ch] = rng.rand<int32_t>(-y_max / 4, y_max / 4);
+      }
+
+      std::array<int, 4> shape = {y_channels, 3, 3, x_channels};
+      std::vector<int8_t> weights =
+          MatMulInt16x8::reorder_kernel_weights(raw_weights.data(), shape);
+      MatMulInt16x8::Params mm_params(elements_per_channel, weights.data());
+      MatMulInt16x8 mm(&mm_params);
+
+      OT_int16::Quantisation q =
+          OT_int16::quantise_activation(biases, multipliers, offsets);
+      OT_int16::Params ot_params(y_channels, output_bytes, q.biases.data(),
+                                 q.multipliers.data(), q.shifts.data(),
+                                 q.offsets.data());
+      OT_int16 ot(&ot_params);
+
+      ImToColPaddedInt16::Params im2col_params(X, K, padding, x_channels, 0);
+      ImToColPaddedInt16 im2col(&im2col_params);
+      std::vector<int32_t> scratch((im2col.get_scratch_bytes() + 3) / 4);
+
+      ImageRegion region(0, 0, 0, Y.height, Y.width, Y.depth);
+      AbstractKernel::Params kparams(Y, region, VPU_INT16_EPV);
+      Filter2D filter(&kparams, &im2col, &mm, &ot, (int8_t *)scratch.data());
+
+      std::vector<int32_t> y((Y.ImageBytes() + 3) / 4);
+      filter.execute((int8_t *)y.data(), (int8_t *)x.data());
+
+      for (int row = 0; row < Y.height; ++row) {
+        for (int col = 0; col < Y.width; ++col) {
+          for (int ch = 0; ch < y_channels; ++ch) {
+            int64_t acc = biases[ch];
+            for (int kr = 0; kr < 3; ++kr) {
+              for (int kc = 0; kc < 3; ++kc) {
+                const int r = row + kr - 1, c = col + kc - 1;
+                if (r < 0 || r >= X.height || c < 0 || c >= X.width) continue;
+                for (int xc = 0; xc < x_channels; ++xc)
+                  acc += x[(r * X.width + c) * x_channels + xc] *
+                         raw_weights[ch * elements_per_channel +
+                                     (kr * 3 + kc) * x_channels + xc];
+              }
+            }
+            double expected = acc * multipliers[ch] + offsets[ch];
+            expected =
+                std::min(std::max(expected, (double)-y_max), (double)y_max);
+
+            const int index = (row * Y.width + col) * y_channels + ch;
+            const int actual = output_bytes == 2
+                                   ? ((int16_t *)y.data())[index]
+                                   : ((int8_t *)y.data())[index];
+            ASSERT_NEAR(expected, actual, 1)
+                << "output_bytes: " << output_bytes << " | row: " << row
+                << " | col: " << col << " | ch: " << ch;
+          }
+        }
+      }
+    }
+  }
+}
+
 }  // namespace nn
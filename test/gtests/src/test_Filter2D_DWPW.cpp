@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <vector>
+
+#include "Filter2D.hpp"
+#include "OutputTransformFixture.hpp"
+#include "Rand.hpp"
+#include "gtest/gtest.h"
+
+namespace nn {
+
+static auto rng = test::Rand(86420);
+
+class Test_Filter2D_DWPW : public ::testing::Test,
+                           protected test::OutputTransformFixture {};
+
+/*
+  The fused filter must produce exactly the output of a Filter2D_DW writing the
+  intermediate image followed by a 1x1 Filter2D over it, and the depthwise
+  stage must match a scalar reference.
+*/
+TEST_F(Test_Filter2D_DWPW, MatchesUnfused) {
+  const int dw_shift = 6;
+
+  for (int padded = 0; padded <= 1; padded++) {
+    for (int dw_channels = 16; dw_channels <= 40; dw_channels += 12) {
+      for (int y_channels = 4; y_channels <= 36; y_channels += 16) {
+        ImageGeometry X(5, 6, dw_channels);
+        WindowGeometry K(3, 3, 1, -padded, -padded);
+        ImageGeometry T(X.height - 2 + 2 * padded, X.width - 2 + 2 * padded,
+                        dw_channels);
+        ImageGeometry Y(T.height, T.width, y_channels);
+        const int8_t pad_value = padded ? rng.rand<int8_t>() : 0;
+
+        std::vector<int8_t> x(X.ImageBytes() + XS3_VPU_VREG_WIDTH_BYTES);
+        for (auto &v : x) v = rng.rand<int8_t>();
+
+        std::vector<int8_t> dw_weights(9 * dw_channels);
+        for (auto &v : dw_weights) v = rng.rand<int8_t>();
+        std::array<int, 4> dw_shape = {1, 3, 3, dw_channels};
+        std::vector<int8_t> dw_reordered =
+            MatMulDirectFn_DW::reorder_kernel_weights(dw_weights.data(),
+                                                      dw_shape);
+
+        std::vector<int8_t> pw_weights(y_channels * dw_channels);
+        for (auto &v : pw_weights) v = rng.rand<int8_t>();
+        std::array<int, 4> pw_shape = {y_channels, 1, 1, dw_channels};
+        Conv2dReorderedWeights pw_reordered =
+            MatMulInt8::reorder_kernel_weights(pw_weights.data(), pw_shape, 8,
+                                               0);
+
+        // Depthwise handlers
+        Filter2dGeometry dw_geom(X, T, K);
+        DerefInputFn::Params deref_params(X, K);
+        ImToColPadded::Params im2col_params(dw_geom, pad_value,
+                                            VPU_INT8_ACC_PERIOD);
+        DerefInputFn deref(&deref_params);
+        ImToColPadded im2col(&im2col_params);
+        MemCpyFn *dw_memcpy =
+            padded ? (MemCpyFn *)&im2col : (MemCpyFn *)&deref;
+
+        MatMulDirectFn_DW::Params dw_direct_params(X, K, dw_reordered.data());
+        MatMulDirectFn_DW::Params dw_patch_params(K, dw_reordered.data());
+        MatMulDirectFn_DW dw_agg(padded ? &dw_patch_params
+                                        : &dw_direct_params);
+        test::RoundShiftOutputTransform dw_ot(dw_channels, dw_shift);
+
+        // Pointwise handlers
+        ImToColPadded::Params pw_im2col_params(
+            Filter2dGeometry(T, Y, WindowGeometry(1, 1, 1)), 0, dw_channels);
+        ImToColPadded pw_im2col(&pw_im2col_params);
+        MatMulInt8::Params pw_params(y_channels, dw_channels,
+                                     pw_reordered.weights.data());
+        MatMulInt8 pw_agg(&pw_params);
+        OT_int8::Params ot_params = make_ot_params(y_channels);
+        OT_int8 pw_ot(&ot_params);
+
+        // Unfused
+        std::vector<int8_t> t(T.ImageBytes() + XS3_VPU_VREG_WIDTH_BYTES);
+        std::vector<int32_t> dw_scratch(
+            (dw_memcpy->get_scratch_bytes() + 3) / 4 + 1);
+        ImageRegion t_region(0, 0, 0, T.height, T.width, T.depth);
+        AbstractKernel::Params t_kparams(T, t_region, VPU_INT8_ACC_PERIOD);
+        Filter2D_DW dw_filter(&t_kparams, dw_memcpy, &dw_agg, &dw_ot,
+                              (int8_t *)dw_scratch.data());
+        dw_filter.execute(t.data(), x.data());
+
+        for (int h = 0; h < T.height; h++) {
+          for (int w = 0; w < T.width; w++) {
+            for (int c = 0; c < T.depth; c++) {
+              int32_t acc = 0;
+              for (int r = 0; r < 3; r++) {
+                for (int s = 0; s < 3; s++) {
+                  const int row = K.start.row + h + r;
+                  const int col = K.start.col + w + s;
+                  const bool valid = row >= 0 && row < X.height && col >= 0 &&
+                                     col < X.width;
+                  const int32_t v = valid ? x[X.Index(row, col, c)] : pad_value;
+                  acc += v * dw_weights[(r * 3 + s) * dw_channels + c];
+                }
+              }
+              ASSERT_EQ(test::RoundShiftOutputTransform::apply(acc, dw_shift),
+                        t[T.Index(h, w, c)])
+                  << "T: " << T << " | h: " << h << " | w: " << w
+                  << " | c: " << c;
+            }
+          }
+        }
+
+        std::vector<int32_t> pw_scratch((pw_im2col.get_scratch_bytes() + 3) /
+                                        4);
+        ImageRegion y_region(0, 0, 0, Y.height, Y.width, Y.depth);
+        AbstractKernel::Params y_kparams(Y, y_region, VPU_INT8_ACC_PERIOD);
+        Filter2D pw_filter(&y_kparams, &pw_im2col, &pw_agg, &pw_ot,
+                           (int8_t *)pw_scratch.data());
+
+        std::vector<int8_t> expected(Y.ImageBytes());
+        pw_filter.execute(expected.data(), t.data());
+
+        // Fused, with the scratch memory sized from the handlers
+        Filter2D_DWPW fused(&y_kparams, dw_memcpy, &dw_agg, &dw_ot,
+                            dw_channels, &pw_agg, &pw_ot);
+        std::vector<int32_t> scratch((fused.get_scratch_bytes() + 3) / 4);
+        Filter2D_DWPW fused_job(fused, &y_kparams, (int8_t *)scratch.data());
+
+        std::vector<int8_t> actual(Y.ImageBytes());
+        fused_job.execute(actual.data(), x.data());
+
+        ASSERT_EQ(expected, actual) << "Y: " << Y;
+      }
+    }
+  }
+}
+
+}  // namespace nn
@@ -0,0 +1,164 @@
+#include <array>
+#include <cstring>
+#include <vector>
+
+#include "Filter2D.hpp"
+#include "OutputTransformFixture.hpp"
+#include "Rand.hpp"
+#include "gtest/gtest.h"
+
+namespace nn {
+
+static auto rng = test::Rand(97531);
+
+class Test_Filter2D_LoopOrder : public ::testing::Test,
+                                protected test::OutputTransformFixture {
+ protected:
+  /*
+    Run `filter` in each loop order, with and without a weights buffer, and
+    check they all give the same output.
+  */
+  void check_loop_orders(Filter2D &filter, const ImageGeometry &Y,
+                         std::vector<int8_t> &x) {
+    std::vector<int8_t> expected(Y.ImageBytes());
+    filter.set_loop_order(Filter2DLoopOrder::PixelOuter);
+    filter.execute(expected.data(), x.data());
+
+    std::vector<int8_t> actual(Y.ImageBytes());
+    filter.set_loop_order(Filter2DLoopOrder::ChannelGroupOuter);
+    filter.execute(actual.data(), x.data());
+    ASSERT_EQ(expected, actual) << "Y: " << Y;
+
+    const int32_t buffer_bytes = filter.get_weights_buffer_bytes();
+    ASSERT_GT(buffer_bytes, 0);
+    std::vector<int32_t> buffer((buffer_bytes + 3) / 4);
+    filter.set_weights_buffer((int8_t *)buffer.data(), buffer_bytes);
+    filter.set_loop_order(Filter2DLoopOrder::ChannelGroupOuter);
+
+    std::fill(actual.begin(), actual.end(), 0);
+    filter.execute(actual.data(), x.data());
+    ASSERT_EQ(expected, actual) << "Y: " << Y;
+  }
+};
+
+TEST_F(Test_Filter2D_LoopOrder, DirectMatchesPixelOuter) {
+  for (int x_channels = 32; x_channels <= 64; x_channels += 32) {
+    for (int y_channels = 16; y_channels <= 48; y_channels += 16) {
+      for (int k = 1; k <= 3; k += 2) {
+        ImageGeometry X(5, 4, x_channels);
+        WindowGeometry K(k, k, 1);
+        ImageGeometry Y(X.height - k + 1, X.width - k + 1, y_channels);
+
+        std::vector<int8_t> weights(y_channels * k * k * x_channels);
+        for (auto &v : weights) v = rng.rand<int8_t>();
+        std::array<int, 4> shape = {y_channels, k, k, x_channels};
+        Conv2dReorderedWeights rw = MatMulInt8::reorder_kernel_weights(
+            weights.data(), shape, 8, 0);
+
+        std::vector<int8_t> x(X.ImageBytes() + XS3_VPU_VREG_WIDTH_BYTES);
+        for (auto &v : x) v = rng.rand<int8_t>();
+
+        DerefInputFn::Params mp(X, K);
+        DerefInputFn mem_fn(&mp);
+        MatMulDirectFn::Params ap(X, K, x_channels, rw.weights.data());
+        MatMulDirectFn agg_fn(&ap);
+        OT_int8::Params op = make_ot_params(y_channels);
+        OT_int8 ot_fn(&op);
+
+        ImageRegion region(0, 0, 0, Y.height, Y.width, Y.depth);
+        AbstractKernel::Params akp(Y, region, VPU_INT8_ACC_PERIOD);
+        Filter2D filter(&akp, &mem_fn, &agg_fn, &ot_fn);
+
+        // Each channel group's weights are contiguous
+        EXPECT_EQ(k * k * x_channels * VPU_INT8_ACC_PERIOD,
+                  filter.get_weights_buffer_bytes());
+
+        check_loop_orders(filter, Y, x);
+      }
+    }
+  }
+}
+
+TEST_F(Test_Filter2D_LoopOrder, Im2colMatchesPixelOuter) {
+  for (int x_channels = 4; x_channels <= 12; x_channels += 4) {
+    for (int y_channels = 4; y_channels <= 40; y_channels += 12) {
+      ImageGeometry X(4, 5, x_channels);
+      WindowGeometry K(3, 3, 1, -1, -1);
+      ImageGeometry Y(X.height, X.width, y_channels);
+
+      std::vector<int8_t> weights(y_channels * 9 * x_channels);
+      for (auto &v : weights) v = rng.rand<int8_t>();
+      std::array<int, 4> shape = {y_channels, 3, 3, x_channels};
+      Conv2dReorderedWeights rw = MatMulInt8::reorder_kernel_weights(
+          weights.data(), shape, 8, 0);
+
+      std::vector<int8_t> x(X.ImageBytes());
+      for (auto &v : x) v = rng.rand<int8_t>();
+
+      ImToColPadded::Params mp(Filter2dGeometry(X, Y, K), 0, x_channels);
+      ImToColPadded mem_fn(&mp);
+      MatMulInt8::Params ap(y_channels, 9 * x_channels, rw.weights.data());
+      MatMulInt8 agg_fn(&ap);
+      OT_int8::Params op = make_ot_params(y_channels);
+      OT_int8 ot_fn(&op);
+
+      std::vector<int32_t> scratch((mem_fn.get_scratch_bytes() + 3) / 4);
+
+      ImageRegion region(0, 0, 0, Y.height, Y.width, Y.depth);
+      AbstractKernel::Params akp(Y, region, VPU_INT8_ACC_PERIOD);
+      Filter2D filter(&akp, &mem_fn, &agg_fn, &ot_fn,
+                      (int8_t *)scratch.data());
+
+      check_loop_orders(filter, Y, x);
+    }
+  }
+}
+
+TEST_F(Test_Filter2D_LoopOrder, ChooseLoopOrder) {
+  ImageGeometry X(8, 8, 32);
+  WindowGeometry K(3, 3, 1);
+  ImageGeometry Y(6, 6, 64);
+
+  std::vector<int8_t> weights(Y.depth * 9 * X.depth);
+  std::array<int, 4> shape = {Y.depth, 3, 3, X.depth};
+  Conv2dReorderedWeights rw =
+      MatMulInt8::reorder_kernel_weights(weights.data(), shape, 8, 0);
+
+  DerefInputFn::Params mp(X, K);
+  DerefInputFn mem_fn(&mp);
+  MatMulDirectFn::Params ap(X, K, X.depth, rw.weights.data());
+  MatMulDirectFn agg_fn(&ap);
+  OT_int8::Params op = make_ot_params(Y.depth);
+  OT_int8 ot_fn(&op);
+
+  ImageRegion region(0, 0, 0, Y.height, Y.width, Y.depth);
+  AbstractKernel::Params akp(Y, region, VPU_INT8_ACC_PERIOD);
+  Filter2D filter(&akp, &mem_fn, &agg_fn, &ot_fn);
+
+  const Filter2DMemoryCosts flash = {10, 1, 1};
+  const Filter2DMemoryCosts sram = {1, 1, 1};
+
+  // Without a buffer the weights are read in place either way
+  EXPECT_EQ(Filter2DLoopOrder::PixelOuter, filter.choose_loop_order(flash));
+
+  // Setting a buffer chooses the order under the default costs
+  std::vector<int32_t> buffer(filter.get_weights_buffer_bytes() / 4);
+  filter.set_weights_buffer((int8_t *)buffer.data(),
+                            filter.get_weights_buffer_bytes());
+  EXPECT_EQ(Filter2DLoopOrder::ChannelGroupOuter, filter.get_loop_order());
+  filter.set_weights_buffer(nullptr, 0);
+  EXPECT_EQ(Filter2DLoopOrder::PixelOuter, filter.get_loop_order());
+  filter.set_weights_buffer((int8_t *)buffer.data(),
+                            filter.get_weights_buffer_bytes(), sram);
+  EXPECT_EQ(Filter2DLoopOrder::PixelOuter, filter.get_loop_order());
+
+  EXPECT_EQ(Filter2DLoopOrder::ChannelGroupOuter,
+            filter.choose_loop_order(flash));
+  EXPECT_EQ(Filter2DLoopOrder::ChannelGroupOuter, filter.get_loop_order());
+
+  // Copying gains nothing when the weights are already in SRAM
+  EXPECT_EQ(Filter2DLoopOrder::PixelOuter, filter.choose_loop_order(sram));
+  EXPECT_EQ(Filter2DLoopOrder::PixelOuter, filter.get_loop_order());
+}
+
+}  // namespace nn
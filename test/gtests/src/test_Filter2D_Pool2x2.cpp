@@ -0,0 +1,115 @@
+#include <array>
+#include <vector>
+
+#include "Filter2D.hpp"
+#include "OutputTransformFixture.hpp"
+#include "Rand.hpp"
+#include "gtest/gtest.h"
+#include "nn_operator.h"
+
+namespace nn {
+
+static auto rng = test::Rand(2468);
+
+class Test_Filter2D_Pool2x2 : public ::testing::Test {};
+
+/*
+  The fused filter is compared with a Filter2D built from the same handlers
+  writing the full resolution image, followed by maxpool2d() or avgpool2d()
+  of that image with a 2x2 window and stride, which avgpool2d() hands to
+  avgpool2d_2x2().
+*/
+TEST_F(Test_Filter2D_Pool2x2, MatchesConvThenPool) {
+  for (auto pool_type : {Filter2D_Pool2x2::PoolType::Max,
+                         Filter2D_Pool2x2::PoolType::Avg}) {
+    for (int x_height = 2; x_height <= 7; ++x_height) {
+      for (int x_width = 2; x_width <= 7; x_width += 2) {
+        for (int x_channels = 32; x_channels <= 64; x_channels += 32) {
+          for (int y_channels = 16; y_channels <= 48; y_channels += 16) {
+            for (int k = 1; k <= 2; ++k) {
+              if (k > x_height || k > x_width) continue;
+
+              ImageGeometry X(x_height, x_width, x_channels);
+              WindowGeometry K(k, k, 1);
+              ImageGeometry Y(x_height - k + 1, x_width - k + 1, y_channels);
+              ImageGeometry P(Y.height / 2, Y.width / 2, y_channels);
+              if (P.height == 0 || P.width == 0) continue;
+
+              std::vector<int8_t> weights(y_channels * k * k * x_channels);
+              for (auto &v : weights) v = rng.rand<int8_t>();
+              std::array<int, 4> shape = {y_channels, k, k, x_channels};
+              Conv2dReorderedWeights rw = MatMulInt8::reorder_kernel_weights(
+                  weights.data(), shape, 8, 0);
+
+              std::vector<int8_t> x(X.ImageBytes() + XS3_VPU_VREG_WIDTH_BYTES);
+              for (auto &v : x) v = rng.rand<int8_t>();
+
+              DerefInputFn::Params mp(X, K);
+              DerefInputFn mem_fn(&mp);
+              MatMulDirectFn::Params ap(X, K, x_channels, rw.weights.data());
+              MatMulDirectFn agg_fn(&ap);
+              test::RoundShiftOutputTransform ot_fn(y_channels, 8 + k);
+
+              ImageRegion y_region(0, 0, 0, Y.height, Y.width, Y.depth);
+              AbstractKernel::Params y_akp(Y, y_region, VPU_INT8_ACC_PERIOD);
+              Filter2D conv(&y_akp, &mem_fn, &agg_fn, &ot_fn);
+
+              // maxpool2d() reads whole vectors of channels
+              std::vector<int8_t> y(Y.ImageBytes() + XS3_VPU_VREG_WIDTH_BYTES);
+              conv.execute(y.data(), x.data());
+
+              nn_image_params_t y_params = {(uint32_t)Y.height,
+                                            (uint32_t)Y.width,
+                                            (channel_count_t)Y.depth};
+              nn_image_params_t p_params = {(uint32_t)P.height,
+                                            (uint32_t)P.width,
+                                            (channel_count_t)P.depth};
+              nn_window_params_t window = {{2, 2}, {0, 0}, {2, 2}, {1, 1}};
+
+              std::vector<int8_t> expected(P.ImageBytes());
+              if (pool_type == Filter2D_Pool2x2::PoolType::Max)
+                maxpool2d(expected.data(), y.data(), &y_params, &p_params,
+                          &window);
+              else
+                avgpool2d(expected.data(), y.data(), &y_params, &p_params,
+                          &window);
+
+              ImageRegion p_region(0, 0, 0, P.height, P.width, P.depth);
+              AbstractKernel::Params p_akp(P, p_region, VPU_INT8_ACC_PERIOD);
+              Filter2D_Pool2x2 fused(&p_akp, &mem_fn, &agg_fn, &ot_fn,
+                                     pool_type);
+              ASSERT_EQ(0, fused.get_scratch_bytes());
+
+              std::vector<int8_t> actual(P.ImageBytes());
+              fused.execute(actual.data(), x.data());
+
+              ASSERT_EQ(expected, actual) << "X: " << X << " | K: " << k;
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST_F(Test_Filter2D_Pool2x2, ScratchPerPatch) {
+  ImageGeometry X(6, 6, 4);
+  WindowGeometry K(3, 3, 1, -1, -1);
+  ImageGeometry Y(6, 6, 16);
+  ImageGeometry P(3, 3, 16);
+
+  ImToColPadded::Params mp(Filter2dGeometry(X, Y, K), 0, 4);
+  ImToColPadded mem_fn(&mp);
+  MatMulDirectFn agg_fn(nullptr);
+  test::RoundShiftOutputTransform ot_fn(P.depth, 1);
+
+  ImageRegion p_region(0, 0, 0, P.height, P.width, P.depth);
+  AbstractKernel::Params p_akp(P, p_region, VPU_INT8_ACC_PERIOD);
+  Filter2D_Pool2x2 fused(&p_akp, &mem_fn, &agg_fn, &ot_fn,
+                         Filter2D_Pool2x2::PoolType::Max);
+
+  EXPECT_EQ(4 * ((mem_fn.get_scratch_bytes() + 3) & ~3),
+            fused.get_scratch_bytes());
+}
+
+}  // namespace nn
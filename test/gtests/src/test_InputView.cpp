@@ -0,0 +1,297 @@
+#include <array>
+#include <cstring>
+#include <vector>
+
+#include "ConvDispatcher.hpp"
+#include "Filter2D.hpp"
+#include "OutputTransformFixture.hpp"
+#include "Rand.hpp"
+#include "gtest/gtest.h"
+
+namespace nn {
+
+static auto rng = test::Rand(75319);
+
+namespace {
+
+enum class Patch { Padded, Valid, Direct, Sliding };
+
+}  // namespace
+
+class Test_InputView : public ::testing::Test,
+                       protected test::OutputTransformFixture {
+ protected:
+  // Run a 3x3 convolution of the image `x` described by `X` with the given
+  // patch handler. Padded handlers use "same" padding.
+  std::vector<int8_t> convolve(Patch patch, const ImageGeometry &X, int8_t *x,
+                               std::vector<int8_t> &raw_weights,
+                               int y_channels) {
+    const bool padded = patch == Patch::Padded || patch == Patch::Sliding;
+    WindowGeometry K(3, 3, X.depth, -(int)padded, -(int)padded);
+    ImageGeometry Y(X.height - 2 + 2 * padded, X.width - 2 + 2 * padded,
+                    y_channels);
+    Filter2dGeometry geom(X, Y, K);
+
+    std::array<int, 4> shape = {y_channels, 3, 3, X.depth};
+    Conv2dReorderedWeights rw =
+        MatMulInt8::reorder_kernel_weights(raw_weights.data(), shape, 8, 0);
+    MatMulInt8::Params mm_params(y_channels, 9 * X.depth, rw.weights.data());
+    MatMulInt8 mm(&mm_params);
+    MatMulDirectFn::Params direct_params(X, K, X.depth, rw.weights.data());
+    MatMulDirectFn direct(&direct_params);
+    AggregateFn *agg = patch == Patch::Direct ? (AggregateFn *)&direct
+                                              : (AggregateFn *)&mm;
+
+    ImToColPadded::Params padded_params(X, K, geom.Padding(), X.depth, 0);
+    ImToColPadded im2col_padded(&padded_params);
+    ImToColValid::Params valid_params(X, K, X.depth);
+    ImToColValid im2col_valid(&valid_params);
+    DerefInputFn::Params deref_params(X, K);
+    DerefInputFn deref(&deref_params);
+    ImToColSliding::Params sliding_params(geom, 0);
+    ImToColSliding sliding(&sliding_params);
+    MemCpyFn *memcpy_handler = nullptr;
+    switch (patch) {
+      case Patch::Padded:
+        memcpy_handler = &im2col_padded;
+        break;
+      case Patch::Valid:
+        memcpy_handler = &im2col_valid;
+        break;
+      case Patch::Direct:
+        memcpy_handler = &deref;
+        break;
+      case Patch::Sliding:
+        memcpy_handler = &sliding;
+        break;
+    }
+
+    OT_int8::Params ot_params = make_ot_params(y_channels);
+    OT_int8 ot(&ot_params);
+    std::vector<int32_t> scratch((memcpy_handler->get_scratch_bytes() + 3) / 4);
+    ImageRegion region(0, 0, 0, Y.height, Y.width, Y.depth);
+    AbstractKernel::Params kparams(Y, region, VPU_INT8_ACC_PERIOD);
+    Filter2D filter(&kparams, memcpy_handler, agg, &ot,
+                    (int8_t *)scratch.data());
+
+    std::vector<int8_t> y(Y.ImageBytes());
+    filter.execute(y.data(), x);
+    return y;
+  }
+};
+
+/*
+  Each patch handler, and the direct aggregator, must consume a crop and
+  channel slice of a larger image in place, giving the output of the same
+  filter over a dense copy of it.
+*/
+TEST_F(Test_InputView, Filter2D) {
+  const Patch patches[] = {Patch::Padded, Patch::Valid, Patch::Direct,
+                           Patch::Sliding};
+  const int y_channels = 20;
+
+  ImageGeometry parent(7, 9, 48);
+  ImageRegion region(1, 2, 8, 5, 6, 32);
+  ImageGeometry X = parent.View(region);
+  ImageGeometry X_dense(5, 6, 32);
+
+  EXPECT_FALSE(X.IsDense());
+  EXPECT_EQ(parent.RowBytes(), X.RowStride());
+  EXPECT_EQ(parent.PixelBytes(), X.PixelStride());
+
+  // Vectors may be read past the end of either image
+  std::vector<int8_t> p(parent.ImageBytes() + XS3_VPU_VREG_WIDTH_BYTES);
+  for (auto &v : p) v = rng.rand<int8_t>();
+  int8_t *x = &p[parent.GetStride(region.StartVect())];
+
+  std::vector<int8_t> x_dense(X_dense.ImageBytes() + XS3_VPU_VREG_WIDTH_BYTES);
+  for (int h = 0; h < X.height; h++)
+    for (int w = 0; w < X.width; w++)
+      for (int c = 0; c < X.depth; c++)
+        X_dense.Element(x_dense.data(), h, w, c) = X.Element(x, h, w, c);
+
+  std::vector<int8_t> raw_weights(y_channels * 9 * X.depth);
+  for (auto &v : raw_weights) v = rng.rand<int8_t>();
+
+  for (auto patch : patches) {
+    std::vector<int8_t> expected =
+        convolve(patch, X_dense, x_dense.data(), raw_weights, y_channels);
+    std::vector<int8_t> actual =
+        convolve(patch, X, x, raw_weights, y_channels);
+    ASSERT_EQ(expected, actual) << "patch: " << (int)patch;
+  }
+}
+
+/*
+  The C operators which read views with conv2d_deep_ext_view() and
+  conv2d_1x1_ext_view() may be chosen for one. Those which take dense images
+  only must not be, and gathering the pixels of a channel slice must cost more
+  than reading a dense image.
+*/
+TEST_F(Test_InputView, ConvDispatcher) {
+  ImageGeometry parent(6, 6, 32);
+  ImageGeometry X = parent.View(ImageRegion(0, 0, 0, 6, 6, 16));
+  ImageGeometry Y(6, 6, 16);
+  Filter2dGeometry dense_filter(ImageGeometry(6, 6, 16), Y,
+                                WindowGeometry(1, 1, 16));
+  Filter2dGeometry view_filter(X, Y, WindowGeometry(1, 1, 16));
+
+  EXPECT_TRUE(ConvDispatcher::is_legal(ConvImpl::Conv2d1x1, dense_filter));
+  EXPECT_TRUE(ConvDispatcher::is_legal(ConvImpl::Conv2d1x1, view_filter));
+  EXPECT_TRUE(ConvDispatcher::is_legal(ConvImpl::Conv2dDeep, view_filter));
+  EXPECT_FALSE(
+      ConvDispatcher::is_legal(ConvImpl::Conv2dShallowIn, view_filter));
+  EXPECT_FALSE(ConvDispatcher::is_legal(ConvImpl::Conv2dIm2col, view_filter));
+  EXPECT_TRUE(
+      ConvDispatcher::is_legal(ConvImpl::Filter2dIm2colValid, view_filter));
+
+  ConvDispatcher dispatcher;
+  EXPECT_GT(dispatcher.estimate_cycles(ConvImpl::Conv2d1x1, view_filter),
+            dispatcher.estimate_cycles(ConvImpl::Conv2d1x1, dense_filter));
+}
+
+namespace {
+
+// A region of a 7x9x48 parent image
+struct ViewCase {
+  const char *name;
+  uint32_t row, col, channel;
+  nn_image_params_t params;
+};
+
+// A crop is read in place; a channel slice or sub-image is gathered
+const ViewCase view_cases[] = {{"crop", 1, 2, 0, {5, 6, 48}},
+                               {"channel slice", 0, 0, 16, {7, 9, 16}},
+                               {"sub-image", 1, 2, 8, {5, 6, 32}}};
+
+}  // namespace
+
+class Test_InputViewC : public Test_InputView,
+                        public ::testing::WithParamInterface<ViewCase> {
+ protected:
+  nn_image_params_t parent = {7, 9, 48};
+  nn_image_params_t x_params;
+  nn_image_strides_t x_strides;
+  const int8_t zero_point = rng.rand<int8_t>();
+
+  // The operators may read a vector past the end of either image
+  std::vector<int8_t> p, x_dense;
+  const int8_t *x;
+
+  void SetUp() override {
+    const ViewCase &v = GetParam();
+    x_params = v.params;
+    x_strides.row = parent.width * parent.channels;
+    x_strides.pixel = parent.channels;
+
+    p.resize(parent.height * x_strides.row + VPU_INT8_EPV);
+    for (auto &e : p) e = rng.rand<int8_t>();
+    x = &p[v.row * x_strides.row + v.col * x_strides.pixel + v.channel];
+
+    x_dense.resize(x_params.height * x_params.width * x_params.channels +
+                   VPU_INT8_EPV);
+    int8_t *d = x_dense.data();
+    for (unsigned h = 0; h < x_params.height; h++)
+      for (unsigned w = 0; w < x_params.width; w++)
+        for (unsigned c = 0; c < x_params.channels; c++)
+          *d++ = x[h * x_strides.row + w * x_strides.pixel + c];
+  }
+};
+
+/*
+  conv2d_deep_ext_view() of a view, with padding, must give the output of
+  conv2d_deep_ext() of a dense copy of it, for whole and partial jobs.
+*/
+TEST_P(Test_InputViewC, Conv2dDeep) {
+  const channel_count_t y_channels = 20;
+  nn_image_params_t y_params = {x_params.height, x_params.width, y_channels};
+  nn_window_params_t window = {{3, 3}, {-1, -1}, {1, 1}, {1, 1}};
+  const nn_conv2d_job_params_t jobs[] = {
+      {{0, 0, 0}, {(int)y_params.height, (int)y_params.width, y_channels}},
+      {{1, 2, 16}, {3, 3, 4}}};
+
+  // conv2d_deep may read a vector before and after K
+  std::vector<int8_t> K_mem(VPU_INT8_EPV + y_channels * 9 * x_params.channels +
+                            VPU_INT8_EPV);
+  for (auto &v : K_mem) v = rng.rand<int8_t>();
+  int8_t *K = &K_mem[VPU_INT8_EPV];
+  std::vector<nn_bso_block_t> bso = make_bso(rng, y_channels);
+  std::vector<int32_t> scratch(
+      (conv2d_deep_view_scratch_bytes(&x_params, &window) + 3) / 4);
+
+  for (auto &job : jobs) {
+    std::vector<int8_t> expected(y_params.height * y_params.width *
+                                 y_channels);
+    std::vector<int8_t> actual(expected.size());
+    conv2d_deep_ext(expected.data(), x_dense.data(), K, bso.data(),
+                    zero_point, &x_params, &y_params, &window, &job,
+                    (nn_conv2d_deep_flags_e)0);
+    conv2d_deep_ext_view(actual.data(), x, K, bso.data(), zero_point,
+                         &x_params, &y_params, &window, &job,
+                         CONV2D_DEEP_FLAG_INPUT_VIEW, &x_strides,
+                         (int8_t *)scratch.data());
+    ASSERT_EQ(expected, actual) << GetParam().name;
+  }
+}
+
+/*
+  conv2d_1x1_ext_view() of a view must give the output of conv2d_1x1_ext() of
+  a dense copy of it, including for jobs which start and end mid-row.
+*/
+TEST_P(Test_InputViewC, Conv2d1x1) {
+  const channel_count_t y_channels = 20;
+  nn_image_params_t y_params = {x_params.height, x_params.width, y_channels};
+  const uint32_t pixels = y_params.height * y_params.width;
+  const nn_conv2d_1x1_job_params_t jobs[] = {{{0, 0, 0}, {pixels, y_channels}},
+                                             {{1, 2, 16}, {10, 4}}};
+
+  std::vector<int8_t> K(y_channels * x_params.channels + VPU_INT8_EPV);
+  for (auto &v : K) v = rng.rand<int8_t>();
+  std::vector<nn_bso_block_t> bso = make_bso(rng, y_channels);
+  std::vector<int32_t> scratch(
+      (x_params.width * x_params.channels + VPU_INT8_EPV + 3) / 4);
+
+  for (auto &job : jobs) {
+    std::vector<int8_t> expected(pixels * y_channels);
+    std::vector<int8_t> actual(expected.size());
+    conv2d_1x1_ext(expected.data(), x_dense.data(), K.data(), bso.data(),
+                   &x_params, &y_params, &job, (nn_conv2d_1x1_flags_e)0);
+    conv2d_1x1_ext_view(actual.data(), x, K.data(), bso.data(), &x_params,
+                        &y_params, &job, CONV2D_1X1_FLAG_INPUT_VIEW,
+                        &x_strides, (nn_image_t *)scratch.data());
+    ASSERT_EQ(expected, actual) << GetParam().name;
+  }
+}
+
+/*
+  conv2d_depthwise_ext_view() of a view, with padding, must give the output of
+  conv2d_depthwise_ext() of a dense copy of it, for whole and partial jobs.
+*/
+TEST_P(Test_InputViewC, Conv2dDepthwise) {
+  const channel_count_t channels = x_params.channels;
+  nn_window_params_t window = {{3, 3}, {-1, -1}, {1, 1}, {1, 1}};
+  const nn_conv2d_job_params_t jobs[] = {
+      {{0, 0, 0}, {(int)x_params.height, (int)x_params.width, (int)channels}},
+      {{1, 2, 0}, {3, 3, 16}}};
+
+  std::vector<int8_t> K(9 * channels + VPU_INT8_EPV);
+  for (auto &v : K) v = rng.rand<int8_t>();
+  std::vector<nn_bso_block_t> bso = make_bso(rng, channels);
+
+  for (auto &job : jobs) {
+    std::vector<int8_t> expected(x_params.height * x_params.width * channels);
+    std::vector<int8_t> actual(expected.size());
+    conv2d_depthwise_ext(expected.data(), x_dense.data(), K.data(), bso.data(),
+                         zero_point, &x_params, &x_params, &window, &job,
+                         (nn_conv2d_depthwise_flags_e)0);
+    conv2d_depthwise_ext_view(actual.data(), x, K.data(), bso.data(),
+                              zero_point, &x_params, &x_params, &window, &job,
+                              CONV2D_DEPTHWISE_FLAG_INPUT_VIEW, &x_strides);
+    ASSERT_EQ(expected, actual) << GetParam().name;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Views, Test_InputViewC,
+                         ::testing::ValuesIn(view_cases));
+
+}  // namespace nn
@@ -0,0 +1,160 @@
+#include <array>
+#include <cstring>
+#include <vector>
+
+#include "InteriorBorderPlanner.hpp"
+#include "OutputTransformFixture.hpp"
+#include "Rand.hpp"
+#include "gtest/gtest.h"
+
+namespace nn {
+
+static auto rng = test::Rand(24680);
+
+class Test_InteriorBorderPlanner : public ::testing::Test,
+                                   protected test::OutputTransformFixture {
+ protected:
+  static std::vector<Filter2dGeometry> make_filters(int x_channels,
+                                                    int y_channels) {
+    std::vector<Filter2dGeometry> filters;
+    ImageGeometry X(7, 9, x_channels);
+
+    // 3x3, 'same' padding
+    filters.emplace_back(X, ImageGeometry(7, 9, y_channels),
+                         WindowGeometry(3, 3, x_channels, -1, -1));
+    // 5x3, padded on the top and left only
+    filters.emplace_back(X, ImageGeometry(5, 8, y_channels),
+                         WindowGeometry(5, 3, x_channels, -2, -1));
+    // 3x3, stride 2
+    filters.emplace_back(X, ImageGeometry(4, 5, y_channels),
+                         WindowGeometry(3, 3, x_channels, -1, -1, 2, 2));
+    // 3x3, dilation 2
+    filters.emplace_back(
+        X, ImageGeometry(7, 9, y_channels),
+        WindowGeometry(3, 3, x_channels, -2, -2, 1, 1, 0, 2, 2));
+    // Unpadded
+    filters.emplace_back(X, ImageGeometry(5, 7, y_channels),
+                         WindowGeometry(3, 3, x_channels));
+    // No interior
+    filters.emplace_back(X, ImageGeometry(1, 3, y_channels),
+                         WindowGeometry(9, 9, x_channels, -1, -1));
+    return filters;
+  }
+};
+
+/*
+  The regions must cover every output pixel once, with no interior window
+  reaching into the padding and every border window doing so.
+*/
+TEST_F(Test_InteriorBorderPlanner, Split) {
+  for (auto &filter : make_filters(4, 16)) {
+    InteriorBorderPlanner::Regions regions =
+        InteriorBorderPlanner::split(filter);
+
+    const ImageGeometry &Y = filter.output;
+    std::vector<int> covered(Y.height * Y.width, 0);
+
+    for (int row = 0; row < Y.height; row++) {
+      for (int col = 0; col < Y.width; col++) {
+        const bool padded =
+            filter.GetWindow(row, col, 0).Padding().HasPadding();
+
+        if (regions.interior.Within(row, col, 0)) {
+          covered[row * Y.width + col]++;
+          EXPECT_FALSE(padded) << filter << " | " << row << ", " << col;
+        }
+
+        for (auto &border : regions.border) {
+          if (border.Within(row, col, 0)) {
+            covered[row * Y.width + col]++;
+            EXPECT_TRUE(padded) << filter << " | " << row << ", " << col;
+          }
+        }
+      }
+    }
+
+    for (int i = 0; i < (int)covered.size(); i++)
+      EXPECT_EQ(1, covered[i]) << filter << " | " << i;
+
+    for (auto &border : regions.border)
+      EXPECT_EQ(Y.depth, border.shape.depth) << filter;
+  }
+}
+
+/*
+  The kernels must produce exactly the output of a single ImToColPadded filter
+  over the whole output image.
+*/
+TEST_F(Test_InteriorBorderPlanner, MatchesPadded) {
+  for (int deref = 0; deref <= 1; deref++) {
+    // MatMulDirectFn only computes whole channel groups
+    const int x_channels = deref ? 32 : 8;
+    const int y_channels = deref ? 32 : 20;
+
+    for (auto &filter : make_filters(x_channels, y_channels)) {
+      const ImageGeometry &X = filter.input;
+      const ImageGeometry &Y = filter.output;
+      const WindowGeometry &K = filter.window;
+      const int8_t pad_value = rng.rand<int8_t>();
+
+      std::vector<int8_t> x(X.ImageBytes() + XS3_VPU_VREG_WIDTH_BYTES);
+      for (auto &v : x) v = rng.rand<int8_t>();
+
+      std::array<int, 4> shape = {y_channels, K.shape.height, K.shape.width,
+                                  x_channels};
+      std::vector<int8_t> raw_weights(y_channels * K.shape.height *
+                                      K.shape.width * x_channels);
+      for (auto &v : raw_weights) v = rng.rand<int8_t>();
+      Conv2dReorderedWeights rw =
+          MatMulInt8::reorder_kernel_weights(raw_weights.data(), shape, 8, 0);
+
+      MatMulInt8::Params mm_params(
+          y_channels, K.shape.height * K.shape.width * x_channels,
+          rw.weights.data());
+      MatMulInt8 mm(&mm_params);
+      MatMulDirectFn::Params direct_params(X, K, x_channels,
+                                           rw.weights.data());
+      MatMulDirectFn direct(&direct_params);
+
+      OT_int8::Params ot_params = make_ot_params(y_channels);
+      OT_int8 ot(&ot_params);
+
+      // A single padded filter
+      ImToColPadded::Params im2col_params(X, K, filter.Padding(), x_channels,
+                                          pad_value);
+      ImToColPadded im2col(&im2col_params);
+      std::vector<int32_t> scratch((im2col.get_scratch_bytes() + 3) / 4);
+      ImageRegion region(0, 0, 0, Y.height, Y.width, Y.depth);
+      AbstractKernel::Params kparams(Y, region, VPU_INT8_ACC_PERIOD);
+      Filter2D padded_filter(&kparams, &im2col, &mm, &ot,
+                             (int8_t *)scratch.data());
+
+      std::vector<int8_t> expected(Y.ImageBytes());
+      padded_filter.execute(expected.data(), x.data());
+
+      // The planned kernels, with the scratch memory sized from them
+      const InteriorCopy interior_copy =
+          deref ? InteriorCopy::Deref : InteriorCopy::ImToColValid;
+      AggregateFn *interior_agg = deref ? (AggregateFn *)&direct : &mm;
+
+      InteriorBorderPlanner sizing(filter, pad_value, interior_copy,
+                                   interior_agg, &mm, &ot);
+      std::vector<int32_t> plan_scratch((sizing.get_scratch_bytes() + 3) / 4);
+      InteriorBorderPlanner plan(filter, pad_value, interior_copy,
+                                 interior_agg, &mm, &ot,
+                                 (int8_t *)plan_scratch.data());
+
+      int padded_pixels = 0;
+      for (auto &kernel : plan.get_kernels())
+        if (kernel.padded) padded_pixels += kernel.region.PixelCount();
+      EXPECT_EQ(filter.Padding().HasPadding(), padded_pixels > 0) << filter;
+
+      std::vector<int8_t> actual(Y.ImageBytes());
+      plan.execute(actual.data(), x.data());
+
+      ASSERT_EQ(expected, actual) << filter;
+    }
+  }
+}
+
+}  // namespace nn
@@ -0,0 +1,124 @@
+#include <cstring>
+#include <vector>
+
+#include "OutputTransformFixture.hpp"
+#include "Rand.hpp"
+#include "gtest/gtest.h"
+#include "nn_operator.h"
+
+namespace nn {
+
+static auto rng = test::Rand(24681);
+
+class Test_LutActivation : public ::testing::Test,
+                           protected test::OutputTransformFixture {
+ protected:
+  // Look up the outputs of `job` in place, as lookup8() would
+  static void lookup_job(std::vector<int8_t> &y, const nn_image_params_t &p,
+                         const nn_conv2d_job_params_t &job,
+                         const std::vector<uint8_t> &lut) {
+    for (int r = job.start.rows; r < job.start.rows + job.size.rows; r++)
+      for (int c = job.start.cols; c < job.start.cols + job.size.cols; c++) {
+        int8_t *pix = &y[(r * p.width + c) * p.channels + job.start.channels];
+        lookup8((uint8_t *)pix, (const uint8_t *)pix, lut.data(), 0,
+                job.size.channels);
+      }
+  }
+
+  static void lookup_job(std::vector<int8_t> &y, const nn_image_params_t &p,
+                         const nn_conv2d_1x1_job_params_t &job,
+                         const std::vector<uint8_t> &lut) {
+    const int start = job.start.rows * p.width + job.start.cols;
+    for (int i = start; i < start + (int)job.size.pixels; i++) {
+      int8_t *pix = &y[i * p.channels + job.start.channels];
+      lookup8((uint8_t *)pix, (const uint8_t *)pix, lut.data(), 0,
+              job.size.channels);
+    }
+  }
+};
+
+/*
+  conv2d_deep_ext_lut(), conv2d_1x1_ext_lut() and conv2d_depthwise_ext_lut()
+  must give the outputs of conv2d_deep_ext(), conv2d_1x1_ext() and
+  conv2d_depthwise_ext() followed by lookup8(), for whole images and for jobs
+  computing part of one.
+*/
+TEST_F(Test_LutActivation, Conv2dExt) {
+  const channel_count_t x_channels = 16, y_channels = 36;
+
+  nn_image_params_t x_params = {5, 6, x_channels};
+  nn_image_params_t y_params = {5, 6, y_channels};
+  nn_image_params_t dw_params = {5, 6, x_channels};
+  nn_window_params_t window = {{3, 3}, {-1, -1}, {1, 1}, {1, 1}};
+  const int pixels = x_params.height * x_params.width;
+  const int8_t zero_point = rng.rand<int8_t>();
+
+  std::vector<uint8_t> lut(1 << 8);
+  for (auto &v : lut) v = rng.rand<uint8_t>();
+
+  // The operators may read a vector past the end of X and K. conv2d_deep also
+  // reads a vector before its K, so K_deep starts VPU_INT8_EPV bytes in.
+  std::vector<int8_t> x(pixels * x_channels + VPU_INT8_EPV);
+  for (auto &v : x) v = rng.rand<int8_t>();
+  std::vector<int8_t> K_deep_mem(VPU_INT8_EPV + y_channels * 9 * x_channels +
+                                 VPU_INT8_EPV);
+  int8_t *K_deep = &K_deep_mem[VPU_INT8_EPV];
+  std::vector<int8_t> K_pw(y_channels * x_channels + VPU_INT8_EPV);
+  std::vector<int8_t> K_dw(9 * x_channels + VPU_INT8_EPV);
+  for (auto &v : K_deep_mem) v = rng.rand<int8_t>();
+  for (auto &v : K_pw) v = rng.rand<int8_t>();
+  for (auto &v : K_dw) v = rng.rand<int8_t>();
+  std::vector<nn_bso_block_t> bso = make_bso(rng, y_channels);
+  std::vector<nn_bso_block_t> bso_dw = make_bso(rng, x_channels);
+
+  const nn_conv2d_job_params_t deep_jobs[] = {
+      {{0, 0, 0}, {5, 6, y_channels}}, {{1, 2, 16}, {3, 3, 20}}};
+  const nn_conv2d_job_params_t dw_jobs[] = {{{0, 0, 0}, {5, 6, x_channels}},
+                                            {{2, 1, 0}, {2, 4, 8}}};
+  const nn_conv2d_1x1_job_params_t pw_jobs[] = {
+      {{0, 0, 0}, {(uint32_t)pixels, y_channels}}, {{1, 4, 16}, {15, 16}}};
+
+  for (int j = 0; j < 2; j++) {
+    {
+      std::vector<int8_t> expected(pixels * y_channels);
+      std::vector<int8_t> actual(pixels * y_channels);
+      conv2d_deep_ext(expected.data(), x.data(), K_deep, bso.data(),
+                      zero_point, &x_params, &y_params, &window, &deep_jobs[j],
+                      (nn_conv2d_deep_flags_e)0);
+      lookup_job(expected, y_params, deep_jobs[j], lut);
+      conv2d_deep_ext_lut(actual.data(), x.data(), K_deep, bso.data(),
+                          zero_point, &x_params, &y_params, &window,
+                          &deep_jobs[j], (nn_conv2d_deep_flags_e)0,
+                          lut.data());
+      ASSERT_EQ(expected, actual) << "deep job: " << j;
+    }
+    {
+      std::vector<int8_t> expected(pixels * y_channels);
+      std::vector<int8_t> actual(pixels * y_channels);
+      conv2d_1x1_ext(expected.data(), x.data(), K_pw.data(), bso.data(),
+                     &x_params, &y_params, &pw_jobs[j],
+                     (nn_conv2d_1x1_flags_e)0);
+      lookup_job(expected, y_params, pw_jobs[j], lut);
+      conv2d_1x1_ext_lut(actual.data(), x.data(), K_pw.data(), bso.data(),
+                         &x_params, &y_params, &pw_jobs[j],
+                         (nn_conv2d_1x1_flags_e)0, lut.data());
+      ASSERT_EQ(expected, actual) << "1x1 job: " << j;
+    }
+    {
+      std::vector<int8_t> expected(pixels * x_channels);
+      std::vector<int8_t> actual(pixels * x_channels);
+      conv2d_depthwise_ext(expected.data(), x.data(), K_dw.data(),
+                           bso_dw.data(), zero_point, &x_params, &dw_params,
+                           &window, &dw_jobs[j],
+                           (nn_conv2d_depthwise_flags_e)0);
+      lookup_job(expected, dw_params, dw_jobs[j], lut);
+      conv2d_depthwise_ext_lut(actual.data(), x.data(), K_dw.data(),
+                               bso_dw.data(), zero_point, &x_params,
+                               &dw_params, &window, &dw_jobs[j],
+                               (nn_conv2d_depthwise_flags_e)0, lut.data());
+      ASSERT_EQ(expected, actual) << "depthwise job: " << j;
+    }
+  }
+}
+
+}  // namespace nn
@@ -1,5 +1,9 @@
+#include <algorithm>
+#include <array>
 #include <cstring>
+#include <vector>
 
+#include "AggregateFn.hpp"
 #include "MemCpyFn.hpp"
 #include "Rand.hpp"
 #include "gtest/gtest.h"
@@ -269,6 +273,80 @@ TEST_F(Test_ImToColPadded, BasicTest) {
   }
 }
 
+class Test_ImToColPaddedInt16 : public ::testing::Test {};
+
+/*
+  The int16 patch must hold the elements of an explicitly padded copy of the
+  input, with a padding value whose two bytes differ, followed by zeros.
+*/
+TEST_F(Test_ImToColPaddedInt16, BasicTest) {
+  const int16_t pad_val = -12345;
+
+  for (int x_channels = 1; x_channels <= 9; x_channels += 4) {
+    for (int k_size = 1; k_size <= 3; ++k_size) {
+      for (int dilation = 1; dilation <= 2; ++dilation) {
+        for (int stride = 1; stride <= 2; ++stride) {
+          for (int p = 0; p <= 1; ++p) {
+            const int x_height = 4, x_width = 5;
+            padding_t padding = {(int16_t)p, (int16_t)p, (int16_t)p,
+                                 (int16_t)p};
+            const int padded_x_height = x_height + 2 * p;
+            const int padded_x_width = x_width + 2 * p;
+
+            const int output_height = CONV2D_OUTPUT_LENGTH(
+                padded_x_height, k_size, dilation, stride);
+            const int output_width =
+                CONV2D_OUTPUT_LENGTH(padded_x_width, k_size, dilation, stride);
+            if (output_height <= 0 || output_width <= 0) continue;
+
+            ImageGeometry X(x_height, x_width, x_channels, sizeof(int16_t));
+            WindowGeometry K(k_size, k_size, 0, 0, 0, stride, stride, 0,
+                             dilation, dilation);
+
+            ImToColPaddedInt16::Params params(X, K, padding, x_channels,
+                                              pad_val);
+            ImToColPaddedInt16 cpy(&params);
+
+            std::vector<int16_t> X_mem(x_height * x_width * x_channels +
+                                       cpy.get_overread_bytes() / 2);
+            for (auto &x : X_mem) x = rng.rand<int16_t>();
+
+            std::vector<int16_t> T(cpy.get_scratch_bytes() / 2);
+            const int patch_elements = k_size * k_size * x_channels;
+            ASSERT_EQ(patch_elements + VPU_INT16_EPV, (int)T.size());
+
+            for (int output_h = 0; output_h < output_height; ++output_h) {
+              for (int output_w = 0; output_w < output_width; ++output_w) {
+                std::fill(T.begin(), T.end(), 0x5555);
+                cpy.memcopy_fn((int8_t *)T.data(), (int8_t *)X_mem.data(),
+                               output_h, output_w, 0);
+
+                int t_idx = 0;
+                for (int kh = 0; kh < k_size; ++kh) {
+                  for (int kw = 0; kw < k_size; ++kw) {
+                    const int h = output_h * stride + kh * dilation - p;
+                    const int w = output_w * stride + kw * dilation - p;
+                    const bool pad =
+                        h < 0 || h >= x_height || w < 0 || w >= x_width;
+
+                    for (int c = 0; c < x_channels; ++c) {
+                      const int16_t x =
+                          pad ? pad_val
+                              : X_mem[(h * x_width + w) * x_channels + c];
+                      ASSERT_EQ(x, T[t_idx++]);
+                    }
+                  }
+                }
+                for (; t_idx < (int)T.size(); ++t_idx) ASSERT_EQ(0, T[t_idx]);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
 class Test_DerefInputFn : public ::testing::Test {};
 
 TEST_F(Test_DerefInputFn, BasicTest) {
@@ -319,4 +397,203 @@ TEST_F(Test_DerefInputFn, BasicTest) {
   }
 }
 
+class Test_ImToColSliding : public ::testing::Test {
+ protected:
+  /*
+    Walks the output image row by row as AbstractKernel::execute() does,
+    checking every patch against the window of the input. The walk is repeated
+    after changing the input image in place, which must not reuse any column
+    copied during the previous one.
+  */
+  void check_walk(const ImageGeometry &X, const WindowGeometry &K,
+                  int window_count) {
+    const int8_t pad_val = 0x55;
+    const int pad = -K.start.col;
+
+    const int output_height =
+        CONV2D_OUTPUT_LENGTH(X.height + 2 * pad, K.shape.height, 1, 1);
+    const int output_width =
+        CONV2D_OUTPUT_LENGTH(X.width + 2 * pad, K.shape.width,
+                             K.dilation.col, K.stride.col);
+
+    if (output_height <= 0 || output_width <= 0) return;
+
+    ImageGeometry Y(output_height, output_width, 4);
+    ImToColSliding::Params p(Filter2dGeometry(X, Y, K), pad_val,
+                             window_count);
+    ImToColSliding cpy(&p);
+
+    // The scratch memory is only valid once reset
+    std::vector<int32_t> scratch((cpy.get_scratch_bytes() + 3) / 4);
+    for (auto &v : scratch) v = rng.rand<int32_t>();
+    int8_t *T = (int8_t *)scratch.data();
+    cpy.reset_scratch(T);
+    const int patch_bytes = K.shape.height * K.shape.width * X.depth;
+
+    std::vector<int8_t> X_mem(X.ImageBytes());
+
+    for (int run = 0; run < 2; ++run) {
+      for (auto &v : X_mem) v = rng.rand<int8_t>();
+
+      for (int h = 0; h < output_height; ++h) {
+        for (int w = 0; w < output_width; ++w) {
+          int8_t *patch = cpy.memcopy_fn(T, X_mem.data(), h, w, 0);
+
+          ASSERT_GE(patch, T);
+          ASSERT_LE(patch + patch_bytes + XS3_VPU_VREG_WIDTH_BYTES,
+                    T + cpy.get_scratch_bytes());
+
+          int t_idx = 0;
+          for (int kw = 0; kw < K.shape.width; ++kw) {
+            for (int kh = 0; kh < K.shape.height; ++kh) {
+              const int row = h + kh - pad;
+              const int col = w * K.stride.col + kw * K.dilation.col - pad;
+              const bool valid =
+                  row >= 0 && row < X.height && col >= 0 && col < X.width;
+              for (int kc = 0; kc < X.depth; ++kc) {
+                const int8_t x = valid ? X_mem[X.Index(row, col, kc)] : pad_val;
+                ASSERT_EQ(x, patch[t_idx++])
+                    << "X: " << X << " | K: " << K << " | h: " << h
+                    << " | w: " << w << " | kh: " << kh << " | kw: " << kw;
+              }
+            }
+          }
+          for (int i = 0; i < XS3_VPU_VREG_WIDTH_BYTES; ++i)
+            ASSERT_EQ(0, patch[t_idx++]);
+        }
+      }
+    }
+  }
+};
+
+TEST_F(Test_ImToColSliding, BasicTest) {
+  const int x_channels = 8;
+
+  for (int x_height = 1; x_height <= 4; ++x_height) {
+    for (int x_width = 1; x_width <= 7; ++x_width) {
+      for (int k_height = 1; k_height <= 3; ++k_height) {
+        for (int k_width = 1; k_width <= 4; ++k_width) {
+          for (int k_h_stride = 1; k_h_stride <= 2; ++k_h_stride) {
+            for (int k_h_dilation = 1; k_h_dilation <= 2; ++k_h_dilation) {
+              for (int pad = 0; pad <= 1; ++pad) {
+                ImageGeometry X(x_height, x_width, x_channels);
+                WindowGeometry K(k_height, k_width, x_channels, -pad, -pad, 1,
+                                 k_h_stride, 0, 1, k_h_dilation);
+                check_walk(X, K, 2);
+                check_walk(X, K, 3);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+/*
+  A scratch buffer last used by another handler for the previous pixel of the
+  same row and image must not have its columns reused once reset, as they were
+  copied with that handler's padding value.
+*/
+TEST_F(Test_ImToColSliding, ResetScratch) {
+  ImageGeometry X(4, 6, 8);
+  ImageGeometry Y(4, 6, 4);
+  WindowGeometry K(3, 3, 8, -1, -1);
+  Filter2dGeometry filter(X, Y, K);
+
+  ImToColSliding::Params other_params(filter, 0x11);
+  ImToColSliding other(&other_params);
+  ImToColSliding::Params params(filter, 0x22);
+  ImToColSliding cpy(&params);
+
+  std::vector<int8_t> X_mem(X.ImageBytes());
+  for (auto &v : X_mem) v = rng.rand<int8_t>();
+
+  std::vector<int32_t> scratch((cpy.get_scratch_bytes() + 3) / 4);
+  int8_t *T = (int8_t *)scratch.data();
+  other.reset_scratch(T);
+  other.memcopy_fn(T, X_mem.data(), 0, 2, 0);
+
+  cpy.reset_scratch(T);
+  int8_t *patch = cpy.memcopy_fn(T, X_mem.data(), 0, 3, 0);
+
+  // The top row of the window is in the padding
+  const int column_bytes = K.shape.height * X.depth;
+  for (int kw = 0; kw < K.shape.width; ++kw)
+    for (int kc = 0; kc < X.depth; ++kc)
+      ASSERT_EQ(0x22, patch[kw * column_bytes + kc]) << "kw: " << kw;
+}
+
+/*
+  Aggregating a sliding patch with transposed weights must give the
+  accumulators of aggregating an ImToColPadded patch with the original ones.
+*/
+TEST_F(Test_ImToColSliding, MatMulInt8) {
+  const int x_channels = 12;
+  const int y_channels = 20;
+
+  ImageGeometry X(5, 9, x_channels);
+  ImageGeometry Y(5, 9, y_channels);
+  WindowGeometry K(3, 5, x_channels, -1, -2);
+  Filter2dGeometry filter(X, Y, K);
+  const int8_t pad_val = rng.rand<int8_t>();
+
+  std::vector<int8_t> X_mem(X.ImageBytes());
+  for (auto &v : X_mem) v = rng.rand<int8_t>();
+
+  std::array<int, 4> shape = {y_channels, 3, 5, x_channels};
+  std::vector<int8_t> raw_weights(y_channels * 3 * 5 * x_channels);
+  for (auto &v : raw_weights) v = rng.rand<int8_t>();
+
+  std::vector<int8_t> transposed =
+      ImToColSliding::transpose_kernel_weights(raw_weights.data(), shape);
+  std::array<int, 4> transposed_shape = {y_channels, 5, 3, x_channels};
+
+  Conv2dReorderedWeights weights =
+      MatMulInt8::reorder_kernel_weights(raw_weights.data(), shape, 8, 0);
+  Conv2dReorderedWeights sliding_weights = MatMulInt8::reorder_kernel_weights(
+      transposed.data(), transposed_shape, 8, 0);
+
+  const int bytes_per_kernel_channel = 3 * 5 * x_channels;
+  MatMulInt8::Params mm_params(y_channels, bytes_per_kernel_channel,
+                               weights.weights.data());
+  MatMulInt8::Params sliding_mm_params(y_channels, bytes_per_kernel_channel,
+                                       sliding_weights.weights.data());
+  MatMulInt8 mm(&mm_params);
+  MatMulInt8 sliding_mm(&sliding_mm_params);
+
+  padding_t padding = filter.Padding();
+  ImToColPadded::Params padded_params(X, K, padding, x_channels, pad_val);
+  ImToColPadded padded(&padded_params);
+  ImToColSliding::Params sliding_params(filter, pad_val);
+  ImToColSliding sliding(&sliding_params);
+
+  std::vector<int32_t> padded_scratch((padded.get_scratch_bytes() + 3) / 4);
+  std::vector<int32_t> sliding_scratch((sliding.get_scratch_bytes() + 3) / 4);
+  sliding.reset_scratch((int8_t *)sliding_scratch.data());
+
+  for (int h = 0; h < Y.height; ++h) {
+    for (int w = 0; w < Y.width; ++w) {
+      int8_t *patch =
+          padded.memcopy_fn((int8_t *)padded_scratch.data(), X_mem.data(), h, w,
+                            0);
+      int8_t *sliding_patch = sliding.memcopy_fn(
+          (int8_t *)sliding_scratch.data(), X_mem.data(), h, w, 0);
+
+      for (int group = 0; group * VPU_INT8_ACC_PERIOD < y_channels; ++group) {
+        VPURingBuffer A, B;
+        mm.aggregate_fn(&A, patch, group);
+        sliding_mm.aggregate_fn(&B, sliding_patch, group);
+
+        const int count =
+            std::min(y_channels - group * VPU_INT8_ACC_PERIOD,
+                     (int)VPU_INT8_ACC_PERIOD);
+        for (int ch = 0; ch < count; ++ch)
+          ASSERT_EQ(A.GetAccu(ch), B.GetAccu(ch))
+              << "h: " << h << " | w: " << w << " | ch: " << ch;
+      }
+    }
+  }
+}
+
 }  // namespace nn
@@ -0,0 +1,155 @@
+#include <vector>
+
+#include "MemoryPlanner.hpp"
+#include "Rand.hpp"
+#include "gtest/gtest.h"
+
+namespace nn {
+
+static auto rng = test::Rand(4321);
+
+class Test_MemoryPlanner : public ::testing::Test {};
+
+TEST_F(Test_MemoryPlanner, ChainReusesMemory) {
+  MemoryPlanner planner;
+
+  // A 5 layer chain: each activation is only live for two operators
+  std::vector<MemoryPlanner::TensorId> t;
+  t.push_back(planner.add_tensor(ImageGeometry(16, 16, 32)));
+  for (int i = 0; i < 5; ++i) {
+    t.push_back(planner.add_tensor(ImageGeometry(16, 16, 32)));
+    planner.add_op({t[i]}, {t[i + 1]});
+  }
+  planner.mark_output(t.back());
+
+  auto plan = planner.plan();
+
+  EXPECT_EQ(2 * 16 * 16 * 32, plan.arena_bytes);
+  EXPECT_EQ(6 * 16 * 16 * 32, planner.get_unshared_bytes());
+  for (int i = 0; i < 5; ++i)
+    EXPECT_NE(plan.tensor_offsets[t[i]], plan.tensor_offsets[t[i + 1]]);
+}
+
+TEST_F(Test_MemoryPlanner, ScratchAndOverread) {
+  MemoryPlanner planner;
+
+  auto x = planner.add_tensor(100);
+  auto y = planner.add_tensor(ImageGeometry(4, 4, 4));
+  auto z = planner.add_tensor(ImageGeometry(4, 4, 4));
+  int op0 = planner.add_op({x}, {y}, 40, 32);
+  int op1 = planner.add_op({y}, {z});
+  planner.mark_output(z);
+
+  auto plan = planner.plan();
+
+  EXPECT_EQ(-1, plan.scratch_offsets[op1]);
+  EXPECT_EQ(nullptr, plan.scratch((int8_t *)nullptr + 64, op1));
+  ASSERT_NE(-1, plan.scratch_offsets[op0]);
+  EXPECT_EQ(0, plan.scratch_offsets[op0] % MemoryPlanner::Alignment);
+
+  // x is followed by at least its overread within the arena
+  EXPECT_LE(plan.tensor_offsets[x] + 100 + 32, plan.arena_bytes);
+}
+
+TEST_F(Test_MemoryPlanner, MemCpyFnOp) {
+  ImageGeometry X(5, 5, 8);
+  WindowGeometry K(3, 3, 1, -1, -1);
+  ImageGeometry Y(5, 5, 16);
+
+  ImToColPadded::Params params(Filter2dGeometry(X, Y, K), 0, 8);
+  ImToColPadded handler(&params);
+
+  MemoryPlanner planner;
+  auto x = planner.add_tensor(X);
+  auto y = planner.add_tensor(Y);
+  int op = planner.add_op(&handler, x, y);
+  auto plan = planner.plan();
+
+  ASSERT_NE(-1, plan.scratch_offsets[op]);
+  EXPECT_GE(plan.arena_bytes,
+            X.ImageBytes() + handler.get_overread_bytes() + Y.ImageBytes() +
+                handler.get_scratch_bytes());
+}
+
+TEST_F(Test_MemoryPlanner, RandomGraphs) {
+  for (int iter = 0; iter < 200; ++iter) {
+    MemoryPlanner planner;
+
+    const int op_count = rng.rand<int>(1, 12);
+    const int input_count = rng.rand<int>(1, 3);
+
+    std::vector<int> bytes;
+    std::vector<int> overread;
+    std::vector<int> first, last;
+    std::vector<int> scratch_bytes;
+
+    auto new_tensor = [&](int producer) {
+      int b = rng.rand<int>(1, 1000);
+      bytes.push_back(b);
+      overread.push_back(0);
+      first.push_back(producer);
+      last.push_back(producer);
+      return planner.add_tensor(b);
+    };
+
+    for (int i = 0; i < input_count; ++i) new_tensor(0);
+
+    for (int op = 0; op < op_count; ++op) {
+      std::vector<MemoryPlanner::TensorId> inputs;
+      const int available = (int)bytes.size();
+      const int n_inputs = rng.rand<int>(1, 2);
+      for (int i = 0; i < n_inputs; ++i) {
+        int t = rng.rand<int>(0, available - 1);
+        inputs.push_back(t);
+        last[t] = op;
+      }
+      int scratch = (rng.rand<int>(0, 1)) ? rng.rand<int>(1, 500) : 0;
+      int ovr = rng.rand<int>(0, 1) * 32;
+      for (auto t : inputs) overread[t] = std::max(overread[t], ovr);
+      scratch_bytes.push_back(scratch);
+
+      auto out = new_tensor(op);
+      planner.add_op(inputs, {out}, scratch, ovr);
+    }
+    planner.mark_output((int)bytes.size() - 1);
+    last.back() = op_count - 1;
+
+    auto plan = planner.plan();
+
+    // Gather every buffer and check that no two live buffers collide
+    struct Span {
+      int begin, end, first, last;
+    };
+    std::vector<Span> spans;
+    for (int t = 0; t < (int)bytes.size(); ++t) {
+      int offset = plan.tensor_offsets[t];
+      ASSERT_EQ(0, offset % MemoryPlanner::Alignment);
+      ASSERT_LE(offset + bytes[t] + overread[t], plan.arena_bytes);
+      spans.push_back(Span{offset, offset + bytes[t], first[t], last[t]});
+    }
+    for (int op = 0; op < op_count; ++op) {
+      if (scratch_bytes[op] == 0) {
+        ASSERT_EQ(-1, plan.scratch_offsets[op]);
+        continue;
+      }
+      int offset = plan.scratch_offsets[op];
+      ASSERT_EQ(0, offset % MemoryPlanner::Alignment);
+      ASSERT_LE(offset + scratch_bytes[op], plan.arena_bytes);
+      spans.push_back(Span{offset, offset + scratch_bytes[op], op, op});
+    }
+
+    for (int i = 0; i < (int)spans.size(); ++i) {
+      for (int j = i + 1; j < (int)spans.size(); ++j) {
+        auto &a = spans[i];
+        auto &b = spans[j];
+        bool live = a.first <= b.last && b.first <= a.last;
+        bool shared = a.begin < b.end && b.begin < a.end;
+        ASSERT_FALSE(live && shared) << "iter " << iter;
+      }
+    }
+
+    EXPECT_LE(plan.arena_bytes, planner.get_unshared_bytes() + 32);
+  }
+}
+
+}  // namespace nn
@@ -1,6 +1,9 @@
+#include <array>
 #include <cmath>
 #include <random>
 
+#include "Filter2D.hpp"
+#include "OutputTransformFixture.hpp"
 #include "OutputTransformFn.hpp"
 #include "Rand.hpp"
 #include "gtest/gtest.h"
@@ -151,4 +154,369 @@ TEST_F(Test_OT_int8, BasicTest) {
     }
   }
 }
+
+class Test_OT_int8_residual : public ::testing::Test,
+                              protected test::OutputTransformFixture {};
+
+TEST_F(Test_OT_int8_residual, MatchesAddElementwise) {
+  // Multiples of 4 keep each pixel word aligned, as the VPU requires
+  for (int output_ch_count = 4; output_ch_count <= 40; output_ch_count += 4) {
+    for (int itt = 0; itt < 1 << 5; itt++) {
+      std::vector<double> f_biases(output_ch_count, 0);
+      std::vector<double> f_multipliers(output_ch_count, 0);
+      std::vector<int32_t> accu_min(output_ch_count, 0);
+      std::vector<int32_t> accu_max(output_ch_count, 0);
+
+      pick_accu_range(accu_min, accu_max);
+      pick_activation_params(f_multipliers, f_biases, accu_max, accu_min);
+
+      QuantisationParams qp = OutputTransformFnInt8::quantise_activation(
+          f_multipliers, f_biases, accu_min, accu_max);
+
+      OT_int8::Params p((int32_t)output_ch_count, &qp.otv, qp.biases.data(),
+                        qp.multipliers.data());
+
+      nn_add_params_t add_params;
+      for (int k = 0; k < 2; ++k) {
+        add_params.input[k].shr = rng.rand<int16_t>(-7, 0);
+        add_params.input[k].multiplier = rng.rand<int16_t>(-0x2000, 0x2000);
+      }
+      add_params.output.bias = rng.rand<int32_t>(-0x100000, 0x100000);
+      add_params.output.shr = rng.rand<int>(8, 14);
+
+      OT_int8 ot(&p);
+      OT_int8_residual::Params rp(&p, &add_params);
+      OT_int8_residual ot_res(&rp);
+
+      const int pixels = 3;
+      const int ocg_count =
+          (output_ch_count + VPU_INT8_ACC_PERIOD - 1) / VPU_INT8_ACC_PERIOD;
+
+      // Residual images are padded as add_elementwise() overreads
+      std::vector<int8_t> R(pixels * output_ch_count + VPU_INT8_EPV);
+      for (auto &r : R) r = rng.rand<int8_t>();
+
+      std::vector<int8_t> conv(pixels * output_ch_count + VPU_INT8_EPV, 0);
+      std::vector<int8_t> expected(pixels * output_ch_count, 0);
+      std::vector<int8_t> actual(pixels * output_ch_count, 0);
+      std::vector<int8_t> in_place(R);
+
+      std::vector<VPURingBuffer> accs;
+
+      ot_res.set_images(actual.data(), R.data());
+
+      for (int pix = 0; pix < pixels; ++pix) {
+        int8_t *c = &conv[pix * output_ch_count];
+        int8_t *y = &actual[pix * output_ch_count];
+
+        for (int ocg = 0; ocg < ocg_count; ++ocg) {
+          VPURingBuffer A;
+          memset(&A, 0, sizeof A);
+          for (int ch = 0; ch < VPU_INT8_ACC_PERIOD; ++ch) {
+            int och = std::min(ocg * VPU_INT8_ACC_PERIOD + ch,
+                               output_ch_count - 1);
+            int64_t range = (int64_t)accu_max[och] - (int64_t)accu_min[och];
+            int32_t v = (int64_t)accu_min[och] + (rng.rand<unsigned>()) % range;
+            A.vR[ch] = ((int16_t *)&v)[0];
+            A.vD[ch] = ((int16_t *)&v)[1];
+          }
+          accs.push_back(A);
+
+          c = ot.output_transform_fn(c, &A, ocg);
+          A = accs.back();
+          int8_t *next_y = ot_res.output_transform_fn(y, &A, ocg);
+          ASSERT_EQ(c - conv.data(), next_y - actual.data());
+          y = next_y;
+        }
+      }
+
+      add_elementwise(expected.data(), conv.data(), R.data(), &add_params, 0,
+                      expected.size());
+      ASSERT_EQ(expected, actual);
+
+      // The same again, writing over the residual image
+      ot_res.set_images(in_place.data(), in_place.data());
+      int8_t *y = in_place.data();
+      for (int pix = 0; pix < pixels; ++pix) {
+        for (int ocg = 0; ocg < ocg_count; ++ocg) {
+          VPURingBuffer A = accs[pix * ocg_count + ocg];
+          y = ot_res.output_transform_fn(y, &A, ocg);
+        }
+      }
+      in_place.resize(expected.size());
+      ASSERT_EQ(expected, in_place);
+    }
+  }
+}
+
+/*
+  A Filter2D with OT_int8_residual must give the output of the same filter with
+  OT_int8 followed by add_elementwise(), for whole images, for a filter split
+  into regions, and for a batch with a residual image per output image in
+  either loop order.
+*/
+TEST_F(Test_OT_int8_residual, Filter2D) {
+  const int batch_count = 2;
+
+  for (int y_channels = 16; y_channels <= 40; y_channels += 12) {
+    ImageGeometry X(5, 4, 8);
+    WindowGeometry K(3, 3, 8, -1, -1);
+    ImageGeometry Y(5, 4, y_channels);
+    Filter2dGeometry geom(X, Y, K);
+    const int x_bytes = X.ImageBytes(), y_bytes = Y.ImageBytes();
+
+    std::vector<int8_t> x(batch_count * x_bytes + XS3_VPU_VREG_WIDTH_BYTES);
+    for (auto &v : x) v = rng.rand<int8_t>();
+
+    // Residual images are padded as add_elementwise() overreads
+    std::vector<int8_t> r(batch_count * y_bytes + VPU_INT8_EPV);
+    for (auto &v : r) v = rng.rand<int8_t>();
+
+    std::array<int, 4> shape = {y_channels, 3, 3, 8};
+    std::vector<int8_t> raw_weights(y_channels * 3 * 3 * 8);
+    for (auto &v : raw_weights) v = rng.rand<int8_t>();
+    Conv2dReorderedWeights rw =
+        MatMulInt8::reorder_kernel_weights(raw_weights.data(), shape, 8, 0);
+    MatMulInt8::Params mm_params(y_channels, 3 * 3 * 8, rw.weights.data());
+    MatMulInt8 mm(&mm_params);
+
+    nn_add_params_t add_params;
+    for (int k = 0; k < 2; ++k) {
+      add_params.input[k].shr = rng.rand<int16_t>(-7, 0);
+      add_params.input[k].multiplier = rng.rand<int16_t>(-0x2000, 0x2000);
+    }
+    add_params.output.bias = rng.rand<int32_t>(-0x100000, 0x100000);
+    add_params.output.shr = rng.rand<int>(8, 14);
+
+    OT_int8::Params ot_params = make_ot_params(y_channels, &rng);
+    OT_int8 ot(&ot_params);
+    OT_int8_residual::Params rp(&ot_params, &add_params);
+    OT_int8_residual ot_res(&rp);
+
+    ImToColPadded::Params im2col_params(X, K, geom.Padding(), 8, 0);
+    ImToColPadded im2col(&im2col_params);
+    std::vector<int32_t> scratch((im2col.get_scratch_bytes() + 3) / 4);
+    ImageRegion region(0, 0, 0, Y.height, Y.width, Y.depth);
+    AbstractKernel::Params kparams(Y, region, VPU_INT8_ACC_PERIOD);
+    Filter2D plain(&kparams, &im2col, &mm, &ot, (int8_t *)scratch.data());
+    Filter2D fused(&kparams, &im2col, &mm, &ot_res, (int8_t *)scratch.data());
+
+    std::vector<int8_t> expected(batch_count * y_bytes);
+    std::vector<int8_t> conv(y_bytes + VPU_INT8_EPV);
+    for (int b = 0; b < batch_count; b++) {
+      plain.execute(conv.data(), &x[b * x_bytes]);
+      add_elementwise(&expected[b * y_bytes], conv.data(), &r[b * y_bytes],
+                      &add_params, 0, y_bytes);
+    }
+
+    std::vector<int8_t> actual(batch_count * y_bytes);
+    for (int b = 0; b < batch_count; b++) {
+      ot_res.set_images(&actual[b * y_bytes], &r[b * y_bytes]);
+      fused.execute(&actual[b * y_bytes], &x[b * x_bytes]);
+    }
+    ASSERT_EQ(expected, actual) << "Y: " << Y;
+
+    // The top and bottom of the image by separate filters
+    ImageRegion top_region(0, 0, 0, 2, Y.width, Y.depth);
+    ImageRegion bottom_region(2, 0, 0, Y.height - 2, Y.width, Y.depth);
+    AbstractKernel::Params top_kparams(Y, top_region, VPU_INT8_ACC_PERIOD);
+    AbstractKernel::Params bottom_kparams(Y, bottom_region,
+                                          VPU_INT8_ACC_PERIOD);
+    Filter2D top(fused, &top_kparams, (int8_t *)scratch.data());
+    Filter2D bottom(fused, &bottom_kparams, (int8_t *)scratch.data());
+
+    std::fill(actual.begin(), actual.end(), 0);
+    ot_res.set_images(actual.data(), r.data());
+    top.execute(actual.data(), x.data());
+    bottom.execute(actual.data(), x.data());
+    ASSERT_TRUE(std::equal(actual.begin(), actual.begin() + y_bytes,
+                           expected.begin()))
+        << "Y: " << Y;
+
+    for (int order = 0; order < 2; order++) {
+      fused.set_loop_order(order == 0 ? Filter2DLoopOrder::PixelOuter
+                                      : Filter2DLoopOrder::ChannelGroupOuter);
+      std::fill(actual.begin(), actual.end(), 0);
+      ot_res.set_images(actual.data(), r.data());
+      fused.execute(actual.data(), x.data(), batch_count, y_bytes, x_bytes);
+      ASSERT_EQ(expected, actual) << "Y: " << Y << " | order: " << order;
+    }
+  }
+}
+
+class Test_OT_int8_lut : public ::testing::Test {};
+
+/*
+  The outputs must be those of OT_int8 looked up in the table, as lookup8()
+  would.
+*/
+TEST_F(Test_OT_int8_lut, MatchesLookup8) {
+  std::vector<int8_t> lut(1 << 8);
+  for (auto &v : lut) v = rng.rand<int8_t>();
+
+  for (int output_ch_count = 4; output_ch_count <= 40; output_ch_count += 4) {
+    for (int itt = 0; itt < 1 << 4; itt++) {
+      std::vector<double> f_biases(output_ch_count, 0);
+      std::vector<double> f_multipliers(output_ch_count, 0);
+      std::vector<int32_t> accu_min(output_ch_count, 0);
+      std::vector<int32_t> accu_max(output_ch_count, 0);
+
+      pick_accu_range(accu_min, accu_max);
+      pick_activation_params(f_multipliers, f_biases, accu_max, accu_min);
+
+      QuantisationParams qp = OutputTransformFnInt8::quantise_activation(
+          f_multipliers, f_biases, accu_min, accu_max);
+
+      OT_int8::Params p((int32_t)output_ch_count, &qp.otv, qp.biases.data(),
+                        qp.multipliers.data());
+      OT_int8 ot(&p);
+      OT_int8_lut::Params lp(&p, lut.data());
+      OT_int8_lut ot_lut(&lp);
+
+      const int pixels = 3;
+      const int ocg_count =
+          (output_ch_count + VPU_INT8_ACC_PERIOD - 1) / VPU_INT8_ACC_PERIOD;
+
+      std::vector<int8_t> expected(pixels * output_ch_count, 0);
+      std::vector<int8_t> actual(pixels * output_ch_count, 0);
+
+      int8_t *e = expected.data();
+      int8_t *y = actual.data();
+      for (int pix = 0; pix < pixels; ++pix) {
+        for (int ocg = 0; ocg < ocg_count; ++ocg) {
+          VPURingBuffer A;
+          memset(&A, 0, sizeof A);
+          for (int ch = 0; ch < VPU_INT8_ACC_PERIOD; ++ch) {
+            int och = std::min(ocg * VPU_INT8_ACC_PERIOD + ch,
+                               output_ch_count - 1);
+            int64_t range = (int64_t)accu_max[och] - (int64_t)accu_min[och];
+            int32_t v = (int64_t)accu_min[och] + (rng.rand<unsigned>()) % range;
+            A.vR[ch] = ((int16_t *)&v)[0];
+            A.vD[ch] = ((int16_t *)&v)[1];
+          }
+          VPURingBuffer B = A;
+
+          e = ot.output_transform_fn(e, &A, ocg);
+          y = ot_lut.output_transform_fn(y, &B, ocg);
+          ASSERT_EQ(e - expected.data(), y - actual.data());
+        }
+      }
+
+      lookup8((uint8_t *)expected.data(), (const uint8_t *)expected.data(),
+              (const uint8_t *)lut.data(), 0, expected.size());
+      ASSERT_EQ(expected, actual);
+    }
+  }
+}
+
+/*
+  Each entry must be the activation of the real value its index represents,
+  requantised.
+*/
+TEST_F(Test_OT_int8_lut, MakeTable) {
+  const double input_scale = 0.05, output_scale = 1.0 / 128;
+  const int input_zero_point = 10, output_zero_point = 0;
+
+  double (*activation)(double) = [](double x) { return std::tanh(x); };
+
+  std::vector<int8_t> lut =
+      OT_int8_lut::make_table(activation, input_scale, input_zero_point,
+                              output_scale, output_zero_point);
+
+  ASSERT_EQ(256, lut.size());
+  for (int i = INT8_MIN; i <= INT8_MAX; i++) {
+    const double y = activation(input_scale * (i - input_zero_point));
+    const long q = std::min(std::lround(y / output_scale), (long)INT8_MAX);
+    EXPECT_EQ(q, lut[(uint8_t)i]) << "i: " << i;
+  }
+  EXPECT_EQ(0, lut[(uint8_t)input_zero_point]);
+}
+
+class Test_OT_int16 : public ::testing::Test {};
+
+/*
+  Each output must be within 1 of the real transform, saturated symmetrically
+  to the width of the output, over multipliers spanning many binades and with
+  some accumulators at the extremes of their range.
+*/
+TEST_F(Test_OT_int16, BasicTest) {
+  for (int output_bytes = 1; output_bytes <= 2; ++output_bytes) {
+    const int32_t y_max = output_bytes == 2 ? INT16_MAX : INT8_MAX;
+
+    for (int output_ch_count = 1; output_ch_count <= 40; output_ch_count += 3) {
+      for (int itt = 0; itt < 1 << 6; itt++) {
+        std::vector<int32_t> biases(output_ch_count);
+        std::vector<double> multipliers(output_ch_count);
+        std::vector<int32_t> offsets(output_ch_count);
+        for (int ch = 0; ch < output_ch_count; ++ch) {
+          multipliers[ch] = rng.rand<double>(-1.99, 1.99) /
+                            (1 << rng.rand<int>(0, 24));
+          const double bias =
+              rng.rand<double>(-y_max, y_max) / std::abs(multipliers[ch]);
+          biases[ch] = std::max(std::min(bias, 1e9), -1e9);
+          offsets[ch] = rng.rand<int32_t>(-y_max / 2, y_max / 2);
+        }
+
+        OT_int16::Quantisation q =
+            OT_int16::quantise_activation(biases, multipliers, offsets);
+        OT_int16::Params p(output_ch_count, output_bytes, q.biases.data(),
+                           q.multipliers.data(), q.shifts.data(),
+                           q.offsets.data());
+        OT_int16 ot(&p);
+
+        std::vector<int16_t> Y(output_ch_count + VPU_INT16_EPV);
+        int8_t *y = (int8_t *)Y.data();
+        std::vector<int32_t> accu_values(output_ch_count);
+
+        for (int ocg = 0; ocg * VPU_INT16_EPV < output_ch_count; ++ocg) {
+          VPURingBuffer A;
+          memset(&A, 0, sizeof A);
+
+          const int chs_in_group = std::min(
+              output_ch_count - ocg * VPU_INT16_EPV, (int)VPU_INT16_EPV);
+          for (int i = 0; i < chs_in_group; ++i) {
+            const int ch = ocg * VPU_INT16_EPV + i;
+
+            // Mostly accumulators giving outputs near the output's range
+            int64_t v;
+            if (rng.rand<int>(0, 7) == 0) {
+              v = rng.rand<int>(0, 1) ? INT32_MAX : -INT32_MAX;
+            } else {
+              double target = rng.rand<double>(-1.5 * y_max, 1.5 * y_max);
+              v = std::llround((target - offsets[ch]) / multipliers[ch]) -
+                  biases[ch];
+              v = std::max<int64_t>(std::min<int64_t>(v, INT32_MAX),
+                                    -INT32_MAX);
+            }
+            accu_values[ch] = v;
+            A.vR[i] = ((int16_t *)&accu_values[ch])[0];
+            A.vD[i] = ((int16_t *)&accu_values[ch])[1];
+          }
+
+          int8_t *next_y = ot.output_transform_fn(y, &A, ocg);
+          ASSERT_EQ(y + chs_in_group * output_bytes, next_y);
+          y = next_y;
+        }
+
+        for (int ch = 0; ch < output_ch_count; ++ch) {
+          const int actual =
+              output_bytes == 2 ? Y[ch] : ((int8_t *)Y.data())[ch];
+          // The bias is added with 32 bit saturation
+          double expected = std::max(
+              std::min((double)accu_values[ch] + biases[ch], (double)INT32_MAX),
+              (double)-INT32_MAX);
+          expected = expected * multipliers[ch] + offsets[ch];
+          expected =
+              std::min(std::max(expected, (double)-y_max), (double)y_max);
+          EXPECT_NEAR(expected, actual, 1)
+              << "ch: " << ch << " | accu_value: " << accu_values[ch]
+              << " | bias: " << biases[ch]
+              << " | multiplier: " << multipliers[ch]
+              << " | offset: " << offsets[ch];
+        }
+      }
+    }
+  }
+}
+
 }  // namespace nn
@@ -0,0 +1,213 @@
+#include <array>
+#include <cstring>
+#include <vector>
+
+#include "Filter2D.hpp"
+#include "OutputTransformFixture.hpp"
+#include "Rand.hpp"
+#include "gtest/gtest.h"
+#include "nn_operator.h"
+
+namespace nn {
+
+static auto rng = test::Rand(97531);
+
+class Test_OutputView : public ::testing::Test,
+                        protected test::OutputTransformFixture {
+ protected:
+  // Copy each pixel of `y` into channels [offset, offset + y_channels) of the
+  // corresponding pixel of `concat`
+  static void concat_copy(std::vector<int8_t> &concat, int concat_channels,
+                          const std::vector<int8_t> &y, int y_channels,
+                          int offset, int pixels) {
+    for (int p = 0; p < pixels; p++)
+      std::memcpy(&concat[p * concat_channels + offset], &y[p * y_channels],
+                  y_channels);
+  }
+};
+
+/*
+  Filters writing their outputs into views of a shared tensor must give the
+  outputs of executing them into their own images and concatenating those.
+*/
+TEST_F(Test_OutputView, Filter2D) {
+  ImageGeometry X(5, 4, 8);
+  const int view_channels[] = {20, 12};
+  const int offsets[] = {0, 20};
+  const int concat_channels = 32;
+  ImageGeometry Y_cat(5, 4, concat_channels);
+
+  std::vector<int8_t> x(X.ImageBytes() + XS3_VPU_VREG_WIDTH_BYTES);
+  for (auto &v : x) v = rng.rand<int8_t>();
+
+  std::vector<int8_t> expected(Y_cat.ImageBytes());
+  std::vector<int8_t> actual(Y_cat.ImageBytes());
+
+  // The second view first, so the first must not write over it
+  for (int i = 1; i >= 0; i--) {
+    const int y_channels = view_channels[i];
+    WindowGeometry K(3, 3, 8, -1, -1);
+    ImageGeometry Y(5, 4, y_channels);
+    Filter2dGeometry geom(X, Y, K);
+
+    std::array<int, 4> shape = {y_channels, 3, 3, 8};
+    std::vector<int8_t> raw_weights(y_channels * 3 * 3 * 8);
+    for (auto &v : raw_weights) v = rng.rand<int8_t>();
+    Conv2dReorderedWeights rw =
+        MatMulInt8::reorder_kernel_weights(raw_weights.data(), shape, 8, 0);
+    MatMulInt8::Params mm_params(y_channels, 3 * 3 * 8, rw.weights.data());
+    MatMulInt8 mm(&mm_params);
+    OT_int8::Params ot_params = make_ot_params(y_channels, &rng);
+    OT_int8 ot(&ot_params);
+    ImToColPadded::Params im2col_params(X, K, geom.Padding(), 8, 0);
+    ImToColPadded im2col(&im2col_params);
+    std::vector<int32_t> scratch((im2col.get_scratch_bytes() + 3) / 4);
+    ImageRegion region(0, 0, 0, Y.height, Y.width, Y.depth);
+
+    AbstractKernel::Params kparams(Y, region, VPU_INT8_ACC_PERIOD);
+    Filter2D filter(&kparams, &im2col, &mm, &ot, (int8_t *)scratch.data());
+    std::vector<int8_t> y(Y.ImageBytes());
+    filter.execute(y.data(), x.data());
+    concat_copy(expected, concat_channels, y, y_channels, offsets[i],
+                Y.PixelCount());
+
+    AbstractKernel::Params view_kparams(Y_cat, region, VPU_INT8_ACC_PERIOD,
+                                        offsets[i]);
+    Filter2D view_filter(&view_kparams, &im2col, &mm, &ot,
+                         (int8_t *)scratch.data());
+    view_filter.execute(actual.data(), x.data());
+  }
+
+  ASSERT_EQ(expected, actual);
+}
+
+/*
+  A depthwise filter reads the input channels of its own output channels,
+  whatever the view's offset.
+*/
+TEST_F(Test_OutputView, Filter2D_DW) {
+  const int channels = 16;
+  const int offset = 8;
+  const int concat_channels = 28;
+  ImageGeometry X(5, 6, channels);
+  WindowGeometry K(3, 3, 1);
+  ImageGeometry Y(3, 4, channels);
+  ImageGeometry Y_cat(3, 4, concat_channels);
+
+  std::vector<int8_t> x(X.ImageBytes() + XS3_VPU_VREG_WIDTH_BYTES);
+  for (auto &v : x) v = rng.rand<int8_t>();
+  std::vector<int8_t> weights(9 * channels);
+  for (auto &v : weights) v = rng.rand<int8_t>();
+  std::array<int, 4> shape = {1, 3, 3, channels};
+  std::vector<int8_t> reordered =
+      MatMulDirectFn_DW::reorder_kernel_weights(weights.data(), shape);
+
+  DerefInputFn::Params deref_params(X, K);
+  DerefInputFn deref(&deref_params);
+  MatMulDirectFn_DW::Params agg_params(X, K, reordered.data());
+  MatMulDirectFn_DW agg(&agg_params);
+  OT_int8::Params ot_params = make_ot_params(channels, &rng);
+  OT_int8 ot(&ot_params);
+  std::vector<int32_t> scratch((deref.get_scratch_bytes() + 3) / 4 + 1);
+  ImageRegion region(0, 0, 0, Y.height, Y.width, Y.depth);
+
+  AbstractKernel::Params kparams(Y, region, VPU_INT8_ACC_PERIOD);
+  Filter2D_DW filter(&kparams, &deref, &agg, &ot, (int8_t *)scratch.data());
+  std::vector<int8_t> y(Y.ImageBytes());
+  filter.execute(y.data(), x.data());
+
+  std::vector<int8_t> expected(Y_cat.ImageBytes(), 0);
+  concat_copy(expected, concat_channels, y, channels, offset, Y.PixelCount());
+
+  AbstractKernel::Params view_kparams(Y_cat, region, VPU_INT8_ACC_PERIOD,
+                                      offset);
+  Filter2D_DW view_filter(&view_kparams, &deref, &agg, &ot,
+                          (int8_t *)scratch.data());
+  std::vector<int8_t> actual(Y_cat.ImageBytes(), 0);
+  view_filter.execute(actual.data(), x.data());
+
+  ASSERT_EQ(expected, actual);
+}
+
+/*
+  conv2d_deep_ext(), conv2d_1x1_ext() and conv2d_depthwise_ext() writing into
+  views of a shared tensor must give the outputs of conv2d_deep(), conv2d_1x1()
+  and conv2d_depthwise() concatenated.
+*/
+TEST_F(Test_OutputView, Conv2dExt) {
+  const channel_count_t x_channels = 16;
+  const channel_count_t deep_channels = 20, pw_channels = 12;
+  const channel_count_t dw_channels = x_channels;
+  const int deep_offset = 0, pw_offset = 20, dw_offset = 32;
+  const channel_count_t concat_channels = 48;
+
+  nn_image_params_t x_params = {5, 6, x_channels};
+  nn_image_params_t cat_params = {5, 6, concat_channels};
+  nn_window_params_t window = {{3, 3}, {-1, -1}, {1, 1}, {1, 1}};
+  const int pixels = x_params.height * x_params.width;
+  const int8_t zero_point = rng.rand<int8_t>();
+
+  // The operators may read a vector past the end of X and K. conv2d_deep also
+  // reads a vector before its K, so K_deep starts VPU_INT8_EPV bytes in.
+  std::vector<int8_t> x(pixels * x_channels + VPU_INT8_EPV);
+  for (auto &v : x) v = rng.rand<int8_t>();
+  std::vector<int8_t> K_deep_mem(VPU_INT8_EPV +
+                                 deep_channels * 9 * x_channels + VPU_INT8_EPV);
+  int8_t *K_deep = &K_deep_mem[VPU_INT8_EPV];
+  std::vector<int8_t> K_pw(pw_channels * x_channels + VPU_INT8_EPV);
+  std::vector<int8_t> K_dw(9 * dw_channels + VPU_INT8_EPV);
+  for (auto &v : K_deep_mem) v = rng.rand<int8_t>();
+  for (auto &v : K_pw) v = rng.rand<int8_t>();
+  for (auto &v : K_dw) v = rng.rand<int8_t>();
+  std::vector<nn_bso_block_t> bso_deep = make_bso(rng, deep_channels);
+  std::vector<nn_bso_block_t> bso_pw = make_bso(rng, pw_channels);
+  std::vector<nn_bso_block_t> bso_dw = make_bso(rng, dw_channels);
+
+  std::vector<int8_t> expected(pixels * concat_channels);
+  {
+    nn_image_params_t y_params = {5, 6, deep_channels};
+    std::vector<int8_t> y(pixels * deep_channels);
+    conv2d_deep(y.data(), x.data(), K_deep, bso_deep.data(), zero_point,
+                &x_params, &y_params, &window);
+    concat_copy(expected, concat_channels, y, deep_channels, deep_offset,
+                pixels);
+  }
+  {
+    nn_image_params_t y_params = {5, 6, pw_channels};
+    std::vector<int8_t> y(pixels * pw_channels);
+    conv2d_1x1(y.data(), x.data(), K_pw.data(), bso_pw.data(), &x_params,
+               &y_params);
+    concat_copy(expected, concat_channels, y, pw_channels, pw_offset, pixels);
+  }
+  {
+    std::vector<int8_t> y(pixels * dw_channels);
+    conv2d_depthwise(y.data(), x.data(), K_dw.data(), bso_dw.data(),
+                     zero_point, &x_params, &x_params, &window);
+    concat_copy(expected, concat_channels, y, dw_channels, dw_offset, pixels);
+  }
+
+  // In reverse order, so no operator may write beyond its own channels
+  std::vector<int8_t> actual(pixels * concat_channels);
+  {
+    const nn_conv2d_job_params_t job = {{0, 0, 0}, {5, 6, dw_channels}};
+    conv2d_depthwise_ext(&actual[dw_offset], x.data(), K_dw.data(),
+                         bso_dw.data(), zero_point, &x_params, &cat_params,
+                         &window, &job, CONV2D_DEPTHWISE_FLAG_OUTPUT_VIEW);
+  }
+  {
+    const nn_conv2d_1x1_job_params_t job = {{0, 0, 0},
+                                            {(uint32_t)pixels, pw_channels}};
+    conv2d_1x1_ext(&actual[pw_offset], x.data(), K_pw.data(), bso_pw.data(),
+                   &x_params, &cat_params, &job, CONV2D_1X1_FLAG_OUTPUT_VIEW);
+  }
+  {
+    const nn_conv2d_job_params_t job = {{0, 0, 0}, {5, 6, deep_channels}};
+    conv2d_deep_ext(&actual[deep_offset], x.data(), K_deep, bso_deep.data(),
+                    zero_point, &x_params, &cat_params, &window, &job,
+                    CONV2D_DEEP_FLAG_OUTPUT_VIEW);
+  }
+
+  ASSERT_EQ(expected, actual);
+}
+
+}  // namespace nn
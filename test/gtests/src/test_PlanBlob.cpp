@@ -0,0 +1,150 @@
+#include <cstring>
+#include <vector>
+
+#include "PlanBlob.hpp"
+#include "Rand.hpp"
+#include "gtest/gtest.h"
+
+namespace nn {
+
+static auto rng = test::Rand(5678);
+
+class Test_PlanBlob : public ::testing::Test {};
+
+TEST_F(Test_PlanBlob, RoundTrip) {
+  ImageGeometry X(7, 6, 16);
+  WindowGeometry K(3, 3, 1, -1, -1, 2, 1);
+  ImageGeometry Y(4, 6, 32);
+  Filter2dGeometry geom(X, Y, K);
+
+  DerefInputFn::Params deref(geom);
+  ImToColPadded::Params padded(geom, -3, 16);
+  ShiftInt8OutputTransform::Params shift(Y, 5);
+  shift.shifts[3] = 7;
+  MaxPoolPatchFn::Params maxpool(K);
+
+  std::vector<int8_t> weights(123);
+  for (auto &w : weights) w = rng.rand<int8_t>();
+
+  PlanBlobWriter writer;
+  writer.add(deref);
+  writer.add_bytes(weights.data(), weights.size());
+  writer.add(padded);
+  writer.add(shift);
+  writer.add(maxpool);
+  auto blob = writer.finish();
+
+  PlanBlobReader reader(blob.data(), blob.size(), true);
+  ASSERT_TRUE(reader.ok());
+  EXPECT_EQ(5, reader.get_remaining_records());
+
+  EXPECT_EQ(PlanRecordType::DerefInputFn, reader.peek_type());
+  auto deref2 = reader.next<DerefInputFn::Params>();
+  ASSERT_NE(nullptr, deref2);
+  EXPECT_EQ(0, std::memcmp(&deref, deref2, sizeof(deref)));
+
+  // The records are used in place
+  EXPECT_GE((const uint8_t *)deref2, blob.data());
+  EXPECT_LT((const uint8_t *)deref2, blob.data() + blob.size());
+
+  size_t bytes = 0;
+  auto weights2 = (const int8_t *)reader.next_bytes(&bytes);
+  ASSERT_NE(nullptr, weights2);
+  ASSERT_EQ(weights.size(), bytes);
+  EXPECT_EQ(0, ((uintptr_t)weights2) % PlanBlob::Alignment);
+  EXPECT_EQ(0, std::memcmp(weights.data(), weights2, bytes));
+
+  auto padded2 = reader.next<ImToColPadded::Params>();
+  ASSERT_NE(nullptr, padded2);
+  EXPECT_EQ(0, std::memcmp(&padded, padded2, sizeof(padded)));
+
+  auto shift2 = reader.next<ShiftInt8OutputTransform::Params>();
+  ASSERT_NE(nullptr, shift2);
+  EXPECT_EQ(shift.output_img_channels, shift2->output_img_channels);
+  EXPECT_EQ(7, shift2->shifts[3]);
+
+  auto maxpool2 = reader.next<MaxPoolPatchFn::Params>();
+  ASSERT_NE(nullptr, maxpool2);
+  EXPECT_EQ(maxpool.pixel_count, maxpool2->pixel_count);
+
+  EXPECT_EQ(0, reader.get_remaining_records());
+  EXPECT_EQ(PlanRecordType::End, reader.peek_type());
+  EXPECT_EQ(nullptr, reader.next<DerefInputFn::Params>());
+  EXPECT_TRUE(reader.ok());
+}
+
+TEST_F(Test_PlanBlob, HandlersUseBlob) {
+  ImageGeometry X(5, 5, 8);
+  WindowGeometry K(3, 3, 1, -1, -1);
+  ImageGeometry Y(5, 5, 8);
+  Filter2dGeometry geom(X, Y, K);
+
+  ImToColPadded::Params params(geom, 0, 8);
+  PlanBlobWriter writer;
+  writer.add(params);
+  auto blob = writer.finish();
+
+  PlanBlobReader reader(blob.data(), blob.size());
+  ImToColPadded from_blob(reader.next<ImToColPadded::Params>());
+  ImToColPadded original(&params);
+
+  std::vector<int8_t> x(X.ImageBytes());
+  for (auto &v : x) v = rng.rand<int8_t>();
+
+  const int scratch_bytes = original.get_scratch_bytes();
+  ASSERT_EQ(scratch_bytes, from_blob.get_scratch_bytes());
+  std::vector<int8_t> t0(scratch_bytes), t1(scratch_bytes);
+
+  for (int h = 0; h < Y.height; ++h) {
+    for (int w = 0; w < Y.width; ++w) {
+      original.memcopy_fn(t0.data(), x.data(), h, w, 0);
+      from_blob.memcopy_fn(t1.data(), x.data(), h, w, 0);
+      ASSERT_EQ(t0, t1);
+    }
+  }
+}
+
+TEST_F(Test_PlanBlob, RejectsBadBlobs) {
+  PlanBlobWriter writer;
+  writer.add(DirectWriteOutputTransform::Params(24));
+  auto blob = writer.finish();
+
+  {
+    PlanBlobReader reader(blob.data(), blob.size() - 1);
+    EXPECT_EQ(PlanBlobReader::Status::Truncated, reader.get_status());
+    EXPECT_EQ(nullptr, reader.next<DirectWriteOutputTransform::Params>());
+  }
+  {
+    auto bad = blob;
+    bad[0] ^= 1;
+    PlanBlobReader reader(bad.data(), bad.size());
+    EXPECT_EQ(PlanBlobReader::Status::BadMagic, reader.get_status());
+  }
+  {
+    auto bad = blob;
+    bad[offsetof(PlanBlobHeader, record_count)] ^= 1;
+    PlanBlobReader reader(bad.data(), bad.size());
+    EXPECT_EQ(PlanBlobReader::Status::BadHeaderChecksum, reader.get_status());
+  }
+  {
+    auto bad = blob;
+    bad.back() ^= 1;
+    // Only noticed if the payload is verified
+    EXPECT_TRUE(PlanBlobReader(bad.data(), bad.size()).ok());
+    PlanBlobReader reader(bad.data(), bad.size(), true);
+    EXPECT_EQ(PlanBlobReader::Status::BadPayloadChecksum, reader.get_status());
+  }
+  {
+    std::vector<uint8_t> shifted(blob.size() + 1);
+    std::memcpy(&shifted[1], blob.data(), blob.size());
+    PlanBlobReader reader(&shifted[1], blob.size());
+    EXPECT_EQ(PlanBlobReader::Status::Misaligned, reader.get_status());
+  }
+  {
+    PlanBlobReader reader(blob.data(), blob.size());
+    EXPECT_EQ(nullptr, reader.next<DerefInputFn::Params>());
+    EXPECT_EQ(PlanBlobReader::Status::BadRecord, reader.get_status());
+  }
+}
+
+}  // namespace nn
@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Rand.hpp"
+#include "gtest/gtest.h"
+#include "nn_operator.h"
+
+namespace nn {
+
+static auto rng = test::Rand(86420);
+
+class Test_Softmax : public ::testing::Test {
+ protected:
+  // The float softmax, quantized to the output's scale of 2^-8 and zero point
+  // of -128
+  template <typename T>
+  static std::vector<double> float_softmax(const std::vector<T> &x,
+                                           double scale) {
+    const T max = *std::max_element(x.begin(), x.end());
+    std::vector<double> y(x.size());
+    double sum = 0;
+    for (size_t k = 0; k < x.size(); k++)
+      sum += y[k] = std::exp(scale * (x[k] - max));
+    for (auto &v : y) v = std::min(v / sum * 256, 255.0) - 128;
+    return y;
+  }
+};
+
+/*
+  Each output must be within 1 of the quantized float softmax, over inputs
+  whose differences span both exponent tables.
+*/
+TEST_F(Test_Softmax, Int16MatchesFloat) {
+  const unsigned lengths[] = {1, 2, 10, 33, 1000};
+
+  for (auto N : lengths) {
+    for (int itt = 0; itt < 1 << 5; itt++) {
+      const float scale = std::ldexp(rng.rand<double>(0.5, 1.0),
+                                     -rng.rand<int>(0, 12));
+      const int16_t spread = rng.rand<int16_t>(1, INT16_MAX);
+      const int16_t centre = rng.rand<int16_t>(-0x4000, 0x4000);
+
+      std::vector<int16_t> x(N);
+      for (auto &v : x)
+        v = std::max(std::min(centre + rng.rand<int32_t>(-spread, spread),
+                              (int32_t)INT16_MAX),
+                     (int32_t)INT16_MIN);
+
+      nn_softmax_params_t params;
+      softmax_prepare(&params, scale);
+
+      std::vector<int8_t> y(N);
+      softmax_16(y.data(), x.data(), &params, N);
+
+      std::vector<double> expected = float_softmax(x, scale);
+      for (unsigned k = 0; k < N; k++)
+        ASSERT_NEAR(expected[k], y[k], 1.0) << "N: " << N << " k: " << k;
+    }
+  }
+}
+
+TEST_F(Test_Softmax, Int8MatchesFloat) {
+  const unsigned lengths[] = {1, 5, 64, 300};
+
+  for (auto N : lengths) {
+    for (int itt = 0; itt < 1 << 5; itt++) {
+      const float scale = std::ldexp(rng.rand<double>(0.5, 1.0),
+                                     -rng.rand<int>(0, 6));
+
+      std::vector<int8_t> x(N);
+      for (auto &v : x) v = rng.rand<int8_t>();
+
+      nn_softmax_params_t params;
+      softmax_prepare(&params, scale);
+
+      std::vector<int8_t> y(N);
+      softmax_8(y.data(), x.data(), &params, N);
+
+      std::vector<double> expected = float_softmax(x, scale);
+      for (unsigned k = 0; k < N; k++)
+        ASSERT_NEAR(expected[k], y[k], 1.0) << "N: " << N << " k: " << k;
+    }
+  }
+}
+
+/*
+  The 8-bit and 16-bit operators must agree on the same inputs, whether or not
+  there are enough of them for softmax_8() to use a lookup table.
+*/
+TEST_F(Test_Softmax, Int8MatchesInt16) {
+  const unsigned lengths[] = {100, 1000};
+  const int8_t ranges[] = {20, 127};
+
+  for (auto N : lengths) {
+    for (auto range : ranges) {
+      std::vector<int8_t> x8(N);
+      for (auto &v : x8) v = rng.rand<int8_t>(-range, range);
+      std::vector<int16_t> x16(x8.begin(), x8.end());
+
+      nn_softmax_params_t params;
+      softmax_prepare(&params, 0.1f);
+
+      std::vector<int8_t> y8(N), y16(N);
+      softmax_8(y8.data(), x8.data(), &params, N);
+      softmax_16(y16.data(), x16.data(), &params, N);
+      ASSERT_EQ(y16, y8) << "N: " << N << " range: " << (int)range;
+    }
+  }
+}
+
+}  // namespace nn
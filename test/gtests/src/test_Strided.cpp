@@ -0,0 +1,69 @@
+#include <cstring>
+#include <vector>
+
+#include "OutputTransformFixture.hpp"
+#include "Rand.hpp"
+#include "gtest/gtest.h"
+#include "nn_operator.h"
+
+namespace nn {
+
+static auto rng = test::Rand(24680);
+
+class Test_Strided : public ::testing::Test,
+                     protected test::OutputTransformFixture {};
+
+/*
+  conv2d_1x1_strided() must give the output of conv2d_1x1() applied to the
+  input pixels picked out by the strides.
+*/
+TEST_F(Test_Strided, Conv2d1x1) {
+  const unsigned strides[][2] = {{1, 1}, {2, 2}, {1, 2}, {2, 1}, {3, 2}};
+
+  for (auto &stride : strides) {
+    for (int x_channels = 4; x_channels <= 68; x_channels += 32) {
+      const int y_channels = 20;
+      nn_image_params_t x_params = {7, 9, (channel_count_t)x_channels};
+      nn_image_params_t y_params = {(7 + stride[0] - 1) / stride[0],
+                                    (9 + stride[1] - 1) / stride[1],
+                                    (channel_count_t)y_channels};
+      const int y_pixels = y_params.height * y_params.width;
+
+      // conv2d_1x1() may read a vector past the end of X and K
+      std::vector<int8_t> x(x_params.height * x_params.width * x_channels +
+                            VPU_INT8_EPV);
+      std::vector<int8_t> K(y_channels * x_channels + VPU_INT8_EPV);
+      for (auto &v : x) v = rng.rand<int8_t>();
+      for (auto &v : K) v = rng.rand<int8_t>();
+      std::vector<nn_bso_block_t> bso = make_bso(rng, y_channels);
+
+      // The strided pixels, as a dense image
+      std::vector<int8_t> x_picked(y_pixels * x_channels + VPU_INT8_EPV);
+      for (unsigned r = 0; r < y_params.height; r++)
+        for (unsigned c = 0; c < y_params.width; c++)
+          std::memcpy(&x_picked[(r * y_params.width + c) * x_channels],
+                      &x[((r * stride[0]) * x_params.width + c * stride[1]) *
+                         x_channels],
+                      x_channels);
+      nn_image_params_t picked_params = {y_params.height, y_params.width,
+                                         (channel_count_t)x_channels};
+
+      std::vector<int8_t> expected(y_pixels * y_channels);
+      conv2d_1x1(expected.data(), x_picked.data(), K.data(), bso.data(),
+                 &picked_params, &y_params);
+
+      std::vector<int32_t> scratch(
+          (y_params.width * x_channels + XS3_VPU_VREG_WIDTH_BYTES) / 4);
+      std::vector<int8_t> actual(y_pixels * y_channels);
+      conv2d_1x1_strided(actual.data(), x.data(), K.data(), bso.data(),
+                         &x_params, &y_params, stride[0], stride[1],
+                         (int8_t *)scratch.data());
+
+      ASSERT_EQ(expected, actual)
+          << "stride: " << stride[0] << "x" << stride[1]
+          << " | x_channels: " << x_channels;
+    }
+  }
+}
+
+}  // namespace nn
@@ -0,0 +1,136 @@
+#include <cstring>
+#include <vector>
+
+#include "Filter2D.hpp"
+#include "Rand.hpp"
+#include "ThreadPoolExecutor.hpp"
+#include "gtest/gtest.h"
+
+namespace nn {
+
+static auto rng = test::Rand(69);
+
+/*
+  Handlers without mutable state, so they can be shared between threads. The
+  output of each channel is a function of the input pixel, the channel and the
+  channel group handed to the aggregator and output transform, so any mismatch
+  in the channel group offsets shows up in the output.
+*/
+class PixelMemCpyFn : public MemCpyFn {
+  int32_t x_width, x_channels, scratch_bytes;
+
+ public:
+  PixelMemCpyFn(int32_t x_width, int32_t x_channels, int32_t scratch_bytes)
+      : x_width(x_width), x_channels(x_channels), scratch_bytes(scratch_bytes) {}
+
+  int8_t *memcopy_fn(int8_t *T, int8_t *X, int32_t h, int32_t w, int32_t c) {
+    int8_t *pixel = X + (h * x_width + w) * x_channels + c;
+    if (scratch_bytes == 0) return pixel;
+    // Use the scratch memory so that shared buffers would be noticed
+    std::memcpy(T, pixel, x_channels - c);
+    return T;
+  }
+  int get_scratch_bytes() { return scratch_bytes; }
+  int get_overread_bytes() { return 0; }
+};
+
+class PixelAggregateFn : public AggregateFn {
+ public:
+  void aggregate_fn(VPURingBuffer *A, int8_t *T, int32_t output_channel_group) {
+    for (int i = 0; i < VPU_INT8_ACC_PERIOD; ++i) {
+      A->vR[i] = T[0] * 3 + output_channel_group * 7 + i;
+      A->vD[i] = 0;
+    }
+  }
+};
+
+class PixelOutputTransform : public OutputTransformFn {
+  int32_t output_channels;
+
+ public:
+  PixelOutputTransform(int32_t output_channels)
+      : output_channels(output_channels) {}
+
+  int8_t *output_transform_fn(int8_t *Y, VPURingBuffer *A,
+                              int32_t output_channel_group) {
+    int count = std::min<int>(
+        output_channels - output_channel_group * VPU_INT8_ACC_PERIOD,
+        VPU_INT8_ACC_PERIOD);
+    for (int ch = 0; ch < count; ++ch) Y[ch] = (int8_t)A->vR[ch];
+    return Y + count;
+  }
+};
+
+template <typename T>
+class Test_ThreadPoolExecutor : public ::testing::Test {};
+
+using Test_ThreadPoolExecutor_Types = ::testing::Types<Filter2D, Filter2D_DW>;
+TYPED_TEST_SUITE(Test_ThreadPoolExecutor, Test_ThreadPoolExecutor_Types);
+
+TYPED_TEST(Test_ThreadPoolExecutor, MatchesSingleThreaded) {
+  for (int thread_count = 1; thread_count <= 5; thread_count += 2) {
+    ThreadPoolExecutor executor(thread_count);
+    ASSERT_EQ(thread_count, executor.get_thread_count());
+
+    for (int y_height = 1; y_height <= 9; y_height += 2) {
+      for (int y_width = 1; y_width <= 5; y_width += 2) {
+        for (int y_channels = 16; y_channels <= 80; y_channels += 24) {
+          for (int scratch_bytes = 0; scratch_bytes <= 128;
+               scratch_bytes += 128) {
+            auto ip = ImageGeometry(y_height, y_width, y_channels);
+            auto ir = ImageRegion(0, 0, 0, y_height, y_width, y_channels);
+
+            std::vector<int8_t> X(ip.ImageBytes());
+            for (auto &x : X) x = rng.rand<int8_t>();
+
+            PixelMemCpyFn mem_fn(y_width, y_channels, scratch_bytes);
+            PixelAggregateFn agg_fn;
+            PixelOutputTransform ot_fn(y_channels);
+            alignas(4) int8_t scratch_mem[128];
+
+            AbstractKernel::Params akp(ip, ir, VPU_INT8_ACC_PERIOD);
+            TypeParam f(&akp, &mem_fn, &agg_fn, &ot_fn, scratch_mem);
+
+            std::vector<int8_t> expected(ip.ImageBytes(), 0);
+            std::vector<int8_t> actual(ip.ImageBytes(), 0);
+
+            f.execute(expected.data(), X.data());
+            executor.execute(f, actual.data(), X.data());
+
+            ASSERT_EQ(expected, actual)
+                << "Y: " << ip << " | threads: " << thread_count
+                << " | scratch: " << scratch_bytes;
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(Test_ThreadPoolExecutor_partition, CoversRegion) {
+  for (int y_height = 1; y_height <= 12; ++y_height) {
+    for (int y_channels = 1; y_channels <= 100; y_channels += 11) {
+      for (int job_count = 1; job_count <= 20; ++job_count) {
+        auto ip = ImageGeometry(y_height + 2, 3, y_channels + 16);
+        auto ir = ImageRegion(1, 1, 16, y_height, 2, y_channels);
+        AbstractKernel::Params akp(ip, ir, VPU_INT8_ACC_PERIOD);
+
+        auto jobs = ThreadPoolExecutor::partition(akp, job_count);
+        ASSERT_LE(jobs.size(), job_count);
+
+        // Every (row, channel group) is covered exactly once
+        std::vector<int> hits(y_height * akp.output_channel_group_count, 0);
+        for (auto &job : jobs) {
+          ASSERT_LT(job.h_begin, job.h_end);
+          ASSERT_LT(job.group_begin, job.group_end);
+          for (int h = job.h_begin; h < job.h_end; ++h)
+            for (int g = job.group_begin; g < job.group_end; ++g)
+              hits[(h - akp.h_begin) * akp.output_channel_group_count + g]++;
+        }
+        for (auto hit : hits) ASSERT_EQ(1, hit);
+      }
+    }
+  }
+}
+
+}  // namespace nn
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "OutputTransformFixture.hpp"
+#include "Rand.hpp"
+#include "WeightStreamer.hpp"
+#include "gtest/gtest.h"
+
+namespace nn {
+
+static auto rng = test::Rand(24680);
+
+class Test_WeightStreamer : public ::testing::TestWithParam<bool>,
+                            protected test::OutputTransformFixture {
+ protected:
+  std::unique_ptr<WeightLoader> make_loader() {
+    if (GetParam())
+      return std::unique_ptr<WeightLoader>(new ThreadWeightLoader);
+    return std::unique_ptr<WeightLoader>(new MemCpyWeightLoader);
+  }
+
+  /*
+    Run `streamer` and check its output matches that of `full`, the operator
+    invoked on the whole of K and BSO.
+  */
+  template <class FullOp>
+  void check(const Conv2dWeightStreamer &streamer,
+             const nn_image_params_t &y_params, int8_t *X,
+             std::vector<int8_t> &K, std::vector<nn_bso_block_t> &bso,
+             FullOp full) {
+    const int y_bytes = y_params.height * y_params.width * y_params.channels;
+
+    std::vector<int8_t> expected(y_bytes);
+    full(expected.data());
+
+    const int32_t buffer_bytes = streamer.get_buffer_bytes();
+    std::vector<int32_t> buffer0((buffer_bytes + 3) / 4);
+    std::vector<int32_t> buffer1((buffer_bytes + 3) / 4);
+
+    std::vector<int8_t> actual(y_bytes);
+    auto loader = make_loader();
+    streamer.execute(actual.data(), X, K.data(), bso.data(), loader.get(),
+                     (int8_t *)buffer0.data(), (int8_t *)buffer1.data());
+
+    ASSERT_EQ(expected, actual);
+  }
+};
+
+TEST_P(Test_WeightStreamer, Deep) {
+  // With 20 input channels the operator reads beyond each end of the kernel
+  for (int x_channels = 20; x_channels <= 32; x_channels += 12) {
+    for (int y_channels = 4; y_channels <= 52; y_channels += 16) {
+      for (int slice_channels = 16; slice_channels <= 32;
+           slice_channels += 16) {
+        nn_image_params_t x_params = {5, 6, (channel_count_t)x_channels};
+        nn_image_params_t y_params = {5, 6, (channel_count_t)y_channels};
+        nn_window_params_t window = {{3, 3}, {-1, -1}, {1, 1}, {1, 1}};
+        const int8_t zero_point = rng.rand<int8_t>();
+
+        std::vector<int8_t> x(x_params.height * x_params.width * x_channels +
+                              VPU_INT8_EPV);
+        std::vector<int8_t> K(y_channels * 9 * x_channels);
+        for (auto &v : x) v = rng.rand<int8_t>();
+        for (auto &v : K) v = rng.rand<int8_t>();
+        std::vector<nn_bso_block_t> bso = make_bso(rng, y_channels);
+
+        // The operator invoked on the whole of K may read a vector before and
+        // after it
+        std::vector<int8_t> K_padded(VPU_INT8_EPV + K.size() + VPU_INT8_EPV);
+        std::copy(K.begin(), K.end(), &K_padded[VPU_INT8_EPV]);
+
+        Conv2dWeightStreamer streamer(Conv2dStreamedOp::Deep, x_params,
+                                      y_params, window, zero_point,
+                                      slice_channels);
+        ASSERT_EQ((y_channels + slice_channels - 1) / slice_channels,
+                  streamer.get_slice_count());
+
+        check(streamer, y_params, x.data(), K, bso, [&](int8_t *Y) {
+          conv2d_deep(Y, x.data(), &K_padded[VPU_INT8_EPV], bso.data(),
+                      zero_point, &x_params, &y_params, &window);
+        });
+      }
+    }
+  }
+}
+
+TEST_P(Test_WeightStreamer, ShallowIn) {
+  // The padded output channel tail of conv2d_shallowin() reads before its
+  // stack buffer, so only whole output channel groups are used here
+  for (int y_channels = 16; y_channels <= 48; y_channels += 16) {
+    for (int slice_channels = 16; slice_channels <= 32; slice_channels += 16) {
+      const int x_channels = 4;
+      const int k_width = 3;
+      const int augmented_width = VPU_INT8_EPV / x_channels;
+
+      nn_image_params_t x_params = {5, 6, x_channels};
+      nn_image_params_t y_params = {5, 6, (channel_count_t)y_channels};
+      nn_window_params_t window = {{3, k_width}, {-1, -1}, {1, 1}, {1, 1}};
+      const int8_t zero_point = rng.rand<int8_t>();
+
+      // Each row of a patch is loaded as a whole vector, starting from the
+      // padding to the left of the image
+      std::vector<int8_t> x_mem(VPU_INT8_EPV +
+                                x_params.height * x_params.width * x_channels +
+                                VPU_INT8_EPV);
+      for (auto &v : x_mem) v = rng.rand<int8_t>();
+      int8_t *x = &x_mem[VPU_INT8_EPV];
+
+      // Columns beyond the window width must be zero
+      std::vector<int8_t> K(y_channels * 3 * VPU_INT8_EPV, 0);
+      for (int i = 0; i < (int)K.size(); i++)
+        if ((i / x_channels) % augmented_width < k_width)
+          K[i] = rng.rand<int8_t>();
+      std::vector<nn_bso_block_t> bso = make_bso(rng, y_channels);
+
+      Conv2dWeightStreamer streamer(Conv2dStreamedOp::ShallowIn, x_params,
+                                    y_params, window, zero_point,
+                                    slice_channels);
+
+      check(streamer, y_params, x, K, bso, [&](int8_t *Y) {
+        conv2d_shallowin(Y, x, K.data(), bso.data(), zero_point, &x_params,
+                         &y_params, &window);
+      });
+    }
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Loaders, Test_WeightStreamer, ::testing::Bool());
+
+}  // namespace nn
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include "Filter2D.hpp"
+#include "OutputTransformFixture.hpp"
+#include "Rand.hpp"
+#include "gtest/gtest.h"
+
+namespace nn {
+
+static auto rng = test::Rand(1357);
+
+namespace {
+
+/*
+  Direct 3x3 convolution accumulator for output pixel (h, w) and output channel
+  oc, with input pixels outside of the image replaced by `pad`.
+*/
+int32_t conv3x3_ref(const ImageGeometry &X, const WindowGeometry &K,
+                    const std::vector<int8_t> &x,
+                    const std::vector<int8_t> &weights, int8_t pad, int h,
+                    int w, int oc) {
+  int32_t acc = 0;
+  for (int r = 0; r < 3; r++) {
+    for (int s = 0; s < 3; s++) {
+      const int row = K.start.row + h + r;
+      const int col = K.start.col + w + s;
+      const bool valid =
+          row >= 0 && row < X.height && col >= 0 && col < X.width;
+      for (int c = 0; c < X.depth; c++) {
+        const int32_t v = valid ? x[X.Index(row, col, c)] : pad;
+        acc += v * weights[((oc * 3 + r) * 3 + s) * X.depth + c];
+      }
+    }
+  }
+  return acc;
+}
+
+}  // namespace
+
+class Test_Winograd : public ::testing::Test {};
+
+/*
+  The accumulators of each tile must be exactly those of the direct
+  convolution.
+*/
+TEST_F(Test_Winograd, MatchesDirectAccumulators) {
+  const int tile = WinogradF2x3::OutputTile;
+
+  for (int x_channels : {1, 4, 16, 20, 48}) {
+    for (int y_channels : {4, 16, 28}) {
+      for (int pad = 0; pad <= 1; ++pad) {
+        ImageGeometry X(5, 6, x_channels);
+        WindowGeometry K(3, 3, 1, -pad, -pad);
+        ImageGeometry Y(X.height - 2 + 2 * pad, X.width - 2 + 2 * pad,
+                        y_channels);
+
+        std::vector<int8_t> weights(y_channels * 9 * x_channels);
+        for (auto &v : weights) v = rng.rand<int8_t>();
+        std::array<int, 4> shape = {y_channels, 3, 3, x_channels};
+        auto u =
+            MatMulWinograd::transform_kernel_weights(weights.data(), shape);
+        ASSERT_EQ(MatMulWinograd::get_weights_bytes(x_channels, y_channels),
+                  u.size() * sizeof(int16_t));
+
+        std::vector<int8_t> x(X.ImageBytes());
+        for (auto &v : x) v = rng.rand<int8_t>();
+        const int8_t pad_value = rng.rand<int8_t>();
+
+        WinogradInputTransform::Params ip(Filter2dGeometry(X, Y, K),
+                                          pad_value);
+        WinogradInputTransform input_fn(&ip);
+        MatMulWinograd::Params ap(x_channels, u.data());
+        MatMulWinograd agg_fn(&ap);
+
+        std::vector<int32_t> scratch(input_fn.get_scratch_bytes() / 4);
+
+        for (int th = 0; th < (Y.height + 1) / tile; ++th) {
+          for (int tw = 0; tw < (Y.width + 1) / tile; ++tw) {
+            int8_t *T = input_fn.memcopy_fn((int8_t *)scratch.data(),
+                                            x.data(), th, tw);
+
+            for (int cg = 0; cg * VPU_INT8_ACC_PERIOD < y_channels; ++cg) {
+              VPURingBuffer A[tile * tile];
+              agg_fn.aggregate_fn(A, T, cg);
+
+              for (int i = 0; i < tile; ++i) {
+                for (int j = 0; j < tile; ++j) {
+                  const int h = tile * th + i, w = tile * tw + j;
+                  if (h >= Y.height || w >= Y.width) continue;
+
+                  for (int ch = 0; ch < VPU_INT8_ACC_PERIOD; ++ch) {
+                    const int oc = cg * VPU_INT8_ACC_PERIOD + ch;
+                    if (oc >= y_channels) break;
+                    ASSERT_EQ(conv3x3_ref(X, K, x, weights, pad_value, h, w,
+                                          oc),
+                              A[i * tile + j].GetAccu(ch))
+                        << "X: " << X << " | Y: " << Y << " | h: " << h
+                        << " | w: " << w << " | oc: " << oc;
+                  }
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST_F(Test_Winograd, Filter2D) {
+  for (int y_height = 1; y_height <= 5; ++y_height) {
+    for (int y_width = 1; y_width <= 5; ++y_width) {
+      for (int y_channels : {4, 20, 32}) {
+        const int x_channels = 12;
+        const int shift = 10;
+
+        ImageGeometry X(y_height, y_width, x_channels);
+        WindowGeometry K(3, 3, 1, -1, -1);
+        ImageGeometry Y(y_height, y_width, y_channels);
+
+        std::vector<int8_t> weights(y_channels * 9 * x_channels);
+        for (auto &v : weights) v = rng.rand<int8_t>();
+        std::array<int, 4> shape = {y_channels, 3, 3, x_channels};
+        auto u =
+            MatMulWinograd::transform_kernel_weights(weights.data(), shape);
+
+        std::vector<int8_t> x(X.ImageBytes());
+        for (auto &v : x) v = rng.rand<int8_t>();
+
+        WinogradInputTransform::Params ip(Filter2dGeometry(X, Y, K), 0);
+        WinogradInputTransform input_fn(&ip);
+        MatMulWinograd::Params ap(x_channels, u.data());
+        MatMulWinograd agg_fn(&ap);
+        test::RoundShiftOutputTransform ot_fn(y_channels, shift);
+
+        std::vector<int32_t> scratch(input_fn.get_scratch_bytes() / 4);
+
+        ImageRegion region(0, 0, 0, Y.height, Y.width, Y.depth);
+        auto kparams = Filter2D_Winograd::get_tile_params(Y, region);
+        Filter2D_Winograd filter(Y, &kparams, &input_fn, &agg_fn, &ot_fn,
+                                 (int8_t *)scratch.data());
+        ASSERT_EQ(input_fn.get_scratch_bytes(), filter.get_scratch_bytes());
+
+        std::vector<int8_t> expected(Y.ImageBytes());
+        for (int h = 0; h < Y.height; ++h)
+          for (int w = 0; w < Y.width; ++w)
+            for (int oc = 0; oc < Y.depth; ++oc)
+              Y.Element<int8_t>(expected.data(), h, w, oc) =
+                  test::RoundShiftOutputTransform::apply(
+                      conv3x3_ref(X, K, x, weights, 0, h, w, oc), shift);
+
+        std::vector<int8_t> y(Y.ImageBytes());
+        filter.execute(y.data(), x.data());
+
+        ASSERT_EQ(expected, y) << "Y: " << Y;
+      }
+    }
+  }
+}
+
+}  // namespace nn
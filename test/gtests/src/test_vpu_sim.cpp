@@ -0,0 +1,325 @@
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "Rand.hpp"
+#include "gtest/gtest.h"
+#include "vpu_sim.h"
+
+namespace nn {
+
+static auto rng = test::Rand(1234);
+
+/*
+  The vpu_sim instructions may be backed by host SIMD code; these tests check
+  them against a plain model of each instruction, biased towards the extreme
+  values where saturation and rounding matter.
+*/
+template <typename T>
+static T edge_rand() {
+  switch (rng.rand<uint32_t>() % 8) {
+    case 0:
+      return std::numeric_limits<T>::min();
+    case 1:
+      return std::numeric_limits<T>::max();
+    case 2:
+      return 0;
+    case 3:
+      return -1;
+    default:
+      return rng.rand<T>();
+  }
+}
+
+template <typename T, int N>
+static void fill(T (&v)[N]) {
+  for (int i = 0; i < N; ++i) v[i] = edge_rand<T>();
+}
+
+static void random_vpu(xs3_vpu &vpu, vector_mode mode) {
+  fill(vpu.vR.s16);
+  fill(vpu.vD.s16);
+  fill(vpu.vC.s8);
+  // Mostly small accumulators so that the sums do not always saturate
+  for (int i = 0; i < VPU_INT16_EPV; ++i)
+    if (rng.rand<uint32_t>() % 2) vpu.vD.s16[i] = (vpu.vR.s16[i] < 0) ? -1 : 0;
+  VSETC(&vpu, mode);
+}
+
+static int64_t acc_of(const xs3_vpu &vpu, int i) {
+  return (int32_t)(((uint32_t)(uint16_t)vpu.vD.s16[i] << 16) |
+                   (uint16_t)vpu.vR.s16[i]);
+}
+
+static int64_t sat(int64_t x, int bits) {
+  int64_t m = (((int64_t)1) << (bits - 1)) - 1;
+  return x > m ? m : x < -m ? -m : x;
+}
+
+static void expect_acc(const xs3_vpu &vpu, int i, int64_t expected) {
+  EXPECT_EQ(expected, acc_of(vpu, i)) << "accumulator " << i;
+}
+
+class Test_vpu_sim : public ::testing::Test {};
+
+TEST_F(Test_vpu_sim, VLMACCR) {
+  for (int iter = 0; iter < 2000; ++iter) {
+    vector_mode mode = (iter % 2) ? MODE_S16 : MODE_S8;
+    xs3_vpu vpu;
+    random_vpu(vpu, mode);
+    alignas(4) int8_t mem[XS3_VPU_VREG_WIDTH_BYTES];
+    fill(mem);
+
+    int64_t before[VPU_INT8_ACC_PERIOD];
+    for (int i = 0; i < VPU_INT8_ACC_PERIOD; ++i) before[i] = acc_of(vpu, i);
+
+    int64_t sum = before[VPU_INT8_ACC_PERIOD - 1];
+    if (mode == MODE_S8) {
+      for (int i = 0; i < VPU_INT8_EPV; ++i)
+        sum += (int64_t)vpu.vC.s8[i] * mem[i];
+    } else {
+      int16_t *mem16 = (int16_t *)mem;
+      for (int i = 0; i < VPU_INT16_EPV; ++i)
+        sum += (int64_t)vpu.vC.s16[i] * mem16[i];
+    }
+
+    VLMACCR(&vpu, mem);
+
+    expect_acc(vpu, 0, sat(sum, 32));
+    for (int i = 1; i < VPU_INT8_ACC_PERIOD; ++i)
+      expect_acc(vpu, i, before[i - 1]);
+  }
+}
+
+TEST_F(Test_vpu_sim, VLMACCR1) {
+  for (int iter = 0; iter < 1000; ++iter) {
+    xs3_vpu vpu;
+    random_vpu(vpu, MODE_S8);
+    alignas(4) int32_t mem[VPU_INT32_EPV];
+    fill(mem);
+
+    int64_t sum = acc_of(vpu, VPU_BIN_ACC_PERIOD - 1);
+    for (int i = 0; i < VPU_INT32_EPV; ++i)
+      for (int b = 0; b < 32; ++b)
+        sum += (((vpu.vC.s32[i] ^ mem[i]) >> b) & 1) ? -1 : 0;
+    sum += 16 * VPU_INT32_EPV;
+
+    VLMACCR1(&vpu, mem);
+
+    expect_acc(vpu, 0, sat(sum, 32));
+  }
+}
+
+TEST_F(Test_vpu_sim, VLMACC) {
+  for (int iter = 0; iter < 1000; ++iter) {
+    vector_mode mode = (iter % 2) ? MODE_S16 : MODE_S8;
+    xs3_vpu vpu;
+    random_vpu(vpu, mode);
+    alignas(4) int8_t mem[XS3_VPU_VREG_WIDTH_BYTES];
+    fill(mem);
+
+    int64_t expected[VPU_INT8_VLMACC_ELMS];
+    for (int i = 0; i < VPU_INT8_VLMACC_ELMS; ++i) {
+      int64_t p = (mode == MODE_S8)
+                      ? (int64_t)vpu.vC.s8[i] * mem[i]
+                      : (int64_t)vpu.vC.s16[i] * ((int16_t *)mem)[i];
+      expected[i] = sat(acc_of(vpu, i) + p, 32);
+    }
+
+    VLMACC(&vpu, mem);
+
+    for (int i = 0; i < VPU_INT8_VLMACC_ELMS; ++i)
+      expect_acc(vpu, i, expected[i]);
+  }
+}
+
+TEST_F(Test_vpu_sim, VLSAT) {
+  for (int iter = 0; iter < 1000; ++iter) {
+    vector_mode mode = (iter % 2) ? MODE_S16 : MODE_S8;
+    xs3_vpu vpu;
+    random_vpu(vpu, mode);
+    alignas(4) uint16_t shr[VPU_INT16_ACC_PERIOD];
+    for (int i = 0; i < VPU_INT16_ACC_PERIOD; ++i)
+      shr[i] = rng.rand<uint16_t>(0, 31);
+
+    int64_t expected[VPU_INT16_ACC_PERIOD];
+    for (int i = 0; i < VPU_INT16_ACC_PERIOD; ++i) {
+      int64_t acc = acc_of(vpu, i);
+      if (shr[i] != 0) acc += ((int64_t)1) << (shr[i] - 1);
+      // the 32 bit accumulator wraps when rounding
+      acc = (int32_t)(uint32_t)acc;
+      expected[i] = sat(acc >> shr[i], (mode == MODE_S8) ? 8 : 16);
+    }
+
+    VLSAT(&vpu, shr);
+
+    for (int i = 0; i < VPU_INT16_ACC_PERIOD; ++i) {
+      int64_t actual = (mode == MODE_S8) ? vpu.vR.s8[i] : vpu.vR.s16[i];
+      EXPECT_EQ(expected[i], actual);
+      EXPECT_EQ(0, vpu.vD.s16[i]);
+      if (mode == MODE_S8) {
+        EXPECT_EQ(0, vpu.vR.s8[VPU_INT8_ACC_PERIOD + i]);
+      }
+    }
+  }
+}
+
+/*
+  In MODE_S32 each accumulator is 40 bits, held in a word of vD (high) and a
+  word of vR (low).
+*/
+static int64_t acc32_of(const xs3_vpu &vpu, int i) {
+  return (int64_t)(((uint64_t)vpu.vD.s32[i] << 32) | vpu.vR.u32[i]);
+}
+
+static void random_vpu32(xs3_vpu &vpu) {
+  fill(vpu.vC.s32);
+  for (int i = 0; i < VPU_INT32_ACC_PERIOD; ++i) {
+    int64_t acc =
+        sat((int64_t)edge_rand<int32_t>() * 256 + rng.rand<uint8_t>(), 40);
+    vpu.vR.u32[i] = (uint32_t)acc;
+    vpu.vD.s32[i] = (int32_t)(acc >> 32);
+  }
+  VSETC(&vpu, MODE_S32);
+}
+
+TEST_F(Test_vpu_sim, S32Accumulators) {
+  for (int iter = 0; iter < 1000; ++iter) {
+    xs3_vpu vpu;
+    random_vpu32(vpu);
+    alignas(4) int32_t mem[VPU_INT32_EPV];
+    fill(mem);
+
+    int64_t before[VPU_INT32_ACC_PERIOD];
+    for (int i = 0; i < VPU_INT32_ACC_PERIOD; ++i)
+      before[i] = acc32_of(vpu, i);
+
+    // VLMACC
+    int64_t expected[VPU_INT32_ACC_PERIOD];
+    for (int i = 0; i < VPU_INT32_ACC_PERIOD; ++i)
+      expected[i] = sat(before[i] + (int64_t)vpu.vC.s32[i] * mem[i], 40);
+
+    VLMACC(&vpu, mem);
+
+    for (int i = 0; i < VPU_INT32_ACC_PERIOD; ++i)
+      EXPECT_EQ(expected[i], acc32_of(vpu, i)) << "accumulator " << i;
+
+    // VLMACCR
+    for (int i = 0; i < VPU_INT32_ACC_PERIOD; ++i)
+      before[i] = acc32_of(vpu, i);
+    int64_t sum = before[VPU_INT32_ACC_PERIOD - 1];
+    for (int i = 0; i < VPU_INT32_EPV; ++i)
+      sum += (int64_t)vpu.vC.s32[i] * mem[i];
+
+    VLMACCR(&vpu, mem);
+
+    EXPECT_EQ(sat(sum, 40), acc32_of(vpu, 0));
+    for (int i = 1; i < VPU_INT32_ACC_PERIOD; ++i)
+      EXPECT_EQ(before[i - 1], acc32_of(vpu, i)) << "accumulator " << i;
+
+    // VLSAT
+    alignas(4) uint32_t shr[VPU_INT32_ACC_PERIOD];
+    for (int i = 0; i < VPU_INT32_ACC_PERIOD; ++i)
+      shr[i] = rng.rand<uint32_t>(0, 39);
+    for (int i = 0; i < VPU_INT32_ACC_PERIOD; ++i) {
+      int64_t acc = acc32_of(vpu, i);
+      if (shr[i] != 0) acc += ((int64_t)1) << (shr[i] - 1);
+      expected[i] = sat(acc >> shr[i], 32);
+    }
+
+    VLSAT(&vpu, shr);
+
+    for (int i = 0; i < VPU_INT32_ACC_PERIOD; ++i) {
+      EXPECT_EQ(expected[i], vpu.vR.s32[i]);
+      EXPECT_EQ(0, vpu.vD.s32[i]);
+    }
+  }
+}
+
+TEST_F(Test_vpu_sim, VLASHR) {
+  // Left shifts of 32 or more are not defined by the C model
+  for (int shr = -31; shr <= 40; ++shr) {
+    for (int iter = 0; iter < 20; ++iter) {
+      vector_mode mode = (iter % 2) ? MODE_S16 : MODE_S8;
+      xs3_vpu vpu;
+      random_vpu(vpu, mode);
+      alignas(4) int8_t mem[XS3_VPU_VREG_WIDTH_BYTES];
+      fill(mem);
+
+      int bits = (mode == MODE_S8) ? 8 : 16;
+      int count = (mode == MODE_S8) ? VPU_INT8_EPV : VPU_INT16_EPV;
+
+      int64_t expected[VPU_INT8_EPV];
+      for (int i = 0; i < count; ++i) {
+        int32_t val = (mode == MODE_S8) ? mem[i] : ((int16_t *)mem)[i];
+        if (shr >= bits - 1)
+          val = (val < 0) ? -1 : 0;
+        else if (shr >= 0)
+          val = val >> shr;
+        else
+          val = (int32_t)((uint32_t)val << (-shr));
+        expected[i] = sat(val, bits);
+      }
+
+      VLASHR(&vpu, mem, shr);
+
+      for (int i = 0; i < count; ++i) {
+        int64_t actual = (mode == MODE_S8) ? vpu.vR.s8[i] : vpu.vR.s16[i];
+        EXPECT_EQ(expected[i], actual) << "shr: " << shr << " element " << i;
+      }
+    }
+  }
+}
+
+TEST_F(Test_vpu_sim, VDEPTH) {
+  for (int iter = 0; iter < 1000; ++iter) {
+    xs3_vpu vpu;
+    random_vpu(vpu, MODE_S16);
+    xs3_vpu vpu1 = vpu;
+    VSETC(&vpu1, (iter % 2) ? MODE_S16 : MODE_S8);
+
+    int8_t expected8[VPU_INT16_EPV];
+    for (int i = 0; i < VPU_INT16_EPV; ++i)
+      expected8[i] = sat(((int32_t)vpu.vR.s16[i] + (1 << 7)) >> 8, 8);
+
+    uint32_t expected1 = 0;
+    if (vpu1.mode == MODE_S8) {
+      for (int i = 0; i < VPU_INT8_EPV; ++i)
+        if (vpu1.vR.s8[i] < 0) expected1 |= 1u << i;
+    } else {
+      for (int i = 0; i < VPU_INT16_EPV; ++i)
+        if (vpu1.vR.s16[i] < 0) expected1 |= 1u << i;
+    }
+
+    VDEPTH8(&vpu);
+    VDEPTH1(&vpu1);
+
+    for (int i = 0; i < VPU_INT16_EPV; ++i) {
+      EXPECT_EQ(expected8[i], vpu.vR.s8[i]);
+      EXPECT_EQ(0, vpu.vR.s8[VPU_INT16_EPV + i]);
+    }
+    EXPECT_EQ(expected1, vpu1.vR.u32[0]);
+    for (int i = 1; i < VPU_INT32_EPV; ++i) EXPECT_EQ(0, vpu1.vR.u32[i]);
+  }
+}
+
+TEST_F(Test_vpu_sim, VSTRPV) {
+  for (int iter = 0; iter < 1000; ++iter) {
+    xs3_vpu vpu;
+    random_vpu(vpu, MODE_S8);
+    uint32_t mask = rng.rand<uint32_t>();
+    if (iter % 2) mask = (iter % 64 == 1) ? 0xFFFFFFFF : (1u << (iter % 32)) - 1;
+
+    alignas(4) int8_t mem[XS3_VPU_VREG_WIDTH_BYTES];
+    fill(mem);
+    int8_t expected[XS3_VPU_VREG_WIDTH_BYTES];
+    for (int i = 0; i < XS3_VPU_VREG_WIDTH_BYTES; ++i)
+      expected[i] = ((mask >> i) & 1) ? vpu.vR.s8[i] : mem[i];
+
+    VSTRPV(&vpu, mem, mask);
+
+    EXPECT_EQ(0, std::memcmp(expected, mem, sizeof(mem)));
+  }
+}
+
+}  // namespace nn
@@ -303,3 +303,42 @@ INSTANTIATE_TEST_SUITE_P(int16, ImageGeometry_Test,
                          ::testing::ValuesIn(TestGeometries<int16_t>()));
 INSTANTIATE_TEST_SUITE_P(int32, ImageGeometry_Test,
                          ::testing::ValuesIn(TestGeometries<int32_t>()));
+
+/////////////////////////////////////////////////////////////////////////
+//
+//
+TEST(ImageGeometry_View_Test, View) {
+  ImageGeometry parent(6, 7, 12, 2);
+  ImageRegion region(1, 2, 4, 3, 4, 8);
+  ImageGeometry view = parent.View(region);
+
+  ASSERT_EQ(3, view.height);
+  ASSERT_EQ(4, view.width);
+  ASSERT_EQ(8, view.depth);
+  ASSERT_EQ(2, view.channel_depth);
+  ASSERT_EQ(parent.RowStride(), view.RowStride());
+  ASSERT_EQ(parent.PixelStride(), view.PixelStride());
+  ASSERT_TRUE(parent.IsDense());
+  ASSERT_FALSE(view.IsDense());
+  ASSERT_FALSE(view == ImageGeometry(3, 4, 8, 2));
+
+  // Elements of the view are those of the region of the parent
+  const int offset = parent.Index(region.start.row, region.start.col,
+                                  region.start.channel);
+  for (int row = 0; row < view.height; row++) {
+    for (int col = 0; col < view.width; col++) {
+      for (int chan = 0; chan < view.depth; chan++) {
+        const int index = parent.Index(region.start.row + row,
+                                       region.start.col + col,
+                                       region.start.channel + chan);
+        ASSERT_EQ(index, offset + view.Index(row, col, chan));
+        ASSERT_EQ((index - offset) * 2, view.GetStride(row, col, chan));
+      }
+    }
+  }
+
+  // A view of a view keeps the strides of the original image
+  ImageGeometry inner = view.View(ImageRegion(1, 1, 0, 2, 2, 8));
+  ASSERT_EQ(parent.RowStride(), inner.RowStride());
+  ASSERT_EQ(parent.PixelStride(), inner.PixelStride());
+}
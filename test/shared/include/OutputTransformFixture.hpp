@@ -0,0 +1,88 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "OutputTransformFn.hpp"
+#include "Rand.hpp"
+#include "nn_operator.h"
+
+namespace nn {
+namespace test {
+
+/*
+  Rounds each 32-bit accumulator right by `shift` bits and saturates it to
+  int8.
+*/
+class RoundShiftOutputTransform : public OutputTransformFn {
+  int32_t output_channels;
+  int shift;
+
+ public:
+  RoundShiftOutputTransform(int32_t output_channels, int shift)
+      : output_channels(output_channels), shift(shift) {}
+
+  static int8_t apply(int32_t acc, int shift) {
+    int32_t v = (acc + (1 << (shift - 1))) >> shift;
+    return (int8_t)std::min(std::max(v, (int32_t)INT8_MIN), (int32_t)INT8_MAX);
+  }
+
+  int8_t *output_transform_fn(int8_t *Y, VPURingBuffer *A,
+                              int32_t output_channel_group) {
+    int count = std::min<int>(
+        output_channels - output_channel_group * VPU_INT8_ACC_PERIOD,
+        VPU_INT8_ACC_PERIOD);
+    for (int ch = 0; ch < count; ++ch) Y[ch] = apply(A->GetAccu(ch), shift);
+    return Y + count;
+  }
+};
+
+/*
+  Output transform parameters shared by the filter tests. The params returned
+  by make_ot_params() point into this object, so it must outlive them, and
+  each call overwrites the values of the previous one.
+*/
+class OutputTransformFixture {
+ protected:
+  OutputTransformValues otv;
+  std::vector<int16_t> biases, multipliers;
+
+  // acc >> 12, saturated, with biases drawn from `bias_rng` if one is given
+  OT_int8::Params make_ot_params(int y_channels, Rand *bias_rng = nullptr) {
+    std::memset(&otv, 0, sizeof(otv));
+    for (int k = 0; k < VPU_INT16_EPV; k++) otv.accu_shr[k] = 4;
+    const int groups =
+        (y_channels + VPU_INT8_ACC_PERIOD - 1) / VPU_INT8_ACC_PERIOD;
+    biases.assign(groups * VPU_INT16_EPV, 0);
+    multipliers.assign(groups * VPU_INT16_EPV, 1);
+    if (bias_rng)
+      for (auto &b : biases) b = bias_rng->rand<int16_t>(-1024, 1024);
+    return OT_int8::Params(y_channels, &otv, biases.data(),
+                           multipliers.data());
+  }
+
+  // Roughly acc >> 12, with random biases
+  static std::vector<nn_bso_block_t> make_bso(Rand &rng, int y_channels) {
+    // nn_standard_BSO_layout() reads a whole block of each array, so they are
+    // padded to a multiple of VPU_INT8_ACC_PERIOD
+    const int groups =
+        (y_channels + VPU_INT8_ACC_PERIOD - 1) / VPU_INT8_ACC_PERIOD;
+    const int padded_channels = groups * VPU_INT8_ACC_PERIOD;
+    std::vector<int32_t> bias(padded_channels, 0);
+    std::vector<int16_t> shift1(padded_channels, 8), scale(padded_channels, 1),
+        offset_scale(padded_channels, 0), offset(padded_channels, 0),
+        shift2(padded_channels, 4);
+    for (int ch = 0; ch < y_channels; ch++) bias[ch] = rng.rand<int16_t>();
+
+    std::vector<nn_bso_block_t> bso(groups);
+    nn_standard_BSO_layout(bso.data(), bias.data(), shift1.data(),
+                           scale.data(), offset_scale.data(), offset.data(),
+                           shift2.data(), nullptr, y_channels);
+    return bso;
+  }
+};
+
+}  // namespace test
+}  // namespace nn